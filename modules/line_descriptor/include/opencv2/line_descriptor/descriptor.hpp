@@ -879,6 +879,10 @@ std::vector<cv::Mat> dxImg_vector, dyImg_vector;
 /* Gaussian pyramid */
 std::vector<cv::Mat> octaveImages;
 
+/* blurred octave images used by line detection, kept across calls to avoid reallocations
+ for same-sized frames */
+std::vector<cv::Mat> blurredOctaveImages;
+
 };
 
 /**
@@ -958,6 +962,8 @@ CV_WRAP void detect( const Mat& image, CV_OUT std::vector<KeyLine>& keypoints, i
 @param scale scale factor used in pyramids generation
 @param numOctaves number of octaves inside pyramid
 @param masks vector of mask matrices to detect only KeyLines of interest from each input image
+
+Images are processed in parallel; results are the same as calling detect on each image.
 */
 CV_WRAP void detect( const std::vector<Mat>& images, std::vector<std::vector<KeyLine> >& keylines, int scale, int numOctaves,
 const std::vector<Mat>& masks = std::vector<Mat>() ) const;
@@ -969,6 +975,10 @@ void computeGaussianPyramid( const Mat& image, int numOctaves, int scale );
 /* implementation of line detection */
 void detectImpl( const Mat& imageSrc, std::vector<KeyLine>& keylines, int numOctaves, int scale, const Mat& mask ) const;
 
+/* implementation of line detection using caller-provided pyramid buffers (octaves are processed in parallel) */
+void detectImpl( const Mat& imageSrc, std::vector<KeyLine>& keylines, int numOctaves, int scale, const Mat& mask,
+                 std::vector<cv::Mat>& pyramid ) const;
+
 /* matrices for Gaussian pyramids */
 std::vector<cv::Mat> gaussianPyrs;
 
@@ -132,4 +132,75 @@ PERF_TEST_P(file_str, detect_lsd, testing::Values(IMAGES))
 
 }
 
+typedef tuple<std::string, int> File_Octaves_t;
+typedef perf::TestBaseWithParam<File_Octaves_t> file_octaves;
+
+PERF_TEST_P(file_octaves, detect_multiscale, testing::Combine(testing::Values(IMAGES), testing::Values(1, 2, 4)))
+{
+  std::string filename = getDataPath( get<0>(GetParam()) );
+  int numOctaves = get<1>(GetParam());
+
+  Mat frame = imread( filename, 1 );
+
+  if( frame.empty() )
+    FAIL()<< "Unable to load source image " << filename;
+
+  std::vector<KeyLine> keylines;
+  BinaryDescriptor::Params params;
+  params.numOfOctave_ = numOctaves;
+  Ptr<BinaryDescriptor> bd = BinaryDescriptor::createBinaryDescriptor( params );
+
+  TEST_CYCLE()
+  {
+    keylines.clear();
+    bd->detect( frame, keylines );
+  }
+
+  SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(file_octaves, detect_lsd_multiscale, testing::Combine(testing::Values(IMAGES), testing::Values(1, 2, 4)))
+{
+  std::string filename = getDataPath( get<0>(GetParam()) );
+  int numOctaves = get<1>(GetParam());
+
+  Mat frame = imread( filename, 1 );
+
+  if( frame.empty() )
+    FAIL()<< "Unable to load source image " << filename;
+
+  std::vector<KeyLine> keylines;
+  Ptr<LSDDetector> lsd = LSDDetector::createLSDDetector();
+
+  TEST_CYCLE()
+  {
+    keylines.clear();
+    lsd->detect( frame, keylines, 2, numOctaves );
+  }
+
+  SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(file_str, detect_lsd_batch, testing::Values(IMAGES))
+{
+  std::string filename = getDataPath( GetParam() );
+
+  Mat frame = imread( filename, 1 );
+
+  if( frame.empty() )
+    FAIL()<< "Unable to load source image " << filename;
+
+  std::vector<Mat> frames( 8, frame );
+  std::vector<std::vector<KeyLine> > keylines;
+  Ptr<LSDDetector> lsd = LSDDetector::createLSDDetector();
+
+  TEST_CYCLE()
+  {
+    keylines.clear();
+    lsd->detect( frames, keylines, 2, 2 );
+  }
+
+  SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
@@ -56,26 +56,31 @@ Ptr<LSDDetector> LSDDetector::createLSDDetector(LSDParam params)
   return Ptr<LSDDetector>( new LSDDetector(params) );
 }
 
-/* compute Gaussian pyramid of input image */
-void LSDDetector::computeGaussianPyramid( const Mat& image, int numOctaves, int scale )
+/* compute Gaussian pyramid of input image; matrices already stored in pyramid are reused
+ when they have the right size */
+static void buildGaussianPyramid( const Mat& image, int numOctaves, int scale, std::vector<cv::Mat>& pyramid )
 {
-  /* clear class fields */
-  gaussianPyrs.clear();
+  CV_Assert( numOctaves > 0 );
+  pyramid.resize( numOctaves );
 
-  /* insert input image into pyramid */
-  cv::Mat currentMat = image.clone();
-  //cv::GaussianBlur( currentMat, currentMat, cv::Size( 5, 5 ), 1 );
-  gaussianPyrs.push_back( currentMat );
+  /* insert input image into pyramid (LSD does not modify it, no copy is needed) */
+  pyramid[0] = image;
 
   /* fill Gaussian pyramid */
   for ( int pyrCounter = 1; pyrCounter < numOctaves; pyrCounter++ )
   {
-    /* compute and store next image in pyramid and its size */
-    pyrDown( currentMat, currentMat, Size( currentMat.cols / scale, currentMat.rows / scale ) );
-    gaussianPyrs.push_back( currentMat );
+    /* compute and store next image in pyramid */
+    const cv::Mat& prevMat = pyramid[pyrCounter - 1];
+    pyrDown( prevMat, pyramid[pyrCounter], Size( prevMat.cols / scale, prevMat.rows / scale ) );
   }
 }
 
+/* compute Gaussian pyramid of input image */
+void LSDDetector::computeGaussianPyramid( const Mat& image, int numOctaves, int scale )
+{
+  buildGaussianPyramid( image, numOctaves, scale, gaussianPyrs );
+}
+
 /* check lines' extremes */
 inline void checkLineExtremes( cv::Vec4f& extremes, cv::Size imageSize )
 {
@@ -119,52 +124,70 @@ void LSDDetector::detect( const Mat& image, CV_OUT std::vector<KeyLine>& keyline
 void LSDDetector::detect( const std::vector<Mat>& images, std::vector<std::vector<KeyLine> >& keylines, int scale, int numOctaves,
                           const std::vector<Mat>& masks ) const
 {
-  /* detect lines from each image */
-  for ( size_t counter = 0; counter < images.size(); counter++ )
+  /* check masks before starting parallel detection */
+  for ( size_t counter = 0; counter < images.size() && counter < masks.size(); counter++ )
   {
     if( masks[counter].data != NULL && ( masks[counter].size() != images[counter].size() || masks[counter].type() != CV_8UC1 ) )
       CV_Error( Error::StsBadArg, "Masks error while detecting lines: please check their dimensions and that data types are CV_8UC1" );
-
-    else
-      detectImpl( images[counter], keylines[counter], numOctaves, scale, masks[counter] );
   }
+
+  keylines.resize( images.size() );
+
+  /* detect lines from each image; every thread reuses its own pyramid buffers
+   for the images it processes */
+  parallel_for_( Range( 0, (int) images.size() ), [&]( const Range& range )
+  {
+    std::vector<cv::Mat> pyramid;
+    for ( int counter = range.start; counter < range.end; counter++ )
+    {
+      Mat mask = (size_t) counter < masks.size() ? masks[counter] : Mat();
+      detectImpl( images[counter], keylines[counter], numOctaves, scale, mask, pyramid );
+    }
+  } );
 }
 
 /* implementation of line detection */
 void LSDDetector::detectImpl( const Mat& imageSrc, std::vector<KeyLine>& keylines, int numOctaves, int scale, const Mat& mask ) const
+{
+  /* create a pointer to self */
+  LSDDetector *lsd = const_cast<LSDDetector*>( this );
+
+  detectImpl( imageSrc, keylines, numOctaves, scale, mask, lsd->gaussianPyrs );
+}
+
+/* implementation of line detection, using the given pyramid buffers */
+void LSDDetector::detectImpl( const Mat& imageSrc, std::vector<KeyLine>& keylines, int numOctaves, int scale, const Mat& mask,
+                              std::vector<cv::Mat>& pyramid ) const
 {
   cv::Mat image;
   if( imageSrc.channels() != 1 )
     cvtColor( imageSrc, image, COLOR_BGR2GRAY );
   else
-    image = imageSrc.clone();
+    image = imageSrc;
 
   /*check whether image depth is different from 0 */
   if( image.depth() != 0 )
     CV_Error( Error::BadDepth, "Error, depth image!= 0" );
 
-  /* create a pointer to self */
-  LSDDetector *lsd = const_cast<LSDDetector*>( this );
-
   /* compute Gaussian pyramids */
-  lsd->computeGaussianPyramid( image, numOctaves, scale );
-
-  /* create an LSD extractor */
-  cv::Ptr<cv::LineSegmentDetector> ls = cv::createLineSegmentDetector(
-    cv::LSD_REFINE_ADV, params.scale, params.sigma_scale,
-    params.quant, params.ang_th, params.log_eps,
-    params.density_th, params.n_bins);
+  buildGaussianPyramid( image, numOctaves, scale, pyramid );
 
   /* prepare a vector to host extracted segments */
-  std::vector<std::vector<cv::Vec4f> > lines_lsd;
+  std::vector<std::vector<cv::Vec4f> > lines_lsd( numOctaves );
 
-  /* extract lines */
-  for ( int i = 0; i < numOctaves; i++ )
+  /* extract lines from all octaves concurrently; LineSegmentDetector keeps per-call
+   state, so every octave uses its own extractor */
+  parallel_for_( Range( 0, numOctaves ), [&]( const Range& range )
   {
-    std::vector<Vec4f> octave_lines;
-    ls->detect( gaussianPyrs[i], octave_lines );
-    lines_lsd.push_back( octave_lines );
-  }
+    for ( int i = range.start; i < range.end; i++ )
+    {
+      cv::Ptr<cv::LineSegmentDetector> ls = cv::createLineSegmentDetector(
+        cv::LSD_REFINE_ADV, params.scale, params.sigma_scale,
+        params.quant, params.ang_th, params.log_eps,
+        params.density_th, params.n_bins);
+      ls->detect( pyramid[i], lines_lsd[i] );
+    }
+  } );
 
   /* create keylines */
   int class_counter = -1;
@@ -177,7 +200,7 @@ void LSDDetector::detectImpl( const Mat& imageSrc, std::vector<KeyLine>& keyline
       cv::Vec4f extremes = lines_lsd[octaveIdx][k];
 
       /* check data validity */
-      checkLineExtremes( extremes, gaussianPyrs[octaveIdx].size() );
+      checkLineExtremes( extremes, pyramid[octaveIdx].size() );
 
       /* fill KeyLine's fields */
       kl.startPointX = extremes[0] * octaveScale;
@@ -191,14 +214,14 @@ void LSDDetector::detectImpl( const Mat& imageSrc, std::vector<KeyLine>& keyline
       kl.lineLength = (float) sqrt( pow( extremes[0] - extremes[2], 2 ) + pow( extremes[1] - extremes[3], 2 ) );
 
       /* compute number of pixels covered by line */
-      LineIterator li( gaussianPyrs[octaveIdx], Point2f( extremes[0], extremes[1] ), Point2f( extremes[2], extremes[3] ) );
+      LineIterator li( pyramid[octaveIdx], Point2f( extremes[0], extremes[1] ), Point2f( extremes[2], extremes[3] ) );
       kl.numOfPixels = li.count;
 
       kl.angle = atan2( ( kl.endPointY - kl.startPointY ), ( kl.endPointX - kl.startPointX ) );
       kl.class_id = ++class_counter;
       kl.octave = octaveIdx;
       kl.size = ( kl.endPointX - kl.startPointX ) * ( kl.endPointY - kl.startPointY );
-      kl.response = kl.lineLength / max( gaussianPyrs[octaveIdx].cols, gaussianPyrs[octaveIdx].rows );
+      kl.response = kl.lineLength / max( pyramid[octaveIdx].cols, pyramid[octaveIdx].rows );
       kl.pt = Point2f( ( kl.endPointX + kl.startPointX ) / 2, ( kl.endPointY + kl.startPointY ) / 2 );
 
       keylines.push_back( kl );
@@ -40,6 +40,7 @@
  //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #ifdef _MSC_VER
     #if (_MSC_VER <= 1700)
@@ -274,13 +275,6 @@ void BinaryDescriptor::operator()( InputArray image, InputArray mask, CV_OUT std
   if( !useProvidedKeyLines )
   {
     keylines.clear();
-    BinaryDescriptor *bn = const_cast<BinaryDescriptor*>( this );
-    bn->edLineVec_.clear();
-    bn->edLineVec_.resize( params.numOfOctave_ );
-
-    for ( int i = 0; i < params.numOfOctave_; i++ )
-    bn->edLineVec_[i] = Ptr<EDLineDetector>( new EDLineDetector() );
-
     detectImpl( imageMat, keylines, maskMat );
 
   }
@@ -344,23 +338,22 @@ static inline int get2Pow( int i )
 /* compute Gaussian pyramids */
 void BinaryDescriptor::computeGaussianPyramid( const Mat& image, const int numOctaves )
 {
-  /* clear class fields */
-  images_sizes.clear();
-  octaveImages.clear();
+  /* resize class fields; matrices already allocated for a previous frame of the
+   same size are reused */
+  images_sizes.resize( numOctaves );
+  octaveImages.resize( numOctaves );
 
   /* insert input image into pyramid */
-  cv::Mat currentMat = image.clone();
-  cv::GaussianBlur( currentMat, currentMat, cv::Size( 5, 5 ), 1 );
-  octaveImages.push_back( currentMat );
-  images_sizes.push_back( currentMat.size() );
+  cv::GaussianBlur( image, octaveImages[0], cv::Size( 5, 5 ), 1 );
+  images_sizes[0] = octaveImages[0].size();
 
   /* fill Gaussian pyramid */
   for ( int pyrCounter = 1; pyrCounter < numOctaves; pyrCounter++ )
   {
     /* compute and store next image in pyramid and its size */
-    pyrDown( currentMat, currentMat, Size( currentMat.cols / params.reductionRatio, currentMat.rows / params.reductionRatio ) );
-    octaveImages.push_back( currentMat );
-    images_sizes.push_back( currentMat.size() );
+    const cv::Mat& prevMat = octaveImages[pyrCounter - 1];
+    pyrDown( prevMat, octaveImages[pyrCounter], Size( prevMat.cols / params.reductionRatio, prevMat.rows / params.reductionRatio ) );
+    images_sizes[pyrCounter] = octaveImages[pyrCounter].size();
   }
 }
 
@@ -371,25 +364,22 @@ void BinaryDescriptor::computeSobel( const cv::Mat& image, const int numOctaves
   /* compute Gaussian pyramids */
   computeGaussianPyramid( image, numOctaves );
 
-  /* reinitialize class structures */
-  dxImg_vector.clear();
-  dyImg_vector.clear();
-
-//  dxImg_vector.resize( params.numOfOctave_ );
-//  dyImg_vector.resize( params.numOfOctave_ );
-
+  /* reinitialize class structures (buffers of same-sized octaves are kept) */
   dxImg_vector.resize( octaveImages.size() );
   dyImg_vector.resize( octaveImages.size() );
 
-  /* compute derivatives */
-  for ( size_t sobelCnt = 0; sobelCnt < octaveImages.size(); sobelCnt++ )
+  /* compute derivatives, one octave per task */
+  parallel_for_( Range( 0, (int) octaveImages.size() ), [&]( const Range& range )
   {
-    dxImg_vector[sobelCnt].create( images_sizes[sobelCnt].height, images_sizes[sobelCnt].width, CV_16SC1 );
-    dyImg_vector[sobelCnt].create( images_sizes[sobelCnt].height, images_sizes[sobelCnt].width, CV_16SC1 );
+    for ( int sobelCnt = range.start; sobelCnt < range.end; sobelCnt++ )
+    {
+      dxImg_vector[sobelCnt].create( images_sizes[sobelCnt].height, images_sizes[sobelCnt].width, CV_16SC1 );
+      dyImg_vector[sobelCnt].create( images_sizes[sobelCnt].height, images_sizes[sobelCnt].width, CV_16SC1 );
 
-    cv::Sobel( octaveImages[sobelCnt], dxImg_vector[sobelCnt], CV_16SC1, 1, 0, 3 );
-    cv::Sobel( octaveImages[sobelCnt], dyImg_vector[sobelCnt], CV_16SC1, 0, 1, 3 );
-  }
+      cv::Sobel( octaveImages[sobelCnt], dxImg_vector[sobelCnt], CV_16SC1, 1, 0, 3 );
+      cv::Sobel( octaveImages[sobelCnt], dyImg_vector[sobelCnt], CV_16SC1, 0, 1, 3 );
+    }
+  } );
 }
 
 /* utility function for conversion of an LBD descriptor to its binary representation */
@@ -452,7 +442,7 @@ void BinaryDescriptor::detectImpl( const Mat& imageSrc, std::vector<KeyLine>& ke
     cvtColor( imageSrc, image, COLOR_BGR2GRAY );
   }
   else
-    image = imageSrc.clone();
+    image = imageSrc;
 
   /*check whether image depth is different from 0 */
   if( image.depth() != 0 )
@@ -699,34 +689,53 @@ int BinaryDescriptor::OctaveKeyLines( cv::Mat& image, ScaleLines &keyLines )
   float curSigma2 = 1.0;  //[sqrt(2)]^0=1;
   double factor = sqrt( 2.0 );  //the down sample factor between connective two octave images
 
-  /* loop over number of octaves */
+  /* make sure there is one EDLine detector per octave (number of octaves may have
+   been changed after construction); detectors keep their buffers across calls */
+  if( (int) edLineVec_.size() != params.numOfOctave_ )
+  {
+    size_t oldSize = edLineVec_.size();
+    edLineVec_.resize( params.numOfOctave_ );
+    for ( size_t i = oldSize; i < edLineVec_.size(); i++ )
+      edLineVec_[i] = Ptr < EDLineDetector > ( new EDLineDetector() );
+  }
+  images_sizes.resize( params.numOfOctave_ );
+  blurredOctaveImages.resize( params.numOfOctave_ );
+
+  /* build blurred pyramid (matrices are reused for same-sized frames) */
   for ( int octaveCount = 0; octaveCount < params.numOfOctave_; octaveCount++ )
   {
-    /* matrix storing results from blurring processes */
-    cv::Mat blur;
+    cv::Mat& blur = blurredOctaveImages[octaveCount];
+
+    /* resize previous level for current level of pyramid */
+    if( octaveCount > 0 )
+      cv::resize( blurredOctaveImages[octaveCount - 1], blur, cv::Size(), ( 1.f / factor ), ( 1.f / factor ), INTER_LINEAR_EXACT );
 
     /* apply Gaussian blur */
     float increaseSigma = sqrt( curSigma2 - preSigma2 );
-    cv::GaussianBlur( image, blur, cv::Size( params.ksize_, params.ksize_ ), increaseSigma );
+    cv::GaussianBlur( octaveCount == 0 ? image : blur, blur, cv::Size( params.ksize_, params.ksize_ ), increaseSigma );
     images_sizes[octaveCount] = blur.size();
 
-    /* for current octave, extract lines */
-    if( ( edLineVec_[octaveCount]->EDline( blur ) ) != 1 )
-    {
-      return -1;
-    }
-
-    /* update number of total extracted lines */
-    numOfFinalLine += edLineVec_[octaveCount]->lines_.numOfLines;
-
-    /* resize image for next level of pyramid */
-    cv::resize( blur, image, cv::Size(), ( 1.f / factor ), ( 1.f / factor ), INTER_LINEAR_EXACT );
-
     /* update sigma values */
     preSigma2 = curSigma2;
     curSigma2 = curSigma2 * 2;
+  }
+
+  /* extract lines from all octaves concurrently: every octave owns its EDLine detector */
+  std::vector<int> octaveStatus( params.numOfOctave_, 1 );
+  parallel_for_( Range( 0, params.numOfOctave_ ), [&]( const Range& range )
+  {
+    for ( int octaveCount = range.start; octaveCount < range.end; octaveCount++ )
+      octaveStatus[octaveCount] = edLineVec_[octaveCount]->EDline( blurredOctaveImages[octaveCount] );
+  } );
+
+  for ( int octaveCount = 0; octaveCount < params.numOfOctave_; octaveCount++ )
+  {
+    if( octaveStatus[octaveCount] != 1 )
+      return -1;
 
-  } /* end of loop over number of octaves */
+    /* update number of total extracted lines */
+    numOfFinalLine += edLineVec_[octaveCount]->lines_.numOfLines;
+  }
 
   /* prepare a vector to store octave information associated to extracted lines */
   std::vector < OctaveLine > octaveLines( numOfFinalLine );
@@ -1029,208 +1038,184 @@ int BinaryDescriptor::computeLBD( ScaleLines &keyLines, bool useDetectionData )
 {
   //the default length of the band is the line length.
   short numOfFinalLine = (short) keyLines.size();
-  float *dL = new float[2];  //line direction cos(dir), sin(dir)
-  float *dO = new float[2];  //the clockwise orthogonal vector of line direction.
-  short heightOfLSP = (short) ( params.widthOfBand_ * NUM_OF_BANDS );  //the height of line support region;
-  short descriptor_size = NUM_OF_BANDS * 8;  //each band, we compute the m( pgdL, ngdL,  pgdO, ngdO) and std( pgdL, ngdL,  pgdO, ngdO);
-  float pgdLRowSum;  //the summation of {g_dL |g_dL>0 } for each row of the region;
-  float ngdLRowSum;  //the summation of {g_dL |g_dL<0 } for each row of the region;
-  float pgdL2RowSum;  //the summation of {g_dL^2 |g_dL>0 } for each row of the region;
-  float ngdL2RowSum;  //the summation of {g_dL^2 |g_dL<0 } for each row of the region;
-  float pgdORowSum;  //the summation of {g_dO |g_dO>0 } for each row of the region;
-  float ngdORowSum;  //the summation of {g_dO |g_dO<0 } for each row of the region;
-  float pgdO2RowSum;  //the summation of {g_dO^2 |g_dO>0 } for each row of the region;
-  float ngdO2RowSum;  //the summation of {g_dO^2 |g_dO<0 } for each row of the region;
-
-  float *pgdLBandSum = new float[NUM_OF_BANDS];  //the summation of {g_dL |g_dL>0 } for each band of the region;
-  float *ngdLBandSum = new float[NUM_OF_BANDS];  //the summation of {g_dL |g_dL<0 } for each band of the region;
-  float *pgdL2BandSum = new float[NUM_OF_BANDS];  //the summation of {g_dL^2 |g_dL>0 } for each band of the region;
-  float *ngdL2BandSum = new float[NUM_OF_BANDS];  //the summation of {g_dL^2 |g_dL<0 } for each band of the region;
-  float *pgdOBandSum = new float[NUM_OF_BANDS];  //the summation of {g_dO |g_dO>0 } for each band of the region;
-  float *ngdOBandSum = new float[NUM_OF_BANDS];  //the summation of {g_dO |g_dO<0 } for each band of the region;
-  float *pgdO2BandSum = new float[NUM_OF_BANDS];  //the summation of {g_dO^2 |g_dO>0 } for each band of the region;
-  float *ngdO2BandSum = new float[NUM_OF_BANDS];  //the summation of {g_dO^2 |g_dO<0 } for each band of the region;
-
-  short numOfBitsBand = NUM_OF_BANDS * sizeof(float);
-  short lengthOfLSP;  //the length of line support region, varies with lines
-  short halfHeight = ( heightOfLSP - 1 ) / 2;
-  short halfWidth;
-  short bandID;
-  float coefInGaussion;
-  float lineMiddlePointX, lineMiddlePointY;
-  float sCorX, sCorY, sCorX0, sCorY0;
-  short tempCor, xCor, yCor;  //pixel coordinates in image plane
-  short dx, dy;
-  float gDL;  //store the gradient projection of pixels in support region along dL vector
-  float gDO;  //store the gradient projection of pixels in support region along dO vector
-  short imageWidth, imageHeight, realWidth;
-  short *pdxImg, *pdyImg;
-  float *desVec;
-
-  short sameLineSize;
-  short octaveCount;
-  OctaveSingleLine *pSingleLine;
-  /* loop over list of LineVec */
-  for ( short lineIDInScaleVec = 0; lineIDInScaleVec < numOfFinalLine; lineIDInScaleVec++ )
+
+  /* LineVecs are described independently of each other: split them among threads,
+   each one with its own band accumulators */
+  parallel_for_( Range( 0, numOfFinalLine ), [&]( const Range& range )
   {
-    sameLineSize = (short) ( keyLines[lineIDInScaleVec].size() );
-    /* loop over current LineVec's lines */
-    for ( short lineIDInSameLine = 0; lineIDInSameLine < sameLineSize; lineIDInSameLine++ )
+    float dL[2];  //line direction cos(dir), sin(dir)
+    float dO[2];  //the clockwise orthogonal vector of line direction.
+    short heightOfLSP = (short) ( params.widthOfBand_ * NUM_OF_BANDS );  //the height of line support region;
+    short descriptor_size = NUM_OF_BANDS * 8;  //each band, we compute the m( pgdL, ngdL,  pgdO, ngdO) and std( pgdL, ngdL,  pgdO, ngdO);
+    float pgdLRowSum;  //the summation of {g_dL |g_dL>0 } for each row of the region;
+    float ngdLRowSum;  //the summation of {g_dL |g_dL<0 } for each row of the region;
+    float pgdL2RowSum;  //the summation of {g_dL^2 |g_dL>0 } for each row of the region;
+    float ngdL2RowSum;  //the summation of {g_dL^2 |g_dL<0 } for each row of the region;
+    float pgdORowSum;  //the summation of {g_dO |g_dO>0 } for each row of the region;
+    float ngdORowSum;  //the summation of {g_dO |g_dO<0 } for each row of the region;
+    float pgdO2RowSum;  //the summation of {g_dO^2 |g_dO>0 } for each row of the region;
+    float ngdO2RowSum;  //the summation of {g_dO^2 |g_dO<0 } for each row of the region;
+
+    float pgdLBandSum[NUM_OF_BANDS];  //the summation of {g_dL |g_dL>0 } for each band of the region;
+    float ngdLBandSum[NUM_OF_BANDS];  //the summation of {g_dL |g_dL<0 } for each band of the region;
+    float pgdL2BandSum[NUM_OF_BANDS];  //the summation of {g_dL^2 |g_dL>0 } for each band of the region;
+    float ngdL2BandSum[NUM_OF_BANDS];  //the summation of {g_dL^2 |g_dL<0 } for each band of the region;
+    float pgdOBandSum[NUM_OF_BANDS];  //the summation of {g_dO |g_dO>0 } for each band of the region;
+    float ngdOBandSum[NUM_OF_BANDS];  //the summation of {g_dO |g_dO<0 } for each band of the region;
+    float pgdO2BandSum[NUM_OF_BANDS];  //the summation of {g_dO^2 |g_dO>0 } for each band of the region;
+    float ngdO2BandSum[NUM_OF_BANDS];  //the summation of {g_dO^2 |g_dO<0 } for each band of the region;
+
+    short numOfBitsBand = NUM_OF_BANDS * sizeof(float);
+    short lengthOfLSP;  //the length of line support region, varies with lines
+    short halfHeight = ( heightOfLSP - 1 ) / 2;
+    short halfWidth;
+    short bandID;
+    float coefInGaussion;
+    float lineMiddlePointX, lineMiddlePointY;
+    float sCorX, sCorY, sCorX0, sCorY0;
+    short tempCor, xCor, yCor;  //pixel coordinates in image plane
+    short dx, dy;
+    float gDL;  //store the gradient projection of pixels in support region along dL vector
+    float gDO;  //store the gradient projection of pixels in support region along dO vector
+    short imageWidth, imageHeight, realWidth;
+    short *pdxImg, *pdyImg;
+    float *desVec;
+
+    short sameLineSize;
+    short octaveCount;
+    OctaveSingleLine *pSingleLine;
+    /* loop over list of LineVec */
+    for ( short lineIDInScaleVec = (short) range.start; lineIDInScaleVec < range.end; lineIDInScaleVec++ )
     {
-      /* get a line in current LineVec and its original ID in its octave */
-      pSingleLine = & ( keyLines[lineIDInScaleVec][lineIDInSameLine] );
-      octaveCount = (short) pSingleLine->octaveCount;
-
-      if( useDetectionData )
+      sameLineSize = (short) ( keyLines[lineIDInScaleVec].size() );
+      /* loop over current LineVec's lines */
+      for ( short lineIDInSameLine = 0; lineIDInSameLine < sameLineSize; lineIDInSameLine++ )
       {
-        /* retrieve associated dxImg and dyImg */
-        pdxImg = edLineVec_[octaveCount]->dxImg_.ptr<short>();
-        pdyImg = edLineVec_[octaveCount]->dyImg_.ptr<short>();
-
-        /* get image size to work on from real one */
-        realWidth = (short) edLineVec_[octaveCount]->imageWidth;
-        imageWidth = realWidth - 1;
-        imageHeight = (short) ( edLineVec_[octaveCount]->imageHeight - 1 );
-      }
+        /* get a line in current LineVec and its original ID in its octave */
+        pSingleLine = & ( keyLines[lineIDInScaleVec][lineIDInSameLine] );
+        octaveCount = (short) pSingleLine->octaveCount;
 
-      else
-      {
-        /* retrieve associated dxImg and dyImg */
-        pdxImg = dxImg_vector[octaveCount].ptr<short>();
-        pdyImg = dyImg_vector[octaveCount].ptr<short>();
-
-        /* get image size to work on from real one */
-        realWidth = (short) images_sizes[octaveCount].width;
-        imageWidth = realWidth - 1;
-        imageHeight = (short) ( images_sizes[octaveCount].height - 1 );
-      }
-
-      /* initialize memory areas */
-      memset( pgdLBandSum, 0, numOfBitsBand );
-      memset( ngdLBandSum, 0, numOfBitsBand );
-      memset( pgdL2BandSum, 0, numOfBitsBand );
-      memset( ngdL2BandSum, 0, numOfBitsBand );
-      memset( pgdOBandSum, 0, numOfBitsBand );
-      memset( ngdOBandSum, 0, numOfBitsBand );
-      memset( pgdO2BandSum, 0, numOfBitsBand );
-      memset( ngdO2BandSum, 0, numOfBitsBand );
-
-      /* get length of line and its half */
-      lengthOfLSP = (short) keyLines[lineIDInScaleVec][lineIDInSameLine].numOfPixels;
-      halfWidth = ( lengthOfLSP - 1 ) / 2;
-
-      /* get middlepoint of line */
-      lineMiddlePointX = (float) ( 0.5 * ( pSingleLine->sPointInOctaveX + pSingleLine->ePointInOctaveX ) );
-      lineMiddlePointY = (float) ( 0.5 * ( pSingleLine->sPointInOctaveY + pSingleLine->ePointInOctaveY ) );
-
-      /*1.rotate the local coordinate system to the line direction (direction is the angle
-       between positive line direction and positive X axis)
-       *2.compute the gradient projection of pixels in line support region*/
-
-      /* get the vector representing original image reference system after rotation to aligh with
-       line's direction */
-      dL[0] = cos( pSingleLine->direction );
-      dL[1] = sin( pSingleLine->direction );
-
-      /* set the clockwise orthogonal vector of line direction */
-      dO[0] = -dL[1];
-      dO[1] = dL[0];
-
-      /* get rotated reference frame */
-      sCorX0 = -dL[0] * halfWidth + dL[1] * halfHeight + lineMiddlePointX;  //hID =0; wID = 0;
-      sCorY0 = -dL[1] * halfWidth - dL[0] * halfHeight + lineMiddlePointY;
-
-      /* BIAS::Matrix<float> gDLMat(heightOfLSP,lengthOfLSP) */
-      for ( short hID = 0; hID < heightOfLSP; hID++ )
-      {
-        /*initialization */
-        sCorX = sCorX0;
-        sCorY = sCorY0;
+        if( useDetectionData )
+        {
+          /* retrieve associated dxImg and dyImg */
+          pdxImg = edLineVec_[octaveCount]->dxImg_.ptr<short>();
+          pdyImg = edLineVec_[octaveCount]->dyImg_.ptr<short>();
+
+          /* get image size to work on from real one */
+          realWidth = (short) edLineVec_[octaveCount]->imageWidth;
+          imageWidth = realWidth - 1;
+          imageHeight = (short) ( edLineVec_[octaveCount]->imageHeight - 1 );
+        }
 
-        pgdLRowSum = 0;
-        ngdLRowSum = 0;
-        pgdORowSum = 0;
-        ngdORowSum = 0;
+        else
+        {
+          /* retrieve associated dxImg and dyImg */
+          pdxImg = dxImg_vector[octaveCount].ptr<short>();
+          pdyImg = dyImg_vector[octaveCount].ptr<short>();
+
+          /* get image size to work on from real one */
+          realWidth = (short) images_sizes[octaveCount].width;
+          imageWidth = realWidth - 1;
+          imageHeight = (short) ( images_sizes[octaveCount].height - 1 );
+        }
 
-        for ( short wID = 0; wID < lengthOfLSP; wID++ )
+        /* initialize memory areas */
+        memset( pgdLBandSum, 0, numOfBitsBand );
+        memset( ngdLBandSum, 0, numOfBitsBand );
+        memset( pgdL2BandSum, 0, numOfBitsBand );
+        memset( ngdL2BandSum, 0, numOfBitsBand );
+        memset( pgdOBandSum, 0, numOfBitsBand );
+        memset( ngdOBandSum, 0, numOfBitsBand );
+        memset( pgdO2BandSum, 0, numOfBitsBand );
+        memset( ngdO2BandSum, 0, numOfBitsBand );
+
+        /* get length of line and its half */
+        lengthOfLSP = (short) keyLines[lineIDInScaleVec][lineIDInSameLine].numOfPixels;
+        halfWidth = ( lengthOfLSP - 1 ) / 2;
+
+        /* get middlepoint of line */
+        lineMiddlePointX = (float) ( 0.5 * ( pSingleLine->sPointInOctaveX + pSingleLine->ePointInOctaveX ) );
+        lineMiddlePointY = (float) ( 0.5 * ( pSingleLine->sPointInOctaveY + pSingleLine->ePointInOctaveY ) );
+
+        /*1.rotate the local coordinate system to the line direction (direction is the angle
+         between positive line direction and positive X axis)
+         *2.compute the gradient projection of pixels in line support region*/
+
+        /* get the vector representing original image reference system after rotation to aligh with
+         line's direction */
+        dL[0] = cos( pSingleLine->direction );
+        dL[1] = sin( pSingleLine->direction );
+
+        /* set the clockwise orthogonal vector of line direction */
+        dO[0] = -dL[1];
+        dO[1] = dL[0];
+
+        /* get rotated reference frame */
+        sCorX0 = -dL[0] * halfWidth + dL[1] * halfHeight + lineMiddlePointX;  //hID =0; wID = 0;
+        sCorY0 = -dL[1] * halfWidth - dL[0] * halfHeight + lineMiddlePointY;
+
+        /* BIAS::Matrix<float> gDLMat(heightOfLSP,lengthOfLSP) */
+        for ( short hID = 0; hID < heightOfLSP; hID++ )
         {
-          tempCor = (short) round( sCorX );
-          xCor = ( tempCor < 0 ) ? 0 : ( tempCor > imageWidth ) ? imageWidth : tempCor;
-          tempCor = (short) round( sCorY );
-          yCor = ( tempCor < 0 ) ? 0 : ( tempCor > imageHeight ) ? imageHeight : tempCor;
-
-          /* To achieve rotation invariance, each simple gradient is rotated aligned with
-           * the line direction and clockwise orthogonal direction.*/
-          dx = pdxImg[yCor * realWidth + xCor];
-          dy = pdyImg[yCor * realWidth + xCor];
-          gDL = dx * dL[0] + dy * dL[1];
-          gDO = dx * dO[0] + dy * dO[1];
-          if( gDL > 0 )
-          {
-            pgdLRowSum += gDL;
-          }
-          else
-          {
-            ngdLRowSum -= gDL;
-          }
-          if( gDO > 0 )
-          {
-            pgdORowSum += gDO;
-          }
-          else
+          /*initialization */
+          sCorX = sCorX0;
+          sCorY = sCorY0;
+
+          pgdLRowSum = 0;
+          ngdLRowSum = 0;
+          pgdORowSum = 0;
+          ngdORowSum = 0;
+
+          for ( short wID = 0; wID < lengthOfLSP; wID++ )
           {
-            ngdORowSum -= gDO;
+            tempCor = (short) round( sCorX );
+            xCor = ( tempCor < 0 ) ? 0 : ( tempCor > imageWidth ) ? imageWidth : tempCor;
+            tempCor = (short) round( sCorY );
+            yCor = ( tempCor < 0 ) ? 0 : ( tempCor > imageHeight ) ? imageHeight : tempCor;
+
+            /* To achieve rotation invariance, each simple gradient is rotated aligned with
+             * the line direction and clockwise orthogonal direction.*/
+            dx = pdxImg[yCor * realWidth + xCor];
+            dy = pdyImg[yCor * realWidth + xCor];
+            gDL = dx * dL[0] + dy * dL[1];
+            gDO = dx * dO[0] + dy * dO[1];
+            if( gDL > 0 )
+            {
+              pgdLRowSum += gDL;
+            }
+            else
+            {
+              ngdLRowSum -= gDL;
+            }
+            if( gDO > 0 )
+            {
+              pgdORowSum += gDO;
+            }
+            else
+            {
+              ngdORowSum -= gDO;
+            }
+            sCorX += dL[0];
+            sCorY += dL[1];
+            /* gDLMat[hID][wID] = gDL; */
           }
-          sCorX += dL[0];
-          sCorY += dL[1];
-          /* gDLMat[hID][wID] = gDL; */
-        }
-        sCorX0 -= dL[1];
-        sCorY0 += dL[0];
-        coefInGaussion = (float) gaussCoefG_[hID];
-        pgdLRowSum = coefInGaussion * pgdLRowSum;
-        ngdLRowSum = coefInGaussion * ngdLRowSum;
-        pgdL2RowSum = pgdLRowSum * pgdLRowSum;
-        ngdL2RowSum = ngdLRowSum * ngdLRowSum;
-        pgdORowSum = coefInGaussion * pgdORowSum;
-        ngdORowSum = coefInGaussion * ngdORowSum;
-        pgdO2RowSum = pgdORowSum * pgdORowSum;
-        ngdO2RowSum = ngdORowSum * ngdORowSum;
-
-        /* compute {g_dL |g_dL>0 }, {g_dL |g_dL<0 },
-         {g_dO |g_dO>0 }, {g_dO |g_dO<0 } of each band in the line support region
-         first, current row belong to current band */
-        bandID = (short) ( hID / params.widthOfBand_ );
-        coefInGaussion = (float) ( gaussCoefL_[hID % params.widthOfBand_ + params.widthOfBand_] );
-        pgdLBandSum[bandID] += coefInGaussion * pgdLRowSum;
-        ngdLBandSum[bandID] += coefInGaussion * ngdLRowSum;
-        pgdL2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdL2RowSum;
-        ngdL2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdL2RowSum;
-        pgdOBandSum[bandID] += coefInGaussion * pgdORowSum;
-        ngdOBandSum[bandID] += coefInGaussion * ngdORowSum;
-        pgdO2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdO2RowSum;
-        ngdO2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdO2RowSum;
-
-        /* In order to reduce boundary effect along the line gradient direction,
-         * a row's gradient will contribute not only to its current band, but also
-         * to its nearest upper and down band with gaussCoefL_.*/
-        bandID--;
-        if( bandID >= 0 )
-        {/* the band above the current band */
-          coefInGaussion = (float) ( gaussCoefL_[hID % params.widthOfBand_ + 2 * params.widthOfBand_] );
-          pgdLBandSum[bandID] += coefInGaussion * pgdLRowSum;
-          ngdLBandSum[bandID] += coefInGaussion * ngdLRowSum;
-          pgdL2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdL2RowSum;
-          ngdL2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdL2RowSum;
-          pgdOBandSum[bandID] += coefInGaussion * pgdORowSum;
-          ngdOBandSum[bandID] += coefInGaussion * ngdORowSum;
-          pgdO2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdO2RowSum;
-          ngdO2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdO2RowSum;
-        }
-        bandID = bandID + 2;
-        if( bandID < NUM_OF_BANDS )
-        {/*the band below the current band */
-          coefInGaussion = (float) ( gaussCoefL_[hID % params.widthOfBand_] );
+          sCorX0 -= dL[1];
+          sCorY0 += dL[0];
+          coefInGaussion = (float) gaussCoefG_[hID];
+          pgdLRowSum = coefInGaussion * pgdLRowSum;
+          ngdLRowSum = coefInGaussion * ngdLRowSum;
+          pgdL2RowSum = pgdLRowSum * pgdLRowSum;
+          ngdL2RowSum = ngdLRowSum * ngdLRowSum;
+          pgdORowSum = coefInGaussion * pgdORowSum;
+          ngdORowSum = coefInGaussion * ngdORowSum;
+          pgdO2RowSum = pgdORowSum * pgdORowSum;
+          ngdO2RowSum = ngdORowSum * ngdORowSum;
+
+          /* compute {g_dL |g_dL>0 }, {g_dL |g_dL<0 },
+           {g_dO |g_dO>0 }, {g_dO |g_dO<0 } of each band in the line support region
+           first, current row belong to current band */
+          bandID = (short) ( hID / params.widthOfBand_ );
+          coefInGaussion = (float) ( gaussCoefL_[hID % params.widthOfBand_ + params.widthOfBand_] );
           pgdLBandSum[bandID] += coefInGaussion * pgdLRowSum;
           ngdLBandSum[bandID] += coefInGaussion * ngdLRowSum;
           pgdL2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdL2RowSum;
@@ -1239,124 +1224,143 @@ int BinaryDescriptor::computeLBD( ScaleLines &keyLines, bool useDetectionData )
           ngdOBandSum[bandID] += coefInGaussion * ngdORowSum;
           pgdO2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdO2RowSum;
           ngdO2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdO2RowSum;
+
+          /* In order to reduce boundary effect along the line gradient direction,
+           * a row's gradient will contribute not only to its current band, but also
+           * to its nearest upper and down band with gaussCoefL_.*/
+          bandID--;
+          if( bandID >= 0 )
+          {/* the band above the current band */
+            coefInGaussion = (float) ( gaussCoefL_[hID % params.widthOfBand_ + 2 * params.widthOfBand_] );
+            pgdLBandSum[bandID] += coefInGaussion * pgdLRowSum;
+            ngdLBandSum[bandID] += coefInGaussion * ngdLRowSum;
+            pgdL2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdL2RowSum;
+            ngdL2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdL2RowSum;
+            pgdOBandSum[bandID] += coefInGaussion * pgdORowSum;
+            ngdOBandSum[bandID] += coefInGaussion * ngdORowSum;
+            pgdO2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdO2RowSum;
+            ngdO2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdO2RowSum;
+          }
+          bandID = bandID + 2;
+          if( bandID < NUM_OF_BANDS )
+          {/*the band below the current band */
+            coefInGaussion = (float) ( gaussCoefL_[hID % params.widthOfBand_] );
+            pgdLBandSum[bandID] += coefInGaussion * pgdLRowSum;
+            ngdLBandSum[bandID] += coefInGaussion * ngdLRowSum;
+            pgdL2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdL2RowSum;
+            ngdL2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdL2RowSum;
+            pgdOBandSum[bandID] += coefInGaussion * pgdORowSum;
+            ngdOBandSum[bandID] += coefInGaussion * ngdORowSum;
+            pgdO2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdO2RowSum;
+            ngdO2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdO2RowSum;
+          }
         }
-      }
-      /* gDLMat.Save("gDLMat.txt");
-       return 0; */
+        /* gDLMat.Save("gDLMat.txt");
+         return 0; */
 
-      /* construct line descriptor */
-      pSingleLine->descriptor.resize( descriptor_size );
-      desVec = &pSingleLine->descriptor.front();
+        /* construct line descriptor */
+        pSingleLine->descriptor.resize( descriptor_size );
+        desVec = &pSingleLine->descriptor.front();
 
-      short desID;
+        short desID;
 
-      /*Note that the first and last bands only have (lengthOfLSP * widthOfBand_ * 2.0) pixels
-       * which are counted. */
-      float invN2 = (float) ( 1.0 / ( params.widthOfBand_ * 2.0 ) );
-      float invN3 = (float) ( 1.0 / ( params.widthOfBand_ * 3.0 ) );
-      float invN, temp;
-      for ( bandID = 0; bandID < NUM_OF_BANDS; bandID++ )
-      {
-        if( bandID == 0 || bandID == NUM_OF_BANDS - 1 )
+        /*Note that the first and last bands only have (lengthOfLSP * widthOfBand_ * 2.0) pixels
+         * which are counted. */
+        float invN2 = (float) ( 1.0 / ( params.widthOfBand_ * 2.0 ) );
+        float invN3 = (float) ( 1.0 / ( params.widthOfBand_ * 3.0 ) );
+        float invN, temp;
+        for ( bandID = 0; bandID < NUM_OF_BANDS; bandID++ )
         {
-          invN = invN2;
+          if( bandID == 0 || bandID == NUM_OF_BANDS - 1 )
+          {
+            invN = invN2;
+          }
+          else
+          {
+            invN = invN3;
+          }
+          desID = bandID * 8;
+          temp = pgdLBandSum[bandID] * invN;
+          desVec[desID] = temp;/* mean value of pgdL; */
+          desVec[desID + 4] = sqrt( pgdL2BandSum[bandID] * invN - temp * temp );  //std value of pgdL;
+          temp = ngdLBandSum[bandID] * invN;
+          desVec[desID + 1] = temp;  //mean value of ngdL;
+          desVec[desID + 5] = sqrt( ngdL2BandSum[bandID] * invN - temp * temp );  //std value of ngdL;
+
+          temp = pgdOBandSum[bandID] * invN;
+          desVec[desID + 2] = temp;  //mean value of pgdO;
+          desVec[desID + 6] = sqrt( pgdO2BandSum[bandID] * invN - temp * temp );  //std value of pgdO;
+          temp = ngdOBandSum[bandID] * invN;
+          desVec[desID + 3] = temp;  //mean value of ngdO;
+          desVec[desID + 7] = sqrt( ngdO2BandSum[bandID] * invN - temp * temp );  //std value of ngdO;
         }
-        else
+
+        // normalize;
+        float tempM, tempS;
+        tempM = 0;
+        tempS = 0;
+        desVec = &pSingleLine->descriptor.front();
+
+        int base = 0;
+        for ( short i = 0; i < (short) ( NUM_OF_BANDS * 8 ); ++base, i = (short) ( base * 8 ) )
         {
-          invN = invN3;
+          tempM += * ( desVec + i ) * * ( desVec + i );  //desVec[8*i+0] * desVec[8*i+0];
+          tempM += * ( desVec + i + 1 ) * * ( desVec + i + 1 );  //desVec[8*i+1] * desVec[8*i+1];
+          tempM += * ( desVec + i + 2 ) * * ( desVec + i + 2 );  //desVec[8*i+2] * desVec[8*i+2];
+          tempM += * ( desVec + i + 3 ) * * ( desVec + i + 3 );  //desVec[8*i+3] * desVec[8*i+3];
+          tempS += * ( desVec + i + 4 ) * * ( desVec + i + 4 );  //desVec[8*i+4] * desVec[8*i+4];
+          tempS += * ( desVec + i + 5 ) * * ( desVec + i + 5 );  //desVec[8*i+5] * desVec[8*i+5];
+          tempS += * ( desVec + i + 6 ) * * ( desVec + i + 6 );  //desVec[8*i+6] * desVec[8*i+6];
+          tempS += * ( desVec + i + 7 ) * * ( desVec + i + 7 );  //desVec[8*i+7] * desVec[8*i+7];
         }
-        desID = bandID * 8;
-        temp = pgdLBandSum[bandID] * invN;
-        desVec[desID] = temp;/* mean value of pgdL; */
-        desVec[desID + 4] = sqrt( pgdL2BandSum[bandID] * invN - temp * temp );  //std value of pgdL;
-        temp = ngdLBandSum[bandID] * invN;
-        desVec[desID + 1] = temp;  //mean value of ngdL;
-        desVec[desID + 5] = sqrt( ngdL2BandSum[bandID] * invN - temp * temp );  //std value of ngdL;
-
-        temp = pgdOBandSum[bandID] * invN;
-        desVec[desID + 2] = temp;  //mean value of pgdO;
-        desVec[desID + 6] = sqrt( pgdO2BandSum[bandID] * invN - temp * temp );  //std value of pgdO;
-        temp = ngdOBandSum[bandID] * invN;
-        desVec[desID + 3] = temp;  //mean value of ngdO;
-        desVec[desID + 7] = sqrt( ngdO2BandSum[bandID] * invN - temp * temp );  //std value of ngdO;
-      }
-
-      // normalize;
-      float tempM, tempS;
-      tempM = 0;
-      tempS = 0;
-      desVec = &pSingleLine->descriptor.front();
 
-      int base = 0;
-      for ( short i = 0; i < (short) ( NUM_OF_BANDS * 8 ); ++base, i = (short) ( base * 8 ) )
-      {
-        tempM += * ( desVec + i ) * * ( desVec + i );  //desVec[8*i+0] * desVec[8*i+0];
-        tempM += * ( desVec + i + 1 ) * * ( desVec + i + 1 );  //desVec[8*i+1] * desVec[8*i+1];
-        tempM += * ( desVec + i + 2 ) * * ( desVec + i + 2 );  //desVec[8*i+2] * desVec[8*i+2];
-        tempM += * ( desVec + i + 3 ) * * ( desVec + i + 3 );  //desVec[8*i+3] * desVec[8*i+3];
-        tempS += * ( desVec + i + 4 ) * * ( desVec + i + 4 );  //desVec[8*i+4] * desVec[8*i+4];
-        tempS += * ( desVec + i + 5 ) * * ( desVec + i + 5 );  //desVec[8*i+5] * desVec[8*i+5];
-        tempS += * ( desVec + i + 6 ) * * ( desVec + i + 6 );  //desVec[8*i+6] * desVec[8*i+6];
-        tempS += * ( desVec + i + 7 ) * * ( desVec + i + 7 );  //desVec[8*i+7] * desVec[8*i+7];
-      }
+        tempM = 1 / sqrt( tempM );
+        tempS = 1 / sqrt( tempS );
+        desVec = &pSingleLine->descriptor.front();
+        base = 0;
+        for ( short i = 0; i < (short) ( NUM_OF_BANDS * 8 ); ++base, i = (short) ( base * 8 ) )
+        {
+          * ( desVec + i ) = * ( desVec + i ) * tempM;  //desVec[8*i] =  desVec[8*i] * tempM;
+          * ( desVec + 1 + i ) = * ( desVec + 1 + i ) * tempM;  //desVec[8*i+1] =  desVec[8*i+1] * tempM;
+          * ( desVec + 2 + i ) = * ( desVec + 2 + i ) * tempM;  //desVec[8*i+2] =  desVec[8*i+2] * tempM;
+          * ( desVec + 3 + i ) = * ( desVec + 3 + i ) * tempM;  //desVec[8*i+3] =  desVec[8*i+3] * tempM;
+          * ( desVec + 4 + i ) = * ( desVec + 4 + i ) * tempS;  //desVec[8*i+4] =  desVec[8*i+4] * tempS;
+          * ( desVec + 5 + i ) = * ( desVec + 5 + i ) * tempS;  //desVec[8*i+5] =  desVec[8*i+5] * tempS;
+          * ( desVec + 6 + i ) = * ( desVec + 6 + i ) * tempS;  //desVec[8*i+6] =  desVec[8*i+6] * tempS;
+          * ( desVec + 7 + i ) = * ( desVec + 7 + i ) * tempS;  //desVec[8*i+7] =  desVec[8*i+7] * tempS;
+        }
 
-      tempM = 1 / sqrt( tempM );
-      tempS = 1 / sqrt( tempS );
-      desVec = &pSingleLine->descriptor.front();
-      base = 0;
-      for ( short i = 0; i < (short) ( NUM_OF_BANDS * 8 ); ++base, i = (short) ( base * 8 ) )
-      {
-        * ( desVec + i ) = * ( desVec + i ) * tempM;  //desVec[8*i] =  desVec[8*i] * tempM;
-        * ( desVec + 1 + i ) = * ( desVec + 1 + i ) * tempM;  //desVec[8*i+1] =  desVec[8*i+1] * tempM;
-        * ( desVec + 2 + i ) = * ( desVec + 2 + i ) * tempM;  //desVec[8*i+2] =  desVec[8*i+2] * tempM;
-        * ( desVec + 3 + i ) = * ( desVec + 3 + i ) * tempM;  //desVec[8*i+3] =  desVec[8*i+3] * tempM;
-        * ( desVec + 4 + i ) = * ( desVec + 4 + i ) * tempS;  //desVec[8*i+4] =  desVec[8*i+4] * tempS;
-        * ( desVec + 5 + i ) = * ( desVec + 5 + i ) * tempS;  //desVec[8*i+5] =  desVec[8*i+5] * tempS;
-        * ( desVec + 6 + i ) = * ( desVec + 6 + i ) * tempS;  //desVec[8*i+6] =  desVec[8*i+6] * tempS;
-        * ( desVec + 7 + i ) = * ( desVec + 7 + i ) * tempS;  //desVec[8*i+7] =  desVec[8*i+7] * tempS;
-      }
+        /* In order to reduce the influence of non-linear illumination,
+         * a threshold is used to limit the value of element in the unit feature
+         * vector no larger than this threshold. In Z.Wang's work, a value of 0.4 is found
+         * empirically to be a proper threshold.*/
+        desVec = &pSingleLine->descriptor.front();
+        for ( short i = 0; i < descriptor_size; i++ )
+        {
+          if( desVec[i] > 0.4 )
+          {
+            desVec[i] = (float) 0.4;
+          }
+        }
 
-      /* In order to reduce the influence of non-linear illumination,
-       * a threshold is used to limit the value of element in the unit feature
-       * vector no larger than this threshold. In Z.Wang's work, a value of 0.4 is found
-       * empirically to be a proper threshold.*/
-      desVec = &pSingleLine->descriptor.front();
-      for ( short i = 0; i < descriptor_size; i++ )
-      {
-        if( desVec[i] > 0.4 )
+        //re-normalize desVec;
+        temp = 0;
+        for ( short i = 0; i < descriptor_size; i++ )
         {
-          desVec[i] = (float) 0.4;
+          temp += desVec[i] * desVec[i];
         }
-      }
 
-      //re-normalize desVec;
-      temp = 0;
-      for ( short i = 0; i < descriptor_size; i++ )
-      {
-        temp += desVec[i] * desVec[i];
-      }
+        temp = 1 / sqrt( temp );
+        for ( short i = 0; i < descriptor_size; i++ )
+        {
+          desVec[i] = desVec[i] * temp;
+        }
+      }/* end for(short lineIDInSameLine = 0; lineIDInSameLine<sameLineSize;
+       lineIDInSameLine++) */
 
-      temp = 1 / sqrt( temp );
-      for ( short i = 0; i < descriptor_size; i++ )
-      {
-        desVec[i] = desVec[i] * temp;
-      }
-    }/* end for(short lineIDInSameLine = 0; lineIDInSameLine<sameLineSize;
-     lineIDInSameLine++) */
-
-  }/* end for(short lineIDInScaleVec = 0;
-   lineIDInScaleVec<numOfFinalLine; lineIDInScaleVec++) */
-
-  delete[] dL;
-  delete[] dO;
-  delete[] pgdLBandSum;
-  delete[] ngdLBandSum;
-  delete[] pgdL2BandSum;
-  delete[] ngdL2BandSum;
-  delete[] pgdOBandSum;
-  delete[] ngdOBandSum;
-  delete[] pgdO2BandSum;
-  delete[] ngdO2BandSum;
+    }/* end for(short lineIDInScaleVec = 0;
+     lineIDInScaleVec<numOfFinalLine; lineIDInScaleVec++) */
+  } );
 
   return 1;
 
@@ -1430,6 +1434,104 @@ BinaryDescriptor::EDLineDetector::~EDLineDetector()
   }
 }
 
+/* Fused computation of the EDLine gradient images from Sobel derivatives: it produces the same
+ * results as thresholding |dx|+|dy| with THRESH_TOZERO, scaling by 1/4 (with rounding to nearest
+ * even) and comparing |dx| < |dy|, without any intermediate full-size matrix. */
+static void computeGradientAndDirection( const cv::Mat& dxImg, const cv::Mat& dyImg, int gradThresh, cv::Mat& gImg, cv::Mat& gImgWO,
+                                         cv::Mat& dirImg )
+{
+  const int rows = dxImg.rows, cols = dxImg.cols;
+  gImg.create( rows, cols, CV_16SC1 );
+  gImgWO.create( rows, cols, CV_16SC1 );
+  dirImg.create( rows, cols, CV_8UC1 );
+
+  parallel_for_( Range( 0, rows ), [&]( const Range& range )
+  {
+    for ( int y = range.start; y < range.end; y++ )
+    {
+      const short* pdx = dxImg.ptr<short>( y );
+      const short* pdy = dyImg.ptr<short>( y );
+      short* pg = gImg.ptr<short>( y );
+      short* pgWO = gImgWO.ptr<short>( y );
+      uchar* pdir = dirImg.ptr<uchar>( y );
+      int x = 0;
+#if CV_SIMD128
+      /* |dx|+|dy| of 3x3 Sobel derivatives of 8-bit images fits in 16 bits */
+      v_int16x8 v_thresh = v_setall_s16( (short) std::min( std::max( gradThresh, -32768 ), 32767 ) );
+      v_int16x8 v_one = v_setall_s16( 1 );
+      v_int16x8 v_zero = v_setzero_s16();
+      for ( ; x <= cols - 8; x += 8 )
+      {
+        v_int16x8 v_adx = v_reinterpret_as_s16( v_abs( v_load( pdx + x ) ) );
+        v_int16x8 v_ady = v_reinterpret_as_s16( v_abs( v_load( pdy + x ) ) );
+        v_int16x8 v_sum = v_adx + v_ady;
+        v_int16x8 v_quarter = v_shr<2>( v_sum + v_one + ( v_shr<2>( v_sum ) & v_one ) );
+        v_store( pgWO + x, v_quarter );
+        v_store( pg + x, v_select( v_sum > v_thresh, v_quarter, v_zero ) );
+        v_pack_store( pdir + x, v_reinterpret_as_u16( v_adx < v_ady ) );
+      }
+#endif
+      for ( ; x < cols; x++ )
+      {
+        int adx = std::abs( (int) pdx[x] );
+        int ady = std::abs( (int) pdy[x] );
+        int sum = adx + ady;
+        short quarter = (short) ( ( sum + 1 + ( ( sum >> 2 ) & 1 ) ) >> 2 );
+        pgWO[x] = quarter;
+        pg[x] = sum > gradThresh ? quarter : (short) 0;
+        pdir[x] = adx < ady ? (uchar) Horizontal : (uchar) Vertical;
+      }
+    }
+  } );
+}
+
+/* Marks with a non-zero value the pixels of gImg that are local maxima (by at least anchorThreshold)
+ * across the edge direction. Only rows visited by the anchor scan are computed. */
+static void computeAnchorMask( const cv::Mat& gImg, const cv::Mat& dirImg, int anchorThreshold, unsigned int scanIntervals, cv::Mat& anchorMask )
+{
+  const int rows = gImg.rows, cols = gImg.cols;
+  anchorMask.create( rows, cols, CV_8UC1 );
+  if( rows < 3 || cols < 3 )
+    return;
+
+  const int step = std::max( (int) scanIntervals, 1 );
+  const int numScanRows = ( rows - 3 ) / step + 1;
+  parallel_for_( Range( 0, numScanRows ), [&]( const Range& range )
+  {
+    for ( int r = range.start; r < range.end; r++ )
+    {
+      const int h = 1 + r * step;
+      const short* pUp = gImg.ptr<short>( h - 1 );
+      const short* pCur = gImg.ptr<short>( h );
+      const short* pDown = gImg.ptr<short>( h + 1 );
+      const uchar* pdir = dirImg.ptr<uchar>( h );
+      uchar* pmask = anchorMask.ptr<uchar>( h );
+      int w = 1;
+#if CV_SIMD128
+      v_int16x8 v_thresh = v_setall_s16( (short) anchorThreshold );
+      v_int16x8 v_horizontal = v_setall_s16( (short) Horizontal );
+      for ( ; w <= cols - 9; w += 8 )
+      {
+        v_int16x8 v_g = v_load( pCur + w );
+        v_int16x8 v_isHorizontal = v_reinterpret_as_s16( v_load_expand( pdir + w ) ) == v_horizontal;
+        v_int16x8 v_hMax = ( v_g >= v_load( pUp + w ) + v_thresh ) & ( v_g >= v_load( pDown + w ) + v_thresh );
+        v_int16x8 v_vMax = ( v_g >= v_load( pCur + w - 1 ) + v_thresh ) & ( v_g >= v_load( pCur + w + 1 ) + v_thresh );
+        v_pack_store( pmask + w, v_reinterpret_as_u16( v_select( v_isHorizontal, v_hMax, v_vMax ) ) );
+      }
+#endif
+      for ( ; w < cols - 1; w++ )
+      {
+        if( pdir[w] == Horizontal )
+          //if the direction of pixel is horizontal, then compare with up and down
+          pmask[w] = ( pCur[w] >= pUp[w] + anchorThreshold && pCur[w] >= pDown[w] + anchorThreshold ) ? 255 : 0;
+        else
+          //it is vertical edge, should be compared with left and right
+          pmask[w] = ( pCur[w] >= pCur[w - 1] + anchorThreshold && pCur[w] >= pCur[w + 1] + anchorThreshold ) ? 255 : 0;
+      }
+    }
+  } );
+}
+
 int BinaryDescriptor::EDLineDetector::EdgeDrawing( cv::Mat &image, EdgeChains &edgeChains )
 {
   imageWidth = image.cols;
@@ -1471,58 +1573,36 @@ int BinaryDescriptor::EDLineDetector::EdgeDrawing( cv::Mat &image, EdgeChains &e
   cv::Sobel( image, dxImg_, CV_16SC1, 1, 0, 3 );
   cv::Sobel( image, dyImg_, CV_16SC1, 0, 1, 3 );
 
-  //compute gradient and direction images
-  cv::Mat dxABS_m = cv::abs( dxImg_ );
-  cv::Mat dyABS_m = cv::abs( dyImg_ );
-  cv::Mat sumDxDy;
-  cv::add( dyABS_m, dxABS_m, sumDxDy );
-
-  cv::threshold( sumDxDy, gImg_, gradienThreshold_ + 1, 255, cv::THRESH_TOZERO );
-  gImg_ = gImg_ / 4;
-  gImgWO_ = sumDxDy / 4;
-  cv::compare( dxABS_m, dyABS_m, dirImg_, cv::CMP_LT );
+  //compute gradient and direction images in a single pass
+  computeGradientAndDirection( dxImg_, dyImg_, gradienThreshold_ + 1, gImg_, gImgWO_, dirImg_ );
 
   short *pgImg = gImg_.ptr<short>();
   unsigned char *pdirImg = dirImg_.ptr();
 
-  //extract the anchors in the gradient image, store into a vector
-  memset( pAnchorX_, 0, edgePixelArraySize * sizeof(unsigned int) );  //initialization
-  memset( pAnchorY_, 0, edgePixelArraySize * sizeof(unsigned int) );
+  //mark the anchors in the gradient image; edgeImage_ is used as scratch, it is cleared before linking
+  computeAnchorMask( gImg_, dirImg_, anchorThreshold_, scanIntervals_, edgeImage_ );
+
+  //collect the anchors into a vector, keeping the column-major scan order used for linking
   unsigned int anchorsSize = 0;
   int indexInArray;
   unsigned char gValue1, gValue2, gValue3;
+  const unsigned char *pAnchorMask = edgeImage_.ptr();
   for ( unsigned int w = 1; w < imageWidth - 1; w = w + scanIntervals_ )
   {
     for ( unsigned int h = 1; h < imageHeight - 1; h = h + scanIntervals_ )
     {
-      indexInArray = h * imageWidth + w;
-      //gValue1 = pdirImg[indexInArray];
-      if( pdirImg[indexInArray] == Horizontal )
-      {  //if the direction of pixel is horizontal, then compare with up and down
-         //gValue2 = pgImg[indexInArray];
-        if( pgImg[indexInArray] >= pgImg[indexInArray - imageWidth] + anchorThreshold_
-            && pgImg[indexInArray] >= pgImg[indexInArray + imageWidth] + anchorThreshold_ )
-        {       // (w,h) is accepted as an anchor
-          pAnchorX_[anchorsSize] = w;
-          pAnchorY_[anchorsSize++] = h;
-        }
-      }
-      else
-      {       // if(pdirImg[indexInArray]==Vertical){//it is vertical edge, should be compared with left and right
-        //gValue2 = pgImg[indexInArray];
-        if( pgImg[indexInArray] >= pgImg[indexInArray - 1] + anchorThreshold_ && pgImg[indexInArray] >= pgImg[indexInArray + 1] + anchorThreshold_ )
-        {       // (w,h) is accepted as an anchor
-          pAnchorX_[anchorsSize] = w;
-          pAnchorY_[anchorsSize++] = h;
+      if( pAnchorMask[h * imageWidth + w] )
+      {       // (w,h) is accepted as an anchor
+        if( anchorsSize >= edgePixelArraySize )
+        {
+          std::cout << "anchor size is larger than its maximal size. anchorsSize=" << anchorsSize + 1 << ", maximal size = " << edgePixelArraySize << std::endl;
+          return -1;
         }
+        pAnchorX_[anchorsSize] = w;
+        pAnchorY_[anchorsSize++] = h;
       }
     }
   }
-  if( anchorsSize > edgePixelArraySize )
-  {
-    std::cout << "anchor size is larger than its maximal size. anchorsSize=" << anchorsSize << ", maximal size = " << edgePixelArraySize << std::endl;
-    return -1;
-  }
 
   //link the anchors by smart routing
   edgeImage_.setTo( 0 );
@@ -64,6 +64,8 @@ Functions reading and writing .flo files in "Middlebury" format, see: <http://vi
 - cv::optflow::readOpticalFlow
 - cv::optflow::writeOpticalFlow
 
+Long flow sequences can be kept in a single memory-mapped file with cv::optflow::OpticalFlowSequence.
+
  */
 
 #include "opencv2/optflow/pcaflow.hpp"
@@ -157,6 +159,76 @@ to the flow in the horizontal direction (u), second - vertical (v).
  */
 CV_EXPORTS_W bool writeOpticalFlow( const String& path, InputArray flow );
 
+/** @brief Container storing a sequence of equally sized flow fields in a single binary file
+
+Frames are appended at the end of the file and can be read back in any order by their index. On
+platforms supporting memory mapping the file is mapped, so getFrame() returns a matrix header pointing
+directly into the mapped file without copying.
+
+Flow fields can be stored as 32-bit floats, as 16-bit floats or quantized into 16-bit integers with
+a fixed step (the stored value is round(flow / step)). The flows produced by DenseOpticalFlow::calc()
+and calcOpticalFlowSparseToDense() can be passed to append() as they are, and read() always returns
+a CV_32FC2 flow that can be used, for instance, as an initial flow of the next DenseOpticalFlow call.
+
+Frames are stored in the byte order of the machine that wrote them, which is recorded in the header;
+open() rejects files written with the other byte order.
+ */
+class CV_EXPORTS_W OpticalFlowSequence
+{
+public:
+    enum StorageType
+    {
+        STORAGE_FLOAT32 = 0, //!< CV_32FC2 frames, lossless
+        STORAGE_FLOAT16 = 1, //!< CV_16FC2 frames
+        STORAGE_INT16   = 2  //!< CV_16SC2 frames quantized with a fixed step
+    };
+
+    virtual ~OpticalFlowSequence();
+
+    /** @brief Creates a new empty sequence file, an existing file is overwritten
+
+    @param path Path to the file to be created
+    @param frameSize Size of every flow field in the sequence
+    @param storage One of OpticalFlowSequence::StorageType
+    @param quantStep Quantization step in pixels, only used by STORAGE_INT16
+     */
+    CV_WRAP static Ptr<OpticalFlowSequence> create( const String& path, Size frameSize,
+                                                    int storage = OpticalFlowSequence::STORAGE_FLOAT32,
+                                                    float quantStep = 1.f / 64 );
+
+    /** @brief Opens an existing sequence file, returns an empty pointer if it cannot be read
+
+    @param path Path to the file to be opened
+    @param writable Whether new frames can be appended to the sequence
+     */
+    CV_WRAP static Ptr<OpticalFlowSequence> open( const String& path, bool writable = false );
+
+    /** @brief Appends a flow field to the end of the sequence
+
+    The flow must be a CV_32FC2 matrix of the sequence frame size. Returns true on success. With
+    STORAGE_INT16 an exception is thrown when the flow has NaNs or values that do not fit into 16 bits
+    once divided by the quantization step, instead of clipping them.
+     */
+    CV_WRAP virtual bool append( InputArray flow ) = 0;
+
+    /** @brief Reads the frame with the given index and converts it to CV_32FC2 */
+    CV_WRAP virtual void read( int index, OutputArray flow ) const = 0;
+
+    /** @brief Returns the frame with the given index in its storage type
+
+    When the file is memory mapped the returned matrix references the read-only mapped file and stays
+    valid as long as the sequence object exists, otherwise a copy is returned.
+     */
+    CV_WRAP virtual Mat getFrame( int index ) const = 0;
+
+    /** @brief Number of frames in the sequence */
+    CV_WRAP virtual int getFramesCount() const = 0;
+    CV_WRAP virtual Size getFrameSize() const = 0;
+    /** @see OpticalFlowSequence::StorageType */
+    CV_WRAP virtual int getStorageType() const = 0;
+    CV_WRAP virtual float getQuantStep() const = 0;
+};
+
 /** @brief Variational optical flow refinement
 
 This class implements variational refinement of the input flow field, i.e.
@@ -252,6 +324,18 @@ CV_EXPORTS_W Ptr<DenseOpticalFlow> createOptFlow_Farneback();
 //! Additional interface to the SparseToDenseFlow algorithm - calcOpticalFlowSparseToDense()
 CV_EXPORTS_W Ptr<DenseOpticalFlow> createOptFlow_SparseToDense();
 
+/** @brief Computes dense optical flow for every pair of consecutive frames of a sequence.
+
+@param algo the algorithm to use. Instances created by createOptFlow_DeepFlow and OpticalFlowPCAFlow
+process the frame pairs in parallel and preprocess every frame (smoothed pyramid for DeepFlow,
+gray conversion and CLAHE for PCAFlow) only once. Other algorithms process the pairs one by one
+with DenseOpticalFlow::calc.
+@param frames input frames of the same size and type.
+@param flows output flow fields of type CV_32FC2, flows[i] is the flow from frames[i] to frames[i + 1].
+ */
+CV_EXPORTS_W void calcOpticalFlowSequence( const Ptr<DenseOpticalFlow>& algo, InputArrayOfArrays frames,
+                                           OutputArrayOfArrays flows );
+
 /** @brief DIS optical flow algorithm.
 
 This class implements the Dense Inverse Search (DIS) optical flow algorithm. More
@@ -346,6 +430,24 @@ public:
     CV_WRAP virtual bool getUseSpatialPropagation() const = 0;
     /** @copybrief getUseSpatialPropagation @see getUseSpatialPropagation */
     CV_WRAP virtual void setUseSpatialPropagation(bool val) = 0;
+
+    /** @brief Computes the flow between the frame passed to the previous call of this method and @p frame.
+
+    This is a streaming variant of @ref calc for consecutive video frames. The Gaussian pyramid built for
+    a frame is kept and reused when the frame becomes the first image of the next pair, and the flow of the
+    previous pair is used as the initial approximation (temporal propagation). The first call of a sequence
+    only stores the frame and returns a zero flow field. A new sequence is started when the frame size
+    changes, as well as after @ref resetStream or @ref collectGarbage.
+
+    @param frame next 8-bit single-channel frame of the sequence
+    @param flow computed flow image between the previous frame and @p frame, it has the same size as
+    @p frame and type CV_32FC2
+    @note This method always runs on the CPU.
+    @see resetStream */
+    CV_WRAP virtual void calcNext(InputArray frame, OutputArray flow) = 0;
+
+    /** @brief Drops the frame and the flow kept by @ref calcNext, the next call starts a new sequence. */
+    CV_WRAP virtual void resetStream() = 0;
 };
 
 /** @brief Creates an instance of DISOpticalFlow
@@ -120,7 +120,16 @@ public:
   void calc( InputArray I0, InputArray I1, InputOutputArray flow ) CV_OVERRIDE;
   void collectGarbage() CV_OVERRIDE;
 
+  /** @brief Computes the flow for every pair of consecutive frames of a sequence.
+   * Each frame is converted and equalized only once and the pairs are processed in parallel.
+   * @param frames Input frames of the same size.
+   * @param flows Output flow fields, flows[i] is the flow from frames[i] to frames[i + 1].
+   */
+  void calcSequence( InputArrayOfArrays frames, OutputArrayOfArrays flows );
+
 private:
+  void calcPrepared( UMat &from, UMat &to, const Mat &fromOrig, Mat &flow );
+
   void findSparseFeatures( UMat &from, UMat &to, std::vector<Point2f> &features,
                            std::vector<Point2f> &predictedFeatures ) const;
 
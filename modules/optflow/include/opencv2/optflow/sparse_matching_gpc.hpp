@@ -168,9 +168,13 @@ private:
   typedef GPCSamplesVector::iterator SIter;
 
   std::vector< Node > nodes;
+  std::vector< Node > flatNodes;       //!< Reachable nodes in breadth-first order, children refer to this array
+  std::vector< unsigned > flatNodeIds; //!< Index in nodes of every element of flatNodes
   GPCTrainingParams params;
 
-  bool trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth );
+  void trainWithSeed( GPCTrainingSamples &samples, const GPCTrainingParams &params, uint64 seed );
+
+  void flatten();
 
 public:
   void train( GPCTrainingSamples &samples, const GPCTrainingParams params = GPCTrainingParams() );
@@ -188,6 +192,17 @@ public:
   int getDescriptorType() const { return params.descriptorType; }
 };
 
+class CV_EXPORTS_W GPCDetails
+{
+public:
+  static void dropOutliers( std::vector< std::pair< Point2i, Point2i > > &corr );
+
+  static void getAllDescriptorsForImage( const Mat *imgCh, std::vector< GPCPatchDescriptor > &descr, const GPCMatchingParams &mp,
+                                         int type );
+
+  static void getCoordinatesFromIndex( size_t index, Size sz, int &x, int &y );
+};
+
 template < int T > class GPCForest : public Algorithm
 {
 private:
@@ -198,12 +213,61 @@ private:
 
     bool operator==( const Trail &trail ) const { return memcmp( leaf, trail.leaf, sizeof( leaf ) ) == 0; }
 
-    bool operator<( const Trail &trail ) const
+    size_t hash() const
+    {
+      uint64 h = 14695981039346656037ULL;
+      for ( int i = 0; i < T; ++i )
+        h = ( h ^ leaf[i] ) * 1099511628211ULL;
+      return size_t( h ^ ( h >> 32 ) );
+    }
+  };
+
+  /** Open addressing hash table of trails. Every slot keeps the index of the first trail with a given value and
+   * whether this value occurred more than once.
+   */
+  class TrailIndex
+  {
+  private:
+    const std::vector< Trail > &trails;
+    std::vector< int > first;
+    std::vector< uchar > repeated;
+    size_t mask;
+
+    TrailIndex &operator=( const TrailIndex & );
+
+  public:
+    TrailIndex( const std::vector< Trail > &_trails ) : trails( _trails )
+    {
+      size_t capacity = 16;
+      while ( capacity < trails.size() * 2 )
+        capacity *= 2;
+      first.assign( capacity, -1 );
+      repeated.assign( capacity, 0 );
+      mask = capacity - 1;
+      for ( size_t i = 0; i < trails.size(); ++i )
+      {
+        size_t slot = find( trails[i] );
+        if ( first[slot] < 0 )
+          first[slot] = (int)i;
+        else
+          repeated[slot] = 1;
+      }
+    }
+
+    //! Slot that keeps the given trail or the empty slot where it has to be inserted.
+    size_t find( const Trail &trail ) const
     {
-      for ( int i = 0; i < T - 1; ++i )
-        if ( leaf[i] != trail.leaf[i] )
-          return leaf[i] < trail.leaf[i];
-      return leaf[T - 1] < trail.leaf[T - 1];
+      size_t slot = trail.hash() & mask;
+      while ( first[slot] >= 0 && !( trails[first[slot]] == trail ) )
+        slot = ( slot + 1 ) & mask;
+      return slot;
+    }
+
+    //! Index of the only trail equal to the given one, or -1 if there are none or several of them.
+    int findUnique( const Trail &trail ) const
+    {
+      const size_t slot = find( trail );
+      return repeated[slot] ? -1 : first[slot];
     }
   };
 
@@ -222,9 +286,9 @@ private:
 
     void operator()( const Range &range ) const CV_OVERRIDE
     {
-      for ( int t = range.start; t < range.end; ++t )
-        for ( size_t i = 0; i < descr->size(); ++i )
-          trails->at( i ).leaf[t] = forest->tree[t].findLeafForPatch( descr->at( i ) );
+      for ( int i = range.start; i < range.end; ++i )
+        for ( int t = 0; t < T; ++t )
+          ( *trails )[i].leaf[t] = forest->tree[t].findLeafForPatch( ( *descr )[i] );
     }
   };
 
@@ -236,6 +300,7 @@ public:
    */
   void train( GPCTrainingSamples &samples, const GPCTrainingParams params = GPCTrainingParams() )
   {
+    // The trees are trained one after another, each of them runs its nodes and samples in parallel
     for ( int i = 0; i < T; ++i )
       tree[i].train( samples, params );
   }
@@ -298,17 +363,6 @@ public:
   static Ptr< GPCForest > create() { return makePtr< GPCForest >(); }
 };
 
-class CV_EXPORTS_W GPCDetails
-{
-public:
-  static void dropOutliers( std::vector< std::pair< Point2i, Point2i > > &corr );
-
-  static void getAllDescriptorsForImage( const Mat *imgCh, std::vector< GPCPatchDescriptor > &descr, const GPCMatchingParams &mp,
-                                         int type );
-
-  static void getCoordinatesFromIndex( size_t index, Size sz, int &x, int &y );
-};
-
 template < int T >
 void GPCForest< T >::findCorrespondences( InputArray imgFrom, InputArray imgTo, std::vector< std::pair< Point2i, Point2i > > &corr,
                                           const GPCMatchingParams params ) const
@@ -332,29 +386,25 @@ void GPCForest< T >::findCorrespondences( InputArray imgFrom, InputArray imgTo,
 
   for ( size_t i = 0; i < descr.size(); ++i )
     GPCDetails::getCoordinatesFromIndex( i, from.size(), trailsFrom[i].coord.x, trailsFrom[i].coord.y );
-  parallel_for_( Range( 0, T ), ParallelTrailsFilling( this, &descr, &trailsFrom ) );
+  parallel_for_( Range( 0, (int)descr.size() ), ParallelTrailsFilling( this, &descr, &trailsFrom ) );
 
   descr.clear();
   GPCDetails::getAllDescriptorsForImage( toCh, descr, params, tree[0].getDescriptorType() );
 
   for ( size_t i = 0; i < descr.size(); ++i )
     GPCDetails::getCoordinatesFromIndex( i, to.size(), trailsTo[i].coord.x, trailsTo[i].coord.y );
-  parallel_for_( Range( 0, T ), ParallelTrailsFilling( this, &descr, &trailsTo ) );
-
-  std::sort( trailsFrom.begin(), trailsFrom.end() );
-  std::sort( trailsTo.begin(), trailsTo.end() );
+  parallel_for_( Range( 0, (int)descr.size() ), ParallelTrailsFilling( this, &descr, &trailsTo ) );
+  std::vector< GPCPatchDescriptor >().swap( descr );
 
+  // A pair of patches is a correspondence if their trail is unique in both images
+  const TrailIndex indexFrom( trailsFrom ), indexTo( trailsTo );
   for ( size_t i = 0; i < trailsFrom.size(); ++i )
   {
-    bool uniq = true;
-    while ( i + 1 < trailsFrom.size() && trailsFrom[i] == trailsFrom[i + 1] )
-      ++i, uniq = false;
-    if ( uniq )
-    {
-      typename std::vector< Trail >::const_iterator lb = std::lower_bound( trailsTo.begin(), trailsTo.end(), trailsFrom[i] );
-      if ( lb != trailsTo.end() && *lb == trailsFrom[i] && ( ( lb + 1 ) == trailsTo.end() || !( *lb == *( lb + 1 ) ) ) )
-        corr.push_back( std::make_pair( trailsFrom[i].coord, lb->coord ) );
-    }
+    if ( indexFrom.findUnique( trailsFrom[i] ) != (int)i )
+      continue;
+    const int j = indexTo.findUnique( trailsFrom[i] );
+    if ( j >= 0 )
+      corr.push_back( std::make_pair( trailsFrom[i].coord, trailsTo[j].coord ) );
   }
 
   GPCDetails::dropOutliers( corr );
@@ -29,4 +29,26 @@ PERF_TEST_P(DenseOpticalFlow_DeepFlow, perf, Values(szVGA, sz720p))
     SANITY_CHECK_NOTHING();
 }
 
+PERF_TEST_P(DenseOpticalFlow_DeepFlow, sequence, Values(szVGA, sz720p))
+{
+    DFParams params = GetParam();
+    Size sz = get<0>(params);
+
+    vector<Mat> frames(5);
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        frames[i].create(sz, CV_8U);
+        randu(frames[i], 0, 255);
+    }
+    vector<Mat> flows;
+
+    TEST_CYCLE_N(1)
+    {
+        Ptr<DenseOpticalFlow> algo = createOptFlow_DeepFlow();
+        calcOpticalFlowSequence(algo, frames, flows);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
@@ -41,6 +41,42 @@ PERF_TEST_P(DenseOpticalFlow_DIS, perf,
     SANITY_CHECK_NOTHING();
 }
 
+PERF_TEST_P(DenseOpticalFlow_DIS, stream,
+            Combine(Values("PRESET_ULTRAFAST", "PRESET_FAST", "PRESET_MEDIUM"), Values(szVGA, sz720p, sz1080p)))
+{
+    DISParams params = GetParam();
+
+    String preset_string = get<0>(params);
+    int preset = DISOpticalFlow::PRESET_FAST;
+    if (preset_string == "PRESET_ULTRAFAST")
+        preset = DISOpticalFlow::PRESET_ULTRAFAST;
+    else if (preset_string == "PRESET_FAST")
+        preset = DISOpticalFlow::PRESET_FAST;
+    else if (preset_string == "PRESET_MEDIUM")
+        preset = DISOpticalFlow::PRESET_MEDIUM;
+    Size sz = get<1>(params);
+
+    Mat frame1(sz, CV_8U);
+    Mat frame2(sz, CV_8U);
+    Mat flow;
+
+    MakeArtificialExample(frame1, frame2);
+
+    Ptr<DISOpticalFlow> algo = createOptFlow_DIS(preset);
+    algo->calcNext(frame1, flow);
+    algo->calcNext(frame2, flow);
+
+    // alternate the frames, each call builds the pyramid of the new frame only
+    bool odd = true;
+    TEST_CYCLE_N(10)
+    {
+        algo->calcNext(odd ? frame1 : frame2, flow);
+        odd = !odd;
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 void MakeArtificialExample(Mat &dst_frame1, Mat &dst_frame2)
 {
     int src_scale = 2;
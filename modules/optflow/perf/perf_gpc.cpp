@@ -0,0 +1,70 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<Size> GPCParams;
+typedef TestBaseWithParam<GPCParams> GlobalPatchCollider;
+
+static void makeShiftedPair(Size sz, Mat &frame1, Mat &frame2, Mat &gt)
+{
+    frame1.create(sz, CV_8UC3);
+    randu(frame1, 0, 255);
+    GaussianBlur(frame1, frame1, Size(5, 5), 0);
+    Mat shift = (Mat_<double>(2, 3) << 1, 0, 2, 0, 1, 1);
+    warpAffine(frame1, frame2, shift, sz, INTER_LINEAR, BORDER_REPLICATE);
+    gt = Mat(sz, CV_32FC2, Scalar(-2, -1));
+}
+
+typedef tuple<Size, int> GPCTrainParams;
+typedef TestBaseWithParam<GPCTrainParams> GlobalPatchColliderTraining;
+
+// The thread counts above the number of trees show whether the node and sample parallelism is used
+PERF_TEST_P(GlobalPatchColliderTraining, train, Combine(Values(szQVGA), Values(1, 4, 8, 16)))
+{
+    Size sz = get<0>(GetParam());
+    const int threads = get<1>(GetParam());
+    Mat frame1, frame2, gt;
+    makeShiftedPair(sz, frame1, frame2, gt);
+
+    Ptr<GPCTrainingSamples> samples = GPCTrainingSamples::create(vector<Mat>(1, frame1), vector<Mat>(1, frame2),
+                                                                 vector<Mat>(1, gt), GPC_DESCRIPTOR_DCT);
+    GPCSamplesVector &sv = *samples;
+    const GPCSamplesVector initial = sv;
+    Ptr< GPCForest<5> > forest = GPCForest<5>::create();
+
+    const int numThreads = getNumThreads();
+    setNumThreads(threads);
+    TEST_CYCLE_N(1)
+    {
+        sv = initial;
+        forest->train(*samples, GPCTrainingParams(8, 3, GPC_DESCRIPTOR_DCT, false));
+    }
+    setNumThreads(numThreads);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(GlobalPatchCollider, findCorrespondences, Values(szQVGA, szVGA))
+{
+    Size sz = get<0>(GetParam());
+    Mat frame1, frame2, gt;
+    makeShiftedPair(sz, frame1, frame2, gt);
+    vector<Mat> img1(1, frame1), img2(1, frame2), flow(1, gt);
+
+    Ptr< GPCForest<5> > forest = GPCForest<5>::create();
+    forest->train(img1, img2, flow, GPCTrainingParams(8, 3, GPC_DESCRIPTOR_DCT, false));
+    vector< pair<Point2i, Point2i> > corr;
+
+    TEST_CYCLE()
+    {
+        corr.clear();
+        forest->findCorrespondences(frame1, frame2, corr);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -0,0 +1,33 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<Size> SFParams;
+typedef TestBaseWithParam<SFParams> DenseOpticalFlow_SimpleFlow;
+
+PERF_TEST_P(DenseOpticalFlow_SimpleFlow, perf, Values(szQVGA, szVGA))
+{
+    SFParams params = GetParam();
+    Size sz = get<0>(params);
+
+    Mat frame1(sz, CV_8UC3);
+    Mat frame2(sz, CV_8UC3);
+    Mat flow;
+
+    randu(frame1, 0, 255);
+    GaussianBlur(frame1, frame1, Size(5, 5), 0);
+    Mat shift = (Mat_<double>(2, 3) << 1, 0, 2, 0, 1, 1);
+    warpAffine(frame1, frame2, shift, sz, INTER_LINEAR, BORDER_REPLICATE);
+
+    TEST_CYCLE_N(1)
+    {
+        calcOpticalFlowSF(frame1, frame2, flow, 3, 2, 4);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
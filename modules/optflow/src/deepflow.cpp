@@ -53,6 +53,7 @@ public:
     OpticalFlowDeepFlow();
 
     void calc( InputArray I0, InputArray I1, InputOutputArray flow ) CV_OVERRIDE;
+    void calcSequence( InputArrayOfArrays frames, OutputArrayOfArrays flows );
     void collectGarbage() CV_OVERRIDE;
 
 protected:
@@ -71,6 +72,10 @@ protected:
 
 private:
     std::vector<Mat> buildPyramid( const Mat& src );
+    std::vector<Mat> buildSmoothedPyramid( const Mat& src );
+    Ptr<VariationalRefinement> createRefinement() const;
+    void calcPyramids( const std::vector<Mat>& pyramid_I0, const std::vector<Mat>& pyramid_I1,
+                       VariationalRefinement& var, Mat& W );
 
 };
 
@@ -113,32 +118,35 @@ std::vector<Mat> OpticalFlowDeepFlow::buildPyramid( const Mat& src )
     return pyramid;
 }
 
-void OpticalFlowDeepFlow::calc( InputArray _I0, InputArray _I1, InputOutputArray _flow )
+std::vector<Mat> OpticalFlowDeepFlow::buildSmoothedPyramid( const Mat& src )
 {
-    Mat I0temp = _I0.getMat();
-    Mat I1temp = _I1.getMat();
-
-    CV_Assert(I0temp.size() == I1temp.size());
-    CV_Assert(I0temp.type() == I1temp.type());
-    CV_Assert(I0temp.channels() == 1);
-    // TODO: currently only grayscale - data term could be computed in color version as well...
-
-    Mat I0, I1;
-
-    I0temp.convertTo(I0, CV_32F);
-    I1temp.convertTo(I1, CV_32F);
-
-    _flow.create(I0.size(), CV_32FC2);
-    Mat W = _flow.getMat(); // if any data present - will be discarded
+    Mat I;
+    src.convertTo(I, CV_32F);
 
     // pre-smooth images
     int kernelLen = ((int)floor(3 * sigma) * 2) + 1;
     Size kernelSize(kernelLen, kernelLen);
-    GaussianBlur(I0, I0, kernelSize, sigma);
-    GaussianBlur(I1, I1, kernelSize, sigma);
+    GaussianBlur(I, I, kernelSize, sigma);
     // build down-sized pyramids
-    std::vector<Mat> pyramid_I0 = buildPyramid(I0);
-    std::vector<Mat> pyramid_I1 = buildPyramid(I1);
+    return buildPyramid(I);
+}
+
+Ptr<VariationalRefinement> OpticalFlowDeepFlow::createRefinement() const
+{
+    Ptr<VariationalRefinement> var = createVariationalFlowRefinement();
+
+    var->setAlpha(4 * alpha);
+    var->setDelta(delta / 3);
+    var->setGamma(gamma / 3);
+    var->setFixedPointIterations(fixedPointIterations);
+    var->setSorIterations(sorIterations);
+    var->setOmega(omega);
+    return var;
+}
+
+void OpticalFlowDeepFlow::calcPyramids( const std::vector<Mat>& pyramid_I0, const std::vector<Mat>& pyramid_I1,
+                                        VariationalRefinement& var, Mat& W )
+{
     int levelCount = (int) pyramid_I0.size();
 
     // initialize the first version of flow estimate to zeros
@@ -147,16 +155,7 @@ void OpticalFlowDeepFlow::calc( InputArray _I0, InputArray _I1, InputOutputArray
 
     for ( int level = levelCount - 1; level >= 0; --level )
     { //iterate through  all levels, beginning with the most coarse
-        Ptr<VariationalRefinement> var = createVariationalFlowRefinement();
-
-        var->setAlpha(4 * alpha);
-        var->setDelta(delta / 3);
-        var->setGamma(gamma / 3);
-        var->setFixedPointIterations(fixedPointIterations);
-        var->setSorIterations(sorIterations);
-        var->setOmega(omega);
-
-        var->calc(pyramid_I0[level], pyramid_I1[level], W);
+        var.calc(pyramid_I0[level], pyramid_I1[level], W);
         if ( level > 0 ) //not the last level
         {
             Mat temp;
@@ -165,9 +164,79 @@ void OpticalFlowDeepFlow::calc( InputArray _I0, InputArray _I1, InputOutputArray
             W = temp * (1.0f / downscaleFactor); //scale values
         }
     }
+}
+
+void OpticalFlowDeepFlow::calc( InputArray _I0, InputArray _I1, InputOutputArray _flow )
+{
+    Mat I0temp = _I0.getMat();
+    Mat I1temp = _I1.getMat();
+
+    CV_Assert(I0temp.size() == I1temp.size());
+    CV_Assert(I0temp.type() == I1temp.type());
+    CV_Assert(I0temp.channels() == 1);
+    // TODO: currently only grayscale - data term could be computed in color version as well...
+
+    _flow.create(I0temp.size(), CV_32FC2);
+
+    std::vector<Mat> pyramid_I0 = buildSmoothedPyramid(I0temp);
+    std::vector<Mat> pyramid_I1 = buildSmoothedPyramid(I1temp);
+
+    // one refinement object serves all levels, so its buffers are reallocated only when the level size changes
+    Ptr<VariationalRefinement> var = createRefinement();
+    Mat W; // if any data present in the output - will be discarded
+    calcPyramids(pyramid_I0, pyramid_I1, *var, W);
     W.copyTo(_flow);
 }
 
+void OpticalFlowDeepFlow::calcSequence( InputArrayOfArrays _frames, OutputArrayOfArrays _flows )
+{
+    std::vector<Mat> frames;
+    _frames.getMatVector(frames);
+    int pairCount = std::max((int)frames.size() - 1, 0);
+    for ( size_t i = 1; i < frames.size(); ++i )
+    {
+        CV_Assert(frames[i].size() == frames[0].size());
+        CV_Assert(frames[i].type() == frames[0].type());
+    }
+    CV_Assert(frames.empty() || frames[0].channels() == 1);
+
+    _flows.create(pairCount, 1, 0, -1, true);
+    std::vector<Mat> flows(pairCount);
+    for ( int i = 0; i < pairCount; ++i )
+    {
+        _flows.create(frames[0].size(), CV_32FC2, i, true);
+        flows[i] = _flows.getMat(i);
+    }
+
+    // every inner frame is shared by two pairs, so its pyramid is built once
+    std::vector<std::vector<Mat> > pyramids(frames.size());
+    parallel_for_(Range(0, (int)frames.size()), [&](const Range& range)
+    {
+        for ( int i = range.start; i < range.end; ++i )
+            pyramids[i] = buildSmoothedPyramid(frames[i]);
+    });
+
+    parallel_for_(Range(0, pairCount), [&](const Range& range)
+    {
+        Ptr<VariationalRefinement> var = createRefinement();
+        for ( int i = range.start; i < range.end; ++i )
+        {
+            Mat W;
+            calcPyramids(pyramids[i], pyramids[i + 1], *var, W);
+            W.copyTo(flows[i]);
+        }
+    });
+}
+
+bool calcDeepFlowSequence( const Ptr<DenseOpticalFlow>& algo, InputArrayOfArrays frames, OutputArrayOfArrays flows )
+{
+    OpticalFlowDeepFlow* deepFlow = dynamic_cast<OpticalFlowDeepFlow*>(algo.get());
+    if ( !deepFlow )
+        return false;
+    deepFlow->calcSequence(frames, flows);
+    return true;
+}
+
 void OpticalFlowDeepFlow::collectGarbage() {}
 
 Ptr<DenseOpticalFlow> createOptFlow_DeepFlow() { return makePtr<OpticalFlowDeepFlow>(); }
@@ -60,6 +60,8 @@ class DISOpticalFlowImpl CV_FINAL : public DISOpticalFlow
     DISOpticalFlowImpl();
 
     void calc(InputArray I0, InputArray I1, InputOutputArray flow) CV_OVERRIDE;
+    void calcNext(InputArray frame, OutputArray flow) CV_OVERRIDE;
+    void resetStream() CV_OVERRIDE;
     void collectGarbage() CV_OVERRIDE;
 
   protected: //!< algorithm parameters
@@ -139,8 +141,16 @@ class DISOpticalFlowImpl CV_FINAL : public DISOpticalFlow
 
     vector<Ptr<VariationalRefinement> > variational_refinement_processors;
 
+    /* State kept between calcNext calls: */
+    Mat_<uchar> stream_frame; //!< copy of the last frame of the sequence
+    Mat_<Vec2f> stream_flow;  //!< flow computed for the last pair of frames
+    bool stream_pyramid_valid; //!< whether I1s still holds the pyramid of stream_frame
+    int stream_finest_scale, stream_coarsest_scale; //!< scales the pyramid in I1s was built for
+
   private: //!< private methods and parallel sections
-    void prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_flow);
+    int computeCoarsestScale(int cols, int rows) const;
+    void calcFlow(Mat &I0, Mat &I1, Mat &flow, bool use_flow, bool reuse_I0_pyramid);
+    void prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_flow, bool reuse_I0_pyramid);
     void precomputeStructureTensor(Mat &dst_I0xx, Mat &dst_I0yy, Mat &dst_I0xy, Mat &dst_I0x, Mat &dst_I0y, Mat &I0x,
                                    Mat &I0y);
 
@@ -152,10 +162,19 @@ class DISOpticalFlowImpl CV_FINAL : public DISOpticalFlow
         Mat *Sx, *Sy, *Ux, *Uy, *I0, *I1, *I0x, *I0y;
         int num_iter, pyr_level;
 
+        /* Wavefront processing of the stripes, used when there are more threads than stripes: */
+        int ncol_blocks, col_block_sz; //!< number and width of column blocks each stripe row is split into
+        int wave_iter, wave_step;      //!< pass of the inverse search and wavefront step being processed
+        int wave_first_block, wave_nblocks; //!< column blocks that are processed in the current wavefront step
+
         PatchInverseSearch_ParBody(DISOpticalFlowImpl &_dis, int _nstripes, int _hs, Mat &dst_Sx, Mat &dst_Sy,
                                    Mat &src_Ux, Mat &src_Uy, Mat &_I0, Mat &_I1, Mat &_I0x, Mat &_I0y, int _num_iter,
-                                   int _pyr_level);
+                                   int _pyr_level, int _ncol_blocks = 1);
         void operator()(const Range &range) const CV_OVERRIDE;
+        void setWave(int iter, int step);
+        int getWaveSteps() const { return stripe_sz + ncol_blocks - 1; }
+        void processPatches(int iter, int start_is, int end_is, int start_js, int end_js, int first_is,
+                            int first_js) const;
     };
 
     struct Densification_ParBody : public ParallelLoopBody
@@ -234,10 +253,19 @@ DISOpticalFlowImpl::DISOpticalFlowImpl()
     int max_possible_scales = 10;
     for (int i = 0; i < max_possible_scales; i++)
         variational_refinement_processors.push_back(createVariationalFlowRefinement());
+
+    stream_pyramid_valid = false;
+    stream_finest_scale = stream_coarsest_scale = -1;
 }
 
-void DISOpticalFlowImpl::prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_flow)
+void DISOpticalFlowImpl::prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_flow, bool reuse_I0_pyramid)
 {
+    /* In the streaming mode the pyramid built for the second frame of the previous pair is the pyramid of
+     * the first frame of this pair, so only the pyramid of I1 has to be computed:
+     */
+    if (reuse_I0_pyramid)
+        std::swap(I0s, I1s);
+
     I0s.resize(coarsest_scale + 1);
     I1s.resize(coarsest_scale + 1);
     I1s_ext.resize(coarsest_scale + 1);
@@ -264,8 +292,11 @@ void DISOpticalFlowImpl::prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_fl
         {
             cur_rows = I0.rows / fraction;
             cur_cols = I0.cols / fraction;
-            I0s[i].create(cur_rows, cur_cols);
-            resize(I0, I0s[i], I0s[i].size(), 0.0, 0.0, INTER_AREA);
+            if (!reuse_I0_pyramid)
+            {
+                I0s[i].create(cur_rows, cur_cols);
+                resize(I0, I0s[i], I0s[i].size(), 0.0, 0.0, INTER_AREA);
+            }
             I1s[i].create(cur_rows, cur_cols);
             resize(I1, I1s[i], I1s[i].size(), 0.0, 0.0, INTER_AREA);
 
@@ -290,8 +321,11 @@ void DISOpticalFlowImpl::prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_fl
         {
             cur_rows = I0s[i - 1].rows / 2;
             cur_cols = I0s[i - 1].cols / 2;
-            I0s[i].create(cur_rows, cur_cols);
-            resize(I0s[i - 1], I0s[i], I0s[i].size(), 0.0, 0.0, INTER_AREA);
+            if (!reuse_I0_pyramid)
+            {
+                I0s[i].create(cur_rows, cur_cols);
+                resize(I0s[i - 1], I0s[i], I0s[i].size(), 0.0, 0.0, INTER_AREA);
+            }
             I1s[i].create(cur_rows, cur_cols);
             resize(I1s[i - 1], I1s[i], I1s[i].size(), 0.0, 0.0, INTER_AREA);
         }
@@ -440,11 +474,25 @@ DISOpticalFlowImpl::PatchInverseSearch_ParBody::PatchInverseSearch_ParBody(DISOp
                                                                            int _hs, Mat &dst_Sx, Mat &dst_Sy,
                                                                            Mat &src_Ux, Mat &src_Uy, Mat &_I0, Mat &_I1,
                                                                            Mat &_I0x, Mat &_I0y, int _num_iter,
-                                                                           int _pyr_level)
+                                                                           int _pyr_level, int _ncol_blocks)
     : dis(&_dis), nstripes(_nstripes), hs(_hs), Sx(&dst_Sx), Sy(&dst_Sy), Ux(&src_Ux), Uy(&src_Uy), I0(&_I0), I1(&_I1),
-      I0x(&_I0x), I0y(&_I0y), num_iter(_num_iter), pyr_level(_pyr_level)
+      I0x(&_I0x), I0y(&_I0y), num_iter(_num_iter), pyr_level(_pyr_level), ncol_blocks(_ncol_blocks), wave_iter(0),
+      wave_step(0), wave_first_block(0), wave_nblocks(0)
 {
     stripe_sz = (int)ceil(hs / (double)nstripes);
+    col_block_sz = (int)ceil(_dis.ws / (double)ncol_blocks);
+}
+
+void DISOpticalFlowImpl::PatchInverseSearch_ParBody::setWave(int iter, int step)
+{
+    /* On the given step the column block b of every stripe processes the patch row (step - b) of the stripe, so
+     * the left and the upper neighbors of each patch (right and lower ones on the backward pass) are already
+     * processed, exactly as in the sequential scan of the stripe:
+     */
+    wave_iter = iter;
+    wave_step = step;
+    wave_first_block = max(step - stripe_sz + 1, 0);
+    wave_nblocks = min(step, ncol_blocks - 1) - wave_first_block + 1;
 }
 
 /////////////////////////////////////////////* Patch processing functions */////////////////////////////////////////////
@@ -738,6 +786,33 @@ inline float computeSSDMeanNorm(uchar *I0_ptr, uchar *I1_ptr, int I0_stride, int
 
 void DISOpticalFlowImpl::PatchInverseSearch_ParBody::operator()(const Range &range) const
 {
+    if (ncol_blocks > 1)
+    {
+        /* Wavefront step: the range enumerates the active column blocks of all stripes */
+        for (int n = range.start; n < range.end; n++)
+        {
+            int stripe = n / wave_nblocks;
+            int block = wave_first_block + n % wave_nblocks;
+            int stripe_start = min(stripe * stripe_sz, hs);
+            int stripe_end = min((stripe + 1) * stripe_sz, hs);
+            int row = wave_step - block;
+            if (row >= stripe_end - stripe_start)
+                continue;
+            if (wave_iter % 2 == 0)
+                processPatches(wave_iter, stripe_start + row, stripe_start + row + 1, min(block * col_block_sz, dis->ws),
+                               min((block + 1) * col_block_sz, dis->ws), stripe_start, 0);
+            else
+            {
+                /* The backward pass starts from the last row of the stripe and the last column block */
+                block = ncol_blocks - 1 - block;
+                processPatches(wave_iter, stripe_end - 1 - row, stripe_end - 2 - row,
+                               min((block + 1) * col_block_sz, dis->ws) - 1, min(block * col_block_sz, dis->ws) - 1,
+                               stripe_end - 1, dis->ws - 1);
+            }
+        }
+        return;
+    }
+
     // force separate processing of stripes if we are using spatial propagation:
     if (dis->use_spatial_propagation && range.end > range.start + 1)
     {
@@ -745,6 +820,25 @@ void DISOpticalFlowImpl::PatchInverseSearch_ParBody::operator()(const Range &ran
             (*this)(Range(n, n + 1));
         return;
     }
+
+    for (int iter = 0; iter < num_iter; iter++)
+    {
+        if (iter % 2 == 0)
+            processPatches(iter, min(range.start * stripe_sz, hs), min(range.end * stripe_sz, hs), 0, dis->ws,
+                           min(range.start * stripe_sz, hs), 0);
+        else
+            processPatches(iter, min(range.end * stripe_sz, hs) - 1, min(range.start * stripe_sz, hs) - 1,
+                           dis->ws - 1, -1, min(range.end * stripe_sz, hs) - 1, dis->ws - 1);
+    }
+}
+
+/* Runs one pass of the inverse search over the patches [start_is, end_is) x [start_js, end_js), walking in the
+ * direction of the pass (backwards on odd passes, the start is then the larger index). Spatial candidates are only
+ * taken from the patches after the row first_is and the column first_js in that direction.
+ */
+void DISOpticalFlowImpl::PatchInverseSearch_ParBody::processPatches(int iter, int start_is, int end_is, int start_js,
+                                                                    int end_js, int first_is, int first_js) const
+{
     int psz = dis->patch_size;
     int psz2 = psz / 2;
     int w_ext = dis->w + 2 * dis->border_size; //!< width of I1_ext
@@ -780,9 +874,8 @@ void DISOpticalFlowImpl::PatchInverseSearch_ParBody::operator()(const Range &ran
         use_temporal_candidates = true;
     }
 
-    int i, j, dir;
-    int start_is, end_is, start_js, end_js;
-    int start_i, start_j;
+    int i, j;
+    int dir = iter % 2 == 0 ? 1 : -1;
     float i_lower_limit = bsz - psz + 1.0f;
     float i_upper_limit = bsz + dis->h - 1.0f;
     float j_lower_limit = bsz - psz + 1.0f;
@@ -808,142 +901,118 @@ void DISOpticalFlowImpl::PatchInverseSearch_ParBody::operator()(const Range &ran
                          w10, w11, psz);
 
     int num_inner_iter = (int)floor(dis->grad_descent_iter / (float)num_iter);
-    for (int iter = 0; iter < num_iter; iter++)
+    i = start_is * dis->patch_stride;
+    for (int is = start_is; dir * is < dir * end_is; is += dir)
     {
-        if (iter % 2 == 0)
-        {
-            dir = 1;
-            start_is = min(range.start * stripe_sz, hs);
-            end_is = min(range.end * stripe_sz, hs);
-            start_js = 0;
-            end_js = dis->ws;
-            start_i = start_is * dis->patch_stride;
-            start_j = 0;
-        }
-        else
+        j = start_js * dis->patch_stride;
+        for (int js = start_js; dir * js < dir * end_js; js += dir)
         {
-            dir = -1;
-            start_is = min(range.end * stripe_sz, hs) - 1;
-            end_is = min(range.start * stripe_sz, hs) - 1;
-            start_js = dis->ws - 1;
-            end_js = -1;
-            start_i = start_is * dis->patch_stride;
-            start_j = (dis->ws - 1) * dis->patch_stride;
-        }
+            if (iter == 0)
+            {
+                /* Using result form the previous pyramid level as the very first approximation: */
+                Sx_ptr[is * dis->ws + js] = Ux_ptr[(i + psz2) * dis->w + j + psz2];
+                Sy_ptr[is * dis->ws + js] = Uy_ptr[(i + psz2) * dis->w + j + psz2];
+            }
 
-        i = start_i;
-        for (int is = start_is; dir * is < dir * end_is; is += dir)
-        {
-            j = start_j;
-            for (int js = start_js; dir * js < dir * end_js; js += dir)
+            float min_SSD = INF, cur_SSD;
+            if (use_temporal_candidates || dis->use_spatial_propagation)
             {
-                if (iter == 0)
-                {
-                    /* Using result form the previous pyramid level as the very first approximation: */
-                    Sx_ptr[is * dis->ws + js] = Ux_ptr[(i + psz2) * dis->w + j + psz2];
-                    Sy_ptr[is * dis->ws + js] = Uy_ptr[(i + psz2) * dis->w + j + psz2];
-                }
+                COMPUTE_SSD(min_SSD, Sx_ptr[is * dis->ws + js], Sy_ptr[is * dis->ws + js]);
+            }
 
-                float min_SSD = INF, cur_SSD;
-                if (use_temporal_candidates || dis->use_spatial_propagation)
+            if (use_temporal_candidates)
+            {
+                /* Try temporal candidates (vectors from the initial flow field that was passed to the function) */
+                COMPUTE_SSD(cur_SSD, initial_Ux_ptr[(i + psz2) * dis->w + j + psz2],
+                            initial_Uy_ptr[(i + psz2) * dis->w + j + psz2]);
+                if (cur_SSD < min_SSD)
                 {
-                    COMPUTE_SSD(min_SSD, Sx_ptr[is * dis->ws + js], Sy_ptr[is * dis->ws + js]);
+                    min_SSD = cur_SSD;
+                    Sx_ptr[is * dis->ws + js] = initial_Ux_ptr[(i + psz2) * dis->w + j + psz2];
+                    Sy_ptr[is * dis->ws + js] = initial_Uy_ptr[(i + psz2) * dis->w + j + psz2];
                 }
+            }
 
-                if (use_temporal_candidates)
+            if (dis->use_spatial_propagation)
+            {
+                /* Try spatial candidates: */
+                if (dir * js > dir * first_js)
                 {
-                    /* Try temporal candidates (vectors from the initial flow field that was passed to the function) */
-                    COMPUTE_SSD(cur_SSD, initial_Ux_ptr[(i + psz2) * dis->w + j + psz2],
-                                initial_Uy_ptr[(i + psz2) * dis->w + j + psz2]);
+                    COMPUTE_SSD(cur_SSD, Sx_ptr[is * dis->ws + js - dir], Sy_ptr[is * dis->ws + js - dir]);
                     if (cur_SSD < min_SSD)
                     {
                         min_SSD = cur_SSD;
-                        Sx_ptr[is * dis->ws + js] = initial_Ux_ptr[(i + psz2) * dis->w + j + psz2];
-                        Sy_ptr[is * dis->ws + js] = initial_Uy_ptr[(i + psz2) * dis->w + j + psz2];
+                        Sx_ptr[is * dis->ws + js] = Sx_ptr[is * dis->ws + js - dir];
+                        Sy_ptr[is * dis->ws + js] = Sy_ptr[is * dis->ws + js - dir];
                     }
                 }
-
-                if (dis->use_spatial_propagation)
+                /* Flow vectors won't actually propagate across different stripes, which is the reason for keeping
+                 * the number of stripes constant. It works well enough in practice and doesn't introduce any
+                 * visible seams.
+                 */
+                if (dir * is > dir * first_is)
                 {
-                    /* Try spatial candidates: */
-                    if (dir * js > dir * start_js)
-                    {
-                        COMPUTE_SSD(cur_SSD, Sx_ptr[is * dis->ws + js - dir], Sy_ptr[is * dis->ws + js - dir]);
-                        if (cur_SSD < min_SSD)
-                        {
-                            min_SSD = cur_SSD;
-                            Sx_ptr[is * dis->ws + js] = Sx_ptr[is * dis->ws + js - dir];
-                            Sy_ptr[is * dis->ws + js] = Sy_ptr[is * dis->ws + js - dir];
-                        }
-                    }
-                    /* Flow vectors won't actually propagate across different stripes, which is the reason for keeping
-                     * the number of stripes constant. It works well enough in practice and doesn't introduce any
-                     * visible seams.
-                     */
-                    if (dir * is > dir * start_is)
+                    COMPUTE_SSD(cur_SSD, Sx_ptr[(is - dir) * dis->ws + js], Sy_ptr[(is - dir) * dis->ws + js]);
+                    if (cur_SSD < min_SSD)
                     {
-                        COMPUTE_SSD(cur_SSD, Sx_ptr[(is - dir) * dis->ws + js], Sy_ptr[(is - dir) * dis->ws + js]);
-                        if (cur_SSD < min_SSD)
-                        {
-                            min_SSD = cur_SSD;
-                            Sx_ptr[is * dis->ws + js] = Sx_ptr[(is - dir) * dis->ws + js];
-                            Sy_ptr[is * dis->ws + js] = Sy_ptr[(is - dir) * dis->ws + js];
-                        }
+                        min_SSD = cur_SSD;
+                        Sx_ptr[is * dis->ws + js] = Sx_ptr[(is - dir) * dis->ws + js];
+                        Sy_ptr[is * dis->ws + js] = Sy_ptr[(is - dir) * dis->ws + js];
                     }
                 }
+            }
 
-                /* Use the best candidate as a starting point for the gradient descent: */
-                float cur_Ux = Sx_ptr[is * dis->ws + js];
-                float cur_Uy = Sy_ptr[is * dis->ws + js];
-
-                /* Computing the inverse of the structure tensor: */
-                float detH = xx_ptr[is * dis->ws + js] * yy_ptr[is * dis->ws + js] -
-                             xy_ptr[is * dis->ws + js] * xy_ptr[is * dis->ws + js];
-                if (abs(detH) < EPS)
-                    detH = EPS;
-                float invH11 = yy_ptr[is * dis->ws + js] / detH;
-                float invH12 = -xy_ptr[is * dis->ws + js] / detH;
-                float invH22 = xx_ptr[is * dis->ws + js] / detH;
-                float prev_SSD = INF, SSD;
-                float x_grad_sum = x_ptr[is * dis->ws + js];
-                float y_grad_sum = y_ptr[is * dis->ws + js];
-
-                for (int t = 0; t < num_inner_iter; t++)
-                {
-                    INIT_BILINEAR_WEIGHTS(cur_Ux, cur_Uy);
-                    if (dis->use_mean_normalization)
-                        SSD = processPatchMeanNorm(dUx, dUy, I0_ptr + i * dis->w + j,
-                                                   I1_ptr + (int)i_I1 * w_ext + (int)j_I1, I0x_ptr + i * dis->w + j,
-                                                   I0y_ptr + i * dis->w + j, dis->w, w_ext, w00, w01, w10, w11, psz,
-                                                   x_grad_sum, y_grad_sum);
-                    else
-                        SSD = processPatch(dUx, dUy, I0_ptr + i * dis->w + j, I1_ptr + (int)i_I1 * w_ext + (int)j_I1,
-                                           I0x_ptr + i * dis->w + j, I0y_ptr + i * dis->w + j, dis->w, w_ext, w00, w01,
-                                           w10, w11, psz);
-
-                    dx = invH11 * dUx + invH12 * dUy;
-                    dy = invH12 * dUx + invH22 * dUy;
-                    cur_Ux -= dx;
-                    cur_Uy -= dy;
-
-                    /* Break when patch distance stops decreasing */
-                    if (SSD >= prev_SSD)
-                        break;
-                    prev_SSD = SSD;
-                }
+            /* Use the best candidate as a starting point for the gradient descent: */
+            float cur_Ux = Sx_ptr[is * dis->ws + js];
+            float cur_Uy = Sy_ptr[is * dis->ws + js];
+
+            /* Computing the inverse of the structure tensor: */
+            float detH = xx_ptr[is * dis->ws + js] * yy_ptr[is * dis->ws + js] -
+                         xy_ptr[is * dis->ws + js] * xy_ptr[is * dis->ws + js];
+            if (abs(detH) < EPS)
+                detH = EPS;
+            float invH11 = yy_ptr[is * dis->ws + js] / detH;
+            float invH12 = -xy_ptr[is * dis->ws + js] / detH;
+            float invH22 = xx_ptr[is * dis->ws + js] / detH;
+            float prev_SSD = INF, SSD;
+            float x_grad_sum = x_ptr[is * dis->ws + js];
+            float y_grad_sum = y_ptr[is * dis->ws + js];
+
+            for (int t = 0; t < num_inner_iter; t++)
+            {
+                INIT_BILINEAR_WEIGHTS(cur_Ux, cur_Uy);
+                if (dis->use_mean_normalization)
+                    SSD = processPatchMeanNorm(dUx, dUy, I0_ptr + i * dis->w + j,
+                                               I1_ptr + (int)i_I1 * w_ext + (int)j_I1, I0x_ptr + i * dis->w + j,
+                                               I0y_ptr + i * dis->w + j, dis->w, w_ext, w00, w01, w10, w11, psz,
+                                               x_grad_sum, y_grad_sum);
+                else
+                    SSD = processPatch(dUx, dUy, I0_ptr + i * dis->w + j, I1_ptr + (int)i_I1 * w_ext + (int)j_I1,
+                                       I0x_ptr + i * dis->w + j, I0y_ptr + i * dis->w + j, dis->w, w_ext, w00, w01,
+                                       w10, w11, psz);
+
+                dx = invH11 * dUx + invH12 * dUy;
+                dy = invH12 * dUx + invH22 * dUy;
+                cur_Ux -= dx;
+                cur_Uy -= dy;
+
+                /* Break when patch distance stops decreasing */
+                if (SSD >= prev_SSD)
+                    break;
+                prev_SSD = SSD;
+            }
 
-                /* If gradient descent converged to a flow vector that is very far from the initial approximation
-                 * (more than patch size) then we don't use it. Noticeably improves the robustness.
-                 */
-                if (norm(Vec2f(cur_Ux - Sx_ptr[is * dis->ws + js], cur_Uy - Sy_ptr[is * dis->ws + js])) <= psz)
-                {
-                    Sx_ptr[is * dis->ws + js] = cur_Ux;
-                    Sy_ptr[is * dis->ws + js] = cur_Uy;
-                }
-                j += dir * dis->patch_stride;
+            /* If gradient descent converged to a flow vector that is very far from the initial approximation
+             * (more than patch size) then we don't use it. Noticeably improves the robustness.
+             */
+            if (norm(Vec2f(cur_Ux - Sx_ptr[is * dis->ws + js], cur_Uy - Sy_ptr[is * dis->ws + js])) <= psz)
+            {
+                Sx_ptr[is * dis->ws + js] = cur_Ux;
+                Sy_ptr[is * dis->ws + js] = cur_Uy;
             }
-            i += dir * dis->patch_stride;
+            j += dir * dis->patch_stride;
         }
+        i += dir * dis->patch_stride;
     }
 #undef INIT_BILINEAR_WEIGHTS
 #undef COMPUTE_SSD
@@ -1380,11 +1449,62 @@ void DISOpticalFlowImpl::calc(InputArray I0, InputArray I1, InputOutputArray flo
     else
         flow.create(I1Mat.size(), CV_32FC2);
     Mat flowMat = flow.getMat();
-    coarsest_scale = min((int)(log(max(I0Mat.cols, I0Mat.rows) / (4.0 * patch_size)) / log(2.0) + 0.5), /* Original code serach for maximal movement of width/4 */
-                         (int)(log(min(I0Mat.cols, I0Mat.rows) / patch_size) / log(2.0)));              /* Deepest pyramid level greater or equal than patch*/
+
+    /* I1s is overwritten, so the next calcNext call has to rebuild the pyramid of its previous frame */
+    stream_pyramid_valid = false;
+    calcFlow(I0Mat, I1Mat, flowMat, use_input_flow, false);
+}
+
+void DISOpticalFlowImpl::calcNext(InputArray frame, OutputArray flow)
+{
+    CV_Assert(!frame.empty() && frame.depth() == CV_8U && frame.channels() == 1);
+    CV_Assert(frame.isContinuous());
+
+    Mat frameMat = frame.getMat();
+    flow.create(frameMat.size(), CV_32FC2);
+    Mat flowMat = flow.getMat();
+    if (stream_frame.empty() || stream_frame.size() != frameMat.size())
+    {
+        /* The first frame of a sequence: there is nothing to match it with yet */
+        resetStream();
+        frameMat.copyTo(stream_frame);
+        flowMat.setTo(Scalar::all(0));
+        return;
+    }
+
+    bool use_input_flow = !stream_flow.empty();
+    if (use_input_flow)
+        stream_flow.copyTo(flowMat);
+    bool reuse_I0_pyramid = stream_pyramid_valid && stream_finest_scale == finest_scale &&
+                            stream_coarsest_scale == computeCoarsestScale(frameMat.cols, frameMat.rows);
+    calcFlow(stream_frame, frameMat, flowMat, use_input_flow, reuse_I0_pyramid);
+
+    flowMat.copyTo(stream_flow);
+    frameMat.copyTo(stream_frame);
+    stream_pyramid_valid = true;
+    stream_finest_scale = finest_scale;
+    stream_coarsest_scale = coarsest_scale;
+}
+
+void DISOpticalFlowImpl::resetStream()
+{
+    stream_frame.release();
+    stream_flow.release();
+    stream_pyramid_valid = false;
+}
+
+int DISOpticalFlowImpl::computeCoarsestScale(int cols, int rows) const
+{
+    return min((int)(log(max(cols, rows) / (4.0 * patch_size)) / log(2.0) + 0.5), /* Original code serach for maximal movement of width/4 */
+               (int)(log(min(cols, rows) / patch_size) / log(2.0)));              /* Deepest pyramid level greater or equal than patch*/
+}
+
+void DISOpticalFlowImpl::calcFlow(Mat &I0Mat, Mat &I1Mat, Mat &flowMat, bool use_input_flow, bool reuse_I0_pyramid)
+{
+    coarsest_scale = computeCoarsestScale(I0Mat.cols, I0Mat.rows);
     int num_stripes = getNumThreads();
 
-    prepareBuffers(I0Mat, I1Mat, flowMat, use_input_flow);
+    prepareBuffers(I0Mat, I1Mat, flowMat, use_input_flow, reuse_I0_pyramid);
     Ux[coarsest_scale].setTo(0.0f);
     Uy[coarsest_scale].setTo(0.0f);
 
@@ -1401,8 +1521,25 @@ void DISOpticalFlowImpl::calc(InputArray I0, InputArray I1, InputOutputArray flo
             /* Use a fixed number of stripes regardless the number of threads to make inverse search
              * with spatial propagation reproducible
              */
-            parallel_for_(Range(0, 8), PatchInverseSearch_ParBody(*this, 8, hs, Sx, Sy, Ux[i], Uy[i], I0s[i],
-                                                                  I1s_ext[i], I0xs[i], I0ys[i], 2, i));
+            int nstripes = 8;
+            /* With more threads than stripes, the rows of each stripe are also split into column blocks that are
+             * processed as a wavefront. It doesn't change the order of processing within a patch neighborhood, so
+             * the result is the same as with the sequential scan of every stripe.
+             */
+            int ncol_blocks = min((num_stripes + nstripes - 1) / nstripes, max(ws / 8, 1));
+            PatchInverseSearch_ParBody inverse_search(*this, nstripes, hs, Sx, Sy, Ux[i], Uy[i], I0s[i], I1s_ext[i],
+                                                      I0xs[i], I0ys[i], 2, i, ncol_blocks);
+            if (ncol_blocks == 1)
+                parallel_for_(Range(0, nstripes), inverse_search);
+            else
+            {
+                for (int iter = 0; iter < 2; iter++)
+                    for (int step = 0; step < inverse_search.getWaveSteps(); step++)
+                    {
+                        inverse_search.setWave(iter, step);
+                        parallel_for_(Range(0, nstripes * inverse_search.wave_nblocks), inverse_search);
+                    }
+            }
         }
         else
         {
@@ -1468,9 +1605,11 @@ void DISOpticalFlowImpl::collectGarbage()
     u_I0xy_buf_aux.release();
 #endif
 
+    /* The processors themselves are kept, as prepareBuffers expects one per scale */
     for (int i = finest_scale; i <= coarsest_scale; i++)
         variational_refinement_processors[i]->collectGarbage();
-    variational_refinement_processors.clear();
+
+    resetStream();
 }
 
 Ptr<DISOpticalFlow> createOptFlow_DIS(int preset)
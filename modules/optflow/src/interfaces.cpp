@@ -213,5 +213,32 @@ Ptr<DenseOpticalFlow> createOptFlow_SparseToDense()
 {
     return makePtr<OpticalFlowSparseToDense>(8,128,0.05f,true,500.0f,1.5f);
 }
+
+void calcOpticalFlowSequence(const Ptr<DenseOpticalFlow>& algo, InputArrayOfArrays frames, OutputArrayOfArrays flows)
+{
+    CV_Assert(!algo.empty());
+    if (calcDeepFlowSequence(algo, frames, flows))
+        return;
+    OpticalFlowPCAFlow* pcaFlow = dynamic_cast<OpticalFlowPCAFlow*>(algo.get());
+    if (pcaFlow)
+    {
+        pcaFlow->calcSequence(frames, flows);
+        return;
+    }
+
+    // the other algorithms keep internal state between the calls, so the pairs are processed one by one
+    std::vector<Mat> frameMats;
+    frames.getMatVector(frameMats);
+    int pairCount = std::max((int)frameMats.size() - 1, 0);
+    flows.create(pairCount, 1, 0, -1, true);
+    for (int i = 0; i < pairCount; i++)
+    {
+        Mat flow; // a fresh matrix, so that no initial flow is passed to the algorithm
+        algo->calc(frameMats[i], frameMats[i + 1], flow);
+        flows.create(flow.size(), flow.type(), i, true);
+        Mat dst = flows.getMat(i);
+        flow.copyTo(dst);
+    }
+}
 }
 }
@@ -0,0 +1,367 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "precomp.hpp"
+#include <cstdio>
+
+#if defined _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#define OPTFLOW_HAVE_MMAP 1
+#elif defined __unix__ || defined __APPLE__
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define OPTFLOW_HAVE_MMAP 1
+#endif
+
+/*
+ * File layout: a 32-byte header followed by the frames stored back to back in the byte order of the
+ * writer. Files are only opened on machines of the same byte order, which is checked with the marker.
+ *
+ *   offset  0: "OFSQ" tag
+ *   offset  4: int32 format version
+ *   offset  8: int32 frame width
+ *   offset 12: int32 frame height
+ *   offset 16: int32 storage type (OpticalFlowSequence::StorageType)
+ *   offset 20: float32 quantization step
+ *   offset 24: int32 number of frames
+ *   offset 28: int32 byte order marker, 0x01020304 written in the writer's byte order
+ */
+
+namespace cv {
+namespace optflow {
+
+static const char SEQUENCE_TAG[4] = { 'O', 'F', 'S', 'Q' };
+static const int SEQUENCE_VERSION = 1;
+static const int SEQUENCE_HEADER_SIZE = 32;
+static const int SEQUENCE_FRAMES_OFFSET = 24;
+static const int SEQUENCE_BYTE_ORDER = 0x01020304;
+
+static bool seekFile( FILE* f, int64 offset )
+{
+#if defined _WIN32
+    return _fseeki64(f, offset, SEEK_SET) == 0;
+#elif defined __unix__ || defined __APPLE__
+    return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#else
+    return fseek(f, (long)offset, SEEK_SET) == 0;
+#endif
+}
+
+static int64 fileSize( FILE* f )
+{
+#if defined _WIN32
+    if ( _fseeki64(f, 0, SEEK_END) != 0 )
+        return -1;
+    return _ftelli64(f);
+#elif defined __unix__ || defined __APPLE__
+    if ( fseeko(f, 0, SEEK_END) != 0 )
+        return -1;
+    return (int64)ftello(f);
+#else
+    if ( fseek(f, 0, SEEK_END) != 0 )
+        return -1;
+    return ftell(f);
+#endif
+}
+
+static int storageElemType( int storage )
+{
+    switch ( storage )
+    {
+    case OpticalFlowSequence::STORAGE_FLOAT32: return CV_32FC2;
+    case OpticalFlowSequence::STORAGE_FLOAT16: return CV_16FC2;
+    case OpticalFlowSequence::STORAGE_INT16:   return CV_16SC2;
+    default: return -1;
+    }
+}
+
+class OpticalFlowSequenceImpl CV_FINAL : public OpticalFlowSequence
+{
+public:
+    OpticalFlowSequenceImpl( FILE* f, bool writable, Size frameSize, int storage, float quantStep, int frames );
+    ~OpticalFlowSequenceImpl() CV_OVERRIDE;
+
+    bool append( InputArray flow ) CV_OVERRIDE;
+    void read( int index, OutputArray flow ) const CV_OVERRIDE;
+    Mat getFrame( int index ) const CV_OVERRIDE;
+
+    int getFramesCount() const CV_OVERRIDE { return frames; }
+    Size getFrameSize() const CV_OVERRIDE { return frameSize; }
+    int getStorageType() const CV_OVERRIDE { return storage; }
+    float getQuantStep() const CV_OVERRIDE { return quantStep; }
+
+    bool writeHeader();
+
+private:
+    int64 frameOffset( int index ) const { return SEQUENCE_HEADER_SIZE + (int64)index * frameBytes; }
+
+#ifdef OPTFLOW_HAVE_MMAP
+    struct Mapping
+    {
+        uchar* data;
+        int64 size;
+#ifdef _WIN32
+        HANDLE handle;
+        Mapping() : data(NULL), size(0), handle(NULL) {}
+#else
+        Mapping() : data(NULL), size(0) {}
+#endif
+    };
+    bool mapFrames( int count ) const;
+    static void unmap( Mapping& m );
+#endif
+
+    FILE* file;
+    bool writable;
+    Size frameSize;
+    int storage;
+    float quantStep;
+    int frames;
+    int elemType;
+    int64 frameBytes;
+    Mat convertBuf;
+
+    mutable Mutex mutex;
+#ifdef OPTFLOW_HAVE_MMAP
+    // Mappings are only replaced when the sequence outgrows them. The previous ones are kept until
+    // destruction, so the frames returned by getFrame() never dangle; a writable sequence doubles its
+    // mapping each time, which keeps their count logarithmic and their total size below twice the file.
+    mutable Mapping mapping;
+    mutable std::vector<Mapping> retiredMappings;
+#endif
+};
+
+OpticalFlowSequence::~OpticalFlowSequence()
+{
+}
+
+OpticalFlowSequenceImpl::OpticalFlowSequenceImpl( FILE* f, bool writable_, Size frameSize_, int storage_,
+                                                  float quantStep_, int frames_ )
+    : file(f), writable(writable_), frameSize(frameSize_), storage(storage_), quantStep(quantStep_),
+      frames(frames_)
+{
+    elemType = storageElemType(storage);
+    frameBytes = (int64)frameSize.area() * CV_ELEM_SIZE(elemType);
+}
+
+OpticalFlowSequenceImpl::~OpticalFlowSequenceImpl()
+{
+#ifdef OPTFLOW_HAVE_MMAP
+    unmap(mapping);
+    for ( size_t i = 0; i < retiredMappings.size(); i++ )
+        unmap(retiredMappings[i]);
+#endif
+    if ( file )
+        fclose(file);
+}
+
+bool OpticalFlowSequenceImpl::writeHeader()
+{
+    char header[SEQUENCE_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    const int version = SEQUENCE_VERSION, width = frameSize.width, height = frameSize.height;
+    memcpy(header, SEQUENCE_TAG, 4);
+    memcpy(header + 4, &version, 4);
+    memcpy(header + 8, &width, 4);
+    memcpy(header + 12, &height, 4);
+    memcpy(header + 16, &storage, 4);
+    memcpy(header + 20, &quantStep, 4);
+    memcpy(header + SEQUENCE_FRAMES_OFFSET, &frames, 4);
+    memcpy(header + 28, &SEQUENCE_BYTE_ORDER, 4);
+    return seekFile(file, 0) && fwrite(header, 1, sizeof(header), file) == sizeof(header) && fflush(file) == 0;
+}
+
+bool OpticalFlowSequenceImpl::append( InputArray _flow )
+{
+    Mat flow = _flow.getMat();
+    if ( !writable || flow.type() != CV_32FC2 || flow.size() != frameSize )
+        return false;
+
+    AutoLock lock(mutex);
+    Mat data;
+    if ( storage == STORAGE_FLOAT32 )
+        data = flow;
+    else if ( storage == STORAGE_FLOAT16 )
+    {
+        flow.convertTo(convertBuf, CV_16F);
+        data = convertBuf;
+    }
+    else
+    {
+        // values that do not fit would be silently clipped by the conversion
+        const double limit = 32767.5 * quantStep;
+        if ( !checkRange(flow, true, NULL, -limit, limit) )
+            CV_Error_(Error::StsOutOfRange, ("The flow has NaN or values outside of the STORAGE_INT16 range "
+                                              "[%g, %g], use a larger quantization step", -limit, limit));
+        flow.convertTo(convertBuf, CV_16S, 1.0 / quantStep);
+        data = convertBuf;
+    }
+
+    if ( !seekFile(file, frameOffset(frames)) )
+        return false;
+    const size_t rowBytes = data.cols * data.elemSize();
+    for ( int i = 0; i < data.rows; i++ )
+    {
+        if ( fwrite(data.ptr(i), 1, rowBytes, file) != rowBytes )
+            return false;
+    }
+
+    // the frame becomes visible only once the counter in the header has been updated
+    frames++;
+    if ( !seekFile(file, SEQUENCE_FRAMES_OFFSET) || fwrite(&frames, 1, 4, file) != 4 || fflush(file) != 0 )
+    {
+        frames--;
+        return false;
+    }
+    return true;
+}
+
+Mat OpticalFlowSequenceImpl::getFrame( int index ) const
+{
+    AutoLock lock(mutex);
+    CV_Assert( 0 <= index && index < frames );
+#ifdef OPTFLOW_HAVE_MMAP
+    if ( mapFrames(index + 1) )
+        return Mat(frameSize, elemType, mapping.data + frameOffset(index));
+#endif
+    // no memory mapping available - fall back to a copy
+    Mat frame(frameSize, elemType);
+    if ( !seekFile(file, frameOffset(index)) ||
+         fread(frame.ptr(), 1, (size_t)frameBytes, file) != (size_t)frameBytes )
+        CV_Error(Error::StsError, "Can't read the optical flow sequence frame");
+    return frame;
+}
+
+void OpticalFlowSequenceImpl::read( int index, OutputArray flow ) const
+{
+    Mat frame = getFrame(index);
+    if ( storage == STORAGE_FLOAT32 )
+        frame.copyTo(flow);
+    else if ( storage == STORAGE_FLOAT16 )
+        frame.convertTo(flow, CV_32F);
+    else
+        frame.convertTo(flow, CV_32F, quantStep);
+}
+
+#ifdef OPTFLOW_HAVE_MMAP
+bool OpticalFlowSequenceImpl::mapFrames( int count ) const
+{
+    const int64 required = frameOffset(count);
+    if ( mapping.data && mapping.size >= required )
+        return true;
+
+    // map everything written so far to make the following reads cheap, and room for as many
+    // frames again when more can be appended
+    int64 size = frameOffset(frames);
+    if ( writable )
+        size = std::max(size, 2 * mapping.size);
+    if ( (int64)(size_t)size != size )
+        return false;
+    Mapping m;
+#ifdef _WIN32
+    // a view cannot be larger than its mapping object, which extends the file when needed; appended
+    // frames overwrite the zeros, and the counter in the header still tells how many frames are valid
+    HANDLE fileHandle = (HANDLE)_get_osfhandle(_fileno(file));
+    m.handle = CreateFileMappingW(fileHandle, NULL, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                  (DWORD)(size >> 32), (DWORD)size, NULL);
+    if ( !m.handle )
+        return false;
+    m.data = (uchar*)MapViewOfFile(m.handle, FILE_MAP_READ, 0, 0, (SIZE_T)size);
+    if ( !m.data )
+    {
+        CloseHandle(m.handle);
+        return false;
+    }
+#else
+    // pages past the end of the file are never accessed before the frames they hold are written
+    void* p = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, fileno(file), 0);
+    if ( p == MAP_FAILED )
+        return false;
+    m.data = (uchar*)p;
+#endif
+    m.size = size;
+
+    if ( mapping.data )
+        retiredMappings.push_back(mapping);
+    mapping = m;
+    return true;
+}
+
+void OpticalFlowSequenceImpl::unmap( Mapping& m )
+{
+    if ( !m.data )
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(m.data);
+    CloseHandle(m.handle);
+#else
+    munmap(m.data, (size_t)m.size);
+#endif
+    m.data = NULL;
+    m.size = 0;
+}
+#endif
+
+Ptr<OpticalFlowSequence> OpticalFlowSequence::create( const String& path, Size frameSize, int storage, float quantStep )
+{
+    CV_Assert( frameSize.width > 0 && frameSize.height > 0 );
+    CV_Assert( storageElemType(storage) >= 0 );
+    CV_Assert( storage != STORAGE_INT16 || quantStep > 0 );
+
+    FILE* f = fopen(path.c_str(), "w+b");
+    if ( !f )
+        return Ptr<OpticalFlowSequence>();
+    Ptr<OpticalFlowSequenceImpl> seq = makePtr<OpticalFlowSequenceImpl>(f, true, frameSize, storage, quantStep, 0);
+    if ( !seq->writeHeader() )
+        return Ptr<OpticalFlowSequence>();
+    return seq;
+}
+
+Ptr<OpticalFlowSequence> OpticalFlowSequence::open( const String& path, bool writable )
+{
+    FILE* f = fopen(path.c_str(), writable ? "r+b" : "rb");
+    if ( !f )
+        return Ptr<OpticalFlowSequence>();
+
+    char header[SEQUENCE_HEADER_SIZE];
+    int version = 0, width = 0, height = 0, storage = -1, frames = 0, byteOrder = 0;
+    float quantStep = 0;
+    bool ok = fread(header, 1, sizeof(header), f) == sizeof(header) && memcmp(header, SEQUENCE_TAG, 4) == 0;
+    if ( ok )
+    {
+        memcpy(&version, header + 4, 4);
+        memcpy(&width, header + 8, 4);
+        memcpy(&height, header + 12, 4);
+        memcpy(&storage, header + 16, 4);
+        memcpy(&quantStep, header + 20, 4);
+        memcpy(&frames, header + SEQUENCE_FRAMES_OFFSET, 4);
+        memcpy(&byteOrder, header + 28, 4);
+        // frames are mapped as they are, so files from a machine of the other byte order are rejected
+        ok = byteOrder == SEQUENCE_BYTE_ORDER && version == SEQUENCE_VERSION && width > 0 && height > 0 && storageElemType(storage) >= 0 &&
+             (storage != STORAGE_INT16 || quantStep > 0) && frames >= 0;
+    }
+    if ( ok )
+    {
+        // a frame being written when the writer stopped is not counted
+        const int64 frameBytes = (int64)width * height * CV_ELEM_SIZE(storageElemType(storage));
+        const int64 size = fileSize(f);
+        ok = size >= SEQUENCE_HEADER_SIZE;
+        if ( ok )
+            frames = (int)std::min((int64)frames, (size - SEQUENCE_HEADER_SIZE) / frameBytes);
+    }
+    if ( !ok )
+    {
+        fclose(f);
+        return Ptr<OpticalFlowSequence>();
+    }
+    return makePtr<OpticalFlowSequenceImpl>(f, writable, Size(width, height), storage, quantStep, frames);
+}
+
+}
+}
@@ -193,10 +193,18 @@ void solveLSQR( const Mat &A, const Mat &b, OutputArray xOut, const double damp
 
 inline void _cpu_fillDCTSampledPoints( float *row, const Point2f &p, const Size &basisSize, const Size &size )
 {
+  // DCT basis is separable, so only basisSize.width + basisSize.height cosines are needed per point
+  AutoBuffer<float> cosBuf( basisSize.width + basisSize.height );
+  float *cosX = cosBuf.data();
+  float *cosY = cosX + basisSize.width;
+  for ( int n1 = 0; n1 < basisSize.width; ++n1 )
+    cosX[n1] = cosf( ( n1 * CV_PI / size.width ) * ( p.x + 0.5 ) );
+  for ( int n2 = 0; n2 < basisSize.height; ++n2 )
+    cosY[n2] = cosf( ( n2 * CV_PI / size.height ) * ( p.y + 0.5 ) );
+
   for ( int n1 = 0; n1 < basisSize.width; ++n1 )
     for ( int n2 = 0; n2 < basisSize.height; ++n2 )
-      row[n1 * basisSize.height + n2] =
-        cosf( ( n1 * CV_PI / size.width ) * ( p.x + 0.5 ) ) * cosf( ( n2 * CV_PI / size.height ) * ( p.y + 0.5 ) );
+      row[n1 * basisSize.height + n2] = cosX[n1] * cosY[n2];
 }
 
 ocl::ProgramSource _ocl_fillDCTSampledPointsSource(
@@ -213,6 +221,19 @@ ocl::ProgramSource _ocl_fillDCTSampledPointsSource(
   "a[0] = cos((n1 * pi / sw) * (p.x + 0.5)) * cos((n2 * pi / sh) * (p.y + 0.5));"
   "}" );
 
+void toGray( InputArray src, UMat &dst )
+{
+  if ( src.channels() == 3 )
+  {
+    cvtColor( src, dst, COLOR_BGR2GRAY );
+    dst.convertTo( dst, CV_8U );
+  }
+  else
+  {
+    src.getMat().convertTo( dst, CV_8U );
+  }
+}
+
 void applyCLAHE( UMat &img, float claheClip )
 {
   Ptr<CLAHE> clahe = createCLAHE();
@@ -423,24 +444,8 @@ void OpticalFlowPCAFlow::calc( InputArray I0, InputArray I1, InputOutputArray fl
   CV_Assert( size == I1.size() );
 
   UMat from, to;
-  if ( I0.channels() == 3 )
-  {
-    cvtColor( I0, from, COLOR_BGR2GRAY );
-    from.convertTo( from, CV_8U );
-  }
-  else
-  {
-    I0.getMat().convertTo( from, CV_8U );
-  }
-  if ( I1.channels() == 3 )
-  {
-    cvtColor( I1, to, COLOR_BGR2GRAY );
-    to.convertTo( to, CV_8U );
-  }
-  else
-  {
-    I1.getMat().convertTo( to, CV_8U );
-  }
+  toGray( I0, from );
+  toGray( I1, to );
 
   CV_Assert( from.channels() == 1 );
   CV_Assert( to.channels() == 1 );
@@ -451,13 +456,19 @@ void OpticalFlowPCAFlow::calc( InputArray I0, InputArray I1, InputOutputArray fl
   applyCLAHE( from, claheClip );
   applyCLAHE( to, claheClip );
 
+  flowOut.create( size, CV_32FC2 );
+  Mat flow = flowOut.getMat();
+  calcPrepared( from, to, fromOrig, flow );
+}
+
+void OpticalFlowPCAFlow::calcPrepared( UMat &from, UMat &to, const Mat &fromOrig, Mat &flow )
+{
+  const Size size = flow.size();
+
   std::vector<Point2f> features, predictedFeatures;
   findSparseFeatures( from, to, features, predictedFeatures );
   removeOcclusions( from, to, features, predictedFeatures );
 
-  flowOut.create( size, CV_32FC2 );
-  Mat flow = flowOut.getMat();
-
   Mat w1, w2;
   if ( prior.get() )
   {
@@ -479,6 +490,49 @@ void OpticalFlowPCAFlow::calc( InputArray I0, InputArray I1, InputOutputArray fl
   ximgproc::fastGlobalSmootherFilter( fromOrig, flow, flow, 500, 2 );
 }
 
+void OpticalFlowPCAFlow::calcSequence( InputArrayOfArrays framesIn, OutputArrayOfArrays flowsOut )
+{
+  std::vector<Mat> frames;
+  framesIn.getMatVector( frames );
+  const int pairCount = std::max( (int)frames.size() - 1, 0 );
+  for ( size_t i = 1; i < frames.size(); ++i )
+    CV_Assert( frames[i].size() == frames[0].size() );
+
+  flowsOut.create( pairCount, 1, 0, -1, true );
+  std::vector<Mat> flows( pairCount );
+  for ( int i = 0; i < pairCount; ++i )
+  {
+    flowsOut.create( frames[0].size(), CV_32FC2, i, true );
+    flows[i] = flowsOut.getMat( i );
+  }
+
+  // Gray conversion and CLAHE are done once per frame, not once per frame in each of the two pairs it belongs to
+  std::vector<Mat> gray( frames.size() ), equalized( frames.size() );
+  parallel_for_( Range( 0, (int)frames.size() ), [&]( const Range &range ) {
+    for ( int i = range.start; i < range.end; ++i )
+    {
+      UMat img;
+      toGray( frames[i], img );
+      CV_Assert( img.channels() == 1 );
+      img.copyTo( gray[i] );
+      applyCLAHE( img, claheClip );
+      img.copyTo( equalized[i] );
+    }
+  } );
+
+  // The pairs are independent and the solver only reads the parameters, so they are processed in parallel
+  useOpenCL = false;
+  parallel_for_( Range( 0, pairCount ), [&]( const Range &range ) {
+    for ( int i = range.start; i < range.end; ++i )
+    {
+      UMat from, to;
+      equalized[i].copyTo( from );
+      equalized[i + 1].copyTo( to );
+      calcPrepared( from, to, gray[i], flows[i] );
+    }
+  } );
+}
+
 OpticalFlowPCAFlow::OpticalFlowPCAFlow( Ptr<const PCAPrior> _prior, const Size _basisSize, float _sparseRate,
                                         float _retainedCornersFraction, float _occlusionsThreshold,
                                         float _dampingFactor, float _claheClip )
@@ -52,4 +52,13 @@ the use of this software, even if advised of the possibility of such damage.
 #include <algorithm>
 #include <cmath>
 
+namespace cv
+{
+namespace optflow
+{
+//! Runs DeepFlow's calcSequence if algo was created by createOptFlow_DeepFlow, returns false otherwise
+bool calcDeepFlowSequence( const Ptr<DenseOpticalFlow>& algo, InputArrayOfArrays frames, OutputArrayOfArrays flows );
+}
+}
+
 #endif
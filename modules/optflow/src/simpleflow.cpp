@@ -41,6 +41,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #ifdef _MSC_VER
 #   pragma warning(disable: 4512)
@@ -111,6 +112,50 @@ static void wd(Mat& d, int top_shift, int bottom_shift, int left_shift, int righ
   exp(d, d);
 }
 
+// Spatial and color weights of a bilateral window, recomputed only when the parameters change
+struct BilateralKernels {
+  Mat spaceWeights;
+  std::vector<double> expLut;
+  int radius;
+  double sigmaSpace, gaussColorCoeff;
+
+  BilateralKernels() : radius(-1), sigmaSpace(-1), gaussColorCoeff(1) {}
+
+  void update(int radius_, double sigmaSpace_, double gaussColorCoeff_) {
+    if (radius_ != radius || sigmaSpace_ != sigmaSpace) {
+      int d = 2 * radius_ + 1;
+      spaceWeights.create(d, d, CV_32F);
+      wd(spaceWeights, radius_, radius_, radius_, radius_, sigmaSpace_);
+    }
+    if (gaussColorCoeff_ != gaussColorCoeff) {
+      expLut.resize(256);
+      for (size_t i = 0; i < expLut.size(); i++) {
+        expLut[i] = std::exp(i * i * gaussColorCoeff_);
+      }
+    }
+    radius = radius_;
+    sigmaSpace = sigmaSpace_;
+    gaussColorCoeff = gaussColorCoeff_;
+  }
+};
+
+// Buffers shared by all the pyramid layers of calcOpticalFlowSF. They only grow, so every layer
+// works in the top-left part of the largest allocation made so far.
+struct SimpleFlowBuffers {
+  Mat prevExt, nextExt;
+  std::vector<Mat> nextPlanes;
+  Mat jointExt, confidenceExt, srcExt;
+  BilateralKernels costKernels, upscaleKernels, postprocessKernels;
+};
+
+static Mat bufferView(Mat& buf, int rows, int cols, int type) {
+  if (buf.type() != type || buf.rows < rows || buf.cols < cols) {
+    buf.create(std::max(rows, buf.type() == type ? buf.rows : 0),
+               std::max(cols, buf.type() == type ? buf.cols : 0), type);
+  }
+  return buf(Rect(0, 0, cols, rows));
+}
+
 template<typename JointVec, typename SrcVec>
 class CrossBilateralFilter : public ParallelLoopBody {
     Mat &joint, &confidence, &src;
@@ -138,6 +183,10 @@ public:
 
     void operator()(const Range &range) const CV_OVERRIDE {
       const int d = 2*radius +1;
+      const double *lut = &expLut[0];
+#if CV_SIMD128_64F
+      const bool useSIMD = useOptimized();
+#endif
       for (int i = range.start; i < range.end; i++) {
         SrcVec* dstRow = dst.ptr<SrcVec>(i);
         for (int j = 0; j < dst.cols; j++) {
@@ -145,15 +194,39 @@ public:
 
           Scalar totalSum = Scalar::all(0);
           double weightsSum = 0;
+#if CV_SIMD128_64F
+          // even and odd taps of the window are accumulated in the two lanes
+          v_float64x2 weightsSumVec = v_setzero_f64();
+          v_float64x2 totalSumVec[SrcVec::channels];
+          for (int cn = 0; cn < SrcVec::channels; cn++) {
+            totalSumVec[cn] = v_setzero_f64();
+          }
+#endif
           for (int dr = i, r = 0; dr < i + d; ++dr, ++r) {
             const JointVec *jointRow = joint.ptr<JointVec>(dr);
             const SrcVec *srcRow = src.ptr<SrcVec>(dr);
             const float *confidenceRow = confidence.ptr<float>(dr);
             const float *spaceWeightsRow = spaceWeights.ptr<float>(r);
-            for (int dc = j, c = 0; dc < j + d; ++dc, ++c) {
+            int dc = j, c = 0;
+#if CV_SIMD128_64F
+            for (; useSIMD && c + 1 < d; dc += 2, c += 2) {
+              double weight0 = spaceWeightsRow[c]*confidenceRow[dc];
+              double weight1 = spaceWeightsRow[c + 1]*confidenceRow[dc + 1];
+              for (int cn = 0; cn < JointVec::channels; cn++) {
+                weight0 *= lut[std::abs(centeralPoint[cn] - jointRow[dc][cn])];
+                weight1 *= lut[std::abs(centeralPoint[cn] - jointRow[dc + 1][cn])];
+              }
+              v_float64x2 weight(weight0, weight1);
+              for (int cn = 0; cn < SrcVec::channels; cn++) {
+                totalSumVec[cn] += weight * v_float64x2(srcRow[dc][cn], srcRow[dc + 1][cn]);
+              }
+              weightsSumVec += weight;
+            }
+#endif
+            for (; c < d; ++dc, ++c) {
               double weight = spaceWeightsRow[c]*confidenceRow[dc];
               for (int cn = 0; cn < JointVec::channels; cn++) {
-                weight *= expLut[std::abs(centeralPoint[cn] - jointRow[dc][cn])];
+                weight *= lut[std::abs(centeralPoint[cn] - jointRow[dc][cn])];
               }
               for (int cn = 0; cn < SrcVec::channels; cn++) {
                 totalSum[cn] += weight * srcRow[dc][cn];
@@ -161,6 +234,15 @@ public:
               weightsSum += weight;
             }
           }
+#if CV_SIMD128_64F
+          double buf[2];
+          v_store(buf, weightsSumVec);
+          weightsSum += buf[0] + buf[1];
+          for (int cn = 0; cn < SrcVec::channels; cn++) {
+            v_store(buf, totalSumVec[cn]);
+            totalSum[cn] += buf[0] + buf[1];
+          }
+#endif
 
           SrcVec& srcSum = dstRow[j];
           for (int cn = 0; cn < SrcVec::channels; cn++) {
@@ -178,6 +260,8 @@ static void crossBilateralFilter(InputArray joint_,
                           InputOutputArray src_,
                           int radius,
                           double sigmaColor, double sigmaSpace,
+                          SimpleFlowBuffers& buffers,
+                          BilateralKernels& kernels,
                           bool flag = false) {
   CV_Assert(!src_.empty());
   CV_Assert(!confidence_.empty());
@@ -202,24 +286,18 @@ static void crossBilateralFilter(InputArray joint_,
   if (src.data == joint.data)
     joint = joint.clone();
 
-  int d = 2 * radius + 1;
-
-  Mat jointTemp, confidenceTemp, srcTemp;
+  Size extSize(src.cols + 2 * radius, src.rows + 2 * radius);
+  Mat jointTemp = bufferView(buffers.jointExt, extSize.height, extSize.width, joint.type());
+  Mat confidenceTemp = bufferView(buffers.confidenceExt, extSize.height, extSize.width, confidence.type());
+  Mat srcTemp = bufferView(buffers.srcExt, extSize.height, extSize.width, src.type());
   copyMakeBorder(joint, jointTemp, radius, radius, radius, radius, BORDER_DEFAULT);
   copyMakeBorder(confidence, confidenceTemp, radius, radius, radius, radius, BORDER_CONSTANT, Scalar(0));
   copyMakeBorder(src, srcTemp, radius, radius, radius, radius, BORDER_DEFAULT);
 
-  Mat spaceWeights(d, d, CV_32F);
-  wd(spaceWeights, radius, radius, radius, radius, sigmaSpace);
-
-  double gaussColorCoeff = -0.5 / (sigmaColor * sigmaColor);
-  std::vector<double> expLut (256);
-  for (size_t i = 0; i < expLut.size(); i++) {
-    expLut[i] = std::exp(i * i * gaussColorCoeff);
-  }
+  kernels.update(radius, sigmaSpace, -0.5 / (sigmaColor * sigmaColor));
 
   Range range(0, src.rows);
-  parallel_for_(range, CrossBilateralFilter<Vec3b, Vec2f>(jointTemp, confidenceTemp, srcTemp, src, radius, flag, spaceWeights, expLut));
+  parallel_for_(range, CrossBilateralFilter<Vec3b, Vec2f>(jointTemp, confidenceTemp, srcTemp, src, radius, flag, kernels.spaceWeights, kernels.expLut));
 }
 
 static void calcConfidence(const Mat& prev,
@@ -274,6 +352,7 @@ static void calcConfidence(const Mat& prev,
 template<typename SrcVec, typename DstVec>
 class CalcOpticalFlowSingleScaleSF : public ParallelLoopBody {
     Mat &prev, &next;
+    const std::vector<Mat> &nextPlanes;
     Mat &mask;
     Mat &dst;
     int radius, maxFlow;
@@ -281,10 +360,11 @@ class CalcOpticalFlowSingleScaleSF : public ParallelLoopBody {
     std::vector<double> &expLut;
 
 public:
-    CalcOpticalFlowSingleScaleSF(Mat &prev_, Mat &next_, Mat &mask_, Mat &dst_, int radius_, int maxFlow_, Mat &spaceWeights_, std::vector<double> &expLut_)
+    CalcOpticalFlowSingleScaleSF(Mat &prev_, Mat &next_, const std::vector<Mat> &nextPlanes_, Mat &mask_, Mat &dst_, int radius_, int maxFlow_, Mat &spaceWeights_, std::vector<double> &expLut_)
             :
             prev(prev_),
             next(next_),
+            nextPlanes(nextPlanes_),
             mask(mask_),
             dst(dst_),
             radius(radius_),
@@ -294,11 +374,16 @@ public:
       CV_DbgAssert(prev.type() == next.type());
       CV_DbgAssert(prev.rows == next.rows && prev.rows == dst.rows + 2 * radius);
       CV_DbgAssert(prev.cols == next.cols && next.cols == dst.cols + 2 * radius);
+      CV_DbgAssert((int)nextPlanes.size() == SrcVec::channels);
     }
 
     void operator()(const Range &range) const CV_OVERRIDE {
       int d = 2 * radius + 1;
-      Mat weights(d, d, CV_32F);
+      AutoBuffer<float> weightsBuf(d * d);
+      float *weights = weightsBuf.data();
+#if CV_SIMD128
+      const bool useSIMD = useOptimized();
+#endif
       for (int i = range.start; i < range.end; i++) {
         const uchar *maskRow = mask.ptr<uchar>(i);
         const DstVec *dstRow = dst.ptr<DstVec>(i);
@@ -329,7 +414,7 @@ public:
           for (int dr = i, r = 0; dr < i + d; ++dr, ++r) {
             const SrcVec *prevRow = prev.ptr<SrcVec>(dr);
             const float* spaceWeightsRow = spaceWeights.ptr<float>(r);
-            float *weightsRow = weights.ptr<float>(r);
+            float *weightsRow = weights + r * d;
             for (int dc = left_border, c = 0; dc < right_border; ++dc, ++c) {
               double weight = spaceWeightsRow[c];
               for(int cn=0;cn<SrcVec::channels;cn++){
@@ -341,14 +426,52 @@ public:
 
           for (int u = topRowShift; u <= bottomRowShift; ++u) {
             const int next_extended_top_window_row = i + u0 + u;
-            for (int v = leftColShift; v <= rightColShift; ++v) {
+            int v = leftColShift;
+#if CV_SIMD128
+            // Four horizontally adjacent candidates are evaluated at once. Every lane sums its window
+            // in the same order as the scalar loop below, and the lanes are compared in the order of v.
+            const float *planeRows[SrcVec::channels];
+            for (; useSIMD && v + 3 <= rightColShift; v += 4) {
+              const int next_extended_left_window_col = j + v0 + v;
+
+              v_float32x4 cost = v_setzero_f32();
+              for (int r = 0; r < d; ++r) {
+                const SrcVec *prev_extended_window_row = prev.ptr<SrcVec>(i + r);
+                for (int cn = 0; cn < SrcVec::channels; cn++) {
+                  planeRows[cn] = nextPlanes[cn].ptr<float>(next_extended_top_window_row + r) + next_extended_left_window_col;
+                }
+                const float *weight_window_row = weights + r * d;
+                for (int c = 0; c < d; ++c) {
+                  const SrcVec &prevPoint = prev_extended_window_row[j + c];
+                  v_float32x4 diff = v_load(planeRows[0] + c) - v_setall_f32((float)prevPoint[0]);
+                  v_float32x4 dist4 = diff * diff;
+                  for (int cn = 1; cn < SrcVec::channels; cn++) {
+                    diff = v_load(planeRows[cn] + c) - v_setall_f32((float)prevPoint[cn]);
+                    dist4 += diff * diff;
+                  }
+                  cost += v_setall_f32(weight_window_row[c]) * dist4;
+                }
+              }
+
+              float costs[4];
+              v_store(costs, cost);
+              for (int k = 0; k < 4; ++k) {
+                if (costs[k] < minCost) {
+                  minCost = costs[k];
+                  bestU = (float) (u + u0);
+                  bestV = (float) (v + k + v0);
+                }
+              }
+            }
+#endif
+            for (; v <= rightColShift; ++v) {
               const int next_extended_left_window_col = j + v0 + v;
 
               float cost = 0;
               for (int r = 0; r < d; ++r) {
                 const SrcVec *prev_extended_window_row = prev.ptr<SrcVec>(i + r);
                 const SrcVec *next_extended_window_row = next.ptr<SrcVec>(next_extended_top_window_row + r);
-                const float *weight_window_row = weights.ptr<float>(r);
+                const float *weight_window_row = weights + r * d;
                 for (int c = 0; c < d; ++c) {
                   cost += weight_window_row[c] *
                           dist(prev_extended_window_row[j + c],
@@ -380,29 +503,42 @@ static void calcOpticalFlowSingleScaleSF(InputArray prev_,
                                   int radius,
                                   int max_flow,
                                   float sigmaSpace,
-                                  float sigmaColor) {
+                                  float sigmaColor,
+                                  SimpleFlowBuffers& buffers) {
   Mat prev = prev_.getMat();
   Mat next = next_.getMat();
   Mat mask = mask_.getMat();
   Mat dst = dst_.getMat();
 
-  Mat prevTemp, nextTemp;
+  const int extRows = prev.rows + 2 * radius, extCols = prev.cols + 2 * radius;
+  Mat prevTemp = bufferView(buffers.prevExt, extRows, extCols, prev.type());
+  Mat nextTemp = bufferView(buffers.nextExt, extRows, extCols, next.type());
   copyMakeBorder(prev, prevTemp, radius, radius, radius, radius, BORDER_DEFAULT);
   copyMakeBorder(next, nextTemp, radius, radius, radius, radius, BORDER_DEFAULT);
 
-  int d = 2 * radius + 1;
-
-  Mat spaceWeights(d, d, CV_32F);
-  wd(spaceWeights, radius, radius, radius, radius, sigmaSpace);
-
-  double gaussColorCoeff = -0.5 / (sigmaColor * sigmaColor);
-  std::vector<double> expLut (256);
-  for (size_t i = 0; i < expLut.size(); i++) {
-    expLut[i] = std::exp(i * i * gaussColorCoeff);
+  // planar float copy of the next image for the vectorized cost computation
+  CV_Assert(nextTemp.type() == CV_8UC3);
+  const int cn = nextTemp.channels();
+  buffers.nextPlanes.resize(cn);
+  std::vector<Mat> nextPlanes(cn);
+  for (int k = 0; k < cn; k++) {
+    nextPlanes[k] = bufferView(buffers.nextPlanes[k], extRows, extCols, CV_32F);
+  }
+  for (int r = 0; r < extRows; r++) {
+    const uchar *nextRow = nextTemp.ptr<uchar>(r);
+    for (int k = 0; k < cn; k++) {
+      float *planeRow = nextPlanes[k].ptr<float>(r);
+      for (int c = 0; c < extCols; c++) {
+        planeRow[c] = nextRow[c * cn + k];
+      }
+    }
   }
 
+  buffers.costKernels.update(radius, sigmaSpace, -0.5 / (sigmaColor * sigmaColor));
+
   Range range(0, dst.rows);
-  parallel_for_(range, CalcOpticalFlowSingleScaleSF<Vec3b, Vec2f>(prevTemp, nextTemp, mask, dst, radius, max_flow, spaceWeights, expLut));
+  parallel_for_(range, CalcOpticalFlowSingleScaleSF<Vec3b, Vec2f>(prevTemp, nextTemp, nextPlanes, mask, dst, radius, max_flow,
+                                                                  buffers.costKernels.spaceWeights, buffers.costKernels.expLut));
 }
 
 static Mat upscaleOpticalFlow(int new_rows,
@@ -412,8 +548,10 @@ static Mat upscaleOpticalFlow(int new_rows,
                                Mat& flow,
                                int averaging_radius,
                                float sigma_dist,
-                               float sigma_color) {
-  crossBilateralFilter(image, confidence, flow, averaging_radius, sigma_color, sigma_dist, true);
+                               float sigma_color,
+                               SimpleFlowBuffers& buffers) {
+  crossBilateralFilter(image, confidence, flow, averaging_radius, sigma_color, sigma_dist,
+                       buffers, buffers.upscaleKernels, true);
   Mat new_flow;
   resize(flow, new_flow, Size(new_cols, new_rows), 0, 0, INTER_NEAREST);
   new_flow *= 2;
@@ -643,6 +781,8 @@ CV_EXPORTS_W void calcOpticalFlowSF(InputArray _from,
   Mat confidence;
   Mat confidence_inv;
 
+  // bordered copies and filter kernels are shared by both directions and all layers
+  SimpleFlowBuffers buffers;
 
   calcOpticalFlowSingleScaleSF(curr_from,
                                curr_to,
@@ -651,7 +791,8 @@ CV_EXPORTS_W void calcOpticalFlowSF(InputArray _from,
                                averaging_radius,
                                max_flow,
                                (float)sigma_dist,
-                               (float)sigma_color);
+                               (float)sigma_color,
+                               buffers);
 
   calcOpticalFlowSingleScaleSF(curr_to,
                                curr_from,
@@ -660,7 +801,8 @@ CV_EXPORTS_W void calcOpticalFlowSF(InputArray _from,
                                averaging_radius,
                                max_flow,
                                (float)sigma_dist,
-                               (float)sigma_color);
+                               (float)sigma_color,
+                               buffers);
 
   removeOcclusions(flow,
                    flow_inv,
@@ -714,7 +856,8 @@ CV_EXPORTS_W void calcOpticalFlowSF(InputArray _from,
                               flow,
                               upscale_averaging_radius,
                               (float)upscale_sigma_dist,
-                              (float)upscale_sigma_color);
+                              (float)upscale_sigma_color,
+                              buffers);
 
     flow_inv = upscaleOpticalFlow(curr_rows,
                                   curr_cols,
@@ -723,7 +866,8 @@ CV_EXPORTS_W void calcOpticalFlowSF(InputArray _from,
                                   flow_inv,
                                   upscale_averaging_radius,
                                   (float)upscale_sigma_dist,
-                                  (float)upscale_sigma_color);
+                                  (float)upscale_sigma_color,
+                                  buffers);
 
     calcConfidence(curr_from, curr_to, flow, confidence, max_flow);
     calcOpticalFlowSingleScaleSF(curr_from,
@@ -733,7 +877,8 @@ CV_EXPORTS_W void calcOpticalFlowSF(InputArray _from,
                                  averaging_radius,
                                  max_flow,
                                  (float)sigma_dist,
-                                 (float)sigma_color);
+                                 (float)sigma_color,
+                                 buffers);
 
     calcConfidence(curr_to, curr_from, flow_inv, confidence_inv, max_flow);
     calcOpticalFlowSingleScaleSF(curr_to,
@@ -743,7 +888,8 @@ CV_EXPORTS_W void calcOpticalFlowSF(InputArray _from,
                                  averaging_radius,
                                  max_flow,
                                  (float)sigma_dist,
-                                 (float)sigma_color);
+                                 (float)sigma_color,
+                                 buffers);
 
     extrapolateFlow(flow, speed_up);
     extrapolateFlow(flow_inv, speed_up_inv);
@@ -754,7 +900,8 @@ CV_EXPORTS_W void calcOpticalFlowSF(InputArray _from,
   }
 
   crossBilateralFilter(curr_from, confidence, flow,
-                       postprocess_window, (float)sigma_color_fix, (float)sigma_dist_fix);
+                       postprocess_window, (float)sigma_color_fix, (float)sigma_dist_fix,
+                       buffers, buffers.postprocessKernels);
 
   GaussianBlur(flow, flow, Size(3, 3), 5);
 
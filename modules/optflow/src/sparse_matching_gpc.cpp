@@ -85,8 +85,6 @@ const unsigned negSearchKNN = 5;
 const double simulatedAnnealingTemperatureCoef = 200.0;
 const double sigmaGrowthRate = 0.2;
 
-RNG rng;
-
 struct Magnitude
 {
   float val;
@@ -453,106 +451,141 @@ void getTrainingSamples( const Mat &from, const Mat &to, const Mat &gt, GPCSampl
 }
 
 /* Sample random number from Cauchy distribution. */
-double getRandomCauchyScalar()
+double getRandomCauchyScalar( RNG &rnd )
 {
-  return tan( rng.uniform( -1.54, 1.54 ) ); // I intentionally used the value slightly less than PI/2 to enforce strictly
+  return tan( rnd.uniform( -1.54, 1.54 ) ); // I intentionally used the value slightly less than PI/2 to enforce strictly
                                             // zero probability for large numbers. Resulting PDF for Cauchy has
                                             // truncated "tails".
 }
 
 /* Sample random vector from Cauchy distribution (pointwise, i.e. vector whose components are independent random
  * variables from Cauchy distribution) */
-void getRandomCauchyVector( Vec< double, GPCPatchDescriptor::nFeatures > &v )
+void getRandomCauchyVector( Vec< double, GPCPatchDescriptor::nFeatures > &v, RNG &rnd )
 {
   for ( unsigned i = 0; i < GPCPatchDescriptor::nFeatures; ++i )
-    v[i] = getRandomCauchyScalar();
+    v[i] = getRandomCauchyScalar( rnd );
 }
 
 double getRobustMedian( double m ) { return m < 0 ? m * ( 1.0 + epsTolerance ) : m * ( 1.0 - epsTolerance ); }
-}
 
-double GPCPatchDescriptor::dot( const Vec< double, nFeatures > &coef ) const
+/* Nodes with at least this number of samples evaluate candidate hyperplanes in parallel over the samples. */
+const int minSamplesForParallelSweeps = 4096;
+const int samplesPerStripe = 1024;
+
+class ParallelSampleProjection : public ParallelLoopBody
 {
-#if CV_SIMD128_64F
-  v_float64x2 sum = v_setzero_f64();
-  for ( unsigned i = 0; i < nFeatures; i += 2 )
+private:
+  const GPCPatchSample *samples;
+  const Vec< double, GPCPatchDescriptor::nFeatures > *coef;
+  double *values;
+  int nSamples;
+
+  ParallelSampleProjection &operator=( const ParallelSampleProjection & );
+
+public:
+  ParallelSampleProjection( const GPCPatchSample *_samples, int _nSamples, const Vec< double, GPCPatchDescriptor::nFeatures > *_coef,
+                            double *_values )
+      : samples( _samples ), coef( _coef ), values( _values ), nSamples( _nSamples ){};
+
+  void operator()( const Range &range ) const CV_OVERRIDE
   {
-    v_float64x2 x = v_load( &feature.val[i] );
-    v_float64x2 y = v_load( &coef.val[i] );
-    sum = v_muladd( x, y, sum );
+    const int end = std::min( range.end * samplesPerStripe, nSamples );
+    for ( int i = range.start * samplesPerStripe; i < end; ++i )
+      values[i] = samples[i].ref.dot( *coef );
   }
-#if CV_SSE2
-  __m128d sumrev = _mm_shuffle_pd( sum.val, sum.val, _MM_SHUFFLE2( 0, 1 ) );
-  return _mm_cvtsd_f64( _mm_add_pd( sum.val, sumrev ) );
-#else
-  double CV_DECL_ALIGNED( 16 ) buf[2];
-  v_store_aligned( buf, sum );
-  return OPENCV_HAL_ADD( buf[0], buf[1] );
-#endif
-
-#else
-  return feature.dot( coef );
-#endif
-}
+};
 
-void GPCPatchSample::getDirections( bool &refdir, bool &posdir, bool &negdir, const Vec< double, GPCPatchDescriptor::nFeatures > &coef, double rhs ) const
+class ParallelSampleScore : public ParallelLoopBody
 {
-  refdir = ( ref.dot( coef ) < rhs );
-  posdir = pos.isSeparated() ? ( !refdir ) : ( pos.dot( coef ) < rhs );
-  negdir = neg.isSeparated() ? ( !refdir ) : ( neg.dot( coef ) < rhs );
-}
+private:
+  const GPCPatchSample *samples;
+  const Vec< double, GPCPatchDescriptor::nFeatures > *coef;
+  double rhs;
+  unsigned *stripeScores;
+  int nSamples;
 
-void GPCDetails::getAllDescriptorsForImage( const Mat *imgCh, std::vector< GPCPatchDescriptor > &descr, const GPCMatchingParams &mp,
-                                            int type )
-{
-  if ( type == GPC_DESCRIPTOR_DCT )
-    getAllDCTDescriptorsForImage( imgCh, descr, mp );
-  else if ( type == GPC_DESCRIPTOR_WHT )
-    getAllWHTDescriptorsForImage( imgCh, descr, mp );
-  else
-    CV_Error( Error::StsBadArg, "Unknown descriptor type" );
-}
+  ParallelSampleScore &operator=( const ParallelSampleScore & );
 
-void GPCDetails::getCoordinatesFromIndex( size_t index, Size sz, int &x, int &y )
-{
-  const size_t stride = sz.width - patchRadius * 2;
-  y = int( index / stride );
-  x = int( index - y * stride + patchRadius );
-  y += patchRadius;
-}
+public:
+  ParallelSampleScore( const GPCPatchSample *_samples, int _nSamples, const Vec< double, GPCPatchDescriptor::nFeatures > *_coef,
+                       double _rhs, unsigned *_stripeScores )
+      : samples( _samples ), coef( _coef ), rhs( _rhs ), stripeScores( _stripeScores ), nSamples( _nSamples ){};
+
+  static unsigned score( const GPCPatchSample *begin, const GPCPatchSample *end, const Vec< double, GPCPatchDescriptor::nFeatures > &coef,
+                         double rhs )
+  {
+    unsigned s = 0;
+    for ( ; begin != end; ++begin )
+    {
+      bool refdir, posdir, negdir;
+      begin->getDirections( refdir, posdir, negdir, coef, rhs );
+      if ( refdir == posdir )
+        s += scoreGainPos;
+      if ( refdir != negdir )
+        s += scoreGainNeg;
+    }
+    return s;
+  }
+
+  void operator()( const Range &range ) const CV_OVERRIDE
+  {
+    for ( int k = range.start; k < range.end; ++k )
+      stripeScores[k] = score( samples + k * samplesPerStripe, samples + std::min( ( k + 1 ) * samplesPerStripe, nSamples ), *coef, rhs );
+  }
+};
 
-bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
+struct NodeTask
 {
-  const int nSamples = (int)std::distance( begin, end );
+  size_t nodeId;
+  size_t begin, end;       //!< Range of the node samples
+  size_t leftEnd, rightBegin;
+  unsigned depth;
+  int parent;              //!< Index of the parent task in the previous level, -1 for the root
+  bool isLeft;
+  bool trained;
 
-  if ( nSamples < params.minNumberOfSamples || depth >= params.maxTreeDepth )
-    return false;
+  NodeTask( size_t _nodeId, size_t _begin, size_t _end, unsigned _depth, int _parent, bool _isLeft )
+      : nodeId( _nodeId ), begin( _begin ), end( _end ), leftEnd( _begin ), rightBegin( _end ), depth( _depth ), parent( _parent ),
+        isLeft( _isLeft ), trained( false ){};
+};
 
-  if ( nodeId >= nodes.size() )
-    nodes.resize( nodeId + 1 );
+/* Every node draws its random numbers from its own generator, so the tree does not depend on the training order. */
+RNG getNodeRNG( uint64 seed, size_t nodeId ) { return RNG( seed ^ ( ( nodeId + 1 ) * CV_BIG_UINT( 0x9E3779B97F4A7C15 ) ) ); }
 
-  Node &node = nodes[nodeId];
+typedef GPCSamplesVector::iterator SIter;
+
+/* Finds the hyperplane of the node and partitions its samples into the left subtree samples [begin, leftEnd),
+ * the undefined samples and the right subtree samples [rightBegin, end). Returns false if the node is a leaf. */
+bool trainNode( GPCTree::Node &node, SIter begin, SIter end, unsigned depth, const GPCTrainingParams &params, RNG &rnd,
+                bool parallelSweeps, SIter &leftEnd, SIter &rightBegin )
+{
+  const int nSamples = (int)std::distance( begin, end );
+  const GPCPatchSample *samples = &*begin;
+  const int nStripes = ( nSamples + samplesPerStripe - 1 ) / samplesPerStripe;
+  parallelSweeps = parallelSweeps && nSamples >= minSamplesForParallelSweeps;
 
   // Select the best hyperplane
   unsigned globalBestScore = 0;
-  std::vector< double > values;
-  values.reserve( nSamples * 2 );
+  std::vector< double > values( nSamples );
+  std::vector< unsigned > stripeScores( nStripes );
 
   for ( int j = 0; j < globalIters; ++j )
   { // Global search step
     Vec< double, GPCPatchDescriptor::nFeatures > coef;
     unsigned localBestScore = 0;
-    getRandomCauchyVector( coef );
+    getRandomCauchyVector( coef, rnd );
 
     for ( int i = 0; i < localIters; ++i )
     { // Local search step
-      double randomModification = getRandomCauchyScalar() * ( 1.0 + sigmaGrowthRate * int( i / GPCPatchDescriptor::nFeatures ) );
+      double randomModification = getRandomCauchyScalar( rnd ) * ( 1.0 + sigmaGrowthRate * int( i / GPCPatchDescriptor::nFeatures ) );
       const int pos = i % GPCPatchDescriptor::nFeatures;
       std::swap( coef[pos], randomModification );
-      values.clear();
 
-      for ( SIter iter = begin; iter != end; ++iter )
-        values.push_back( iter->ref.dot( coef ) );
+      if ( parallelSweeps )
+        parallel_for_( Range( 0, nStripes ), ParallelSampleProjection( samples, nSamples, &coef, &values[0] ) );
+      else
+        for ( int k = 0; k < nSamples; ++k )
+          values[k] = samples[k].ref.dot( coef );
 
       std::nth_element( values.begin(), values.begin() + nSamples / 2, values.end() );
       double median = values[nSamples / 2];
@@ -566,22 +599,21 @@ bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
       median = getRobustMedian( median );
 
       unsigned score = 0;
-      for ( SIter iter = begin; iter != end; ++iter )
+      if ( parallelSweeps )
       {
-        bool refdir, posdir, negdir;
-        iter->getDirections( refdir, posdir, negdir, coef, median );
-        if ( refdir == posdir )
-          score += scoreGainPos;
-        if ( refdir != negdir )
-          score += scoreGainNeg;
+        parallel_for_( Range( 0, nStripes ), ParallelSampleScore( samples, nSamples, &coef, median, &stripeScores[0] ) );
+        for ( int k = 0; k < nStripes; ++k )
+          score += stripeScores[k];
       }
+      else
+        score = ParallelSampleScore::score( samples, samples + nSamples, coef, median );
 
       if ( score > localBestScore )
         localBestScore = score;
       else
       {
         const double beta = simulatedAnnealingTemperatureCoef * std::sqrt( static_cast<float>(i) ) / ( nSamples * ( scoreGainPos + scoreGainNeg ) );
-        if ( rng.uniform( 0.0, 1.0 ) > std::exp( -beta * ( localBestScore - score) ) )
+        if ( rnd.uniform( 0.0, 1.0 ) > std::exp( -beta * ( localBestScore - score) ) )
           coef[pos] = randomModification;
       }
 
@@ -601,10 +633,10 @@ bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
   {
     const int maxScore = nSamples * ( scoreGainPos + scoreGainNeg );
     const double correctRatio = double( globalBestScore ) / maxScore;
-    printf( "[%u] Correct %.2f (%u/%d)\nWeights:", depth, correctRatio, globalBestScore, maxScore );
+    String msg = format( "[%u] Correct %.2f (%u/%d)\nWeights:", depth, correctRatio, globalBestScore, maxScore );
     for ( unsigned k = 0; k < GPCPatchDescriptor::nFeatures; ++k )
-      printf( " %.3f", node.coef[k] );
-    printf( "\n" );
+      msg += format( " %.3f", node.coef[k] );
+    printf( "%s\n", msg.c_str() ); // Nodes are trained in parallel, print the whole report at once
   }
 
   for ( SIter iter = begin; iter != end; ++iter )
@@ -624,25 +656,192 @@ bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
   // Partition vector with samples according to the hyperplane in QuickSort-like manner.
   // Unlike QuickSort, we need to partition it into 3 parts (left subtree samples; undefined samples; right subtree
   // samples), so we call it two times.
-  SIter leftEnd = std::partition( begin, end, PartitionPredicate1( node.coef, node.rhs ) ); // Separate left subtree samples from others.
-  SIter rightBegin =
+  leftEnd = std::partition( begin, end, PartitionPredicate1( node.coef, node.rhs ) ); // Separate left subtree samples from others.
+  rightBegin =
     std::partition( leftEnd, end, PartitionPredicate2( node.coef, node.rhs ) ); // Separate undefined samples from right subtree samples.
 
-  node.left = ( trainNode( nodeId * 2 + 1, begin, leftEnd, depth + 1 ) ) ? unsigned( nodeId * 2 + 1 ) : 0;
-  node.right = ( trainNode( nodeId * 2 + 2, rightBegin, end, depth + 1 ) ) ? unsigned( nodeId * 2 + 2 ) : 0;
-
+  node.left = node.right = 0; // Set once the children are trained
   return true;
 }
 
+class ParallelNodeTraining : public ParallelLoopBody
+{
+private:
+  std::vector< GPCTree::Node > *nodes;
+  std::vector< NodeTask > *tasks;
+  GPCSamplesVector *samples;
+  const GPCTrainingParams *params;
+  uint64 seed;
+  bool parallelSweeps;
+
+  ParallelNodeTraining &operator=( const ParallelNodeTraining & );
+
+public:
+  ParallelNodeTraining( std::vector< GPCTree::Node > *_nodes, std::vector< NodeTask > *_tasks, GPCSamplesVector *_samples,
+                        const GPCTrainingParams *_params, uint64 _seed, bool _parallelSweeps )
+      : nodes( _nodes ), tasks( _tasks ), samples( _samples ), params( _params ), seed( _seed ), parallelSweeps( _parallelSweeps ){};
+
+  void operator()( const Range &range ) const CV_OVERRIDE
+  {
+    for ( int k = range.start; k < range.end; ++k )
+    {
+      NodeTask &task = ( *tasks )[k];
+      RNG rnd = getNodeRNG( seed, task.nodeId );
+      SIter begin = samples->begin() + task.begin, end = samples->begin() + task.end, leftEnd, rightBegin;
+      task.trained = trainNode( ( *nodes )[task.nodeId], begin, end, task.depth, *params, rnd, parallelSweeps, leftEnd, rightBegin );
+      if ( task.trained )
+      {
+        task.leftEnd = leftEnd - samples->begin();
+        task.rightBegin = rightBegin - samples->begin();
+      }
+    }
+  }
+};
+
+// Drawn from theRNG() like the sample shuffling, so cv::setRNGSeed() makes the training reproducible
+uint64 getTreeSeed()
+{
+  RNG &rnd = theRNG();
+  const uint64 hi = rnd.next();
+  return ( hi << 32 ) | rnd.next();
+}
+}
+
+double GPCPatchDescriptor::dot( const Vec< double, nFeatures > &coef ) const
+{
+#if CV_SIMD128_64F
+  v_float64x2 sum = v_setzero_f64();
+  for ( unsigned i = 0; i < nFeatures; i += 2 )
+  {
+    v_float64x2 x = v_load( &feature.val[i] );
+    v_float64x2 y = v_load( &coef.val[i] );
+    sum = v_muladd( x, y, sum );
+  }
+#if CV_SSE2
+  __m128d sumrev = _mm_shuffle_pd( sum.val, sum.val, _MM_SHUFFLE2( 0, 1 ) );
+  return _mm_cvtsd_f64( _mm_add_pd( sum.val, sumrev ) );
+#else
+  double CV_DECL_ALIGNED( 16 ) buf[2];
+  v_store_aligned( buf, sum );
+  return OPENCV_HAL_ADD( buf[0], buf[1] );
+#endif
+
+#else
+  return feature.dot( coef );
+#endif
+}
+
+void GPCPatchSample::getDirections( bool &refdir, bool &posdir, bool &negdir, const Vec< double, GPCPatchDescriptor::nFeatures > &coef, double rhs ) const
+{
+  refdir = ( ref.dot( coef ) < rhs );
+  posdir = pos.isSeparated() ? ( !refdir ) : ( pos.dot( coef ) < rhs );
+  negdir = neg.isSeparated() ? ( !refdir ) : ( neg.dot( coef ) < rhs );
+}
+
+void GPCDetails::getAllDescriptorsForImage( const Mat *imgCh, std::vector< GPCPatchDescriptor > &descr, const GPCMatchingParams &mp,
+                                            int type )
+{
+  if ( type == GPC_DESCRIPTOR_DCT )
+    getAllDCTDescriptorsForImage( imgCh, descr, mp );
+  else if ( type == GPC_DESCRIPTOR_WHT )
+    getAllWHTDescriptorsForImage( imgCh, descr, mp );
+  else
+    CV_Error( Error::StsBadArg, "Unknown descriptor type" );
+}
+
+void GPCDetails::getCoordinatesFromIndex( size_t index, Size sz, int &x, int &y )
+{
+  const size_t stride = sz.width - patchRadius * 2;
+  y = int( index / stride );
+  x = int( index - y * stride + patchRadius );
+  y += patchRadius;
+}
+
 void GPCTree::train( GPCTrainingSamples &samples, const GPCTrainingParams _params )
+{
+  trainWithSeed( samples, _params, getTreeSeed() );
+}
+
+void GPCTree::trainWithSeed( GPCTrainingSamples &samples, const GPCTrainingParams &_params, uint64 seed )
 {
   if ( _params.descriptorType != samples.type() )
     CV_Error( Error::StsBadArg, "Descriptor type mismatch! Check that samples are collected with the same descriptor type." );
   nodes.clear();
-  nodes.reserve( samples.size() * 2 - 1 ); // set upper bound for the possible number of nodes so all subsequent resize() will be no-op
   params = _params;
   GPCSamplesVector &sv = samples;
-  trainNode( 0, sv.begin(), sv.end(), 0 );
+
+  // The tree is grown level by level. Nodes of a level own disjoint ranges of samples and are trained in parallel.
+  std::vector< NodeTask > level, nextLevel;
+  level.push_back( NodeTask( 0, 0, sv.size(), 0, -1, false ) );
+  std::vector< NodeTask > prevLevel;
+
+  while ( !level.empty() )
+  {
+    size_t n = 0, maxNodeId = 0;
+    for ( size_t k = 0; k < level.size(); ++k )
+      if ( int( level[k].end - level[k].begin ) >= params.minNumberOfSamples && level[k].depth < params.maxTreeDepth )
+      {
+        level[n++] = level[k];
+        maxNodeId = std::max( maxNodeId, level[k].nodeId );
+      }
+    level.erase( level.begin() + n, level.end() );
+    if ( level.empty() )
+      break;
+    if ( maxNodeId >= nodes.size() )
+      nodes.resize( maxNodeId + 1 );
+
+    // Few large nodes near the root are not enough to occupy all the threads, their samples are processed in parallel instead
+    const bool parallelNodes = (int)level.size() >= getNumThreads();
+    ParallelNodeTraining body( &nodes, &level, &sv, &params, seed, !parallelNodes );
+    if ( parallelNodes )
+      parallel_for_( Range( 0, (int)level.size() ), body );
+    else
+      body( Range( 0, (int)level.size() ) );
+
+    nextLevel.clear();
+    for ( size_t k = 0; k < level.size(); ++k )
+    {
+      const NodeTask &task = level[k];
+      if ( !task.trained )
+        continue;
+      if ( task.parent >= 0 )
+      {
+        Node &parent = nodes[prevLevel[task.parent].nodeId];
+        ( task.isLeft ? parent.left : parent.right ) = unsigned( task.nodeId );
+      }
+      nextLevel.push_back( NodeTask( task.nodeId * 2 + 1, task.begin, task.leftEnd, task.depth + 1, (int)k, true ) );
+      nextLevel.push_back( NodeTask( task.nodeId * 2 + 2, task.rightBegin, task.end, task.depth + 1, (int)k, false ) );
+    }
+    prevLevel.swap( level );
+    level.swap( nextLevel );
+  }
+
+  flatten();
+}
+
+void GPCTree::flatten()
+{
+  flatNodes.clear();
+  flatNodeIds.clear();
+  if ( nodes.empty() )
+    return;
+
+  flatNodeIds.push_back( 0 );
+  for ( size_t k = 0; k < flatNodeIds.size(); ++k )
+  {
+    Node node = nodes[flatNodeIds[k]];
+    if ( node.left )
+    {
+      flatNodeIds.push_back( node.left );
+      node.left = unsigned( flatNodeIds.size() - 1 );
+    }
+    if ( node.right )
+    {
+      flatNodeIds.push_back( node.right );
+      node.right = unsigned( flatNodeIds.size() - 1 );
+    }
+    flatNodes.push_back( node );
+  }
 }
 
 void GPCTree::write( FileStorage &fs ) const
@@ -657,20 +856,23 @@ void GPCTree::read( const FileNode &fn )
 {
   fn["nodes"] >> nodes;
   fn["dtype"] >> (int &)params.descriptorType;
+  flatten();
 }
 
 unsigned GPCTree::findLeafForPatch( const GPCPatchDescriptor &descr ) const
 {
+  // Traverse the compact breadth-first copy of the tree, but report the leaf by its index in nodes
+  const Node *flat = &flatNodes[0];
   unsigned id = 0, prevId;
   do
   {
     prevId = id;
-    if ( descr.dot( nodes[id].coef ) < nodes[id].rhs )
-      id = nodes[id].right;
+    if ( descr.dot( flat[id].coef ) < flat[id].rhs )
+      id = flat[id].right;
     else
-      id = nodes[id].left;
+      id = flat[id].left;
   } while ( id );
-  return prevId;
+  return flatNodeIds[prevId];
 }
 
 Ptr< GPCTrainingSamples > GPCTrainingSamples::create( const std::vector< String > &imagesFrom, const std::vector< String > &imagesTo,
@@ -140,6 +140,32 @@ TEST(DenseOpticalFlow_SimpleFlow, ReferenceAccuracy)
     EXPECT_LE(calcRMSE(GT, flow), target_RMSE);
 }
 
+TEST(DenseOpticalFlow_SimpleFlow, OptimizedMatchesPlain)
+{
+    Mat frame1(240, 320, CV_8UC3), frame2;
+    RNG rng(0x51F);
+    rng.fill(frame1, RNG::UNIFORM, 0, 255);
+    GaussianBlur(frame1, frame1, Size(5, 5), 0);
+    Mat shift = (Mat_<double>(2, 3) << 1, 0, 2.5, 0, 1, -1.5);
+    warpAffine(frame1, frame2, shift, frame1.size(), INTER_LINEAR, BORDER_REPLICATE);
+
+    const bool useOptimizedBackup = useOptimized();
+    Mat flowPlain, flowOpt;
+    setUseOptimized(false);
+    calcOpticalFlowSF(frame1, frame2, flowPlain, 3, 2, 4);
+    setUseOptimized(true);
+    calcOpticalFlowSF(frame1, frame2, flowOpt, 3, 2, 4);
+    setUseOptimized(useOptimizedBackup);
+
+    // the vectorized cost is bit-exact; the bilateral filter only differs by double rounding,
+    // which may move a few rounded flow candidates on the finer layers
+    ASSERT_EQ(flowPlain.size(), flowOpt.size());
+    EXPECT_LE(calcRMSE(flowPlain, flowOpt), 0.05f);
+    Mat diff;
+    absdiff(flowPlain.reshape(1), flowOpt.reshape(1), diff);
+    EXPECT_LE(countNonZero(diff > 0.1), (int)(diff.total() / 100));
+}
+
 TEST(DenseOpticalFlow_DeepFlow, ReferenceAccuracy)
 {
     Mat frame1, frame2, GT;
@@ -157,6 +183,38 @@ TEST(DenseOpticalFlow_DeepFlow, ReferenceAccuracy)
     EXPECT_LE(calcRMSE(GT, flow), target_RMSE);
 }
 
+static void checkSequenceMatchesCalc(const Ptr<DenseOpticalFlow>& algo, const Ptr<DenseOpticalFlow>& reference,
+                                     const vector<Mat>& frames)
+{
+    vector<Mat> flows;
+    calcOpticalFlowSequence(algo, frames, flows);
+    ASSERT_EQ(frames.size() - 1, flows.size());
+    for (size_t i = 0; i + 1 < frames.size(); ++i)
+    {
+        Mat flow;
+        reference->calc(frames[i], frames[i + 1], flow);
+        ASSERT_EQ(CV_32FC2, flows[i].type());
+        ASSERT_EQ(flow.size(), flows[i].size());
+        EXPECT_LE(cvtest::norm(flow, flows[i], NORM_INF), 0.01) << "pair " << i;
+    }
+}
+
+TEST(DenseOpticalFlow_DeepFlow, SequenceMatchesCalc)
+{
+    Mat frame1, frame2, GT;
+    ASSERT_TRUE(readRubberWhale(frame1, frame2, GT));
+    cvtColor(frame1, frame1, COLOR_BGR2GRAY);
+    cvtColor(frame2, frame2, COLOR_BGR2GRAY);
+    resize(frame1, frame1, Size(), 0.5, 0.5, INTER_AREA);
+    resize(frame2, frame2, Size(), 0.5, 0.5, INTER_AREA);
+
+    vector<Mat> frames;
+    frames.push_back(frame1);
+    frames.push_back(frame2);
+    frames.push_back(frame1);
+    checkSequenceMatchesCalc(createOptFlow_DeepFlow(), createOptFlow_DeepFlow(), frames);
+}
+
 TEST(DenseOpticalFlow_SparseToDenseFlow, ReferenceAccuracy)
 {
     Mat frame1, frame2, GT;
@@ -232,6 +290,18 @@ TEST(DenseOpticalFlow_PCAFlow, ReferenceAccuracy)
     EXPECT_LE(calcRMSE(GT, flow), target_RMSE);
 }
 
+TEST(DenseOpticalFlow_PCAFlow, SequenceMatchesCalc)
+{
+    Mat frame1, frame2, GT;
+    ASSERT_TRUE(readRubberWhale(frame1, frame2, GT));
+
+    vector<Mat> frames;
+    frames.push_back(frame1);
+    frames.push_back(frame2);
+    frames.push_back(frame1);
+    checkSequenceMatchesCalc(createOptFlow_PCAFlow(), createOptFlow_PCAFlow(), frames);
+}
+
 TEST(DenseOpticalFlow_GlobalPatchColliderDCT, ReferenceAccuracy)
 {
     Mat frame1, frame2, GT;
@@ -280,5 +350,100 @@ TEST(DenseOpticalFlow_GlobalPatchColliderWHT, ReferenceAccuracy)
     ASSERT_LE(calcAvgEPE(corr, GT), 0.5f);
 }
 
+TEST(OpticalFlowSequence, AppendAndRandomAccess)
+{
+    Mat frame1, frame2, GT;
+    ASSERT_TRUE(readRubberWhale(frame1, frame2, GT));
+    // clamp the unknown flow markers of the ground truth to the range of the 16-bit storages
+    GT = min(max(GT, -100.), 100.);
+
+    Mat flow;
+    calcOpticalFlowSparseToDense(frame1, frame2, flow);
+
+    vector<Mat> flows;
+    flows.push_back(GT);
+    flows.push_back(flow);
+    flows.push_back(-GT);
+
+    const int storages[] = { OpticalFlowSequence::STORAGE_FLOAT32, OpticalFlowSequence::STORAGE_FLOAT16,
+                             OpticalFlowSequence::STORAGE_INT16 };
+    const double eps[] = { 0, 0.01, 1. / 128 };
+    for (int k = 0; k < 3; k++)
+    {
+        const string path = cv::tempfile(".ofs");
+        {
+            Ptr<OpticalFlowSequence> seq = OpticalFlowSequence::create(path, GT.size(), storages[k]);
+            ASSERT_FALSE(seq.empty());
+            for (size_t i = 0; i < flows.size() - 1; i++)
+                ASSERT_TRUE(seq->append(flows[i]));
+            EXPECT_FALSE(seq->append(frame1));
+        }
+        {
+            Ptr<OpticalFlowSequence> seq = OpticalFlowSequence::open(path, true);
+            ASSERT_FALSE(seq.empty());
+            ASSERT_EQ((int)flows.size() - 1, seq->getFramesCount());
+            ASSERT_TRUE(seq->append(flows.back()));
+        }
+        Ptr<OpticalFlowSequence> seq = OpticalFlowSequence::open(path);
+        ASSERT_FALSE(seq.empty());
+        ASSERT_EQ((int)flows.size(), seq->getFramesCount());
+        EXPECT_EQ(storages[k], seq->getStorageType());
+        EXPECT_FALSE(seq->append(flows[0]));
+        for (int i = (int)flows.size() - 1; i >= 0; i--)
+        {
+            Mat stored;
+            seq->read(i, stored);
+            ASSERT_EQ(CV_32FC2, stored.type());
+            EXPECT_LE(cvtest::norm(stored, flows[i], NORM_INF), eps[k] * (1 + cvtest::norm(flows[i], NORM_INF)));
+        }
+        seq.release();
+        remove(path.c_str());
+    }
+}
+
+TEST(OpticalFlowSequence, InterleavedAppendAndGetFrame)
+{
+    const string path = cv::tempfile(".ofs");
+    const Size sz(64, 48);
+    {
+        Ptr<OpticalFlowSequence> seq = OpticalFlowSequence::create(path, sz, OpticalFlowSequence::STORAGE_INT16);
+        ASSERT_FALSE(seq.empty());
+
+        // every getFrame() after an append makes the mapping grow, frames returned earlier must stay valid
+        vector<Mat> frames;
+        for (int i = 0; i < 300; i++)
+        {
+            ASSERT_TRUE(seq->append(Mat(sz, CV_32FC2, Scalar(i / 64., -i / 64.))));
+            frames.push_back(seq->getFrame(i));
+        }
+        for (int i = 0; i < (int)frames.size(); i++)
+        {
+            ASSERT_EQ(CV_16SC2, frames[i].type());
+            EXPECT_EQ(0, cvtest::norm(frames[i], Scalar(i, -i), NORM_INF)) << "frame " << i;
+        }
+
+        // flows that do not fit the 16-bit range are rejected instead of being clipped
+        EXPECT_THROW(seq->append(Mat(sz, CV_32FC2, Scalar(600, 0))), cv::Exception);
+        Mat nanFlow(sz, CV_32FC2, Scalar::all(0));
+        nanFlow.at<Vec2f>(5, 7)[1] = std::numeric_limits<float>::quiet_NaN();
+        EXPECT_THROW(seq->append(nanFlow), cv::Exception);
+        EXPECT_EQ(300, seq->getFramesCount());
+    }
+
+    // a file written with the other byte order is not opened
+    FILE* f = fopen(path.c_str(), "r+b");
+    ASSERT_TRUE(f != NULL);
+    unsigned char marker[4];
+    ASSERT_EQ(0, fseek(f, 28, SEEK_SET));
+    ASSERT_EQ(4u, fread(marker, 1, 4, f));
+    std::swap(marker[0], marker[3]);
+    std::swap(marker[1], marker[2]);
+    ASSERT_EQ(0, fseek(f, 28, SEEK_SET));
+    ASSERT_EQ(4u, fwrite(marker, 1, 4, f));
+    fclose(f);
+    EXPECT_TRUE(OpticalFlowSequence::open(path).empty());
+
+    remove(path.c_str());
+}
 
 }} // namespace
@@ -101,6 +101,77 @@ TEST_P(DenseOpticalFlow_DIS, MultithreadReproducibility)
     }
 }
 
+TEST_P(DenseOpticalFlow_DIS, SpatialPropagationIsThreadCountIndependent)
+{
+    OFParams params = GetParam();
+    Size size = get<0>(params);
+
+    Mat frame1(size, CV_8U);
+    randu(frame1, 0, 255);
+    Mat frame2;
+    GaussianBlur(frame1, frame2, Size(3, 3), 0);
+
+    Ptr<DISOpticalFlow> algo = createOptFlow_DIS();
+    algo->setFinestScale(0);
+    algo->setVariationalRefinementIterations(0);
+    algo->setUseSpatialPropagation(true);
+
+    int nThreads = cv::getNumThreads();
+    Mat resSingleThread;
+    cv::setNumThreads(1);
+    algo->calc(frame1, frame2, resSingleThread);
+
+    // more threads than the spatial propagation stripes, so the stripes are split into column blocks
+    Mat resManyThreads;
+    cv::setNumThreads(64);
+    algo->calc(frame1, frame2, resManyThreads);
+    cv::setNumThreads(nThreads);
+
+    EXPECT_EQ(0, cvtest::norm(resSingleThread, resManyThreads, NORM_INF));
+}
+
+TEST_P(DenseOpticalFlow_DIS, StreamMatchesPairwiseCalc)
+{
+    int framesCount = 4;
+    RNG rng(0);
+
+    OFParams params = GetParam();
+    Size size = get<0>(params);
+
+    vector<Mat> frames(framesCount);
+    Mat base(size, CV_8U);
+    randu(base, 0, 255);
+    for (int i = 0; i < framesCount; i++)
+    {
+        Mat shift = (Mat_<double>(2, 3) << 1, 0, rng.uniform(-2.0, 2.0), 0, 1, rng.uniform(-2.0, 2.0));
+        warpAffine(base, frames[i], shift, size, INTER_LINEAR, BORDER_REPLICATE);
+    }
+
+    Ptr<DISOpticalFlow> stream = createOptFlow_DIS();
+    Ptr<DISOpticalFlow> pairwise = createOptFlow_DIS();
+
+    Mat streamFlow;
+    stream->calcNext(frames[0], streamFlow);
+    ASSERT_EQ(CV_32FC2, streamFlow.type());
+    EXPECT_EQ(0, cvtest::norm(streamFlow, NORM_INF));
+
+    // every pair after the first one is warm-started from the flow of the previous pair
+    Mat pairwiseFlow;
+    for (int i = 1; i < framesCount; i++)
+    {
+        stream->calcNext(frames[i], streamFlow);
+        pairwise->calc(frames[i - 1], frames[i], pairwiseFlow);
+        EXPECT_EQ(0, cvtest::norm(streamFlow, pairwiseFlow, NORM_INF)) << "frame " << i;
+    }
+
+    // a frame of another size starts a new sequence
+    Mat smallFrame;
+    resize(frames[0], smallFrame, Size(size.width / 2, size.height / 2));
+    stream->calcNext(smallFrame, streamFlow);
+    EXPECT_EQ(smallFrame.size(), streamFlow.size());
+    EXPECT_EQ(0, cvtest::norm(streamFlow, NORM_INF));
+}
+
 INSTANTIATE_TEST_CASE_P(FullSet, DenseOpticalFlow_DIS, Values(szODD, szQVGA));
 
 TEST_P(DenseOpticalFlow_VariationalRefinement, MultithreadReproducibility)
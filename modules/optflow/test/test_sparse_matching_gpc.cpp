@@ -0,0 +1,225 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef GPCTree::Node Node;
+typedef std::pair<Point2i, Point2i> Correspondence;
+
+static const int nTrees = 5;
+
+// Top-left quarter of RubberWhale, like the reference accuracy tests
+static bool readRubberWhaleQuarter(Mat &frame1, Mat &frame2, Mat &gt)
+{
+    const string path = cvtest::TS::ptr()->get_data_path() + "optflow/";
+    frame1 = imread(path + "RubberWhale1.png");
+    frame2 = imread(path + "RubberWhale2.png");
+    gt = readOpticalFlow(path + "RubberWhale.flo");
+    if (frame1.empty() || frame2.empty() || gt.empty())
+        return false;
+
+    const Rect roi(Point(), frame1.size() / 2);
+    frame1 = frame1(roi);
+    frame2 = frame2(roi);
+    gt = gt(roi);
+    return true;
+}
+
+static void trainForest(GPCForest<nTrees> &forest, const Mat &frame1, const Mat &frame2, const Mat &gt)
+{
+    vector<Mat> img1(1, frame1), img2(1, frame2), flow(1, gt);
+    forest.train(img1, img2, flow, GPCTrainingParams(8, 3, GPC_DESCRIPTOR_DCT, false));
+}
+
+static string writeToString(const Algorithm &algo)
+{
+    FileStorage fs(".yml", FileStorage::WRITE + FileStorage::MEMORY);
+    algo.write(fs);
+    return fs.releaseAndGetString();
+}
+
+static void getDescriptors(const Mat &img, vector<GPCPatchDescriptor> &descr)
+{
+    Mat ycrcb, ch[3];
+    img.convertTo(ycrcb, CV_32FC3);
+    cvtColor(ycrcb, ycrcb, COLOR_BGR2YCrCb);
+    split(ycrcb, ch);
+    GPCDetails::getAllDescriptorsForImage(ch, descr, GPCMatchingParams(), GPC_DESCRIPTOR_DCT);
+}
+
+// Walk over the nodes in the order they were produced by the training
+static unsigned refFindLeaf(const vector<Node> &nodes, const GPCPatchDescriptor &descr)
+{
+    unsigned id = 0, prevId;
+    do
+    {
+        prevId = id;
+        if (descr.dot(nodes[id].coef) < nodes[id].rhs)
+            id = nodes[id].right;
+        else
+            id = nodes[id].left;
+    } while (id);
+    return prevId;
+}
+
+struct RefTrail
+{
+    unsigned leaf[nTrees];
+    Point2i coord;
+
+    bool operator==(const RefTrail &t) const { return memcmp(leaf, t.leaf, sizeof(leaf)) == 0; }
+
+    bool operator<(const RefTrail &t) const
+    {
+        for (int i = 0; i < nTrees - 1; ++i)
+            if (leaf[i] != t.leaf[i])
+                return leaf[i] < t.leaf[i];
+        return leaf[nTrees - 1] < t.leaf[nTrees - 1];
+    }
+};
+
+static void getRefTrails(const vector<Node> *nodes, const Mat &img, vector<RefTrail> &trails)
+{
+    vector<GPCPatchDescriptor> descr;
+    getDescriptors(img, descr);
+    trails.resize(descr.size());
+    for (size_t i = 0; i < descr.size(); ++i)
+    {
+        GPCDetails::getCoordinatesFromIndex(i, img.size(), trails[i].coord.x, trails[i].coord.y);
+        for (int t = 0; t < nTrees; ++t)
+            trails[i].leaf[t] = refFindLeaf(nodes[t], descr[i]);
+    }
+}
+
+// Sort both trail sets and merge them, as findCorrespondences used to do
+static void refFindCorrespondences(const vector<Node> *nodes, const Mat &imgFrom, const Mat &imgTo, vector<Correspondence> &corr)
+{
+    vector<RefTrail> trailsFrom, trailsTo;
+    getRefTrails(nodes, imgFrom, trailsFrom);
+    getRefTrails(nodes, imgTo, trailsTo);
+
+    std::sort(trailsFrom.begin(), trailsFrom.end());
+    std::sort(trailsTo.begin(), trailsTo.end());
+
+    for (size_t i = 0; i < trailsFrom.size(); ++i)
+    {
+        bool uniq = true;
+        while (i + 1 < trailsFrom.size() && trailsFrom[i] == trailsFrom[i + 1])
+            ++i, uniq = false;
+        if (uniq)
+        {
+            vector<RefTrail>::const_iterator lb = std::lower_bound(trailsTo.begin(), trailsTo.end(), trailsFrom[i]);
+            if (lb != trailsTo.end() && *lb == trailsFrom[i] && ((lb + 1) == trailsTo.end() || !(*lb == *(lb + 1))))
+                corr.push_back(std::make_pair(trailsFrom[i].coord, lb->coord));
+        }
+    }
+
+    GPCDetails::dropOutliers(corr);
+}
+
+struct CorrespondenceLess
+{
+    bool operator()(const Correspondence &a, const Correspondence &b) const
+    {
+        if (a.first.y != b.first.y) return a.first.y < b.first.y;
+        if (a.first.x != b.first.x) return a.first.x < b.first.x;
+        if (a.second.y != b.second.y) return a.second.y < b.second.y;
+        return a.second.x < b.second.x;
+    }
+};
+
+TEST(GlobalPatchCollider, TrainingDoesNotDependOnThreads)
+{
+    Mat frame1, frame2, gt;
+    ASSERT_TRUE(readRubberWhaleQuarter(frame1, frame2, gt));
+
+    // both the sample shuffling and the tree seeds are drawn from theRNG()
+    Ptr< GPCForest<nTrees> > forest = GPCForest<nTrees>::create();
+    setRNGSeed(0x69C);
+    trainForest(*forest, frame1, frame2, gt);
+
+    const int numThreads = getNumThreads();
+    Ptr< GPCForest<nTrees> > forestSingle = GPCForest<nTrees>::create();
+    setNumThreads(1);
+    setRNGSeed(0x69C);
+    trainForest(*forestSingle, frame1, frame2, gt);
+    setNumThreads(numThreads);
+
+    EXPECT_EQ(writeToString(*forest), writeToString(*forestSingle));
+}
+
+TEST(GlobalPatchCollider, FlatTraversalMatchesNodeWalk)
+{
+    Mat frame1, frame2, gt;
+    ASSERT_TRUE(readRubberWhaleQuarter(frame1, frame2, gt));
+
+    vector<Mat> img1(1, frame1), img2(1, frame2), flow(1, gt);
+    Ptr<GPCTrainingSamples> samples = GPCTrainingSamples::create(img1, img2, flow, GPC_DESCRIPTOR_DCT);
+    Ptr<GPCTree> tree = GPCTree::create();
+    setRNGSeed(0x69C);
+    tree->train(*samples, GPCTrainingParams(8, 3, GPC_DESCRIPTOR_DCT, false));
+
+    const string stored = writeToString(*tree);
+    FileStorage fs(stored, FileStorage::READ + FileStorage::MEMORY);
+    vector<Node> nodes;
+    fs["nodes"] >> nodes;
+    ASSERT_LT(1u, nodes.size());
+
+    // the flat copy is rebuilt on read
+    Ptr<GPCTree> loaded = GPCTree::create();
+    loaded->read(fs.root());
+    EXPECT_TRUE(*loaded == *tree);
+
+    vector<GPCPatchDescriptor> descr;
+    getDescriptors(frame2, descr);
+    ASSERT_FALSE(descr.empty());
+
+    int mismatches = 0, mismatchesLoaded = 0;
+    for (size_t i = 0; i < descr.size(); ++i)
+    {
+        const unsigned leaf = refFindLeaf(nodes, descr[i]);
+        mismatches += tree->findLeafForPatch(descr[i]) != leaf;
+        mismatchesLoaded += loaded->findLeafForPatch(descr[i]) != leaf;
+    }
+    EXPECT_EQ(0, mismatches);
+    EXPECT_EQ(0, mismatchesLoaded);
+}
+
+TEST(GlobalPatchCollider, HashedMatchingMatchesSortMerge)
+{
+    Mat frame1, frame2, gt;
+    ASSERT_TRUE(readRubberWhaleQuarter(frame1, frame2, gt));
+
+    Ptr< GPCForest<nTrees> > forest = GPCForest<nTrees>::create();
+    setRNGSeed(0x69C);
+    trainForest(*forest, frame1, frame2, gt);
+
+    vector<Correspondence> corr;
+    forest->findCorrespondences(frame1, frame2, corr);
+
+    const string stored = writeToString(*forest);
+    FileStorage fs(stored, FileStorage::READ + FileStorage::MEMORY);
+    vector<Node> nodes[nTrees];
+    FileNodeIterator it = fs["trees"].begin();
+    for (int t = 0; t < nTrees; ++t, ++it)
+        (*it)["nodes"] >> nodes[t];
+
+    vector<Correspondence> ref;
+    refFindCorrespondences(nodes, frame1, frame2, ref);
+
+    // dropOutliers only depends on the set of pairs, not on their order
+    ASSERT_FALSE(ref.empty());
+    std::sort(corr.begin(), corr.end(), CorrespondenceLess());
+    std::sort(ref.begin(), ref.end(), CorrespondenceLess());
+    ASSERT_EQ(ref.size(), corr.size());
+    for (size_t i = 0; i < ref.size(); ++i)
+    {
+        EXPECT_EQ(ref[i].first, corr[i].first) << "pair " << i;
+        EXPECT_EQ(ref[i].second, corr[i].second) << "pair " << i;
+    }
+}
+
+}} // namespace
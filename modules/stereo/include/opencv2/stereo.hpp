@@ -158,6 +158,19 @@ namespace cv
 
             virtual int getAgregationWindowSize() const = 0;
             virtual void setAgregationWindowSize(int value) = 0;
+
+            //! when enabled, the Hamming costs are aggregated in a sliding window of rows and the disparities are formed
+            //! row by row on parallel horizontal bands, so the memory grows with width * numDisparities instead of
+            //! width * height * numDisparities. The disparity map is the same as in the default mode.
+            //! Images that are not wider than numDisparities always use the full cost volume.
+            virtual bool getUseStreaming() const = 0;
+            virtual void setUseStreaming(bool value) = 0;
+
+            //! CV_SIMETRICV_INTERPOLATION (default) or CV_QUADRATIC_INTERPOLATION. The quadratic interpolation fits
+            //! a parabola through the costs around the best disparity; it is computed for whole rows at once
+            //! and the left-right check is done on the fixed point disparities.
+            virtual int getSubPixelInterpolationMethod() const = 0;
+            virtual void setSubPixelInterpolationMethod(int value) = 0;
             /** @brief Creates StereoBM object
 
             @param numDisparities the disparity search range. For each pixel algorithm will find the best
@@ -179,7 +192,8 @@ namespace cv
 
         -   By default, the algorithm is single-pass, which means that you consider only 5 directions
         instead of 8. Set mode=StereoSGBM::MODE_HH in createStereoSGBM to run the full variant of the
-        algorithm but beware that it may consume a lot of memory.
+        algorithm but beware that it may consume a lot of memory. Set mode=StereoBinarySGBM::MODE_SGBM_PARALLEL
+        to split the image into horizontal bands that are processed in parallel.
         -   The algorithm matches blocks, not individual pixels. Though, setting blockSize=1 reduces the
         blocks to single pixels.
         -   Mutual information cost function is not implemented. Instead, a simpler Birchfield-Tomasi
@@ -198,7 +212,11 @@ namespace cv
             enum
             {
                 MODE_SGBM = 0,
-                MODE_HH   = 1
+                MODE_HH   = 1,
+                //! single-pass 5-direction algorithm, computed independently on horizontal bands of the image
+                //! in parallel (one band per thread). The paths coming from above are restarted a few rows
+                //! before each band, so the result may slightly differ from MODE_SGBM near the band borders.
+                MODE_SGBM_PARALLEL = 2
             };
 
             virtual int getPreFilterCap() const = 0;
@@ -256,7 +274,9 @@ namespace cv
             Normally, 1 or 2 is good enough.
             @param mode Set it to StereoSGBM::MODE_HH to run the full-scale two-pass dynamic programming
             algorithm. It will consume O(W\*H\*numDisparities) bytes, which is large for 640x480 stereo and
-            huge for HD-size pictures. By default, it is set to false .
+            huge for HD-size pictures. Set it to StereoBinarySGBM::MODE_SGBM_PARALLEL to run the single-pass
+            algorithm on horizontal bands of the image in parallel; the bands only depend on the image size and
+            blockSize, so the result does not depend on the number of threads. By default, it is set to StereoBinarySGBM::MODE_SGBM .
 
             The first constructor initializes StereoSGBM with all the default parameters. So, you only have to
             set StereoSGBM::numDisparities at minimum. The second constructor enables you to set each parameter
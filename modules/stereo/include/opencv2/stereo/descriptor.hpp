@@ -39,6 +39,20 @@ CV_EXPORTS void symetricCensusTransform(const Mat &img1, int kernelSize, Mat &di
 CV_EXPORTS void starCensusTransform(const Mat &img1, const Mat &img2, int kernelSize, Mat &dist1, Mat &dist2);
 ///single image version of star kernel
 CV_EXPORTS void starCensusTransform(const Mat &img1, int kernelSize, Mat &dist);
+/**
+Dense (CV_DENSE_CENSUS) or sparse (CV_SPARSE_CENSUS) census transform with 64 or 128 bit descriptors, for windows
+whose comparisons do not fit into the 32 bit descriptors of censusTransform (up to 7x7 dense / 15x15 sparse with 64 bits,
+11x11 dense / 21x21 sparse with 128 bits). The descriptors are stored in CV_32SC2 (64 bits) or CV_32SC4 (128 bits) images
+**/
+CV_EXPORTS void wideCensusTransform(const Mat &image1, const Mat &image2, int kernelSize, Mat &dist1, Mat &dist2, const int type, int descriptorBits = 64);
+///single image version of the wide census transform
+CV_EXPORTS void wideCensusTransform(const Mat &image1, int kernelSize, Mat &dist1, const int type, int descriptorBits = 64);
+/**
+Hamming cost volume of two descriptor images with 32, 64 or 128 bit descriptors (CV_32SC1, CV_32SC2 or CV_32SC4):
+cost(y, x * (maxDisparity + 1) + d) is the Hamming distance between left(y, x) and right(y, max(x - d, 0)),
+d = 0..maxDisparity. cost is a CV_16SC1 image of left.rows x left.cols * (maxDisparity + 1)
+**/
+CV_EXPORTS void hammingCostVolume(const Mat &left, const Mat &right, int maxDisparity, Mat &cost);
 
 }}  // namespace
 #endif
@@ -76,6 +76,37 @@ PERF_TEST_P( s_bm, sgm_perf,
     }
     SANITY_CHECK_NOTHING();
 }
+typedef tuple<Size, int> s_sgbm_mode_t;
+typedef perf::TestBaseWithParam<s_sgbm_mode_t> s_sgbm_mode;
+
+PERF_TEST_P( s_sgbm_mode, sgm_mode_perf,
+            testing::Combine(
+            testing::Values( cv::Size(640, 480), cv::Size(1280, 720) ),
+            testing::Values( (int)StereoBinarySGBM::MODE_SGBM, (int)StereoBinarySGBM::MODE_SGBM_PARALLEL )
+            )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int mode = get<1>(GetParam());
+
+    Mat left(sz, CV_8U);
+    Mat right(sz, CV_8U);
+    Mat out1(sz, CV_16S);
+    Ptr<StereoBinarySGBM> sgbm = StereoBinarySGBM::create(0, 64, 5);
+    sgbm->setBinaryKernelType(CV_DENSE_CENSUS);
+    sgbm->setMode(mode);
+    declare
+        .in(left, WARMUP_RNG)
+        .in(right, WARMUP_RNG)
+        .out(out1)
+        .time(0.1)
+        .iterations(20);
+    TEST_CYCLE()
+    {
+        sgbm->compute(left, right, out1);
+    }
+    SANITY_CHECK_NOTHING();
+}
 PERF_TEST_P( s_bm, bm_perf,
             testing::Combine(
             testing::Values( cv::Size(512, 383),  cv::Size(320, 240) ),
@@ -118,5 +149,38 @@ PERF_TEST_P( s_bm, bm_perf,
     SANITY_CHECK_NOTHING();
 }
 
+typedef tuple<Size, bool> s_bm_streaming_t;
+typedef perf::TestBaseWithParam<s_bm_streaming_t> s_bm_streaming;
+
+PERF_TEST_P( s_bm_streaming, bm_streaming_perf,
+            testing::Combine(
+            testing::Values( cv::Size(640, 480), cv::Size(1280, 720) ),
+            testing::Bool()
+            )
+            )
+{
+    Size sz = get<0>(GetParam());
+    bool streaming = get<1>(GetParam());
+
+    Mat left(sz, CV_8U);
+    Mat right(sz, CV_8U);
+    Mat out1(sz, CV_8U);
+    Ptr<StereoBinaryBM> sbm = StereoBinaryBM::create(64, 9);
+    sbm->setAgregationWindowSize(11);
+    sbm->setSpekleRemovalTechnique(CV_SPECKLE_REMOVAL_AVG_ALGORITHM);
+    sbm->setUseStreaming(streaming);
+
+    declare
+        .in(left, WARMUP_RNG)
+        .in(right, WARMUP_RNG)
+        .out(out1)
+        .time(0.1)
+        .iterations(20);
+    TEST_CYCLE()
+    {
+        sbm->compute(left, right, out1);
+    }
+    SANITY_CHECK_NOTHING();
+}
 
 }} // namespace
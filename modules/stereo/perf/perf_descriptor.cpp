@@ -139,5 +139,56 @@ PERF_TEST_P( descript_params, center_symetric_census,
     SANITY_CHECK_NOTHING();
 }
 
+typedef tuple<Size, MatType> hamming_params_t;
+typedef perf::TestBaseWithParam<hamming_params_t> hamming_params;
+
+PERF_TEST_P( hamming_params, hamming_cost_volume,
+            testing::Combine(
+            testing::Values( szVGA, sz720p ),
+            testing::Values( CV_32SC1, CV_32SC2, CV_32SC4 )
+            )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int descriptorType = get<1>(GetParam());
+
+    Mat left(sz, descriptorType);
+    Mat right(sz, descriptorType);
+    Mat cost;
+
+    declare.in(left, right, WARMUP_RNG)
+        .time(0.1);
+    TEST_CYCLE()
+    {
+        hammingCostVolume(left, right, 64, cost);
+    }
+    SANITY_CHECK_NOTHING();
+}
+PERF_TEST_P( descript_params, wide_census_transform,
+            testing::Combine(
+            testing::Values( TYPICAL_MAT_SIZES ),
+            testing::Values( CV_8U ),
+            testing::Values( CV_32SC2, CV_32SC4 )
+            )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int matType = get<1>(GetParam());
+    int sdepth = get<2>(GetParam());
+
+    Mat left(sz, matType);
+    Mat out1;
+
+    declare.in(left, WARMUP_RNG)
+        .time(0.01);
+    TEST_CYCLE()
+    {
+        if (sdepth == CV_32SC2)
+            wideCensusTransform(left, 7, out1, CV_DENSE_CENSUS, 64);
+        else
+            wideCensusTransform(left, 11, out1, CV_DENSE_CENSUS, 128);
+    }
+    SANITY_CHECK_NOTHING();
+}
 
 }} // namespace
@@ -96,6 +96,64 @@ namespace cv
                     CombinedDescriptor<2,2,1,1,CensusKernel<1> >(image1.cols, image1.rows,stride,n2,costs,CensusKernel<1>(images),n2));
             }
         }
+        //census with 64 or 128 bit descriptors for the windows which do not fit in 32 bits
+        CV_EXPORTS void wideCensusTransform(const Mat &image1, const Mat &image2, int kernelSize, Mat &dist1, Mat &dist2, const int type, int descriptorBits)
+        {
+            CV_Assert(image1.size() == image2.size());
+            CV_Assert(kernelSize % 2 != 0);
+            CV_Assert(image1.type() == CV_8UC1 && image2.type() == CV_8UC1);
+            CV_Assert(type == CV_DENSE_CENSUS || type == CV_SPARSE_CENSUS);
+            CV_Assert(descriptorBits == 64 || descriptorBits == 128);
+            CV_Assert(wideCensusComparisons(kernelSize, type) <= descriptorBits);
+            int n2 = kernelSize / 2;
+            int nwords = descriptorBits / 32;
+            dist1.create(image1.size(), CV_32SC(nwords));
+            dist2.create(image1.size(), CV_32SC(nwords));
+            Mat images[] = {image1, image2};
+            Mat dist[] = {dist1, dist2};
+            int step = type == CV_DENSE_CENSUS ? 1 : 2;
+            if(nwords == 2)
+                parallel_for_(Range(0, image1.rows), WideCensus<2>(images, dist, 2, n2, step));
+            else
+                parallel_for_(Range(0, image1.rows), WideCensus<4>(images, dist, 2, n2, step));
+        }
+        //wide census on one image
+        CV_EXPORTS void wideCensusTransform(const Mat &image1, int kernelSize, Mat &dist1, const int type, int descriptorBits)
+        {
+            CV_Assert(kernelSize % 2 != 0);
+            CV_Assert(image1.type() == CV_8UC1);
+            CV_Assert(type == CV_DENSE_CENSUS || type == CV_SPARSE_CENSUS);
+            CV_Assert(descriptorBits == 64 || descriptorBits == 128);
+            CV_Assert(wideCensusComparisons(kernelSize, type) <= descriptorBits);
+            int n2 = kernelSize / 2;
+            int nwords = descriptorBits / 32;
+            dist1.create(image1.size(), CV_32SC(nwords));
+            Mat images[] = {image1};
+            Mat dist[] = {dist1};
+            int step = type == CV_DENSE_CENSUS ? 1 : 2;
+            if(nwords == 2)
+                parallel_for_(Range(0, image1.rows), WideCensus<2>(images, dist, 1, n2, step));
+            else
+                parallel_for_(Range(0, image1.rows), WideCensus<4>(images, dist, 1, n2, step));
+        }
+        //Hamming distance for all the disparities between two descriptor images
+        CV_EXPORTS void hammingCostVolume(const Mat &left, const Mat &right, int maxDisparity, Mat &cost)
+        {
+            CV_Assert(left.size() == right.size() && left.type() == right.type());
+            CV_Assert(left.type() == CV_32SC1 || left.type() == CV_32SC2 || left.type() == CV_32SC4);
+            CV_Assert(maxDisparity >= 0);
+            cost.create(left.rows, left.cols * (maxDisparity + 1), CV_16S);
+            const unsigned *l = (const unsigned *)left.data, *r = (const unsigned *)right.data;
+            const size_t lstep = left.step / sizeof(unsigned), rstep = right.step / sizeof(unsigned);
+            const size_t cstep = cost.step / sizeof(short);
+            short *c = (short *)cost.data;
+            if(left.channels() == 1)
+                parallel_for_(Range(0, left.rows), HammingCostVolume<1>(l, lstep, r, rstep, c, cstep, left.cols, maxDisparity, 0));
+            else if(left.channels() == 2)
+                parallel_for_(Range(0, left.rows), HammingCostVolume<2>(l, lstep, r, rstep, c, cstep, left.cols, maxDisparity, 0));
+            else
+                parallel_for_(Range(0, left.rows), HammingCostVolume<4>(l, lstep, r, rstep, c, cstep, left.cols, maxDisparity, 0));
+        }
         //in a 9x9 kernel only certain positions are choosen for comparison
         CV_EXPORTS void starCensusTransform(const Mat &img1, const Mat &img2, int kernelSize, Mat &dist1, Mat &dist2)
         {
@@ -49,6 +49,9 @@
 #define _OPENCV_DESCRIPTOR_HPP_
 #ifdef __cplusplus
 
+#include "opencv2/core/hal/hal.hpp"
+#include "opencv2/core/hal/intrin.hpp"
+
 namespace cv
 {
     namespace stereo
@@ -407,6 +410,180 @@ namespace cv
                 }
             }
         };
+
+        //!number of comparisons of the wide census window
+        static inline int wideCensusComparisons(int kernelSize, int type)
+        {
+            const int n2 = kernelSize / 2;
+            if (type == CV_DENSE_CENSUS)
+                return kernelSize * kernelSize - 1;
+            // the sparse window samples every second pixel, it contains the center if n2 is even
+            return (n2 + 1) * (n2 + 1) - (n2 % 2 == 0 ? 1 : 0);
+        }
+
+        //!number of 32 bit words of the census descriptors used by the matchers: 1 for the kernels computed
+        //!by the 32 bit census transforms, 2 or 4 for the dense and sparse census windows with more than 32 comparisons
+        static inline int wideCensusWords(int kernelType, int kernelSize)
+        {
+            if (kernelType != CV_DENSE_CENSUS && kernelType != CV_SPARSE_CENSUS)
+                return 1;
+            const int comparisons = wideCensusComparisons(kernelSize, kernelType);
+            if (comparisons <= 32)
+                return 1;
+            return comparisons <= 64 ? 2 : 4;
+        }
+
+        //!census transform that packs the comparisons of the window into nwords 32 bit words,
+        //!the first comparison in the least significant bit of the first word. With step == 2
+        //!only every second pixel of the window is compared (the sparse census)
+        template<int nwords>
+        class WideCensus:public ParallelLoopBody
+        {
+        private:
+            const uint8_t *image[2];
+            uint8_t *dst[2];
+            size_t imageStep[2], dstStep[2];
+            int n2, step, width, height, im_num;
+        public:
+            WideCensus(const cv::Mat *img, cv::Mat *distance, int numImages, int k2, int sampleStep)
+            {
+                for(int i = 0; i < numImages; i++)
+                {
+                    image[i] = img[i].data;
+                    imageStep[i] = img[i].step;
+                    dst[i] = distance[i].data;
+                    dstStep[i] = distance[i].step;
+                }
+                im_num = numImages;
+                n2 = k2;
+                step = sampleStep;
+                width = img[0].cols;
+                height = img[0].rows;
+            }
+
+            void operator()(const cv::Range &r) const CV_OVERRIDE {
+                for (int d = 0; d < im_num; d++)
+                {
+                    for (int i = r.start; i < r.end; i++)
+                    {
+                        const uint8_t *center = image[d] + i * imageStep[d];
+                        unsigned *out = (unsigned *)(dst[d] + i * dstStep[d]);
+                        memset(out, 0, sizeof(out[0]) * width * nwords);
+                        if (i < n2 || i >= height - n2)
+                            continue;
+                        for (int j = n2; j < width - n2; j++)
+                        {
+                            unsigned c[nwords] = { 0 };
+                            int bit = 0;
+                            for (int ii = -n2; ii <= n2; ii += step)
+                            {
+                                const uint8_t *row = image[d] + (i + ii) * imageStep[d] + j;
+                                for (int jj = -n2; jj <= n2; jj += step)
+                                {
+                                    if (ii == 0 && jj == 0)
+                                        continue;
+                                    c[bit >> 5] |= (unsigned)(row[jj] > center[j]) << (bit & 31);
+                                    bit++;
+                                }
+                            }
+                            for (int w = 0; w < nwords; w++)
+                                out[j * nwords + w] = c[w];
+                        }
+                    }
+                }
+            }
+        };
+
+#if CV_SIMD128
+        //!Hamming distances between one descriptor and 4 consecutive descriptors of nwords words
+        template<int nwords> struct HammingBlock;
+        template<> struct HammingBlock<1>
+        {
+            v_uint32x4 l0;
+            HammingBlock(const unsigned *l) : l0(v_setall_u32(l[0])) {}
+            v_uint32x4 operator()(const unsigned *q) const
+            {
+                return v_popcount(v_load(q) ^ l0);
+            }
+        };
+        template<> struct HammingBlock<2>
+        {
+            v_uint32x4 l0, l1;
+            HammingBlock(const unsigned *l) : l0(v_setall_u32(l[0])), l1(v_setall_u32(l[1])) {}
+            v_uint32x4 operator()(const unsigned *q) const
+            {
+                v_uint32x4 a, b;
+                v_load_deinterleave(q, a, b);
+                return v_popcount(a ^ l0) + v_popcount(b ^ l1);
+            }
+        };
+        template<> struct HammingBlock<4>
+        {
+            v_uint32x4 l0, l1, l2, l3;
+            HammingBlock(const unsigned *l) : l0(v_setall_u32(l[0])), l1(v_setall_u32(l[1])),
+                l2(v_setall_u32(l[2])), l3(v_setall_u32(l[3])) {}
+            v_uint32x4 operator()(const unsigned *q) const
+            {
+                v_uint32x4 a, b, c, d;
+                v_load_deinterleave(q, a, b, c, d);
+                return (v_popcount(a ^ l0) + v_popcount(b ^ l1)) + (v_popcount(c ^ l2) + v_popcount(d ^ l3));
+            }
+        };
+#endif
+
+        //!Hamming cost volume: cost[j * (maxDisp + 1) + d] = popcount(left[j] ^ right[max(j - d, 0)]).
+        //!Each right row is copied in reverse order, so that the descriptors matched against a left pixel
+        //!for increasing disparities are contiguous and 8 disparities are evaluated per iteration
+        template<int nwords>
+        class HammingCostVolume:public ParallelLoopBody
+        {
+        private:
+            const unsigned *left, *right;
+            size_t leftStep, rightStep, costStep;
+            short *c;
+            int width, maxDisp, border;
+        public:
+            HammingCostVolume(const unsigned *leftData, size_t leftRowStep, const unsigned *rightData, size_t rightRowStep,
+                short *cost, size_t costRowStep, int w, int maxDisparity, int borderSize) :
+                left(leftData), right(rightData), leftStep(leftRowStep), rightStep(rightRowStep), costStep(costRowStep),
+                c(cost), width(w), maxDisp(maxDisparity), border(borderSize) {}
+
+            void operator()(const cv::Range &r) const CV_OVERRIDE {
+                const int ndisp = maxDisp + 1;
+                AutoBuffer<unsigned> _rev((size_t)(width + maxDisp) * nwords);
+                unsigned *rev = _rev.data();
+                for (int i = r.start; i < r.end; i++)
+                {
+                    const unsigned *l = left + i * leftStep;
+                    const unsigned *rr = right + i * rightStep;
+                    short *ci = c + i * costStep;
+                    // rev[k] = right[max(width - 1 - k, 0)]
+                    for (int k = 0; k < width + maxDisp; k++)
+                    {
+                        const unsigned *src = rr + std::max(width - 1 - k, 0) * nwords;
+                        for (int w = 0; w < nwords; w++)
+                            rev[k * nwords + w] = src[w];
+                    }
+                    for (int j = border; j < width - border; j++)
+                    {
+                        const unsigned *lj = l + j * nwords;
+                        const unsigned *q = rev + (width - 1 - j) * nwords;
+                        short *cj = ci + j * ndisp;
+                        int d = 0;
+#if CV_SIMD128
+                        HammingBlock<nwords> hamming(lj);
+                        for (; d <= ndisp - 8; d += 8)
+                        {
+                            v_uint16x8 cost8 = v_pack(hamming(q + d * nwords), hamming(q + (d + 4) * nwords));
+                            v_store(cj + d, v_reinterpret_as_s16(cost8));
+                        }
+#endif
+                        for (; d < ndisp; d++)
+                            cj[d] = (short)hal::normHamming((const uchar *)lj, (const uchar *)(q + d * nwords), nwords * (int)sizeof(unsigned));
+                    }
+                }
+            }
+        };
     }
 }
 #endif
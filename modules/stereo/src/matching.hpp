@@ -48,7 +48,9 @@
 #define _OPENCV_MATCHING_HPP_
 
 #include <stdint.h>
+#include <vector>
 #include "opencv2/core.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv
 {
@@ -63,8 +65,8 @@ namespace cv
             int scallingFactor;
             //!the confidence to which a min disparity found is good or not
             double confidenceCheck;
-            //!the LUT used in case SSE is not available
-            int hamLut[65536];  // FIXIT use preferined 8-bit lookup table for hamming
+            //!the subpixel interpolation used by makeMap, CV_SIMETRICV_INTERPOLATION or CV_QUADRATIC_INTERPOLATION
+            int interpolationMethod;
             //!function used for getting the minimum disparity from the cost volume"
             static int minim(short *c, int iwpj, int widthDisp,const double confidence, const int search_region)
             {
@@ -128,60 +130,6 @@ namespace cv
                     p = winDisp + p;
                 return p;
             }
-            //!a pre processing function that generates the Hamming LUT in case the algorithm will ever be used on platform where SSE is not available
-            void hammingLut()
-            {
-                for (int i = 0; i < 65536; i++)
-                {
-                    int dist = 0;
-                    int j = i;
-                    //we number the bits from our number
-                    while (j)
-                    {
-                        dist = dist + 1;
-                        j = j & (j - 1);
-                    }
-                    hamLut[i] = dist;
-                }
-            }
-            //!the class used in computing the hamming distance
-            class hammingDistance : public ParallelLoopBody
-            {
-            private:
-                int *left, *right;
-                short *c;
-                int v,kernelSize, width;
-                int MASK;
-                int *hammLut;
-            public :
-                hammingDistance(const Mat &leftImage, const Mat &rightImage, short *cost, int maxDisp, int kerSize, int *hammingLUT):
-                    left((int *)leftImage.data), right((int *)rightImage.data), c(cost), v(maxDisp),kernelSize(kerSize),width(leftImage.cols), MASK(65535), hammLut(hammingLUT){}
-                void operator()(const cv::Range &r) const CV_OVERRIDE {
-                    for (int i = r.start; i < r.end ; i++)
-                    {
-                        int iw = i * width;
-                        for (int j = kernelSize; j < width - kernelSize; j++)
-                        {
-                            int iwj = iw + j;
-                            for (int d = 0; d <= v; d++)
-                            {
-                                int j2 = std::max(0, j - d);
-                                int xorul = left[(iwj)] ^ right[(iw + j2)];
-#if CV_POPCNT
-                                if (checkHardwareSupport(CV_CPU_POPCNT))
-                                {
-                                    c[(iwj)* (v + 1) + d] = (short)_mm_popcnt_u32(xorul);
-                                }
-                                else
-#endif
-                                {
-                                    c[(iwj)* (v + 1) + d] = (short)(hammLut[xorul & MASK] + hammLut[(xorul >> 16) & MASK]);
-                                }
-                            }
-                        }
-                    }
-                }
-            };
             //!cost aggregation
             class agregateCost:public ParallelLoopBody
             {
@@ -234,12 +182,12 @@ namespace cv
             private:
                 //enum used to notify wether we are searching on the vertical ie (lr) or diagonal (rl)
                 enum {CV_VERTICAL_SEARCH, CV_DIAGONAL_SEARCH};
-                int width,disparity,scallingFact,th;
+                int width,disparity,scallingFact,th,interpolation;
                 double confCheck;
                 uint8_t *map;
                 short *c;
             public:
-                makeMap(const Mat &costVolume, int threshold, int maxDisp, double confidence,int scale, Mat &mapFinal)
+                makeMap(const Mat &costVolume, int threshold, int maxDisp, double confidence,int scale, int interpolationMethod, Mat &mapFinal)
                 {
                     c = (short *)costVolume.data;
                     map = mapFinal.data;
@@ -248,8 +196,27 @@ namespace cv
                     th = threshold;
                     scallingFact = scale;
                     confCheck = confidence;
+                    interpolation = interpolationMethod;
+                }
+                //!costVolume holds rows of width * (maxDisp + 1) costs and mapFinal rows of width disparities
+                makeMap(const short *costVolume, int w, int threshold, int maxDisp, double confidence, int scale, int interpolationMethod,
+                    uint8_t *mapFinal)
+                {
+                    c = (short *)costVolume;
+                    map = mapFinal;
+                    disparity = maxDisp;
+                    width = w;
+                    th = threshold;
+                    scallingFact = scale;
+                    confCheck = confidence;
+                    interpolation = interpolationMethod;
                 }
                 void operator()(const cv::Range &r) const CV_OVERRIDE {
+                    if (interpolation == CV_QUADRATIC_INTERPOLATION)
+                    {
+                        parabolicMap(r);
+                        return;
+                    }
                     for (int i = r.start; i < r.end ; i++)
                     {
                         int lr;
@@ -289,6 +256,358 @@ namespace cv
                         }
                     }
                 }
+            private:
+                //!the same search as above, but the minima found on a row are refined all at once by parabolicSubpixel
+                //!the disparities are compared in fixed point, with scallingFact steps per pixel
+                void parabolicMap(const cv::Range &r) const
+                {
+                    const int ndisp = disparity + 1;
+                    AutoBuffer<short> _buf((size_t)width * 10);
+                    short *lrBuf = _buf.data(), *vBuf = lrBuf + width;
+                    // costs around the minimum of the vertical search, then of the diagonal one
+                    short *vm = vBuf + width, *v0 = vm + width, *vp = v0 + width;
+                    short *dm = vp + width, *d0 = dm + width, *dp = d0 + width;
+                    short *p2 = dp + width, *p1 = p2 + width;
+                    for (int i = r.start; i < r.end; i++)
+                    {
+                        int iw = i * width;
+                        for (int j = 0; j < width; j++)
+                        {
+                            const int lr = Matching::minim(c, iw + j, ndisp, confCheck, CV_VERTICAL_SEARCH);
+                            const int v = lr != -1 ? Matching::minim(c, iw + j - lr, ndisp, confCheck, CV_DIAGONAL_SEARCH) : -1;
+                            lrBuf[j] = (short)lr;
+                            vBuf[j] = (short)v;
+                            // no refinement at the ends of the range, like in symetricVInterpolation
+                            const short *cl = c + (iw + j) * ndisp;
+                            const int l = std::max(lr, 0);
+                            v0[j] = cl[l];
+                            vm[j] = l > 0 && l < disparity ? cl[l - 1] : v0[j];
+                            vp[j] = l > 0 && l < disparity ? cl[l + 1] : v0[j];
+                            const short *cd = c + (iw + j - lr) * ndisp;
+                            const int k = std::max(v, 0);
+                            d0[j] = v != -1 ? cd[k * ndisp + k] : 0;
+                            dm[j] = k > 0 && k < disparity ? cd[(k - 1) * ndisp + k - 1] : d0[j];
+                            dp[j] = k > 0 && k < disparity ? cd[(k + 1) * ndisp + k + 1] : d0[j];
+                        }
+                        Matching::parabolicSubpixel(vm, v0, vp, lrBuf, width, scallingFact, p2);
+                        Matching::parabolicSubpixel(dm, d0, dp, vBuf, width, scallingFact, p1);
+                        for (int j = 0; j < width; j++)
+                        {
+                            if (lrBuf[j] == -1)
+                                map[iw + j] = 0;
+                            else if (vBuf[j] != -1)
+                                map[iw + j] = std::abs(p1[j] - p2[j]) <= th * scallingFact ? (uint8_t)p2[j] : 0;
+                            else if (width - j <= disparity)
+                                map[iw + j] = (uint8_t)p2[j];
+                        }
+                    }
+                }
+            };
+            //!adds (sign > 0) or subtracts a row of Hamming costs to the column sums
+            //!the sums wrap around like the short partial sums of costGathering, so the aggregated costs are the same
+            static void accumulateRow(ushort *sum, const short *row, size_t n, int sign)
+            {
+                size_t k = 0;
+#if CV_SIMD128
+                if (sign > 0)
+                {
+                    for (; k + 8 <= n; k += 8)
+                        v_store(sum + k, v_add_wrap(v_load(sum + k), v_reinterpret_as_u16(v_load(row + k))));
+                }
+                else
+                {
+                    for (; k + 8 <= n; k += 8)
+                        v_store(sum + k, v_sub_wrap(v_load(sum + k), v_reinterpret_as_u16(v_load(row + k))));
+                }
+#endif
+                for (; k < n; k++)
+                    sum[k] = (ushort)(sign > 0 ? sum[k] + (ushort)row[k] : sum[k] - (ushort)row[k]);
+            }
+            //!horizontal part of the aggregation, the same window as agregateCost
+            //!(rows are already summed in colSum, columns j - win - 1 ... j + win - 1 are added here)
+            static void aggregateRow(const ushort *colSum, ushort *out, int width, int ndisp, int win)
+            {
+                memset(out, 0, sizeof(out[0]) * width * ndisp);
+                const int j0 = win + 1, j1 = width - win - 1;
+                if (j0 >= j1)
+                    return;
+                ushort *o = out + j0 * ndisp;
+                for (int s = 0; s <= 2 * win; s++)
+                {
+                    for (int d = 0; d < ndisp; d++)
+                        o[d] = (ushort)(o[d] + colSum[s * ndisp + d]);
+                }
+                for (int j = j0 + 1; j < j1; j++)
+                {
+                    const ushort *prev = out + (j - 1) * ndisp;
+                    const ushort *add = colSum + (j + win - 1) * ndisp;
+                    const ushort *sub = colSum + (j - win - 2) * ndisp;
+                    o = out + j * ndisp;
+                    int d = 0;
+#if CV_SIMD128
+                    for (; d <= ndisp - 8; d += 8)
+                        v_store(o + d, v_sub_wrap(v_add_wrap(v_load(prev + d), v_load(add + d)), v_load(sub + d)));
+#endif
+                    for (; d < ndisp; d++)
+                        o[d] = (ushort)(prev[d] + add[d] - sub[d]);
+                }
+            }
+            //!streaming version of the block matching, used on horizontal bands of the image
+            //!every band slides a window of Hamming cost rows down the image, keeps their column sums
+            //!and forms the disparities each time STREAM_BLOCK_ROWS aggregated rows are ready
+            template <int nwords>
+            class streamingMatch:public ParallelLoopBody
+            {
+            private:
+                const unsigned *left, *right;
+                size_t step;
+                uint8_t *map;
+                std::vector<Mat> *buffers;
+                int width, height, maxDisp, n2, win, nbands, th, scallingFact, interpolation;
+                double confCheck;
+            public:
+                streamingMatch(const Mat &leftImage, const Mat &rightImage, int kernelSize, int windowSize, int maxDisparity,
+                    double confidence, int scale, int interpolationMethod, int threshold, int bands, std::vector<Mat> &bandBuffers, Mat &mapFinal)
+                {
+                    left = (const unsigned *)leftImage.data;
+                    right = (const unsigned *)rightImage.data;
+                    step = (size_t)leftImage.cols * nwords;
+                    map = mapFinal.data;
+                    buffers = &bandBuffers;
+                    width = leftImage.cols;
+                    height = leftImage.rows;
+                    maxDisp = maxDisparity;
+                    n2 = kernelSize / 2;
+                    win = windowSize / 2;
+                    nbands = bands;
+                    th = threshold;
+                    scallingFact = scale;
+                    confCheck = confidence;
+                    interpolation = interpolationMethod;
+                }
+                void operator()(const cv::Range &r) const CV_OVERRIDE {
+                    const int ndisp = maxDisp + 1;
+                    const size_t rowSize = (size_t)width * ndisp;
+                    const int ringRows = 2 * win + 1;
+                    // only these rows have non zero aggregated costs
+                    const int first = win + 1, last = height - win - 1;
+                    for (int b = r.start; b < r.end; b++)
+                    {
+                        const int y0 = first + (last - first) * b / nbands;
+                        const int y1 = first + (last - first) * (b + 1) / nbands;
+                        if (y0 >= y1)
+                            continue;
+                        Mat &buf = (*buffers)[b];
+                        buf.create(ringRows + STREAM_BLOCK_ROWS + 3, (int)rowSize, CV_16S);
+                        short *ring = buf.ptr<short>(0);
+                        ushort *colSum = buf.ptr<ushort>(ringRows);
+                        ushort *block = buf.ptr<ushort>(ringRows + 1);
+
+                        // the block holds the aggregated rows base ... base + filled - 1
+                        int base = y0 - 1, filled = 0;
+                        memset(colSum, 0, sizeof(colSum[0]) * rowSize);
+                        for (int k = base - win; k < base + win; k++)
+                        {
+                            short *slot = ring + (k % ringRows) * rowSize;
+                            hammingRow(k, slot);
+                            accumulateRow(colSum, slot, rowSize, 1);
+                        }
+                        for (int i = base; i <= y1; i++)
+                        {
+                            // the row i + win takes the place of the row i - win - 1
+                            short *slot = ring + ((i + win) % ringRows) * rowSize;
+                            if (i > base)
+                                accumulateRow(colSum, slot, rowSize, -1);
+                            hammingRow(i + win, slot);
+                            accumulateRow(colSum, slot, rowSize, 1);
+
+                            ushort *out = block + filled * rowSize;
+                            if (i >= first && i < last)
+                                aggregateRow(colSum, out, width, ndisp, win);
+                            else
+                                memset(out, 0, sizeof(out[0]) * rowSize);
+                            filled++;
+
+                            if (filled == STREAM_BLOCK_ROWS + 2 || i == y1)
+                            {
+                                // the diagonal search of makeMap may read the rows above and below
+                                makeMap wta((const short *)block, width, th, maxDisp, confCheck, scallingFact, interpolation,
+                                    map + (size_t)base * width);
+                                wta(Range(1, filled - 1));
+                                memmove(block, block + (filled - 2) * rowSize, 2 * rowSize * sizeof(block[0]));
+                                base += filled - 2;
+                                filled = 2;
+                            }
+                        }
+                    }
+                }
+            private:
+                void hammingRow(int i, short *c) const
+                {
+                    memset(c, 0, sizeof(c[0]) * width * (maxDisp + 1));
+                    if (i >= n2 && i < height - n2)
+                    {
+                        // a zero row step writes the costs of row i at c
+                        HammingCostVolume<nwords> hamming(left, step, right, step, c, 0, width, maxDisp, n2);
+                        hamming(Range(i, i + 1));
+                    }
+                }
+            };
+            //!the zero pixels of a band of rows of the disparity map, labelled by speckleLabeling
+            struct SpeckleBand
+            {
+                //!equivalences between the provisional labels, then the final label of every provisional one
+                std::vector<int> parent;
+                //!area of every region, and sum and number of the good pixels around it
+                std::vector<int> area, sum, count;
+                int labels;
+            };
+            //!labels the 8-connected regions of zero pixels of every band, the labels start from 0 in every band
+            template <typename T>
+            class speckleLabeling:public ParallelLoopBody
+            {
+            private:
+                const Mat *map;
+                Mat_<int> *labels;
+                std::vector<SpeckleBand> *bands;
+                int nbands;
+                static int find(std::vector<int> &parent, int l)
+                {
+                    while (parent[l] != l)
+                        l = parent[l] = parent[parent[l]];
+                    return l;
+                }
+            public:
+                speckleLabeling(const Mat &currentMap, Mat_<int> &labelImage, std::vector<SpeckleBand> &bandData, int bandCount)
+                {
+                    map = &currentMap;
+                    labels = &labelImage;
+                    bands = &bandData;
+                    nbands = bandCount;
+                }
+                void operator()(const cv::Range &r) const CV_OVERRIDE {
+                    const int height = map->rows, width = map->cols;
+                    const int di[] = { -1, -1, -1, 0, 1, 1, 1, 0 },
+                        dj[] = { -1, 0, 1, 1, 1, 0, -1, -1 };
+                    for (int b = r.start; b < r.end; b++)
+                    {
+                        const int y0 = height * b / nbands, y1 = height * (b + 1) / nbands;
+                        SpeckleBand &band = (*bands)[b];
+                        std::vector<int> &parent = band.parent;
+                        parent.clear();
+                        // first pass, provisional labels: the left neighbour and the ones above are already labelled
+                        for (int i = y0; i < y1; i++)
+                        {
+                            const T *m = map->ptr<T>(i);
+                            int *lab = labels->ptr<int>(i);
+                            const int *labAbove = i > y0 ? labels->ptr<int>(i - 1) : 0;
+                            for (int j = 0; j < width; j++)
+                            {
+                                if (m[j] != 0)
+                                {
+                                    lab[j] = -1;
+                                    continue;
+                                }
+                                int l = j > 0 && lab[j - 1] >= 0 ? find(parent, lab[j - 1]) : -1;
+                                for (int dx = -1; labAbove && dx <= 1; dx++)
+                                {
+                                    if (j + dx < 0 || j + dx >= width || labAbove[j + dx] < 0)
+                                        continue;
+                                    const int a = find(parent, labAbove[j + dx]);
+                                    if (l < 0)
+                                        l = a;
+                                    else if (a != l)
+                                    {
+                                        parent[std::max(a, l)] = std::min(a, l);
+                                        l = std::min(a, l);
+                                    }
+                                }
+                                if (l < 0)
+                                {
+                                    l = (int)parent.size();
+                                    parent.push_back(l);
+                                }
+                                lab[j] = l;
+                            }
+                        }
+                        // every label points to a smaller one, so the final labels can be assigned in one pass
+                        int n = 0;
+                        for (size_t l = 0; l < parent.size(); l++)
+                            parent[l] = parent[l] == (int)l ? n++ : parent[parent[l]];
+                        band.labels = n;
+                        band.area.assign(n, 0);
+                        band.sum.assign(n, 0);
+                        band.count.assign(n, 0);
+                        // second pass, final labels and the good neighbours of every region
+                        for (int i = y0; i < y1; i++)
+                        {
+                            int *lab = labels->ptr<int>(i);
+                            for (int j = 0; j < width; j++)
+                            {
+                                if (lab[j] < 0)
+                                    continue;
+                                const int l = lab[j] = parent[lab[j]];
+                                band.area[l]++;
+                                for (int d = 0; d < 8; d++)
+                                {
+                                    const int ii = i + di[d], jj = j + dj[d];
+                                    if (ii < 0 || ii >= height || jj < 0 || jj >= width)
+                                        continue;
+                                    const int val = map->ptr<T>(ii)[jj];
+                                    if (val >= 1 && val < 250)
+                                    {
+                                        band.sum[l] += val;
+                                        band.count[l]++;
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            };
+            //!writes the disparities of the bands, the small regions of zero pixels get their fill value
+            template <typename T>
+            class speckleFilling:public ParallelLoopBody
+            {
+            private:
+                const Mat *map;
+                const Mat_<int> *labels;
+                const int *fill, *offsets;
+                int nbands;
+                Mat *out;
+            public:
+                speckleFilling(const Mat &currentMap, const Mat_<int> &labelImage, const std::vector<int> &fillValues,
+                    const std::vector<int> &labelOffsets, int bandCount, Mat &outputMap)
+                {
+                    map = &currentMap;
+                    labels = &labelImage;
+                    fill = fillValues.empty() ? 0 : &fillValues[0];
+                    offsets = &labelOffsets[0];
+                    nbands = bandCount;
+                    out = &outputMap;
+                }
+                void operator()(const cv::Range &r) const CV_OVERRIDE {
+                    const int height = map->rows, width = map->cols;
+                    for (int b = r.start; b < r.end; b++)
+                    {
+                        const int y0 = height * b / nbands, y1 = height * (b + 1) / nbands;
+                        for (int i = y0; i < y1; i++)
+                        {
+                            const T *m = map->ptr<T>(i);
+                            const int *lab = labels->ptr<int>(i);
+                            T *o = out->ptr<T>(i);
+                            for (int j = 0; j < width; j++)
+                            {
+                                if (i < 1 || i >= height - 1 || j < 1 || j >= width - 1)
+                                    o[j] = 0;
+                                else if (m[j] != 0)
+                                    o[j] = m[j];
+                                else
+                                    o[j] = (T)fill[offsets[b] + lab[j]];
+                            }
+                        }
+                    }
+                }
             };
             //!median 1x9 paralelized filter
             template <typename T>
@@ -383,13 +702,21 @@ namespace cv
                 }
             };
         protected:
-            //arrays used in the region removal
-            Mat_<int> speckleY;
-            Mat_<int> speckleX;
-            Mat_<int> puss;
-            //int *specklePointX;
-            //int *specklePointY;
-            //long long *pus;
+            //!number of aggregated cost rows that streamingBlockMatching keeps besides the two neighbouring rows
+            static const int STREAM_BLOCK_ROWS = 8;
+            //!buffers of streamingBlockMatching, one for every band
+            std::vector<Mat> streamBuffers;
+            //buffers used in the region removal, the labels of the zero pixels and the tables used to merge them
+            Mat_<int> speckleLabels;
+            std::vector<SpeckleBand> speckleBands;
+            std::vector<int> speckleParents, speckleStats, speckleFill;
+            //!root of a merged label, with path halving
+            int findSpeckleRoot(int l)
+            {
+                while (speckleParents[l] != l)
+                    l = speckleParents[l] = speckleParents[speckleParents[l]];
+                return l;
+            }
             //!method for setting the maximum disparity
             void setMaxDisparity(int val)
             {
@@ -423,19 +750,43 @@ namespace cv
             {
                 return confidenceCheck;
             }
+            //!setter for the subpixel interpolation of the disparity map
+            void setInterpolationMethod(int val)
+            {
+                CV_Assert(val == CV_QUADRATIC_INTERPOLATION || val == CV_SIMETRICV_INTERPOLATION);
+                this->interpolationMethod = val;
+            }
+            //!getter for the subpixel interpolation
+            int getInterpolationMethod()
+            {
+                return interpolationMethod;
+            }
             //! Hamming distance computation method
             //! leftImage and rightImage are the two transformed images
             //! the cost is the resulted cost volume and kernel Size is the size of the matching window
-            void hammingDistanceBlockMatching(const Mat &leftImage, const Mat &rightImage, Mat &cost, const int kernelSize= 9)
+            //! descriptorWords is the number of 32 bit words of a descriptor (1 for the 32 bit descriptors
+            //! stored contiguously, 2 or 4 for the CV_32SC2 / CV_32SC4 output of wideCensusTransform)
+            void hammingDistanceBlockMatching(const Mat &leftImage, const Mat &rightImage, Mat &cost, const int kernelSize= 9, const int descriptorWords = 1)
             {
                 CV_Assert(leftImage.cols == rightImage.cols);
                 CV_Assert(leftImage.rows == rightImage.rows);
                 CV_Assert(kernelSize % 2 != 0);
                 CV_Assert(cost.rows == leftImage.rows);
                 CV_Assert(cost.cols / (maxDisparity + 1) == leftImage.cols);
+                CV_Assert(descriptorWords == 1 || descriptorWords == 2 || descriptorWords == 4);
                 short *c = (short *)cost.data;
                 memset(c, 0, sizeof(c[0]) * leftImage.cols * leftImage.rows * (maxDisparity + 1));
-                parallel_for_(cv::Range(kernelSize / 2,leftImage.rows - kernelSize / 2), hammingDistance(leftImage,rightImage,(short *)cost.data,maxDisparity,kernelSize / 2,hamLut));
+                const int n2 = kernelSize / 2;
+                const unsigned *left = (const unsigned *)leftImage.data, *right = (const unsigned *)rightImage.data;
+                const size_t step = (size_t)leftImage.cols * descriptorWords;
+                const size_t costStep = (size_t)leftImage.cols * (maxDisparity + 1);
+                const cv::Range rows(n2, leftImage.rows - n2);
+                if (descriptorWords == 1)
+                    parallel_for_(rows, HammingCostVolume<1>(left, step, right, step, c, costStep, leftImage.cols, maxDisparity, n2));
+                else if (descriptorWords == 2)
+                    parallel_for_(rows, HammingCostVolume<2>(left, step, right, step, c, costStep, leftImage.cols, maxDisparity, n2));
+                else
+                    parallel_for_(rows, HammingCostVolume<4>(left, step, right, step, c, costStep, leftImage.cols, maxDisparity, n2));
             }
             //preprocessing the cost volume in order to get it ready for aggregation
             void costGathering(const Mat &hammingDistanceCost, Mat &cost)
@@ -490,95 +841,97 @@ namespace cv
                 parallel_for_(cv::Range(0, height), agregateCost(partialSums,windowSize, maxDisp, cost));
             }
             //!remove small regions that have an area smaller than t, we fill the region with the average of the good pixels around it
+            //!the zero pixels are labelled on horizontal bands in parallel, the labels that touch across the band borders are merged
+            //!and the regions are filled in parallel again. The labels and the merge tables are kept between the calls.
+            //!currentMap and out can be the same matrix
             template <typename T>
             void smallRegionRemoval(const Mat &currentMap, int t, Mat &out)
             {
-                CV_Assert(currentMap.data != out.data && "inplace is not supported");
                 CV_Assert(currentMap.cols == out.cols);
                 CV_Assert(currentMap.rows == out.rows);
                 CV_Assert(t >= 0);
-                CV_Assert(!puss.empty());
-                int *specklePointX = (int *)speckleX.data;
-                int *specklePointY = (int *)speckleY.data;
-                puss.setTo(Scalar::all(0));
-                T *map = (T *)currentMap.data;
-                T *outputMap = (T *)out.data;
-                int height = currentMap.rows;
-                int width = currentMap.cols;
-                T k = 1;
-                int st, dr;
-                int di[] = { -1, -1, -1, 0, 1, 1, 1, 0 },
-                    dj[] = { -1, 0, 1, 1, 1, 0, -1, -1 };
-                int speckle_size = 0;
-                st = 0;
-                dr = 0;
-                for (int i = 0; i < height; i++)
+                const int height = currentMap.rows, width = currentMap.cols;
+                speckleLabels.create(height, width);
+                const int nbands = std::max(1, std::min(getNumThreads(), height / 8));
+                if ((int)speckleBands.size() < nbands)
+                    speckleBands.resize(nbands);
+                parallel_for_(Range(0, nbands), speckleLabeling<T>(currentMap, speckleLabels, speckleBands, nbands));
+
+                // the labels of every band follow the ones of the previous bands
+                std::vector<int> offsets(nbands + 1, 0);
+                for (int b = 0; b < nbands; b++)
+                    offsets[b + 1] = offsets[b] + speckleBands[b].labels;
+                const int nlabels = offsets[nbands];
+                speckleParents.resize(nlabels);
+                for (int l = 0; l < nlabels; l++)
+                    speckleParents[l] = l;
+                for (int b = 1; b < nbands; b++)
                 {
-                    int iw = i * width;
-                    for (int j = 0; j < width; j++)
+                    const int y = height * b / nbands;
+                    const int *lab = speckleLabels.ptr<int>(y), *labAbove = speckleLabels.ptr<int>(y - 1);
+                    for (int x = 0; x < width; x++)
                     {
-                        if (i < 1 || i >= height - 1 || j < 1 || j >= width - 1)
-                        {
-                            outputMap[iw + j] = 0;
+                        if (lab[x] < 0)
                             continue;
-                        }
-
-                        if (map[iw + j] != 0)
-                        {
-                            outputMap[iw + j] = map[iw + j];
-                        }
-                        else // if (map[iw + j] == 0)
+                        for (int dx = -1; dx <= 1; dx++)
                         {
-                            T nr = 1;
-                            T avg = 0;
-                            speckle_size = dr;
-                            specklePointX[dr] = i;
-                            specklePointY[dr] = j;
-                            puss(i, j) = 1;
-                            dr++;
-                            map[iw + j] = k;
-                            while (st < dr)
+                            if (x + dx >= 0 && x + dx < width && labAbove[x + dx] >= 0)
                             {
-                                int ii = specklePointX[st];
-                                int jj = specklePointY[st];
-                                //going on 8 directions
-                                for (int d = 0; d < 8; d++)
-                                {//if insisde
-                                    if (ii + di[d] >= 0 && ii + di[d] < height && jj + dj[d] >= 0 && jj + dj[d] < width &&
-                                        puss(ii + di[d], jj + dj[d]) == 0)
-                                    {
-                                        T val = map[(ii + di[d]) * width + jj + dj[d]];
-                                        if (val == 0)
-                                        {
-                                            map[(ii + di[d]) * width + jj + dj[d]] = k;
-                                            specklePointX[dr] = (ii + di[d]);
-                                            specklePointY[dr] = (jj + dj[d]);
-                                            dr++;
-                                            puss(ii + di[d], jj + dj[d]) = 1;
-                                        }//this means that my point is a good point to be used in computing the final filling value
-                                        else if (val >= 1 && val < 250)
-                                        {
-                                            avg += val;
-                                            nr++;
-                                        }
-                                    }
-                                }
-                                st++;
-                            }//if hole size is smaller than a specified threshold we fill the respective hole with the average of the good neighbours
-                            if (st - speckle_size <= t)
-                            {
-                                T fillValue = (T)(avg / nr);
-                                while (speckle_size < st)
-                                {
-                                    int ii = specklePointX[speckle_size];
-                                    int jj = specklePointY[speckle_size];
-                                    outputMap[ii * width + jj] = fillValue;
-                                    speckle_size++;
-                                }
+                                const int a = findSpeckleRoot(offsets[b] + lab[x]), c = findSpeckleRoot(offsets[b - 1] + labAbove[x + dx]);
+                                speckleParents[std::max(a, c)] = std::min(a, c);
                             }
                         }
                     }
                 }
+                // area, sum and number of the good neighbours of the merged regions
+                speckleStats.assign((size_t)nlabels * 3, 0);
+                for (int b = 0; b < nbands; b++)
+                {
+                    const SpeckleBand &band = speckleBands[b];
+                    for (int l = 0; l < band.labels; l++)
+                    {
+                        int *stats = &speckleStats[findSpeckleRoot(offsets[b] + l) * 3];
+                        stats[0] += band.area[l];
+                        stats[1] += band.sum[l];
+                        stats[2] += band.count[l];
+                    }
+                }
+                speckleFill.resize(nlabels);
+                for (int l = 0; l < nlabels; l++)
+                {
+                    const int *stats = &speckleStats[findSpeckleRoot(l) * 3];
+                    speckleFill[l] = stats[0] <= t && stats[2] > 0 ? stats[1] / stats[2] : 0;
+                }
+                parallel_for_(Range(0, nbands), speckleFilling<T>(currentMap, speckleLabels, speckleFill, offsets, nbands, out));
+            }
+            //!Streaming equivalent of hammingDistanceBlockMatching, costGathering, blockAgregation and dispartyMapFormation
+            //!the rows are processed in a sliding window, so no full cost volume is allocated. Every band of the image needs
+            //!O(width * maxDisparity * (windowSize + STREAM_BLOCK_ROWS)) memory and the disparity map is the same
+            //!as the one of the non streaming functions
+            void streamingBlockMatching(const Mat &leftImage, const Mat &rightImage, Mat &mapFinal, const int kernelSize, const int windowSize,
+                const int th, const int descriptorWords = 1)
+            {
+                CV_Assert(leftImage.cols == rightImage.cols);
+                CV_Assert(leftImage.rows == rightImage.rows);
+                CV_Assert(kernelSize % 2 != 0 && windowSize % 2 != 0);
+                CV_Assert(mapFinal.rows == leftImage.rows && mapFinal.cols == leftImage.cols && mapFinal.isContinuous());
+                // the diagonal search never reaches further than the neighbouring rows
+                CV_Assert(maxDisparity < leftImage.cols);
+                CV_Assert(descriptorWords == 1 || descriptorWords == 2 || descriptorWords == 4);
+                memset(mapFinal.data, 0, mapFinal.total());
+                const int nbands = std::max(1, std::min(getNumThreads(), leftImage.rows / (4 * (windowSize / 2 + 1))));
+                if ((int)streamBuffers.size() < nbands)
+                    streamBuffers.resize(nbands);
+                const Range bands(0, nbands);
+                if (descriptorWords == 1)
+                    parallel_for_(bands, streamingMatch<1>(leftImage, rightImage, kernelSize, windowSize, maxDisparity,
+                        confidenceCheck, scallingFactor, interpolationMethod, th, nbands, streamBuffers, mapFinal));
+                else if (descriptorWords == 2)
+                    parallel_for_(bands, streamingMatch<2>(leftImage, rightImage, kernelSize, windowSize, maxDisparity,
+                        confidenceCheck, scallingFactor, interpolationMethod, th, nbands, streamBuffers, mapFinal));
+                else
+                    parallel_for_(bands, streamingMatch<4>(leftImage, rightImage, kernelSize, windowSize, maxDisparity,
+                        confidenceCheck, scallingFactor, interpolationMethod, th, nbands, streamBuffers, mapFinal));
             }
             //!Method responsible for generating the disparity map
             //!function for generating disparity maps at sub pixel level
@@ -595,9 +948,43 @@ namespace cv
                 int width = costVolume.cols / ( disparity + 1) - 1;
                 int height = costVolume.rows - 1;
                 memset(map, 0, sizeof(map[0]) * width * height);
-                parallel_for_(Range(0, height), makeMap(costVolume,th,disparity,confidenceCheck,scallingFactor,mapFinal));
+                parallel_for_(Range(0, height), makeMap(costVolume,th,disparity,confidenceCheck,scallingFactor,interpolationMethod,mapFinal));
             }
         public:
+            //!parabolic subpixel refinement of n disparities d, cm, c0 and cp are the costs at d - 1, d and d + 1
+            //!out = d * scale + ((cm - cp) * scale + denom) / (2 * denom), where denom = max(cm + cp - 2 * c0, 1)
+            static void parabolicSubpixel(const short *cm, const short *c0, const short *cp, const short *d, int n, int scale, short *out)
+            {
+                int k = 0;
+#if CV_SIMD128
+                // the numerators and the denominators stay below 2^24, so the truncated float quotients
+                // are the same as the integer divisions
+                if (scale <= 128)
+                {
+                    const v_int32x4 vscale = v_setall_s32(scale), one = v_setall_s32(1);
+                    for (; k <= n - 8; k += 8)
+                    {
+                        v_int32x4 m[2], z[2], p[2], dd[2], res[2];
+                        v_expand(v_load(cm + k), m[0], m[1]);
+                        v_expand(v_load(c0 + k), z[0], z[1]);
+                        v_expand(v_load(cp + k), p[0], p[1]);
+                        v_expand(v_load(d + k), dd[0], dd[1]);
+                        for (int h = 0; h < 2; h++)
+                        {
+                            const v_int32x4 denom = v_max(m[h] + p[h] - (z[h] + z[h]), one);
+                            const v_float32x4 q = v_cvt_f32((m[h] - p[h]) * vscale + denom) / v_cvt_f32(denom + denom);
+                            res[h] = dd[h] * vscale + v_trunc(q);
+                        }
+                        v_store(out + k, v_pack(res[0], res[1]));
+                    }
+                }
+#endif
+                for (; k < n; k++)
+                {
+                    const int denom = std::max(cm[k] + cp[k] - 2 * c0[k], 1);
+                    out[k] = saturate_cast<short>(d[k] * scale + ((cm[k] - cp[k]) * scale + denom) / (denom * 2));
+                }
+            }
             //!a median filter of 1x9 and 9x1
             //!1x9 median filter
             template<typename T>
@@ -619,7 +1006,6 @@ namespace cv
             //!maxDisp - represents the maximum disparity
             Matching(void)
             {
-                hammingLut();
             }
             ~Matching(void)
             {
@@ -635,8 +1021,8 @@ namespace cv
                 setScallingFactor(scalling);
                 //set the value for the confidence
                 setConfidence(confidence);
-                //generate the hamming lut in case SSE is not available
-                hammingLut();
+                //the disparities are refined with the simetric v by default
+                setInterpolationMethod(CV_SIMETRICV_INTERPOLATION);
             }
         };
     }
@@ -74,6 +74,8 @@ namespace cv
                 scalling = 4;
                 kernelType = CV_MODIFIED_CENSUS_TRANSFORM;
                 agregationWindowSize = 9;
+                useStreaming = false;
+                subpixelInterpolationMethod = CV_SIMETRICV_INTERPOLATION;
             }
 
             int preFilterType;
@@ -93,6 +95,8 @@ namespace cv
             int regionRemoval;
             int kernelType;
             int agregationWindowSize;
+            bool useStreaming;
+            int subpixelInterpolationMethod;
         };
 
         static void prefilterNorm(const Mat& src, Mat& dst, int winsize, int ftzero, uchar* buf)
@@ -321,19 +325,8 @@ namespace cv
 
                 int width = left0.cols;
                 int height = left0.rows;
-                if (puss.total() != (size_t)width * height)
+                if (aux.total() != (size_t)width * height)
                 {
-                    speckleX.create(height, width);
-                    speckleY.create(height, width);
-                    puss.create(height, width);
-
-                    censusImage[0].create(left0.rows,left0.cols,CV_32SC4);
-                    censusImage[1].create(left0.rows,left0.cols,CV_32SC4);
-
-                    partialSumsLR.create(left0.rows + 1,(left0.cols + 1) * (params.numDisparities + 1),CV_16S);
-                    agregatedHammingLRCost.create(left0.rows + 1,(left0.cols + 1) * (params.numDisparities + 1),CV_16S);
-                    hammingDistance.create(left0.rows, left0.cols * (params.numDisparities + 1),CV_16S);
-
                     preFilteredImg0.create(left0.size(), CV_8U);
                     preFilteredImg1.create(left0.size(), CV_8U);
 
@@ -362,7 +355,15 @@ namespace cv
                     left = left0;
                     right = right0;
                 }
-                if(params.kernelType == CV_SPARSE_CENSUS)
+                // the census windows that do not fit into 32 bits use the 64 or 128 bit descriptors
+                const int descriptorWords = wideCensusWords(params.kernelType, params.kernelSize);
+                censusImage[0].create(left0.rows,left0.cols,descriptorWords == 1 ? CV_32SC4 : CV_32SC(descriptorWords));
+                censusImage[1].create(left0.rows,left0.cols,descriptorWords == 1 ? CV_32SC4 : CV_32SC(descriptorWords));
+                if(descriptorWords > 1)
+                {
+                    wideCensusTransform(left,right,params.kernelSize,censusImage[0],censusImage[1],params.kernelType,descriptorWords * 32);
+                }
+                else if(params.kernelType == CV_SPARSE_CENSUS)
                 {
                     censusTransform(left,right,params.kernelSize,censusImage[0],censusImage[1],CV_SPARSE_CENSUS);
                 }
@@ -393,16 +394,30 @@ namespace cv
                 {
                     starCensusTransform(left,right,params.kernelSize,censusImage[0],censusImage[1]);
                 }
-                hammingDistanceBlockMatching(censusImage[0], censusImage[1], hammingDistance, params.kernelSize);
-                costGathering(hammingDistance, partialSumsLR);
-                blockAgregation(partialSumsLR, params.agregationWindowSize, agregatedHammingLRCost);
-                dispartyMapFormation(agregatedHammingLRCost, disp0, 3);
+                if(params.useStreaming && getMaxDisparity() < width)
+                {
+                    // the cost volumes are not needed anymore
+                    hammingDistance.release();
+                    partialSumsLR.release();
+                    agregatedHammingLRCost.release();
+                    streamingBlockMatching(censusImage[0], censusImage[1], disp0, params.kernelSize, params.agregationWindowSize, 3, descriptorWords);
+                }
+                else
+                {
+                    partialSumsLR.create(left0.rows + 1,(left0.cols + 1) * (params.numDisparities + 1),CV_16S);
+                    agregatedHammingLRCost.create(left0.rows + 1,(left0.cols + 1) * (params.numDisparities + 1),CV_16S);
+                    hammingDistance.create(left0.rows, left0.cols * (params.numDisparities + 1),CV_16S);
+                    hammingDistanceBlockMatching(censusImage[0], censusImage[1], hammingDistance, params.kernelSize, descriptorWords);
+                    costGathering(hammingDistance, partialSumsLR);
+                    blockAgregation(partialSumsLR, params.agregationWindowSize, agregatedHammingLRCost);
+                    dispartyMapFormation(agregatedHammingLRCost, disp0, 3);
+                }
                 Median1x9Filter<uint8_t>(disp0, aux);
                 Median9x1Filter<uint8_t>(aux,disp0);
 
                 if(params.regionRemoval == CV_SPECKLE_REMOVAL_AVG_ALGORITHM)
                 {
-                    smallRegionRemoval<uint8_t>(disp0.clone(),params.speckleWindowSize,disp0);
+                    smallRegionRemoval<uint8_t>(disp0,params.speckleWindowSize,disp0);
                 }
                 else if(params.regionRemoval == CV_SPECKLE_REMOVAL_ALGORITHM)
                 {
@@ -413,6 +428,15 @@ namespace cv
             int getAgregationWindowSize() const CV_OVERRIDE { return params.agregationWindowSize;}
             void setAgregationWindowSize(int value = 9) CV_OVERRIDE { CV_Assert(value % 2 != 0); params.agregationWindowSize = value;}
 
+            int getSubPixelInterpolationMethod() const CV_OVERRIDE { return params.subpixelInterpolationMethod;}
+            void setSubPixelInterpolationMethod(int value = CV_SIMETRICV_INTERPOLATION) CV_OVERRIDE
+            {
+                CV_Assert(value == CV_QUADRATIC_INTERPOLATION || value == CV_SIMETRICV_INTERPOLATION); params.subpixelInterpolationMethod = value; setInterpolationMethod(value);
+            }
+
+            bool getUseStreaming() const CV_OVERRIDE { return params.useStreaming;}
+            void setUseStreaming(bool value = false) CV_OVERRIDE { params.useStreaming = value;}
+
             int getBinaryKernelType() const CV_OVERRIDE { return params.kernelType;}
             void setBinaryKernelType(int value = CV_MODIFIED_CENSUS_TRANSFORM) CV_OVERRIDE { CV_Assert(value < 7); params.kernelType = value; }
 
@@ -49,6 +49,7 @@ SGBM (Semi-global block matching)
 */
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <limits.h>
 
 namespace cv
@@ -59,6 +60,8 @@ namespace cv
         typedef short CostType;
         typedef short DispType;
         enum { NR = 16, NR2 = NR/2 };
+        //! upper bound on the number of horizontal bands processed by MODE_SGBM_PARALLEL
+        enum { MAX_SGBM_BANDS = 8 };
 
         struct StereoBinarySGBMParams
         {
@@ -126,12 +129,16 @@ namespace cv
         is written as is, without interpolation.
         disp2cost also has the same size as img1 (or img2).
         It contains the minimum current cost, used to find the best disparity, corresponding to the minimal cost.
+        In the single-pass mode only the rows [rowStart, rowEnd) of disp1 are computed; the paths coming
+        from above are started warmupRows rows earlier, so that a horizontal band of the image can be
+        processed independently of the others (see StereoBinarySGBM::MODE_SGBM_PARALLEL).
         */
         static void computeDisparityBinarySGBM( const Mat& img1,
             Mat& disp1, const StereoBinarySGBMParams& params,
-            Mat& buffer,const Mat& hamDist)
+            Mat& buffer,const Mat& hamDist,
+            int rowStart = 0, int rowEnd = -1, int warmupRows = 0)
         {
-#if CV_SSE2
+#if CV_SIMD128
             static const uchar LSBTab[] =
             {
                 0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
@@ -143,8 +150,6 @@ namespace cv
                 6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
                 5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
             };
-
-            volatile bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
 #endif
 
             const int ALIGN = 16;
@@ -168,10 +173,17 @@ namespace cv
             const int SW2 = kernelSize.width/2, SH2 = kernelSize.height/2;
             const bool fullDP = params.mode == StereoBinarySGBM::MODE_HH;
             const int npasses = fullDP ? 2 : 1;
+            if( rowEnd < 0 || fullDP )
+            {
+                rowStart = 0;
+                rowEnd = height;
+            }
+            // the first row processed by the forward pass; the rows above rowStart only warm up the paths
+            const int firstRow = fullDP ? 0 : std::max(rowStart - warmupRows, 0);
 
             if( minX1 >= maxX1 )
             {
-                disp1 = Scalar::all(INVALID_DISP_SCALED);
+                disp1.rowRange(rowStart, rowEnd).setTo(Scalar::all(INVALID_DISP_SCALED));
                 return;
             }
             CV_Assert( D % 16 == 0 );
@@ -197,7 +209,8 @@ namespace cv
                 costBufSize*(hsumBufNRows + 1)*sizeof(CostType) + // hsumBuf, pixdiff
                 CSBufSize*2*sizeof(CostType) + // C, S
                 width*16*img1.channels()*sizeof(PixType) + // temp buffer for computing per-pixel cost
-                width*(sizeof(CostType) + sizeof(DispType)) + 1024; // disp2cost + disp2
+                width*(sizeof(CostType) + sizeof(DispType)) + // disp2cost + disp2
+                width*(sizeof(int) + 4*sizeof(CostType) + sizeof(DispType)) + 1024; // the quadratic subpixel fits of a row
             if( buffer.empty() || !buffer.isContinuous() ||
                 buffer.cols*buffer.rows*buffer.elemSize() < totalBufSize )
                 buffer.create(1, (int)totalBufSize, CV_8U);
@@ -208,6 +221,13 @@ namespace cv
             CostType* pixDiff = hsumBuf + costBufSize*hsumBufNRows;
             CostType* disp2cost = pixDiff + costBufSize + (LrSize + minLrSize)*NLR;
             DispType* disp2ptr = (DispType*)(disp2cost + width);
+            // the pixels of a row that get the quadratic interpolation, the costs around their disparity and the result
+            int* subX = (int*)alignPtr(disp2ptr + width, sizeof(int));
+            CostType* subCm = (CostType*)(subX + width);
+            CostType* subC0 = subCm + width;
+            CostType* subCp = subC0 + width;
+            CostType* subD = subCp + width;
+            DispType* subDisp = (DispType*)(subD + width);
             //            PixType* tempBuf = (PixType*)(disp2ptr + width);
             // add P2 to every C(x,y). it saves a few operations in the inner loops
             for(int k = 0; k < width1*D; k++ )
@@ -217,7 +237,7 @@ namespace cv
                 int x1, y1, x2, y2, dx, dy;
                 if( pass == 1 )
                 {
-                    y1 = 0; y2 = height; dy = 1;
+                    y1 = firstRow; y2 = rowEnd; dy = 1;
                     x1 = 0; x2 = width1; dx = 1;
                 }
                 else
@@ -246,7 +266,8 @@ namespace cv
                     CostType* S = Sbuf + (!fullDP ? 0 : y*costBufSize);
                     if( pass == 1 ) // compute C on the first pass, and reuse it on the second pass, if any.
                     {
-                        int dy1 = y == 0 ? 0 : y + SH2, dy2 = y == 0 ? SH2 : dy1;
+                        // on the first row the window rows above the image replicate row 0
+                        int dy1 = y == y1 ? std::max(y - SH2, 0) : y + SH2, dy2 = y + SH2;
                         for(int k = dy1; k <= dy2; k++ )
                         {
                             CostType* hsumAdd = hsumBuf + (std::min(k, height-1) % hsumBufNRows)*costBufSize;
@@ -268,7 +289,7 @@ namespace cv
                                         hsumAdd[d] = (CostType)(hsumAdd[d] + pixDiff[x + d]*scale);
                                 }
 
-                                if( y > 0 )
+                                if( y > y1 )
                                 {
                                     const CostType* hsumSub = hsumBuf + (std::max(y - SH2 - 1, 0) % hsumBufNRows)*costBufSize;
                                     const CostType* Cprev = !fullDP || y == 0 ? C : C - costBufSize;
@@ -278,32 +299,21 @@ namespace cv
                                         const CostType* pixAdd = pixDiff + std::min(x + SW2*D, (width1-1)*D);
                                         const CostType* pixSub = pixDiff + std::max(x - (SW2+1)*D, 0);
 
-#if CV_SSE2
-                                        if( useSIMD )
+#if CV_SIMD128
+                                        for( d = 0; d < D; d += 8 )
                                         {
-                                            for( d = 0; d < D; d += 8 )
-                                            {
-                                                __m128i hv = _mm_load_si128((const __m128i*)(hsumAdd + x - D + d));
-                                                __m128i Cx = _mm_load_si128((__m128i*)(Cprev + x + d));
-                                                hv = _mm_adds_epi16(_mm_subs_epi16(hv,
-                                                    _mm_load_si128((const __m128i*)(pixSub + d))),
-                                                    _mm_load_si128((const __m128i*)(pixAdd + d)));
-                                                Cx = _mm_adds_epi16(_mm_subs_epi16(Cx,
-                                                    _mm_load_si128((const __m128i*)(hsumSub + x + d))),
-                                                    hv);
-                                                _mm_store_si128((__m128i*)(hsumAdd + x + d), hv);
-                                                _mm_store_si128((__m128i*)(C + x + d), Cx);
-                                            }
+                                            v_int16x8 hv = v_load(hsumAdd + x - D + d) - v_load(pixSub + d) + v_load(pixAdd + d);
+                                            v_int16x8 Cx = v_load(Cprev + x + d) - v_load(hsumSub + x + d) + hv;
+                                            v_store(hsumAdd + x + d, hv);
+                                            v_store(C + x + d, Cx);
                                         }
-                                        else
-#endif
+#else
+                                        for( d = 0; d < D; d++ )
                                         {
-                                            for( d = 0; d < D; d++ )
-                                            {
-                                                const int hv = hsumAdd[x + d] = (CostType)(hsumAdd[x - D + d] + pixAdd[d] - pixSub[d]);
-                                                C[x + d] = (CostType)(Cprev[x + d] + hv - hsumSub[x + d]);
-                                            }
+                                            const int hv = hsumAdd[x + d] = (CostType)(hsumAdd[x - D + d] + pixAdd[d] - pixSub[d]);
+                                            C[x + d] = (CostType)(Cprev[x + d] + hv - hsumSub[x + d]);
                                         }
+#endif
                                     }
                                 }
                                 else
@@ -317,9 +327,9 @@ namespace cv
                                     }
                                 }
                             }
-                            if( y == 0 )
+                            if( y == y1 )
                             {
-                                const int scale = k == 0 ? SH2 + 1 : 1;
+                                const int scale = k == 0 ? SH2 - y + 1 : 1;
                                 for( x = 0; x < width1*D; x++ )
                                     C[x] = (CostType)(C[x] + hsumAdd[x]*scale);
                             }
@@ -368,59 +378,48 @@ namespace cv
                         CostType* Lr_p = Lr[0] + xd;
                         const CostType* Cp = C + x*D;
                         CostType* Sp = S + x*D;
-#if CV_SSE2
-                        if( useSIMD )
+#if CV_SIMD128
                         {
-                            __m128i _P1 = _mm_set1_epi16((short)P1);
-                            __m128i _delta0 = _mm_set1_epi16((short)delta0);
-                            __m128i _delta1 = _mm_set1_epi16((short)delta1);
-                            __m128i _delta2 = _mm_set1_epi16((short)delta2);
-                            __m128i _delta3 = _mm_set1_epi16((short)delta3);
-                            __m128i _minL0 = _mm_set1_epi16((short)MAX_COST);
+                            v_int16x8 _P1 = v_setall_s16((short)P1);
+                            v_int16x8 _delta0 = v_setall_s16((short)delta0);
+                            v_int16x8 _delta1 = v_setall_s16((short)delta1);
+                            v_int16x8 _delta2 = v_setall_s16((short)delta2);
+                            v_int16x8 _delta3 = v_setall_s16((short)delta3);
+                            v_int16x8 _minL0 = v_setall_s16((short)MAX_COST);
                             for( d = 0; d < D; d += 8 )
                             {
-                                __m128i Cpd = _mm_load_si128((const __m128i*)(Cp + d));
-                                __m128i L0, L1, L2, L3;
-                                L0 = _mm_load_si128((const __m128i*)(Lr_p0 + d));
-                                L1 = _mm_load_si128((const __m128i*)(Lr_p1 + d));
-                                L2 = _mm_load_si128((const __m128i*)(Lr_p2 + d));
-                                L3 = _mm_load_si128((const __m128i*)(Lr_p3 + d));
-                                L0 = _mm_min_epi16(L0, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p0 + d - 1)), _P1));
-                                L0 = _mm_min_epi16(L0, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p0 + d + 1)), _P1));
-                                L1 = _mm_min_epi16(L1, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p1 + d - 1)), _P1));
-                                L1 = _mm_min_epi16(L1, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p1 + d + 1)), _P1));
-                                L2 = _mm_min_epi16(L2, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p2 + d - 1)), _P1));
-                                L2 = _mm_min_epi16(L2, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p2 + d + 1)), _P1));
-                                L3 = _mm_min_epi16(L3, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p3 + d - 1)), _P1));
-                                L3 = _mm_min_epi16(L3, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p3 + d + 1)), _P1));
-                                L0 = _mm_min_epi16(L0, _delta0);
-                                L0 = _mm_adds_epi16(_mm_subs_epi16(L0, _delta0), Cpd);
-                                L1 = _mm_min_epi16(L1, _delta1);
-                                L1 = _mm_adds_epi16(_mm_subs_epi16(L1, _delta1), Cpd);
-                                L2 = _mm_min_epi16(L2, _delta2);
-                                L2 = _mm_adds_epi16(_mm_subs_epi16(L2, _delta2), Cpd);
-                                L3 = _mm_min_epi16(L3, _delta3);
-                                L3 = _mm_adds_epi16(_mm_subs_epi16(L3, _delta3), Cpd);
-                                _mm_store_si128( (__m128i*)(Lr_p + d), L0);
-                                _mm_store_si128( (__m128i*)(Lr_p + d + D2), L1);
-                                _mm_store_si128( (__m128i*)(Lr_p + d + D2*2), L2);
-                                _mm_store_si128( (__m128i*)(Lr_p + d + D2*3), L3);
-                                __m128i t0 = _mm_min_epi16(_mm_unpacklo_epi16(L0, L2), _mm_unpackhi_epi16(L0, L2));
-                                __m128i t1 = _mm_min_epi16(_mm_unpacklo_epi16(L1, L3), _mm_unpackhi_epi16(L1, L3));
-                                t0 = _mm_min_epi16(_mm_unpacklo_epi16(t0, t1), _mm_unpackhi_epi16(t0, t1));
-                                _minL0 = _mm_min_epi16(_minL0, t0);
-                                __m128i Sval = _mm_load_si128((const __m128i*)(Sp + d));
-                                L0 = _mm_adds_epi16(L0, L1);
-                                L2 = _mm_adds_epi16(L2, L3);
-                                Sval = _mm_adds_epi16(Sval, L0);
-                                Sval = _mm_adds_epi16(Sval, L2);
-                                _mm_store_si128((__m128i*)(Sp + d), Sval);
+                                v_int16x8 Cpd = v_load(Cp + d);
+                                v_int16x8 L0 = v_load(Lr_p0 + d), L1 = v_load(Lr_p1 + d);
+                                v_int16x8 L2 = v_load(Lr_p2 + d), L3 = v_load(Lr_p3 + d);
+                                L0 = v_min(L0, v_load(Lr_p0 + d - 1) + _P1);
+                                L0 = v_min(L0, v_load(Lr_p0 + d + 1) + _P1);
+                                L1 = v_min(L1, v_load(Lr_p1 + d - 1) + _P1);
+                                L1 = v_min(L1, v_load(Lr_p1 + d + 1) + _P1);
+                                L2 = v_min(L2, v_load(Lr_p2 + d - 1) + _P1);
+                                L2 = v_min(L2, v_load(Lr_p2 + d + 1) + _P1);
+                                L3 = v_min(L3, v_load(Lr_p3 + d - 1) + _P1);
+                                L3 = v_min(L3, v_load(Lr_p3 + d + 1) + _P1);
+                                L0 = v_min(L0, _delta0) - _delta0 + Cpd;
+                                L1 = v_min(L1, _delta1) - _delta1 + Cpd;
+                                L2 = v_min(L2, _delta2) - _delta2 + Cpd;
+                                L3 = v_min(L3, _delta3) - _delta3 + Cpd;
+                                v_store(Lr_p + d, L0);
+                                v_store(Lr_p + d + D2, L1);
+                                v_store(Lr_p + d + D2*2, L2);
+                                v_store(Lr_p + d + D2*3, L3);
+                                // interleave the four directions, so that after the loop
+                                // the lanes 0..3 hold min_k L_r for r = 0..3
+                                v_int16x8 t0, t1, t2, t3;
+                                v_zip(L0, L2, t0, t2);
+                                v_zip(L1, L3, t1, t3);
+                                v_zip(v_min(t0, t2), v_min(t1, t3), t0, t1);
+                                _minL0 = v_min(_minL0, v_min(t0, t1));
+                                v_store(Sp + d, v_load(Sp + d) + (L0 + L1) + (L2 + L3));
                             }
-                            _minL0 = _mm_min_epi16(_minL0, _mm_srli_si128(_minL0, 8));
-                            _mm_storel_epi64((__m128i*)&minLr[0][xm], _minL0);
+                            _minL0 = v_min(_minL0, v_rotate_right<4>(_minL0));
+                            v_store_low(&minLr[0][xm], _minL0);
                         }
-                        else
-#endif
+#else
                         {
                             int minL0 = MAX_COST, minL1 = MAX_COST, minL2 = MAX_COST, minL3 = MAX_COST;
 
@@ -451,15 +450,17 @@ namespace cv
                             minLr[0][xm+2] = (CostType)minL2;
                             minLr[0][xm+3] = (CostType)minL3;
                         }
+#endif
                     }
 
-                    if( pass == npasses )
+                    if( pass == npasses && y >= rowStart )
                     {
                         for( x = 0; x < width; x++ )
                         {
                             disp1ptr[x] = disp2ptr[x] = (DispType)INVALID_DISP_SCALED;
                             disp2cost[x] = MAX_COST;
                         }
+                        int nsub = 0;
 
                         for( x = width1 - 1; x >= 0; x-- )
                         {
@@ -478,48 +479,36 @@ namespace cv
                                 Lr_p0[-1] = Lr_p0[D] = MAX_COST;
                                 CostType* Lr_p = Lr[0] + xd;
                                 const CostType* Cp = C + x*D;
-#if CV_SSE2
-                                if( useSIMD )
+#if CV_SIMD128
                                 {
-                                    __m128i _P1 = _mm_set1_epi16((short)P1);
-                                    __m128i _delta0 = _mm_set1_epi16((short)delta0);
-                                    __m128i _minL0 = _mm_set1_epi16((short)minL0);
-                                    __m128i _minS = _mm_set1_epi16(MAX_COST), _bestDisp = _mm_set1_epi16(-1);
-                                    __m128i _d8 = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7), _8 = _mm_set1_epi16(8);
+                                    v_int16x8 _P1 = v_setall_s16((short)P1);
+                                    v_int16x8 _delta0 = v_setall_s16((short)delta0);
+                                    v_int16x8 _minL0 = v_setall_s16((short)minL0);
+                                    v_int16x8 _minS = v_setall_s16(MAX_COST), _bestDisp = v_setall_s16(-1);
+                                    v_int16x8 _d8(0, 1, 2, 3, 4, 5, 6, 7), _8 = v_setall_s16(8);
                                     for( d = 0; d < D; d += 8 )
                                     {
-                                        __m128i Cpd = _mm_load_si128((const __m128i*)(Cp + d)), L0;
-                                        L0 = _mm_load_si128((const __m128i*)(Lr_p0 + d));
-                                        L0 = _mm_min_epi16(L0, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p0 + d - 1)), _P1));
-                                        L0 = _mm_min_epi16(L0, _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(Lr_p0 + d + 1)), _P1));
-                                        L0 = _mm_min_epi16(L0, _delta0);
-                                        L0 = _mm_adds_epi16(_mm_subs_epi16(L0, _delta0), Cpd);
-                                        _mm_store_si128((__m128i*)(Lr_p + d), L0);
-                                        _minL0 = _mm_min_epi16(_minL0, L0);
-                                        L0 = _mm_adds_epi16(L0, *(__m128i*)(Sp + d));
-                                        _mm_store_si128((__m128i*)(Sp + d), L0);
-                                        __m128i mask = _mm_cmpgt_epi16(_minS, L0);
-                                        _minS = _mm_min_epi16(_minS, L0);
-                                        _bestDisp = _mm_xor_si128(_bestDisp, _mm_and_si128(_mm_xor_si128(_bestDisp,_d8), mask));
-                                        _d8 = _mm_adds_epi16(_d8, _8);
+                                        v_int16x8 L0 = v_load(Lr_p0 + d);
+                                        L0 = v_min(L0, v_load(Lr_p0 + d - 1) + _P1);
+                                        L0 = v_min(L0, v_load(Lr_p0 + d + 1) + _P1);
+                                        L0 = v_min(L0, _delta0) - _delta0 + v_load(Cp + d);
+                                        v_store(Lr_p + d, L0);
+                                        _minL0 = v_min(_minL0, L0);
+                                        L0 = L0 + v_load(Sp + d);
+                                        v_store(Sp + d, L0);
+                                        _bestDisp = v_select(_minS > L0, _d8, _bestDisp);
+                                        _minS = v_min(_minS, L0);
+                                        _d8 = _d8 + _8;
                                     }
                                     short CV_DECL_ALIGNED(16) bestDispBuf[8];
-                                    _mm_store_si128((__m128i*)bestDispBuf, _bestDisp);
-                                    _minL0 = _mm_min_epi16(_minL0, _mm_srli_si128(_minL0, 8));
-                                    _minL0 = _mm_min_epi16(_minL0, _mm_srli_si128(_minL0, 4));
-                                    _minL0 = _mm_min_epi16(_minL0, _mm_srli_si128(_minL0, 2));
-                                    __m128i qS = _mm_min_epi16(_minS, _mm_srli_si128(_minS, 8));
-                                    qS = _mm_min_epi16(qS, _mm_srli_si128(qS, 4));
-                                    qS = _mm_min_epi16(qS, _mm_srli_si128(qS, 2));
-                                    minLr[0][xm] = (CostType)_mm_cvtsi128_si32(_minL0);
-                                    minS = (CostType)_mm_cvtsi128_si32(qS);
-                                    qS = _mm_shuffle_epi32(_mm_unpacklo_epi16(qS, qS), 0);
-                                    qS = _mm_cmpeq_epi16(_minS, qS);
-                                    int idx = _mm_movemask_epi8(_mm_packs_epi16(qS, qS)) & 255;
+                                    v_store(bestDispBuf, _bestDisp);
+                                    minLr[0][xm] = (CostType)v_reduce_min(_minL0);
+                                    minS = v_reduce_min(_minS);
+                                    // the first lane holding the minimum has the smallest disparity among the candidates
+                                    int idx = v_signmask(_minS == v_setall_s16((short)minS));
                                     bestDisp = bestDispBuf[LSBTab[idx]];
                                 }
-                                else
-#endif
+#else
                                 {
                                     for( d = 0; d < D; d++ )
                                     {
@@ -535,6 +524,7 @@ namespace cv
                                     }
                                     minLr[0][xm] = (CostType)minL0;
                                 }
+#endif
                             }
                             else
                             {
@@ -595,14 +585,23 @@ namespace cv
                                     // do subpixel quadratic interpolation:
                                     //   fit parabola into (x1=d-1, y1=Sp[d-1]), (x2=d, y2=Sp[d]), (x3=d+1, y3=Sp[d+1])
                                     //   then find minimum of the parabola.
-                                    const int denom2 = std::max(Sp[d-1] + Sp[d+1] - 2*Sp[d], 1);
-                                    d = d*DISP_SCALE + ((Sp[d-1] - Sp[d+1])*DISP_SCALE + denom2)/(denom2*2);
+                                    // the parabolas of the whole row are computed at once below
+                                    subX[nsub] = x + minX1;
+                                    subCm[nsub] = Sp[d-1];
+                                    subC0[nsub] = Sp[d];
+                                    subCp[nsub] = Sp[d+1];
+                                    subD[nsub] = (CostType)d;
+                                    nsub++;
+                                    continue;
                                 }
                             }
                             else
                                 d *= DISP_SCALE;
                             disp1ptr[x + minX1] = (DispType)(d + minD*DISP_SCALE);
                         }
+                        Matching::parabolicSubpixel(subCm, subC0, subCp, subD, nsub, DISP_SCALE, subDisp);
+                        for( int k = 0; k < nsub; k++ )
+                            disp1ptr[subX[k]] = (DispType)(subDisp[k] + minD*DISP_SCALE);
                         for( x = minX1; x < maxX1; x++ )
                         {
                             // we round the computed disparity both towards -inf and +inf and check
@@ -626,6 +625,42 @@ namespace cv
                 }
             }
         }
+        /*
+        runs the single-pass algorithm on horizontal bands of the image. Each band has its own buffer
+        and starts its forward pass "overlap" rows above the band, so that the paths coming from above
+        have converged by the time they reach the first row of the band. The bands write disjoint rows
+        of disp1 and do not share any other state, so the merge is free.
+        */
+        class ParallelBandsSGBM : public ParallelLoopBody
+        {
+        public:
+            ParallelBandsSGBM(const Mat& _img1, Mat& _disp1, const StereoBinarySGBMParams& _params,
+                std::vector<Mat>& _buffers, const Mat& _hamDist, int _bandHeight, int _overlap) :
+                img1(_img1), disp1(_disp1), params(_params), buffers(&_buffers), hamDist(_hamDist),
+                bandHeight(_bandHeight), overlap(_overlap)
+            {}
+            void operator()(const Range& range) const CV_OVERRIDE
+            {
+                Mat disp = disp1;
+                for( int i = range.start; i < range.end; i++ )
+                {
+                    const int rowStart = i*bandHeight;
+                    const int rowEnd = std::min(rowStart + bandHeight, disp.rows);
+                    if( rowStart >= rowEnd )
+                        break;
+                    computeDisparityBinarySGBM(img1, disp, params, (*buffers)[i], hamDist, rowStart, rowEnd, overlap);
+                }
+            }
+        private:
+            Mat img1;
+            Mat disp1;
+            StereoBinarySGBMParams params;
+            std::vector<Mat>* buffers;
+            Mat hamDist;
+            int bandHeight;
+            int overlap;
+        };
+
         class StereoBinarySGBMImpl CV_FINAL : public StereoBinarySGBM, public Matching
         {
         public:
@@ -650,12 +685,18 @@ namespace cv
                     left.depth() == CV_8U );
                 disparr.create( left.size(), CV_16S );
                 Mat disp = disparr.getMat();
-                censusImageLeft.create(left.rows,left.cols,CV_32SC4);
-                censusImageRight.create(left.rows,left.cols,CV_32SC4);
+                // the census windows that do not fit into 32 bits use the 64 or 128 bit descriptors
+                const int descriptorWords = wideCensusWords(params.kernelType, params.kernelSize);
+                censusImageLeft.create(left.rows,left.cols,descriptorWords == 1 ? CV_32SC4 : CV_32SC(descriptorWords));
+                censusImageRight.create(left.rows,left.cols,descriptorWords == 1 ? CV_32SC4 : CV_32SC(descriptorWords));
 
                 hamDist.create(left.rows, left.cols * (params.numDisparities + 1),CV_16S);
 
-                if(params.kernelType == CV_SPARSE_CENSUS)
+                if(descriptorWords > 1)
+                {
+                    wideCensusTransform(left,right,params.kernelSize,censusImageLeft,censusImageRight,params.kernelType,descriptorWords * 32);
+                }
+                else if(params.kernelType == CV_SPARSE_CENSUS)
                 {
                     censusTransform(left,right,params.kernelSize,censusImageLeft,censusImageRight,CV_SPARSE_CENSUS);
                 }
@@ -687,25 +728,31 @@ namespace cv
                     starCensusTransform(left,right,params.kernelSize,censusImageLeft,censusImageRight);
                 }
 
-                hammingDistanceBlockMatching(censusImageLeft, censusImageRight, hamDist, params.kernelSize);
+                hammingDistanceBlockMatching(censusImageLeft, censusImageRight, hamDist, params.kernelSize, descriptorWords);
 
-                computeDisparityBinarySGBM( left, disp, params, buffer,hamDist);
+                if( params.mode == MODE_SGBM_PARALLEL )
+                {
+                    const int SH2 = (params.kernelSize > 0 ? params.kernelSize : 5)/2;
+                    // the split only depends on the image and the parameters, so the result is the same for any number of threads
+                    const int nbands = std::max(1, std::min((int)MAX_SGBM_BANDS, left.rows/(4*(SH2 + 1))));
+                    const int bandHeight = (left.rows + nbands - 1)/nbands;
+                    const int overlap = SH2 + 1 + cvCeil(0.1*bandHeight);
+                    if( (int)bandBuffers.size() < nbands )
+                        bandBuffers.resize(nbands);
+                    parallel_for_(Range(0, nbands), ParallelBandsSGBM(left, disp, params, bandBuffers, hamDist, bandHeight, overlap));
+                }
+                else
+                    computeDisparityBinarySGBM( left, disp, params, buffer,hamDist);
 
                 if(params.regionRemoval == CV_SPECKLE_REMOVAL_AVG_ALGORITHM)
                 {
                     int width = left.cols;
                     int height = left.rows;
-                    if (puss.total() != (size_t)width * height)
-                    {
-                        speckleX.create(height, width);
-                        speckleY.create(height, width);
-                        puss.create(height, width);
-                    }
                     Mat aux;
                     aux.create(height,width,CV_16S);
                     Median1x9Filter<short>(disp, aux);
                     Median9x1Filter<short>(aux,disp);
-                    smallRegionRemoval<short>(disp.clone(), params.speckleWindowSize, disp);
+                    smallRegionRemoval<short>(disp, params.speckleWindowSize, disp);
                 }
                 else if(params.regionRemoval == CV_SPECKLE_REMOVAL_ALGORITHM)
                 {
@@ -721,7 +768,7 @@ namespace cv
                 }
             }
             int getSubPixelInterpolationMethod() const CV_OVERRIDE { return params.subpixelInterpolationMethod;}
-            void setSubPixelInterpolationMethod(int value = CV_QUADRATIC_INTERPOLATION) CV_OVERRIDE { CV_Assert(value < 2); params.subpixelInterpolationMethod = value;}
+            void setSubPixelInterpolationMethod(int value = CV_QUADRATIC_INTERPOLATION) CV_OVERRIDE { CV_Assert(value == CV_QUADRATIC_INTERPOLATION || value == CV_SIMETRICV_INTERPOLATION); params.subpixelInterpolationMethod = value;}
 
             int getBinaryKernelType() const CV_OVERRIDE { return params.kernelType;}
             void setBinaryKernelType(int value = CV_MODIFIED_CENSUS_TRANSFORM) CV_OVERRIDE { CV_Assert(value < 7); params.kernelType = value; }
@@ -798,6 +845,7 @@ namespace cv
 
             StereoBinarySGBMParams params;
             Mat buffer;
+            std::vector<Mat> bandBuffers;
             static const char* name_;
             Mat censusImageLeft;
             Mat censusImageRight;
@@ -232,5 +232,96 @@ void CV_SGBlockMatchingTest::run(int )
 TEST(block_matching_simple_test, accuracy) { CV_BlockMatchingTest test; test.safe_run(); }
 TEST(SG_block_matching_simple_test, accuracy) { CV_SGBlockMatchingTest test; test.safe_run(); }
 
+TEST(SG_block_matching_parallel_test, accuracy)
+{
+    const std::string dataPath = cvtest::TS::ptr()->get_data_path() + "stereomatching/datasets/tsukuba/";
+    Mat image1 = imread(dataPath + "im2.png", IMREAD_GRAYSCALE);
+    Mat image2 = imread(dataPath + "im6.png", IMREAD_GRAYSCALE);
+    ASSERT_FALSE(image1.empty() || image2.empty());
+
+    Ptr<StereoBinarySGBM> sgbm = StereoBinarySGBM::create(0, 16, 5);
+    sgbm->setP1(10);
+    sgbm->setP2(100);
+    sgbm->setUniquenessRatio(1);
+    sgbm->setBinaryKernelType(CV_DENSE_CENSUS);
+    sgbm->setSpekleRemovalTechnique(CV_SPECKLE_REMOVAL_AVG_ALGORITHM);
+
+    Mat reference, parallel, parallelSingleThread;
+    sgbm->compute(image1, image2, reference);
+    sgbm->setMode(StereoBinarySGBM::MODE_SGBM_PARALLEL);
+    sgbm->compute(image1, image2, parallel);
+
+    // the bands only differ from the sequential pass near their upper borders
+    Mat diff;
+    absdiff(reference, parallel, diff);
+    EXPECT_LE(countNonZero(diff > StereoBinarySGBM::DISP_SCALE), (int)(0.05 * diff.total()));
+
+    // the bands do not depend on the number of threads
+    const int threads = getNumThreads();
+    setNumThreads(1);
+    sgbm->compute(image1, image2, parallelSingleThread);
+    setNumThreads(threads);
+    EXPECT_EQ(0, cvtest::norm(parallel, parallelSingleThread, NORM_INF));
+}
+
+TEST(block_matching_streaming_test, accuracy)
+{
+    const std::string dataPath = cvtest::TS::ptr()->get_data_path() + "stereomatching/datasets/tsukuba/";
+    Mat image1 = imread(dataPath + "im2.png", IMREAD_GRAYSCALE);
+    Mat image2 = imread(dataPath + "im6.png", IMREAD_GRAYSCALE);
+    ASSERT_FALSE(image1.empty() || image2.empty());
+
+    // the 32 bit modified census and the 128 bit dense census
+    const int kernelTypes[] = { CV_MODIFIED_CENSUS_TRANSFORM, CV_DENSE_CENSUS };
+    for (int k = 0; k < 2; k++)
+    {
+        Ptr<StereoBinaryBM> sbm = StereoBinaryBM::create(16, 9);
+        sbm->setSpeckleWindowSize(400);
+        sbm->setScalleFactor(16);
+        sbm->setBinaryKernelType(kernelTypes[k]);
+        sbm->setAgregationWindowSize(11);
+        sbm->setSpekleRemovalTechnique(CV_SPECKLE_REMOVAL_AVG_ALGORITHM);
+
+        Mat reference(image1.size(), CV_8UC1), streaming(image1.size(), CV_8UC1);
+        sbm->compute(image1, image2, reference);
+        sbm->setUseStreaming(true);
+        sbm->compute(image1, image2, streaming);
+
+        EXPECT_GT(countNonZero(reference), 0);
+        EXPECT_EQ(0, cvtest::norm(reference, streaming, NORM_INF)) << "kernel type: " << kernelTypes[k];
+    }
+}
+
+TEST(block_matching_quadratic_test, accuracy)
+{
+    const std::string dataPath = cvtest::TS::ptr()->get_data_path() + "stereomatching/datasets/tsukuba/";
+    Mat image1 = imread(dataPath + "im2.png", IMREAD_GRAYSCALE);
+    Mat image2 = imread(dataPath + "im6.png", IMREAD_GRAYSCALE);
+    Mat gt = imread(dataPath + "disp2.png", IMREAD_GRAYSCALE);
+    ASSERT_FALSE(image1.empty() || image2.empty() || gt.empty());
+
+    Ptr<StereoBinaryBM> sbm = StereoBinaryBM::create(16, 9);
+    sbm->setSpeckleWindowSize(400);
+    sbm->setScalleFactor(16);
+    sbm->setAgregationWindowSize(11);
+    sbm->setSpekleRemovalTechnique(CV_SPECKLE_REMOVAL_AVG_ALGORITHM);
+    sbm->setSubPixelInterpolationMethod(CV_QUADRATIC_INTERPOLATION);
+
+    Mat reference(image1.size(), CV_8UC1), streaming(image1.size(), CV_8UC1), singleBand(image1.size(), CV_8UC1);
+    sbm->compute(image1, image2, reference);
+    EXPECT_LE(errorLevel(gt, reference), 20);
+
+    sbm->setUseStreaming(true);
+    sbm->compute(image1, image2, streaming);
+    EXPECT_EQ(0, cvtest::norm(reference, streaming, NORM_INF));
+
+    // the speckle regions merged across the bands are the same as the ones found in a single band
+    const int threads = getNumThreads();
+    setNumThreads(1);
+    sbm->compute(image1, image2, singleBand);
+    setNumThreads(threads);
+    EXPECT_EQ(0, cvtest::norm(reference, singleBand, NORM_INF));
+}
+
 
 }} // namespace
\ No newline at end of file
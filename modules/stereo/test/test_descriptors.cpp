@@ -461,5 +461,145 @@ TEST(DISABLED_symetric_census_testing, accuracy) { CV_SymetricCensusTest test; t
 TEST(DISABLED_Dmodified_census_testing, accuracy) { CV_ModifiedCensusTransformTest test; test.safe_run(); }
 TEST(DISABLED_Dstar_kernel_testing, accuracy) { CV_StarKernelCensusTest test; test.safe_run(); }
 
+static int hammingReference(const Mat &left, const Mat &right, int y, int x, int x2)
+{
+    const int nwords = left.channels();
+    const unsigned *l = left.ptr<unsigned>(y) + x * nwords;
+    const unsigned *r = right.ptr<unsigned>(y) + x2 * nwords;
+    int dist = 0;
+    for (int w = 0; w < nwords; w++)
+        for (unsigned v = l[w] ^ r[w]; v != 0; v &= v - 1)
+            dist++;
+    return dist;
+}
+
+TEST(Stereo_HammingCostVolume, matches_scalar)
+{
+    const int types[] = { CV_32SC1, CV_32SC2, CV_32SC4 };
+    const int maxDisparities[] = { 15, 21, 64 };
+    for (int t = 0; t < 3; t++)
+    {
+        for (int m = 0; m < 3; m++)
+        {
+            const int maxDisp = maxDisparities[m];
+            // ROIs, to check that the row steps are respected
+            Mat leftFull(17, 100, types[t]), rightFull(17, 100, types[t]);
+            randu(leftFull, Scalar::all(std::numeric_limits<int>::min()), Scalar::all(std::numeric_limits<int>::max()));
+            randu(rightFull, Scalar::all(std::numeric_limits<int>::min()), Scalar::all(std::numeric_limits<int>::max()));
+            Mat left = leftFull.colRange(3, 96), right = rightFull.colRange(2, 95);
+
+            Mat cost;
+            hammingCostVolume(left, right, maxDisp, cost);
+            ASSERT_EQ(CV_16SC1, cost.type());
+            ASSERT_EQ(Size(left.cols * (maxDisp + 1), left.rows), cost.size());
+
+            int errors = 0;
+            for (int y = 0; y < left.rows; y++)
+                for (int x = 0; x < left.cols; x++)
+                    for (int d = 0; d <= maxDisp; d++)
+                        if (cost.at<short>(y, x * (maxDisp + 1) + d) != hammingReference(left, right, y, x, std::max(x - d, 0)))
+                            errors++;
+            EXPECT_EQ(0, errors) << "descriptor words: " << left.channels() << ", max disparity: " << maxDisp;
+        }
+    }
+}
+
+TEST(Stereo_WideCensus, same_costs_as_32bit_census)
+{
+    Mat image(64, 96, CV_8UC1);
+    randu(image, 0, 256);
+    const int kernelSize = 5, n2 = kernelSize / 2, maxDisp = 16;
+
+    Mat census32(image.size(), CV_32SC4), census64;
+    censusTransform(image, kernelSize, census32, CV_DENSE_CENSUS);
+    wideCensusTransform(image, kernelSize, census64, CV_DENSE_CENSUS, 64);
+    ASSERT_EQ(CV_32SC2, census64.type());
+    // the 32 bit descriptors are stored contiguously at the beginning of the buffer
+    Mat census32c(image.size(), CV_32SC1, census32.data);
+
+    Mat cost32, cost64;
+    hammingCostVolume(census32c, census32c, maxDisp, cost32);
+    hammingCostVolume(census64, census64, maxDisp, cost64);
+    // the 32 bit census leaves a wider border and skips a comparison on row n2
+    int errors = 0;
+    for (int y = n2 + 1; y < image.rows - n2; y++)
+        for (int x = n2 + 2 + maxDisp; x < image.cols - n2 - 2; x++)
+            for (int d = 0; d <= maxDisp; d++)
+                if (cost32.at<short>(y, x * (maxDisp + 1) + d) != cost64.at<short>(y, x * (maxDisp + 1) + d))
+                    errors++;
+    EXPECT_EQ(0, errors);
+}
+
+TEST(Stereo_WideCensus, zero_cost_at_true_disparity)
+{
+    const int shift = 7, maxDisp = 16;
+    Mat left(48, 128, CV_8UC1);
+    randu(left, 0, 256);
+    Mat right = left.clone();
+    left.colRange(shift, left.cols).copyTo(right.colRange(0, left.cols - shift));
+
+    const int kernelTypes[] = { CV_DENSE_CENSUS, CV_DENSE_CENSUS, CV_SPARSE_CENSUS, CV_SPARSE_CENSUS, CV_SPARSE_CENSUS };
+    const int kernelSizes[] = { 7, 11, 11, 15, 21 };
+    const int bits[] = { 64, 128, 64, 64, 128 };
+    for (int k = 0; k < 5; k++)
+    {
+        const int n2 = kernelSizes[k] / 2;
+        Mat censusLeft, censusRight, cost;
+        wideCensusTransform(left, right, kernelSizes[k], censusLeft, censusRight, kernelTypes[k], bits[k]);
+        ASSERT_GT(countNonZero(censusLeft.reshape(1)), 0);
+        hammingCostVolume(censusLeft, censusRight, maxDisp, cost);
+
+        int errors = 0, ambiguous = 0, total = 0;
+        for (int y = n2; y < left.rows - n2; y++)
+        {
+            for (int x = n2 + maxDisp; x < left.cols - n2 - shift; x++)
+            {
+                const short *c = cost.ptr<short>(y) + x * (maxDisp + 1);
+                if (c[shift] != 0)
+                    errors++;
+                for (int d = 0; d <= maxDisp; d++)
+                    if (d != shift && c[d] == 0)
+                        ambiguous++;
+                total++;
+            }
+        }
+        EXPECT_EQ(0, errors) << "kernel size: " << kernelSizes[k];
+        // only the windows with a saturated center have all-zero descriptors at several disparities
+        EXPECT_LE(ambiguous, total / 50) << "kernel size: " << kernelSizes[k];
+    }
+}
+
+TEST(Stereo_WideCensus, sparse_11_keeps_all_comparisons)
+{
+    // the sparse 11x11 window has 6x6 = 36 comparisons, 4 more than a 32 bit descriptor can hold
+    Mat image(40, 64, CV_8UC1);
+    randu(image, 0, 256);
+    const int kernelSize = 11, n2 = kernelSize / 2;
+
+    Mat census;
+    wideCensusTransform(image, kernelSize, census, CV_SPARSE_CENSUS, 64);
+    ASSERT_EQ(CV_32SC2, census.type());
+
+    int errors = 0, highBits = 0;
+    for (int y = n2; y < image.rows - n2; y++)
+    {
+        for (int x = n2; x < image.cols - n2; x++)
+        {
+            unsigned ref[2] = { 0, 0 };
+            int bit = 0;
+            for (int dy = -n2; dy <= n2; dy += 2)
+                for (int dx = -n2; dx <= n2; dx += 2, bit++)
+                    ref[bit >> 5] |= (unsigned)(image.at<uchar>(y + dy, x + dx) > image.at<uchar>(y, x)) << (bit & 31);
+            ASSERT_EQ(36, bit);
+            const Vec2i c = census.at<Vec2i>(y, x);
+            if ((unsigned)c[0] != ref[0] || (unsigned)c[1] != ref[1])
+                errors++;
+            if (c[1] != 0)
+                highBits++;
+        }
+    }
+    EXPECT_EQ(0, errors);
+    EXPECT_GT(highBits, 0);
+}
 
 }} // namespace
@@ -68,6 +68,48 @@ namespace xfeatures2d
 //! @addtogroup xfeatures2d_experiment
 //! @{
 
+/** @brief Preprocessed versions of an image, shared between descriptor extractors.
+
+BRIEF, FREAK and LUCID all start by converting the input image to grayscale and building an
+integral or a box-filtered image from it. When several of these descriptors are computed on the
+same frame, a DescriptorImageCache lets them build each of those images only once: every image is
+computed on first request and kept until setImage() is called with the next frame. Buffers are
+reused between frames of the same size.
+
+@note The cache is not thread-safe: one instance must not be used from several threads at a time.
+ */
+class CV_EXPORTS DescriptorImageCache
+{
+public:
+    virtual ~DescriptorImageCache();
+
+    /** @brief Replaces the cached frame and invalidates all images derived from the previous one.
+    @param image 8-bit or floating-point image with 1, 3 (BGR) or 4 (BGRA) channels. The data is
+    referenced, not copied, and must stay unchanged while the cache is in use.
+     */
+    virtual void setImage(InputArray image) = 0;
+
+    /** @brief Returns the image passed to setImage(). */
+    virtual const Mat& getImage() const = 0;
+
+    /** @brief Returns the single-channel version of the image (COLOR_BGR2GRAY for 3 or 4 channels). */
+    virtual const Mat& getGray() = 0;
+
+    /** @brief Returns the integral image of getGray().
+    @param sdepth depth of the integral image: CV_32S, CV_32F or CV_64F.
+     */
+    virtual const Mat& getIntegral(int sdepth) = 0;
+
+    /** @brief Returns the image blurred with a normalized ksize x ksize box filter.
+
+    4-channel images lose their alpha channel first (COLOR_BGRA2BGR), other images are filtered as is.
+     */
+    virtual const Mat& getBoxBlurred(int ksize) = 0;
+
+    /** @brief Creates a cache, optionally initialized with the first frame. */
+    static Ptr<DescriptorImageCache> create(InputArray image = noArray());
+};
+
 /** @brief Class implementing the FREAK (*Fast Retina Keypoint*) keypoint descriptor, described in @cite AOV12 .
 
 The algorithm propose a novel keypoint descriptor inspired by the human visual system and more
@@ -101,6 +143,17 @@ public:
                              float patternScale = 22.0f,
                              int nOctaves = 4,
                              const std::vector<int>& selectedPairs = std::vector<int>());
+
+    using Feature2D::compute;
+
+    /** @brief Computes the descriptors using the grayscale and integral images held by @p cache.
+
+    Equivalent to compute(cache->getImage(), keypoints, descriptors), except that the integral image
+    is taken from (and left in) the cache so it can be shared with other extractors. The default
+    implementation just calls compute() on cache->getImage().
+     */
+    virtual void compute(const Ptr<DescriptorImageCache>& cache, std::vector<KeyPoint>& keypoints,
+                         OutputArray descriptors);
 };
 
 
@@ -130,6 +183,16 @@ class CV_EXPORTS_W BriefDescriptorExtractor : public Feature2D
 {
 public:
     CV_WRAP static Ptr<BriefDescriptorExtractor> create( int bytes = 32, bool use_orientation = false );
+
+    using Feature2D::compute;
+
+    /** @brief Computes the descriptors using the CV_32S integral image held by @p cache.
+
+    Equivalent to compute(cache->getImage(), keypoints, descriptors), which is what the default
+    implementation does.
+     */
+    virtual void compute(const Ptr<DescriptorImageCache>& cache, std::vector<KeyPoint>& keypoints,
+                         OutputArray descriptors);
 };
 
 /** @brief Class implementing the locally uniform comparison image descriptor, described in @cite LUCID
@@ -147,6 +210,16 @@ public:
      * @param blur_kernel kernel for blurring image prior to descriptor construction, where 1=3x3, 2=5x5, 3=7x7 and so forth
      */
     CV_WRAP static Ptr<LUCID> create(const int lucid_kernel = 1, const int blur_kernel = 2);
+
+    using Feature2D::compute;
+
+    /** @brief Computes the descriptors using the box-filtered image held by @p cache.
+
+    Equivalent to compute(cache->getImage(), keypoints, descriptors), which is what the default
+    implementation does.
+     */
+    virtual void compute(const Ptr<DescriptorImageCache>& cache, std::vector<KeyPoint>& keypoints,
+                         OutputArray descriptors);
 };
 
 
@@ -0,0 +1,95 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef perf::TestBaseWithParam<std::string> binary_descriptors;
+
+#define BINARY_DESCRIPTORS_IMAGES \
+    "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png",\
+    "stitching/a3.png"
+
+static void detectKeypoints(const Mat& frame, vector<KeyPoint>& points)
+{
+    Ptr<FastFeatureDetector> detector = FastFeatureDetector::create(20);
+    detector->detect(frame, points);
+}
+
+PERF_TEST_P(binary_descriptors, brief, testing::Values(BINARY_DESCRIPTORS_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    vector<KeyPoint> points;
+    detectKeypoints(frame, points);
+
+    Ptr<BriefDescriptorExtractor> descriptor = BriefDescriptorExtractor::create();
+    Mat descriptors;
+    TEST_CYCLE() descriptor->compute(frame, points, descriptors);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(binary_descriptors, freak, testing::Values(BINARY_DESCRIPTORS_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    vector<KeyPoint> points;
+    detectKeypoints(frame, points);
+
+    Ptr<FREAK> descriptor = FREAK::create();
+    Mat descriptors;
+    TEST_CYCLE() descriptor->compute(frame, points, descriptors);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(binary_descriptors, lucid, testing::Values(BINARY_DESCRIPTORS_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    vector<KeyPoint> points;
+    detectKeypoints(frame, points);
+
+    Ptr<LUCID> descriptor = LUCID::create();
+    Mat descriptors;
+    TEST_CYCLE() descriptor->compute(frame, points, descriptors);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(binary_descriptors, all_shared_cache, testing::Values(BINARY_DESCRIPTORS_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    vector<KeyPoint> points;
+    detectKeypoints(frame, points);
+
+    Ptr<BriefDescriptorExtractor> brief = BriefDescriptorExtractor::create();
+    Ptr<FREAK> freak = FREAK::create();
+    Ptr<LUCID> lucid = LUCID::create();
+    Ptr<DescriptorImageCache> cache = DescriptorImageCache::create();
+    Mat briefDescriptors, freakDescriptors, lucidDescriptors;
+
+    TEST_CYCLE()
+    {
+        vector<KeyPoint> briefPoints = points, freakPoints = points, lucidPoints = points;
+        cache->setImage(frame);
+        brief->compute(cache, briefPoints, briefDescriptors);
+        freak->compute(cache, freakPoints, freakDescriptors);
+        lucid->compute(cache, lucidPoints, lucidDescriptors);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
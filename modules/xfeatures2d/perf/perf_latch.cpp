@@ -33,4 +33,33 @@ PERF_TEST_P(latch, extract, testing::Values(LATCH_IMAGES))
 }
 #endif // NONFREE
 
+typedef tuple<int, int> LATCHParams;
+typedef perf::TestBaseWithParam<LATCHParams> latch_params;
+
+PERF_TEST_P(latch_params, extract_fast_keypoints,
+            testing::Combine(testing::Values(8, 32, 64),   // bytes
+                             testing::Values(3, 7, 8)))    // half_ssd_size
+{
+    const int bytes = get<0>(GetParam());
+    const int halfSSDSize = get<1>(GetParam());
+
+    string filename = getDataPath("cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png");
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    vector<KeyPoint> points;
+    FAST(frame, points, 40);
+    declare.in(frame).time(90);
+
+    Ptr<LATCH> descriptor = LATCH::create(bytes, true, halfSSDSize);
+    Mat descriptors;
+    TEST_CYCLE()
+    {
+        vector<KeyPoint> kp = points;
+        descriptor->compute(frame, kp, descriptors);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
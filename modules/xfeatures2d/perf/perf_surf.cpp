@@ -64,5 +64,31 @@ PERF_TEST_P(surf, full, testing::Values(SURF_IMAGES))
     SANITY_CHECK_NOTHING();
 }
 
+typedef tuple<std::string, int> SURF_Threads_t;
+typedef perf::TestBaseWithParam<SURF_Threads_t> surf_threads;
+
+PERF_TEST_P(surf_threads, extract_threads, testing::Combine(testing::Values(SURF_IMAGES), testing::Values(1, 2, 4, 8)))
+{
+    string filename = getDataPath(get<0>(GetParam()));
+    int threads = get<1>(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    Mat mask;
+    declare.in(frame).time(90);
+
+    Ptr<SURF> detector = SURF::create();
+    vector<KeyPoint> points;
+    Mat descriptors;
+    detector->detect(frame, points, mask);
+
+    int prevThreads = getNumThreads();
+    setNumThreads(threads);
+    TEST_CYCLE() detector->compute(frame, points, descriptors);
+    setNumThreads(prevThreads);
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
 #endif // NONFREE
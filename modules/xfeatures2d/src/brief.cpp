@@ -71,9 +71,11 @@ public:
     virtual int defaultNorm() const CV_OVERRIDE;
 
     virtual void compute(InputArray image, std::vector<KeyPoint>& keypoints, OutputArray descriptors) CV_OVERRIDE;
+    virtual void compute(const Ptr<DescriptorImageCache>& cache, std::vector<KeyPoint>& keypoints,
+                         OutputArray descriptors) CV_OVERRIDE;
 
 protected:
-    typedef void(*PixelTestFn)(InputArray, const std::vector<KeyPoint>&, OutputArray, bool use_orientation );
+    typedef void(*PixelTestFn)(const Mat&, const std::vector<KeyPoint>&, Mat&, bool use_orientation );
 
     int bytes_;
     bool use_orientation_;
@@ -85,6 +87,13 @@ Ptr<BriefDescriptorExtractor> BriefDescriptorExtractor::create( int bytes, bool
     return makePtr<BriefDescriptorExtractorImpl>(bytes, use_orientation );
 }
 
+void BriefDescriptorExtractor::compute( const Ptr<DescriptorImageCache>& cache, std::vector<KeyPoint>& keypoints,
+                                        OutputArray descriptors )
+{
+    CV_Assert( !cache.empty() );
+    compute(cache->getImage(), keypoints, descriptors);
+}
+
 inline int smoothedSum(const Mat& sum, const KeyPoint& pt, int y, int x, bool use_orientation, Matx21f R)
 {
     static const int HALF_KERNEL = BriefDescriptorExtractorImpl::KERNEL_SIZE / 2;
@@ -107,64 +116,70 @@ inline int smoothedSum(const Mat& sum, const KeyPoint& pt, int y, int x, bool us
            + sum.at<int>(img_y - HALF_KERNEL, img_x - HALF_KERNEL);
 }
 
-static void pixelTests16(InputArray _sum, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, bool use_orientation )
+static void pixelTests16(const Mat& sum, const std::vector<KeyPoint>& keypoints, Mat& descriptors, bool use_orientation )
 {
-    Matx21f R;
-    Mat sum = _sum.getMat(), descriptors = _descriptors.getMat();
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
     {
-        uchar* desc = descriptors.ptr(static_cast<int>(i));
-        const KeyPoint& pt = keypoints[i];
-        if ( use_orientation )
+        Matx21f R;
+        for (int i = range.start; i < range.end; ++i)
         {
-          float angle = pt.angle;
-          angle *= (float)(CV_PI/180.f);
-          R(0,0) = sin(angle);
-          R(1,0) = cos(angle);
-        }
+            uchar* desc = descriptors.ptr(i);
+            const KeyPoint& pt = keypoints[i];
+            if ( use_orientation )
+            {
+              float angle = pt.angle;
+              angle *= (float)(CV_PI/180.f);
+              R(0,0) = sin(angle);
+              R(1,0) = cos(angle);
+            }
 
 #include "generated_16.i"
-    }
+        }
+    });
 }
 
-static void pixelTests32(InputArray _sum, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, bool use_orientation)
+static void pixelTests32(const Mat& sum, const std::vector<KeyPoint>& keypoints, Mat& descriptors, bool use_orientation )
 {
-    Matx21f R;
-    Mat sum = _sum.getMat(), descriptors = _descriptors.getMat();
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
     {
-        uchar* desc = descriptors.ptr(static_cast<int>(i));
-        const KeyPoint& pt = keypoints[i];
-        if ( use_orientation )
+        Matx21f R;
+        for (int i = range.start; i < range.end; ++i)
         {
-          float angle = pt.angle;
-          angle *= (float)(CV_PI / 180.f);
-          R(0,0) = sin(angle);
-          R(1,0) = cos(angle);
-        }
+            uchar* desc = descriptors.ptr(i);
+            const KeyPoint& pt = keypoints[i];
+            if ( use_orientation )
+            {
+              float angle = pt.angle;
+              angle *= (float)(CV_PI/180.f);
+              R(0,0) = sin(angle);
+              R(1,0) = cos(angle);
+            }
 
 #include "generated_32.i"
-    }
+        }
+    });
 }
 
-static void pixelTests64(InputArray _sum, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, bool use_orientation)
+static void pixelTests64(const Mat& sum, const std::vector<KeyPoint>& keypoints, Mat& descriptors, bool use_orientation )
 {
-    Matx21f R;
-    Mat sum = _sum.getMat(), descriptors = _descriptors.getMat();
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
     {
-        uchar* desc = descriptors.ptr(static_cast<int>(i));
-        const KeyPoint& pt = keypoints[i];
-        if ( use_orientation )
+        Matx21f R;
+        for (int i = range.start; i < range.end; ++i)
         {
-          float angle = pt.angle;
-          angle *= (float)(CV_PI/180.f);
-          R(0,0) = sin(angle);
-          R(1,0) = cos(angle);
-        }
+            uchar* desc = descriptors.ptr(i);
+            const KeyPoint& pt = keypoints[i];
+            if ( use_orientation )
+            {
+              float angle = pt.angle;
+              angle *= (float)(CV_PI/180.f);
+              R(0,0) = sin(angle);
+              R(1,0) = cos(angle);
+            }
 
 #include "generated_64.i"
-    }
+        }
+    });
 }
 
 BriefDescriptorExtractorImpl::BriefDescriptorExtractorImpl(int bytes, bool use_orientation) :
@@ -232,25 +247,25 @@ void BriefDescriptorExtractorImpl::compute(InputArray image,
                                            std::vector<KeyPoint>& keypoints,
                                            OutputArray descriptors)
 {
-    // Construct integral image for fast smoothing (box filter)
-    Mat sum;
-
-    Mat grayImage = image.getMat();
-    if( image.type() != CV_8U ) cvtColor( image, grayImage, COLOR_BGR2GRAY );
+    compute(DescriptorImageCache::create(image), keypoints, descriptors);
+}
 
-    ///TODO allow the user to pass in a precomputed integral image
-    //if(image.type() == CV_32S)
-    //  sum = image;
-    //else
+void BriefDescriptorExtractorImpl::compute(const Ptr<DescriptorImageCache>& cache,
+                                           std::vector<KeyPoint>& keypoints,
+                                           OutputArray descriptors)
+{
+    CV_Assert( !cache.empty() );
 
-    integral( grayImage, sum, CV_32S);
+    // Integral image for fast smoothing (box filter), shared through the cache
+    const Mat& sum = cache->getIntegral(CV_32S);
 
     //Remove keypoints very close to the border
-    KeyPointsFilter::runByImageBorder(keypoints, image.size(), PATCH_SIZE/2 + KERNEL_SIZE/2);
+    KeyPointsFilter::runByImageBorder(keypoints, cache->getImage().size(), PATCH_SIZE/2 + KERNEL_SIZE/2);
 
     descriptors.create((int)keypoints.size(), bytes_, CV_8U);
     descriptors.setTo(Scalar::all(0));
-    test_fn_(sum, keypoints, descriptors, use_orientation_);
+    Mat descriptorsMat = descriptors.getMat();
+    test_fn_(sum, keypoints, descriptorsMat, use_orientation_);
 }
 
 }
@@ -0,0 +1,121 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html
+
+/*
+ * Lazily computed gray, integral and box-filtered images shared between descriptor extractors
+ */
+
+#include "precomp.hpp"
+#include <map>
+
+namespace cv
+{
+namespace xfeatures2d
+{
+
+DescriptorImageCache::~DescriptorImageCache()
+{
+}
+
+class DescriptorImageCacheImpl CV_FINAL : public DescriptorImageCache
+{
+public:
+    DescriptorImageCacheImpl() : grayValid_(false) {}
+
+    void setImage(InputArray image) CV_OVERRIDE;
+    const Mat& getImage() const CV_OVERRIDE { return image_; }
+    const Mat& getGray() CV_OVERRIDE;
+    const Mat& getIntegral(int sdepth) CV_OVERRIDE;
+    const Mat& getBoxBlurred(int ksize) CV_OVERRIDE;
+
+private:
+    struct CachedImage
+    {
+        CachedImage() : valid(false) {}
+        Mat data;
+        bool valid;
+    };
+
+    Mat image_;
+    // gray_ either references image_ or grayBuf_; conversions always go to grayBuf_
+    // so that a single-channel input of a previous frame is never overwritten
+    Mat gray_, grayBuf_;
+    Mat colorBuf_;
+    bool grayValid_;
+    std::map<int, CachedImage> integrals_; // keyed by depth
+    std::map<int, CachedImage> blurred_;   // keyed by kernel size
+};
+
+Ptr<DescriptorImageCache> DescriptorImageCache::create(InputArray image)
+{
+    Ptr<DescriptorImageCache> cache = makePtr<DescriptorImageCacheImpl>();
+    if( !image.empty() )
+        cache->setImage(image);
+    return cache;
+}
+
+void DescriptorImageCacheImpl::setImage(InputArray image)
+{
+    image_ = image.getMat();
+    gray_.release();
+    grayValid_ = false;
+    for( std::map<int, CachedImage>::iterator it = integrals_.begin(); it != integrals_.end(); ++it )
+        it->second.valid = false;
+    for( std::map<int, CachedImage>::iterator it = blurred_.begin(); it != blurred_.end(); ++it )
+        it->second.valid = false;
+}
+
+const Mat& DescriptorImageCacheImpl::getGray()
+{
+    CV_Assert( !image_.empty() );
+    if( !grayValid_ )
+    {
+        if( image_.channels() == 3 || image_.channels() == 4 )
+        {
+            cvtColor(image_, grayBuf_, COLOR_BGR2GRAY);
+            gray_ = grayBuf_;
+        }
+        else
+        {
+            CV_Assert( image_.channels() == 1 );
+            gray_ = image_;
+        }
+        grayValid_ = true;
+    }
+    return gray_;
+}
+
+const Mat& DescriptorImageCacheImpl::getIntegral(int sdepth)
+{
+    CV_Assert( sdepth == CV_32S || sdepth == CV_32F || sdepth == CV_64F );
+    CachedImage& entry = integrals_[sdepth];
+    if( !entry.valid )
+    {
+        integral(getGray(), entry.data, sdepth);
+        entry.valid = true;
+    }
+    return entry.data;
+}
+
+const Mat& DescriptorImageCacheImpl::getBoxBlurred(int ksize)
+{
+    CV_Assert( !image_.empty() );
+    CV_Assert( ksize > 0 );
+    CachedImage& entry = blurred_[ksize];
+    if( !entry.valid )
+    {
+        if( image_.channels() == 4 )
+        {
+            cvtColor(image_, colorBuf_, COLOR_BGRA2BGR);
+            blur(colorBuf_, entry.data, Size(ksize, ksize));
+        }
+        else
+            blur(image_, entry.data, Size(ksize, ksize));
+        entry.valid = true;
+    }
+    return entry.data;
+}
+
+}
+}
@@ -86,20 +86,23 @@ public:
     std::vector<int> selectPairs( const std::vector<Mat>& images, std::vector<std::vector<KeyPoint> >& keypoints,
                                  const double corrThresh = 0.7, bool verbose = true );
     virtual void compute( InputArray image, std::vector<KeyPoint>& keypoints, OutputArray descriptors ) CV_OVERRIDE;
+    virtual void compute( const Ptr<DescriptorImageCache>& cache, std::vector<KeyPoint>& keypoints,
+                          OutputArray descriptors ) CV_OVERRIDE;
 
 protected:
 
     void buildPattern();
 
     template <typename imgType, typename iiType>
-    imgType meanIntensity( InputArray image, InputArray integral, const float kp_x, const float kp_y,
-                          const unsigned int scale, const unsigned int rot, const unsigned int point );
+    imgType meanIntensity( const Mat& image, const Mat& integral, const float kp_x, const float kp_y,
+                          const unsigned int scale, const unsigned int rot, const unsigned int point ) const;
 
     template <typename srcMatType, typename iiMatType>
-    void computeDescriptors( InputArray image, std::vector<KeyPoint>& keypoints, OutputArray descriptors );
+    void computeDescriptors( const Mat& image, const Mat& imgIntegral, std::vector<KeyPoint>& keypoints,
+                             OutputArray descriptors );
 
     template <typename srcMatType>
-    void extractDescriptor(srcMatType *pointsValue, void ** ptr);
+    void extractDescriptor(const srcMatType *pointsValue, uchar* ptr) const;
 
     bool orientationNormalized; //true if the orientation is normalized, false otherwise
     bool scaleNormalized; //true if the scale is normalized, false otherwise
@@ -324,7 +327,18 @@ void FREAK_Impl::buildPattern()
 
 void FREAK_Impl::compute( InputArray _image, std::vector<KeyPoint>& keypoints, OutputArray _descriptors )
 {
-    Mat image = _image.getMat();
+    if( _image.empty() )
+        return;
+    if( keypoints.empty() )
+        return;
+
+    compute(DescriptorImageCache::create(_image), keypoints, _descriptors);
+}
+
+void FREAK_Impl::compute( const Ptr<DescriptorImageCache>& cache, std::vector<KeyPoint>& keypoints, OutputArray _descriptors )
+{
+    CV_Assert( !cache.empty() );
+    const Mat& image = cache->getImage();
     if( image.empty() )
         return;
     if( keypoints.empty() )
@@ -333,13 +347,7 @@ void FREAK_Impl::compute( InputArray _image, std::vector<KeyPoint>& keypoints, O
     ((FREAK_Impl*)this)->buildPattern();
 
     // Convert to gray if not already
-    Mat grayImage;
-    if( image.channels() == 3 || image.channels() == 4 )
-        cvtColor(image, grayImage, COLOR_BGR2GRAY);
-    else {
-        CV_Assert(image.channels() == 1);
-        grayImage = image;
-    }
+    const Mat& grayImage = cache->getGray();
 
     // Use 32-bit integers if we won't overflow in the integral image
     if ((image.depth() == CV_8U || image.depth() == CV_8S) &&
@@ -347,30 +355,30 @@ void FREAK_Impl::compute( InputArray _image, std::vector<KeyPoint>& keypoints, O
     {
         // Create the integral image appropriate for our type & usage
         if (image.depth() == CV_8U)
-            computeDescriptors<uchar, int>(grayImage, keypoints, _descriptors);
+            computeDescriptors<uchar, int>(grayImage, cache->getIntegral(CV_32S), keypoints, _descriptors);
         else if (image.depth() == CV_8S)
-            computeDescriptors<char, int>(grayImage, keypoints, _descriptors);
+            computeDescriptors<char, int>(grayImage, cache->getIntegral(CV_32S), keypoints, _descriptors);
         else
             CV_Error( Error::StsUnsupportedFormat, "" );
     } else {
         // Create the integral image appropriate for our type & usage
         if ( image.depth() == CV_8U )
-            computeDescriptors<uchar, double>(grayImage, keypoints, _descriptors);
+            computeDescriptors<uchar, double>(grayImage, cache->getIntegral(CV_64F), keypoints, _descriptors);
         else if ( image.depth() == CV_8S )
-            computeDescriptors<char, double>(grayImage, keypoints, _descriptors);
+            computeDescriptors<char, double>(grayImage, cache->getIntegral(CV_64F), keypoints, _descriptors);
         else if ( image.depth() == CV_16U )
-            computeDescriptors<ushort, double>(grayImage, keypoints, _descriptors);
+            computeDescriptors<ushort, double>(grayImage, cache->getIntegral(CV_64F), keypoints, _descriptors);
         else if ( image.depth() == CV_16S )
-            computeDescriptors<short, double>(grayImage, keypoints, _descriptors);
+            computeDescriptors<short, double>(grayImage, cache->getIntegral(CV_64F), keypoints, _descriptors);
         else
             CV_Error( Error::StsUnsupportedFormat, "" );
     }
 }
 
 template <typename srcMatType>
-void FREAK_Impl::extractDescriptor(srcMatType *pointsValue, void ** ptr)
+void FREAK_Impl::extractDescriptor(const srcMatType *pointsValue, uchar* ptr) const
 {
-    std::bitset<FREAK_NB_PAIRS>** ptrScalar = (std::bitset<FREAK_NB_PAIRS>**) ptr;
+    std::bitset<FREAK_NB_PAIRS>* ptrScalar = (std::bitset<FREAK_NB_PAIRS>*) ptr;
 
     // extracting descriptor preserving the order of SSE version
     int cnt = 0;
@@ -381,18 +389,17 @@ void FREAK_Impl::extractDescriptor(srcMatType *pointsValue, void ** ptr)
             int nm = n-m;
             for(int kk = nm+15*8; kk >= nm; kk-=8, ++cnt)
             {
-                (*ptrScalar)->set(kk, pointsValue[descriptionPairs[cnt].i] >= pointsValue[descriptionPairs[cnt].j]);
+                ptrScalar->set(kk, pointsValue[descriptionPairs[cnt].i] >= pointsValue[descriptionPairs[cnt].j]);
             }
         }
     }
-    --(*ptrScalar);
 }
 
 #if CV_SSE2
 template <>
-void FREAK_Impl::extractDescriptor(uchar *pointsValue, void ** ptr)
+void FREAK_Impl::extractDescriptor(const uchar *pointsValue, uchar* ptr) const
 {
-    __m128i** ptrSSE = (__m128i**) ptr;
+    __m128i* ptrSSE = (__m128i*) ptr;
 
     // note that comparisons order is modified in each block (but first 128 comparisons remain globally the same-->does not affect the 128,384 bits segmanted matching strategy)
     int cnt = 0;
@@ -441,27 +448,21 @@ void FREAK_Impl::extractDescriptor(uchar *pointsValue, void ** ptr)
             workReg = _mm_and_si128(_mm_set1_epi16(short(0x8080 >> m)), workReg); // merge the last 16 bits with the 128bits std::vector until full
             result128 = _mm_or_si128(result128, workReg);
         }
-        (**ptrSSE) = result128;
-        ++(*ptrSSE);
+        _mm_storeu_si128(ptrSSE, result128);
+        ++ptrSSE;
     }
-    (*ptrSSE) -= 8;
 }
 #endif
 
 template <typename srcMatType, typename iiMatType>
-void FREAK_Impl::computeDescriptors( InputArray _image, std::vector<KeyPoint>& keypoints, OutputArray _descriptors ){
+void FREAK_Impl::computeDescriptors( const Mat& image, const Mat& imgIntegral, std::vector<KeyPoint>& keypoints,
+                                     OutputArray _descriptors ){
 
-    Mat image = _image.getMat();
-    Mat imgIntegral;
-    integral(image, imgIntegral, DataType<iiMatType>::type);
+    CV_Assert( imgIntegral.type() == DataType<iiMatType>::type );
     std::vector<int> kpScaleIdx(keypoints.size()); // used to save pattern scale index corresponding to each keypoints
     const std::vector<int>::iterator ScaleIdxBegin = kpScaleIdx.begin(); // used in std::vector erase function
     const std::vector<cv::KeyPoint>::iterator kpBegin = keypoints.begin(); // used in std::vector erase function
     const float sizeCst = static_cast<float>(FREAK_NB_SCALES/(FREAK_LOG2* nOctaves));
-    srcMatType pointsValue[FREAK_NB_POINTS];
-    int thetaIdx = 0;
-    int direction0;
-    int direction1;
 
     // compute the scale index corresponding to the keypoint size and remove keypoints close to the border
     if( scaleNormalized )
@@ -507,16 +508,18 @@ void FREAK_Impl::computeDescriptors( InputArray _image, std::vector<KeyPoint>& k
     }
 
     // allocate descriptor memory, estimate orientations, extract descriptors
-    if( !extAll )
-    {
-        // extract the best comparisons only
-        _descriptors.create((int)keypoints.size(), FREAK_NB_PAIRS/8, CV_8U);
-        _descriptors.setTo(Scalar::all(0));
-        Mat descriptors = _descriptors.getMat();
-
-        void *ptr = descriptors.data+(keypoints.size()-1)*descriptors.step[0];
+    // (only the best comparisons, or all possible comparisons for selection)
+    _descriptors.create((int)keypoints.size(), extAll ? 128 : FREAK_NB_PAIRS/8, CV_8U);
+    _descriptors.setTo(Scalar::all(0));
+    Mat descriptors = _descriptors.getMat();
 
-        for( size_t k = keypoints.size(); k--; ) {
+    // keypoints are independent: each range handles its own rows and angles
+    parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
+    {
+        srcMatType pointsValue[FREAK_NB_POINTS];
+        for( int k = range.start; k < range.end; ++k )
+        {
+            int thetaIdx = 0;
             // estimate orientation (gradient)
             if( !orientationNormalized )
             {
@@ -531,8 +534,8 @@ void FREAK_Impl::computeDescriptors( InputArray _image, std::vector<KeyPoint>& k
                                                                           keypoints[k].pt.x, keypoints[k].pt.y,
                                                                           kpScaleIdx[k], 0, i);
                 }
-                direction0 = 0;
-                direction1 = 0;
+                int direction0 = 0;
+                int direction1 = 0;
                 for( int m = 45; m--; )
                 {
                     //iterate through the orientation pairs
@@ -558,85 +561,38 @@ void FREAK_Impl::computeDescriptors( InputArray _image, std::vector<KeyPoint>& k
                                                                       kpScaleIdx[k], thetaIdx, i);
             }
 
-            // Extract descriptor
-            extractDescriptor<srcMatType>(pointsValue, &ptr);
-        }
-    }
-    else // extract all possible comparisons for selection
-    {
-        _descriptors.create((int)keypoints.size(), 128, CV_8U);
-        _descriptors.setTo(Scalar::all(0));
-        Mat descriptors = _descriptors.getMat();
-        std::bitset<1024>* ptr = (std::bitset<1024>*) (descriptors.data+(keypoints.size()-1)*descriptors.step[0]);
-
-        for( size_t k = keypoints.size(); k--; )
-        {
-            //estimate orientation (gradient)
-            if( !orientationNormalized )
+            if( !extAll )
             {
-                thetaIdx = 0;//assign 0° to all keypoints
-                keypoints[k].angle = 0.0;
+                // Extract descriptor
+                extractDescriptor<srcMatType>(pointsValue, descriptors.ptr(k));
             }
             else
             {
-                //get the points intensity value in the un-rotated pattern
-                for( int i = FREAK_NB_POINTS;i--; )
-                    pointsValue[i] = meanIntensity<srcMatType, iiMatType>(image, imgIntegral,
-                                                                          keypoints[k].pt.x,keypoints[k].pt.y,
-                                                                          kpScaleIdx[k], 0, i);
-
-                direction0 = 0;
-                direction1 = 0;
-                for( int m = 45; m--; )
+                std::bitset<1024>* ptr = (std::bitset<1024>*) descriptors.ptr(k);
+                int cnt(0);
+                for( int i = 1; i < FREAK_NB_POINTS; ++i )
                 {
-                    //iterate through the orientation pairs
-                    const int delta = (pointsValue[ orientationPairs[m].i ]-pointsValue[ orientationPairs[m].j ]);
-                    direction0 += delta*(orientationPairs[m].weight_dx)/2048;
-                    direction1 += delta*(orientationPairs[m].weight_dy)/2048;
+                    //(generate all the pairs)
+                    for( int j = 0; j < i; ++j )
+                    {
+                        ptr->set(cnt, pointsValue[i] >= pointsValue[j] );
+                        ++cnt;
+                    }
                 }
-
-                keypoints[k].angle = static_cast<float>(atan2((float)direction1,(float)direction0)*(180.0/CV_PI)); //estimate orientation
-
-                thetaIdx = cvRound(FREAK_NB_ORIENTATION*keypoints[k].angle*(1/360.0));
-
-                if( thetaIdx < 0 )
-                    thetaIdx += FREAK_NB_ORIENTATION;
-
-                if( thetaIdx >= FREAK_NB_ORIENTATION )
-                    thetaIdx -= FREAK_NB_ORIENTATION;
             }
-            // get the points intensity value in the rotated pattern
-            for( int i = FREAK_NB_POINTS; i--; ) {
-                pointsValue[i] = meanIntensity<srcMatType, iiMatType>(image, imgIntegral,
-                                                                      keypoints[k].pt.x, keypoints[k].pt.y,
-                                                                      kpScaleIdx[k], thetaIdx, i);
-            }
-
-            int cnt(0);
-            for( int i = 1; i < FREAK_NB_POINTS; ++i )
-            {
-                //(generate all the pairs)
-                for( int j = 0; j < i; ++j )
-                {
-                    ptr->set(cnt, pointsValue[i] >= pointsValue[j] );
-                    ++cnt;
-                }
-            }
-            --ptr;
         }
-    }
+    });
 }
 
 // simply take average on a square patch, not even gaussian approx
 template <typename imgType, typename iiType>
-imgType FREAK_Impl::meanIntensity( InputArray _image, InputArray _integral,
+imgType FREAK_Impl::meanIntensity( const Mat& image, const Mat& integral,
                               const float kp_x,
                               const float kp_y,
                               const unsigned int scale,
                               const unsigned int rot,
-                              const unsigned int point)
+                              const unsigned int point) const
 {
-    Mat image = _image.getMat(), integral = _integral.getMat();
     // get point position in image
     const PatternPoint& FreakPoint = patternLookup[scale*FREAK_NB_ORIENTATION*FREAK_NB_POINTS + rot*FREAK_NB_POINTS + point];
     const float xf = FreakPoint.x+kp_x;
@@ -844,5 +800,11 @@ Ptr<FREAK> FREAK::create(bool orientationNormalized,
                                patternScale, nOctaves, selectedPairs);
 }
 
+void FREAK::compute( const Ptr<DescriptorImageCache>& cache, std::vector<KeyPoint>& keypoints, OutputArray descriptors )
+{
+    CV_Assert( !cache.empty() );
+    compute(cache->getImage(), keypoints, descriptors);
+}
+
 }
 } // END NAMESPACE CV
@@ -44,6 +44,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <algorithm>
 #include <vector>
 
@@ -91,318 +92,195 @@ namespace cv
         {
             return makePtr<LATCHDescriptorExtractorImpl>(bytes, rotationInvariance, half_ssd_size, sigma);
         }
-        void CalcuateSums(int count, const std::vector<int> &points, bool rotationInvariance, const Mat &grayImage, const KeyPoint &pt, int &suma, int &sumc, float cos_theta, float sin_theta, int half_ssd_size);
-
-
-        static void pixelTests1(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        /*
+        * Sums of squared differences of the triplet patches (a,b) and (c,b), each of size (2K+1)x(2K+1).
+        * Pointers address the top-left pixel of each patch.
+        */
+        static inline void tripletSSD(const uchar* a, const uchar* b, const uchar* c, size_t step, int K, int &suma, int &sumc)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            const int patch = 2 * K + 1;
+            for (int iy = 0; iy < patch; iy++, a += step, b += step, c += step)
             {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 1; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
+                for (int ix = 0; ix < patch; ix++)
+                {
+                    int difa = a[ix] - b[ix];
+                    suma += difa * difa;
 
-                        count += 6;
-                    }
+                    int difc = c[ix] - b[ix];
+                    sumc += difc * difc;
                 }
             }
         }
 
-
-        static void pixelTests2(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+#if CV_SIMD128
+        /* Same as tripletSSD for patches not wider than 16 pixels; every row of each patch is read with a single
+        * 16-byte load, so the caller must ensure that 16 bytes can be read from each row start. */
+        static inline void tripletSSD_SIMD(const uchar* a, const uchar* b, const uchar* c, size_t step, int K, const v_uint8x16& rowMask, int &suma, int &sumc)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            const int patch = 2 * K + 1;
+            v_int32x4 v_suma = v_setzero_s32(), v_sumc = v_setzero_s32();
+            for (int iy = 0; iy < patch; iy++, a += step, b += step, c += step)
             {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 2; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
+                v_uint8x16 v_b = v_load(b);
+                v_uint8x16 v_difa = v_absdiff(v_load(a), v_b) & rowMask;
+                v_uint8x16 v_difc = v_absdiff(v_load(c), v_b) & rowMask;
+
+                v_uint16x8 v_difa_lo, v_difa_hi, v_difc_lo, v_difc_hi;
+                v_expand(v_difa, v_difa_lo, v_difa_hi);
+                v_expand(v_difc, v_difc_lo, v_difc_hi);
+
+                v_int16x8 v_a_lo = v_reinterpret_as_s16(v_difa_lo), v_a_hi = v_reinterpret_as_s16(v_difa_hi);
+                v_int16x8 v_c_lo = v_reinterpret_as_s16(v_difc_lo), v_c_hi = v_reinterpret_as_s16(v_difc_hi);
+                v_suma += v_dotprod(v_a_lo, v_a_lo) + v_dotprod(v_a_hi, v_a_hi);
+                v_sumc += v_dotprod(v_c_lo, v_c_lo) + v_dotprod(v_c_hi, v_c_hi);
             }
+            suma += v_reduce_sum(v_suma);
+            sumc += v_reduce_sum(v_sumc);
         }
+#endif
 
-
-        static void pixelTests4(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        /*
+        * Computes LATCH descriptors of a range of keypoints. For every keypoint the (rotated) sampling
+        * triplets are computed once, then each bit compares the SSDs of the two patch pairs of its triplet.
+        */
+        class LATCHPixelTestsInvoker : public ParallelLoopBody
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+        public:
+            LATCHPixelTestsInvoker(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors,
+                                   const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, int bytes) :
+                grayImage_(grayImage), keypoints_(keypoints), descriptors_(descriptors), points_(points),
+                rotationInvariance_(rotationInvariance), half_ssd_size_(half_ssd_size), bytes_(bytes)
             {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 4; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
+            }
 
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
+            void operator()(const Range& range) const CV_OVERRIDE
+            {
+                const int K = half_ssd_size_;
+                const int numCoords = bytes_ * 8 * 6;
+                const size_t step = grayImage_.step;
+                const uchar* data = grayImage_.data;
+
+                /* absolute coordinates of the triplets of the current keypoint, reused for all keypoints of the range */
+                std::vector<int> coords(numCoords);
+
+#if CV_SIMD128
+                const bool useSIMD = 2 * K + 1 <= v_uint8x16::nlanes && useOptimized();
+                uchar rowMaskBuf[v_uint8x16::nlanes];
+                for (int i = 0; i < v_uint8x16::nlanes; i++)
+                    rowMaskBuf[i] = i < 2 * K + 1 ? 255 : 0;
+                v_uint8x16 rowMask = v_load(rowMaskBuf);
+#endif
+
+                for (int i = range.start; i < range.end; ++i)
+                {
+                    uchar* desc = descriptors_.ptr(i);
+                    const KeyPoint& pt = keypoints_[i];
+
+                    //handling keypoint orientation
+                    float angle = pt.angle;
+                    angle *= (float)(CV_PI / 180.f);
+                    float cos_theta = cos(angle);
+                    float sin_theta = sin(angle);
+
+                    /* top-left corners of the patches */
+                    int cx0 = (int)(pt.pt.x + 0.5) - K;
+                    int cy0 = (int)(pt.pt.y + 0.5) - K;
+                    for (int k = 0; k < numCoords; k += 2)
+                    {
+                        int x = points_[k];
+                        int y = points_[k + 1];
+                        if (rotationInvariance_)
+                        {
+                            int x2 = (int)(((float)x)*cos_theta - ((float)y)*sin_theta);
+                            int y2 = (int)(((float)x)*sin_theta + ((float)y)*cos_theta);
+                            x = std::min(std::max(x2, -24), 24);
+                            y = std::min(std::max(y2, -24), 24);
+                        }
+                        coords[k] = x + cx0;
+                        coords[k + 1] = y + cy0;
+                    }
 
-                        count += 6;
+#if CV_SIMD128
+                    /* 16-byte row loads stay inside the image unless the patches touch its right border */
+                    const bool keypointSIMD = useSIMD && cx0 + 24 + v_uint8x16::nlanes <= grayImage_.cols;
+#endif
+                    int count = 0;
+                    for (int ix = 0; ix < bytes_; ix++){
+                        desc[ix] = 0;
+                        for (int j = 7; j >= 0; j--){
+
+                            int suma = 0;
+                            int sumc = 0;
+
+                            const uchar* a = data + coords[count + 1] * step + coords[count];
+                            const uchar* b = data + coords[count + 3] * step + coords[count + 2];
+                            const uchar* c = data + coords[count + 5] * step + coords[count + 4];
+#if CV_SIMD128
+                            if (keypointSIMD)
+                                tripletSSD_SIMD(a, b, c, step, K, rowMask, suma, sumc);
+                            else
+#endif
+                                tripletSSD(a, b, c, step, K, suma, sumc);
+                            desc[ix] += (uchar)((suma < sumc) << j);
+
+                            count += 6;
+                        }
                     }
                 }
             }
-        }
-
 
+        private:
+            const Mat& grayImage_;
+            const std::vector<KeyPoint>& keypoints_;
+            Mat& descriptors_;
+            const std::vector<int>& points_;
+            bool rotationInvariance_;
+            int half_ssd_size_;
+            int bytes_;
+        };
 
-        static void pixelTests8(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, int bytes)
         {
             Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 8; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
+            parallel_for_(Range(0, (int)keypoints.size()),
+                          LATCHPixelTestsInvoker(grayImage, keypoints, descriptors, points, rotationInvariance, half_ssd_size, bytes));
+        }
 
-                        int suma = 0;
-                        int sumc = 0;
+        static void pixelTests1(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        {
+            pixelTests(grayImage, keypoints, _descriptors, points, rotationInvariance, half_ssd_size, 1);
+        }
 
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
+        static void pixelTests2(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        {
+            pixelTests(grayImage, keypoints, _descriptors, points, rotationInvariance, half_ssd_size, 2);
+        }
 
-                        count += 6;
-                    }
-                }
-            }
+        static void pixelTests4(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        {
+            pixelTests(grayImage, keypoints, _descriptors, points, rotationInvariance, half_ssd_size, 4);
         }
 
+        static void pixelTests8(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        {
+            pixelTests(grayImage, keypoints, _descriptors, points, rotationInvariance, half_ssd_size, 8);
+        }
 
         static void pixelTests16(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 16; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
-            }
+            pixelTests(grayImage, keypoints, _descriptors, points, rotationInvariance, half_ssd_size, 16);
         }
 
-
         static void pixelTests32(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 32; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
-            }
+            pixelTests(grayImage, keypoints, _descriptors, points, rotationInvariance, half_ssd_size, 32);
         }
 
-
         static void pixelTests64(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 64; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
-            }
+            pixelTests(grayImage, keypoints, _descriptors, points, rotationInvariance, half_ssd_size, 64);
         }
 
-        void CalcuateSums(int count, const std::vector<int> &points, bool rotationInvariance, const Mat &grayImage, const KeyPoint &pt, int &suma, int &sumc, float cos_theta, float sin_theta, int half_ssd_size)
-
-        {
-            int ax = points[count];
-            int ay = points[count + 1];
-
-            int	bx = points[count + 2];
-            int	by = points[count + 3];
-
-            int cx = points[count + 4];
-            int cy = points[count + 5];
-
-            int ax2 = ax;
-            int ay2 = ay;
-            int bx2 = bx;
-            int by2 = by;
-            int cx2 = cx;
-            int cy2 = cy;
-
-            if (rotationInvariance){
-
-
-                ax2 =(int)(((float)ax)*cos_theta - ((float)ay)*sin_theta);
-                ay2 = (int)(((float)ax)*sin_theta + ((float)ay)*cos_theta);
-                bx2 = (int)(((float)bx)*cos_theta - ((float)by)*sin_theta);
-                by2 = (int)(((float)bx)*sin_theta + ((float)by)*cos_theta);
-                cx2 = (int)(((float)cx)*cos_theta - ((float)cy)*sin_theta);
-                cy2 = (int)(((float)cx)*sin_theta + ((float)cy)*cos_theta);
-
-
-                if (ax2 > 24)
-                    ax2 = 24;
-                if (ax2<-24)
-                    ax2 = -24;
-
-                if (ay2>24)
-                    ay2 = 24;
-                if (ay2<-24)
-                    ay2 = -24;
-
-                if (bx2>24)
-                    bx2 = 24;
-                if (bx2<-24)
-                    bx2 = -24;
-
-                if (by2>24)
-                    by2 = 24;
-                if (by2<-24)
-                    by2 = -24;
-
-                if (cx2>24)
-                    cx2 = 24;
-                if (cx2<-24)
-                    cx2 = -24;
-
-                if (cy2>24)
-                    cy2 = 24;
-                if (cy2 < -24)
-                    cy2 = -24;
-
-            }
-
-
-            ax2 += (int)(pt.pt.x + 0.5);
-            ay2 += (int)(pt.pt.y + 0.5);
-
-            bx2 += (int)(pt.pt.x + 0.5);
-            by2 += (int)(pt.pt.y + 0.5);
-
-            cx2 += (int)(pt.pt.x + 0.5);
-            cy2 += (int)(pt.pt.y + 0.5);
-
-
-            int K = half_ssd_size;
-            for (int iy = -K; iy <= K; iy++)
-            {
-                const uchar * Mi_a = grayImage.ptr<uchar>(ay2 + iy);
-                const uchar * Mi_b = grayImage.ptr<uchar>(by2 + iy);
-                const uchar * Mi_c = grayImage.ptr<uchar>(cy2 + iy);
-
-                for (int ix = -K; ix <= K; ix++)
-                {
-                    double difa = Mi_a[ax2 + ix] - Mi_b[bx2 + ix];
-                    suma += (int)((difa)*(difa));
-
-                    double difc = Mi_c[cx2 + ix] - Mi_b[bx2 + ix];
-                    sumc += (int)((difc)*(difc));
-                }
-            }
-
-        }
-
-
 
         LATCHDescriptorExtractorImpl::LATCHDescriptorExtractorImpl(int bytes, bool rotationInvariance, int half_ssd_size, double sigma) :
             bytes_(bytes), test_fn_(NULL), rotationInvariance_(rotationInvariance), half_ssd_size_(half_ssd_size), sigma_(sigma)
@@ -47,6 +47,7 @@ the use of this software, even if advised of the possibility of such damage.
 */
 
 #include "precomp.hpp"
+#include <algorithm>
 
 namespace cv {
     namespace xfeatures2d {
@@ -71,6 +72,7 @@ namespace cv {
                 virtual int defaultNorm() const CV_OVERRIDE;
 
                 virtual void compute(InputArray _src, std::vector<KeyPoint> &keypoints, OutputArray _desc) CV_OVERRIDE;
+                virtual void compute(const Ptr<DescriptorImageCache>& cache, std::vector<KeyPoint> &keypoints, OutputArray _desc) CV_OVERRIDE;
 
             protected:
                 int l_kernel, b_kernel;
@@ -80,6 +82,11 @@ namespace cv {
             return makePtr<LUCIDImpl>(lucid_kernel, blur_kernel);
         }
 
+        void LUCID::compute(const Ptr<DescriptorImageCache>& cache, std::vector<KeyPoint> &keypoints, OutputArray _desc) {
+            CV_Assert(!cache.empty());
+            compute(cache->getImage(), keypoints, _desc);
+        }
+
         LUCIDImpl::LUCIDImpl(const int lucid_kernel, const int blur_kernel) {
             l_kernel = lucid_kernel;
             b_kernel = blur_kernel*2+1;
@@ -101,47 +108,53 @@ namespace cv {
         // speed-ups and enhancements by gliese581h
         void LUCIDImpl::compute(InputArray _src, std::vector<KeyPoint> &keypoints, OutputArray _desc) {
             if (_src.empty()) return;
-            CV_Assert(_src.depth() == CV_8U);
-            cv::Mat src_input;
-            if (_src.channels() == 4)
-                cvtColor(_src, src_input, COLOR_BGRA2BGR);
-            else {
-                CV_Assert(_src.channels() == 3);
-                src_input = _src.getMat();
-            }
+            compute(DescriptorImageCache::create(_src), keypoints, _desc);
+        }
 
-            Mat_<Vec3b> src;
+        void LUCIDImpl::compute(const Ptr<DescriptorImageCache>& cache, std::vector<KeyPoint> &keypoints, OutputArray _desc) {
+            CV_Assert(!cache.empty());
+            const Mat& src_input = cache->getImage();
+            if (src_input.empty()) return;
+            CV_Assert(src_input.depth() == CV_8U);
+            CV_Assert(src_input.channels() == 3 || src_input.channels() == 4);
 
-            blur(src_input, src, cv::Size(b_kernel, b_kernel));
+            const Mat_<Vec3b> src = cache->getBoxBlurred(b_kernel);
 
-            int x, y, j, d, p, m = (l_kernel*2+1)*(l_kernel*2+1)*3, width = src.cols, height = src.rows, r, c;
+            const int m = (l_kernel*2+1)*(l_kernel*2+1)*3, width = src.cols, height = src.rows;
 
             Mat_<uchar> desc(static_cast<int>(keypoints.size()), m);
 
-            for (std::size_t i = 0; i < keypoints.size(); ++i) {
-                x = static_cast<int>(keypoints[i].pt.x)-l_kernel, y = static_cast<int>(keypoints[i].pt.y)-l_kernel, d = x+2*l_kernel, p = y+2*l_kernel, j = x, r = static_cast<int>(i), c = 0;
-
-                while (x <= d) {
-                    Vec3b &pix = src((y < 0 ? height+y : y >= height ? y-height : y), (x < 0 ? width+x : x >= width ? x-width : x));
-
-                    desc(r, c++) = pix[0];
-                    desc(r, c++) = pix[1];
-                    desc(r, c++) = pix[2];
-
-                    ++x;
-                    if (x > d) {
-                        if (y < p) {
-                            ++y;
-                            x = j;
+            // every row is filled and sorted independently
+            parallel_for_(Range(0, desc.rows), [&](const Range& range) {
+                for (int r = range.start; r < range.end; ++r) {
+                    int x = static_cast<int>(keypoints[r].pt.x)-l_kernel, y = static_cast<int>(keypoints[r].pt.y)-l_kernel, d = x+2*l_kernel, p = y+2*l_kernel, j = x, c = 0;
+                    uchar* row = desc[r];
+
+                    while (x <= d) {
+                        const Vec3b &pix = src((y < 0 ? height+y : y >= height ? y-height : y), (x < 0 ? width+x : x >= width ? x-width : x));
+
+                        row[c++] = pix[0];
+                        row[c++] = pix[1];
+                        row[c++] = pix[2];
+
+                        ++x;
+                        if (x > d) {
+                            if (y < p) {
+                                ++y;
+                                x = j;
+                            }
+                            else
+                                break;
                         }
-                        else
-                            break;
                     }
+
+                    // same result as sort(desc, _desc, SORT_EVERY_ROW | SORT_ASCENDING), done row by row
+                    std::sort(row, row + m);
                 }
-            }
+            });
 
             if (_desc.needed())
-                sort(desc, _desc, SORT_EVERY_ROW | SORT_ASCENDING);
+                desc.copyTo(_desc);
         }
     }
 } // END NAMESPACE CV
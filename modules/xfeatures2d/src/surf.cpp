@@ -109,6 +109,7 @@ Modifications by Ian Mahon
 */
 #include "precomp.hpp"
 #include "surf.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv
 {
@@ -147,6 +148,49 @@ inline float calcHaarPattern( const int* origin, const SurfHF* f, int n )
     return (float)d;
 }
 
+/*
+ * Evaluate the two 2-rectangle gradient wavelets used for orientation assignment at
+ * n sample points of the integral image (given by their offsets from sum) at once,
+ * and weight the responses with the Gaussian weights w.
+ */
+static void calcHaarResponses( const int* sum, const int* ofs, const float* w, int n,
+                               const SurfHF* fx, const SurfHF* fy, float* X, float* Y )
+{
+    int i = 0;
+#if CV_SIMD128
+    if( useOptimized() )
+    {
+        const v_float32x4 fx0 = v_setall_f32(fx[0].w), fx1 = v_setall_f32(fx[1].w);
+        const v_float32x4 fy0 = v_setall_f32(fy[0].w), fy1 = v_setall_f32(fy[1].w);
+        for( ; i <= n - 4; i += 4 )
+        {
+            const int* o = ofs + i;
+#define SURF_GATHER4(p) v_int32x4(sum[o[0] + (p)], sum[o[1] + (p)], sum[o[2] + (p)], sum[o[3] + (p)])
+#define SURF_BOX4(f) (SURF_GATHER4((f).p0) + SURF_GATHER4((f).p3) - SURF_GATHER4((f).p1) - SURF_GATHER4((f).p2))
+            v_float32x4 vx = v_cvt_f32(SURF_BOX4(fx[0]))*fx0 + v_cvt_f32(SURF_BOX4(fx[1]))*fx1;
+            v_float32x4 vy = v_cvt_f32(SURF_BOX4(fy[0]))*fy0 + v_cvt_f32(SURF_BOX4(fy[1]))*fy1;
+#undef SURF_BOX4
+#undef SURF_GATHER4
+            v_float32x4 vw = v_load(w + i);
+            v_store(X + i, vx*vw);
+            v_store(Y + i, vy*vw);
+        }
+    }
+#endif
+    // the tail accumulates in float exactly like the vector lanes, so the result
+    // does not depend on which samples happen to fall into the tail
+    for( ; i < n; i++ )
+    {
+        const int* ptr = sum + ofs[i];
+        float dx = (float)(ptr[fx[0].p0] + ptr[fx[0].p3] - ptr[fx[0].p1] - ptr[fx[0].p2])*fx[0].w +
+                   (float)(ptr[fx[1].p0] + ptr[fx[1].p3] - ptr[fx[1].p1] - ptr[fx[1].p2])*fx[1].w;
+        float dy = (float)(ptr[fy[0].p0] + ptr[fy[0].p3] - ptr[fy[0].p1] - ptr[fy[0].p2])*fy[0].w +
+                   (float)(ptr[fy[1].p0] + ptr[fy[1].p3] - ptr[fy[1].p1] - ptr[fy[1].p2])*fy[1].w;
+        X[i] = dx*w[i];
+        Y[i] = dy*w[i];
+    }
+}
+
 static void
 resizeHaarPattern( const int src[][5], SurfHF* dst, int n, int oldSize, int newSize, int widthStep )
 {
@@ -577,6 +621,8 @@ struct SURFInvoker : ParallelLoopBody
         const int nOriSampleBound =(2*ORI_RADIUS+1)*(2*ORI_RADIUS+1);
 
         float X[nOriSampleBound], Y[nOriSampleBound], angle[nOriSampleBound];
+        float W[nOriSampleBound];
+        int ofs[nOriSampleBound], iangle[nOriSampleBound];
         uchar PATCH[PATCH_SZ+1][PATCH_SZ+1];
         float DX[PATCH_SZ][PATCH_SZ], DY[PATCH_SZ][PATCH_SZ];
         Mat _patch(PATCH_SZ+1, PATCH_SZ+1, CV_8U, PATCH);
@@ -622,6 +668,8 @@ struct SURFInvoker : ParallelLoopBody
             {
                 resizeHaarPattern( dx_s, dx_t, NX, 4, grad_wav_size, sum->cols );
                 resizeHaarPattern( dy_s, dy_t, NY, 4, grad_wav_size, sum->cols );
+                /* collect the samples lying inside the image, then evaluate all their
+                 wavelet responses in one pass */
                 for( kk = 0, nangle = 0; kk < nOriSamples; kk++ )
                 {
                     int x = cvRound( center.x + apt[kk].x*s - (float)(grad_wav_size-1)/2 );
@@ -629,11 +677,8 @@ struct SURFInvoker : ParallelLoopBody
                     if( y < 0 || y >= sum->rows - grad_wav_size ||
                         x < 0 || x >= sum->cols - grad_wav_size )
                         continue;
-                    const int* ptr = &sum->at<int>(y, x);
-                    float vx = calcHaarPattern( ptr, dx_t, 2 );
-                    float vy = calcHaarPattern( ptr, dy_t, 2 );
-                    X[nangle] = vx*aptw[kk];
-                    Y[nangle] = vy*aptw[kk];
+                    ofs[nangle] = y*sum->cols + x;
+                    W[nangle] = aptw[kk];
                     nangle++;
                 }
                 if( nangle == 0 )
@@ -646,7 +691,11 @@ struct SURFInvoker : ParallelLoopBody
                     continue;
                 }
 
+                calcHaarResponses( sum->ptr<int>(), ofs, W, nangle, dx_t, dy_t, X, Y );
+
                 phase( Mat(1, nangle, CV_32F, X), Mat(1, nangle, CV_32F, Y), Mat(1, nangle, CV_32F, angle), true );
+                for( j = 0; j < nangle; j++ )
+                    iangle[j] = cvRound(angle[j]);
 
                 float bestx = 0, besty = 0, descriptor_mod = 0;
                 for( i = 0; i < 360; i += SURF_ORI_SEARCH_INC )
@@ -654,7 +703,7 @@ struct SURFInvoker : ParallelLoopBody
                     float sumx = 0, sumy = 0, temp_mod;
                     for( j = 0; j < nangle; j++ )
                     {
-                        int d = std::abs(cvRound(angle[j]) - i);
+                        int d = std::abs(iangle[j] - i);
                         if( d < ORI_WIN/2 || d > 360-ORI_WIN/2 )
                         {
                             sumx += X[j];
@@ -776,7 +825,21 @@ struct SURFInvoker : ParallelLoopBody
 
             // Calculate gradients in x and y with wavelets of size 2s
             for( i = 0; i < PATCH_SZ; i++ )
-                for( j = 0; j < PATCH_SZ; j++ )
+            {
+                j = 0;
+#if CV_SIMD128
+                for( ; j <= PATCH_SZ - 4; j += 4 )
+                {
+                    v_int32x4 p00 = v_reinterpret_as_s32(v_load_expand_q(&PATCH[i][j]));
+                    v_int32x4 p01 = v_reinterpret_as_s32(v_load_expand_q(&PATCH[i][j+1]));
+                    v_int32x4 p10 = v_reinterpret_as_s32(v_load_expand_q(&PATCH[i+1][j]));
+                    v_int32x4 p11 = v_reinterpret_as_s32(v_load_expand_q(&PATCH[i+1][j+1]));
+                    v_float32x4 dw = v_load(&DW[i*PATCH_SZ + j]);
+                    v_store(&DX[i][j], v_cvt_f32(p01 - p00 + p11 - p10)*dw);
+                    v_store(&DY[i][j], v_cvt_f32(p10 - p00 + p11 - p01)*dw);
+                }
+#endif
+                for( ; j < PATCH_SZ; j++ )
                 {
                     float dw = DW[i*PATCH_SZ + j];
                     float vx = (PATCH[i][j+1] - PATCH[i][j] + PATCH[i+1][j+1] - PATCH[i+1][j])*dw;
@@ -784,6 +847,7 @@ struct SURFInvoker : ParallelLoopBody
                     DX[i][j] = vx;
                     DY[i][j] = vy;
                 }
+            }
 
             // Construct the descriptor
             vec = descriptors->ptr<float>(k);
@@ -984,7 +1048,10 @@ void SURF_Impl::detectAndCompute(InputArray _img, InputArray _mask,
 
         // we call SURFInvoker in any case, even if we do not need descriptors,
         // since it computes orientation of each feature.
-        parallel_for_(Range(0, N), SURFInvoker(img, sum, keypoints, descriptors, extended, upright) );
+        // Keypoints are processed in a few stripes per thread, so that the per-stripe
+        // window buffer is allocated once for many keypoints.
+        double nstripes = std::max(1, std::min(N, getNumThreads()*4));
+        parallel_for_(Range(0, N), SURFInvoker(img, sum, keypoints, descriptors, extended, upright), nstripes );
 
         // remove keypoints that were marked for deletion
         for( i = j = 0; i < N; i++ )
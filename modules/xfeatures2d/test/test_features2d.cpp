@@ -993,6 +993,42 @@ TEST( Features2d_Detector_SURF, regression )
     CV_FeatureDetectorTest test( "detector-surf", SURF::create() );
     test.safe_run();
 }
+
+TEST( Features2d_Detector_SURF, orientation_simd_matches_scalar )
+{
+    string imgFilename = cvtest::TS::ptr()->get_data_path() + FEATURES2D_DIR + "/" + IMAGE_FILENAME;
+    Mat image = imread(imgFilename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(image.empty()) << "Unable to load source image " << imgFilename;
+
+#ifdef HAVE_OPENCL
+    bool useOCL = cv::ocl::useOpenCL();
+    cv::ocl::setUseOpenCL(false);
+#endif
+    const bool useOptimizedBackup = useOptimized();
+
+    Ptr<SURF> surf = SURF::create();
+    vector<KeyPoint> kpScalar, kpSIMD;
+    setUseOptimized(false);
+    surf->detect(image, kpScalar);
+    setUseOptimized(true);
+    surf->detect(image, kpSIMD);
+
+    setUseOptimized(useOptimizedBackup);
+#ifdef HAVE_OPENCL
+    cv::ocl::setUseOpenCL(useOCL);
+#endif
+
+    // Haar responses are accumulated in float on both paths, so locations, scales
+    // and orientations of the keypoints must agree
+    ASSERT_FALSE(kpScalar.empty());
+    ASSERT_EQ(kpScalar.size(), kpSIMD.size());
+    for (size_t i = 0; i < kpScalar.size(); i++)
+    {
+        EXPECT_EQ(kpScalar[i].pt, kpSIMD[i].pt) << "keypoint " << i;
+        EXPECT_EQ(kpScalar[i].size, kpSIMD[i].size) << "keypoint " << i;
+        EXPECT_NEAR(kpScalar[i].angle, kpSIMD[i].angle, 1e-3f) << "keypoint " << i;
+    }
+}
 #endif
 
 TEST( Features2d_Detector_STAR, regression )
@@ -1107,6 +1143,36 @@ TEST( Features2d_DescriptorExtractor_LUCID, regression )
     test.safe_run();
 }
 
+template <typename T>
+static void checkCachedCompute(const Ptr<T>& extractor, const Mat& image,
+                               const Ptr<DescriptorImageCache>& cache, const vector<KeyPoint>& keypoints)
+{
+    vector<KeyPoint> kpRef = keypoints, kpCached = keypoints;
+    Mat descRef, descCached;
+    extractor->compute(image, kpRef, descRef);
+    extractor->compute(cache, kpCached, descCached);
+
+    ASSERT_EQ(kpRef.size(), kpCached.size());
+    EXPECT_EQ(0, cvtest::norm(descRef, descCached, NORM_INF));
+}
+
+TEST( Features2d_DescriptorImageCache, same_as_uncached )
+{
+    string imgFilename = cvtest::TS::ptr()->get_data_path() + FEATURES2D_DIR + "/" + IMAGE_FILENAME;
+    Mat image = imread(imgFilename);
+    ASSERT_FALSE(image.empty()) << "Unable to load source image " << imgFilename;
+
+    vector<KeyPoint> keypoints;
+    FAST(image, keypoints, 20);
+    ASSERT_FALSE(keypoints.empty());
+
+    // one cache shared by all extractors of the frame
+    Ptr<DescriptorImageCache> cache = DescriptorImageCache::create(image);
+    checkCachedCompute(BriefDescriptorExtractor::create(32, true), image, cache, keypoints);
+    checkCachedCompute(FREAK::create(), image, cache, keypoints);
+    checkCachedCompute(LUCID::create(1, 2), image, cache, keypoints);
+}
+
 TEST( Features2d_DescriptorExtractor_LATCH, regression )
 {
     CV_DescriptorExtractorTest<Hamming> test( "descriptor-latch",  1,
@@ -1114,6 +1180,44 @@ TEST( Features2d_DescriptorExtractor_LATCH, regression )
     test.safe_run();
 }
 
+TEST( Features2d_DescriptorExtractor_LATCH, simd_matches_scalar )
+{
+    RNG rng(0xC0FFEE);
+    Mat image(240, 320, CV_8UC1);
+    rng.fill(image, RNG::UNIFORM, 0, 256);
+
+    // keypoints cover the whole image, so patches near the right border take the scalar fallback
+    vector<KeyPoint> keypoints;
+    for (int i = 0; i < 200; i++)
+        keypoints.push_back(KeyPoint(rng.uniform(0.f, (float)image.cols), rng.uniform(0.f, (float)image.rows),
+                                     7.f, rng.uniform(0.f, 360.f)));
+
+    const bool useOptimizedBackup = useOptimized();
+    const int bytesList[] = { 1, 8, 32, 64 };
+    // patch widths 7 and 15 fit a single 16-byte row load, 17 and 23 do not
+    const int halfSSDList[] = { 3, 7, 8, 11 };
+    for (size_t b = 0; b < sizeof(bytesList)/sizeof(bytesList[0]); b++)
+    {
+        for (size_t h = 0; h < sizeof(halfSSDList)/sizeof(halfSSDList[0]); h++)
+        {
+            SCOPED_TRACE(cv::format("bytes=%d half_ssd_size=%d", bytesList[b], halfSSDList[h]));
+            Ptr<LATCH> latch = LATCH::create(bytesList[b], true, halfSSDList[h], 0);
+
+            vector<KeyPoint> kpScalar = keypoints, kpSIMD = keypoints;
+            Mat descScalar, descSIMD;
+            setUseOptimized(false);
+            latch->compute(image, kpScalar, descScalar);
+            setUseOptimized(true);
+            latch->compute(image, kpSIMD, descSIMD);
+
+            ASSERT_FALSE(kpScalar.empty());
+            ASSERT_EQ(kpScalar.size(), kpSIMD.size());
+            EXPECT_EQ(0, cvtest::norm(descScalar, descSIMD, NORM_HAMMING));
+        }
+    }
+    setUseOptimized(useOptimizedBackup);
+}
+
 #ifdef OPENCV_XFEATURES2D_HAS_VGG_DATA
 TEST( Features2d_DescriptorExtractor_VGG, regression )
 {
@@ -316,6 +316,35 @@ proportional to sigmaSpace .
 CV_EXPORTS_W
 void jointBilateralFilter(InputArray joint, InputArray src, OutputArray dst, int d, double sigmaColor, double sigmaSpace, int borderType = BORDER_DEFAULT);
 
+/** @brief Interface for the bilateral texture filter.
+
+Keeps the intermediate images (padded input, gradients, mRTV map, guidance image) between calls, so
+that filtering a sequence of images of the same size and type does not reallocate them.
+
+@sa bilateralTextureFilter
+*/
+class CV_EXPORTS_W BilateralTextureFilter : public Algorithm
+{
+public:
+    /** @brief Applies the bilateral texture filter to an image.
+
+    @param src Source image whose depth is 8-bit UINT or 32-bit FLOAT
+
+    @param dst Destination image of the same size and type as src.
+    */
+    CV_WRAP virtual void filter(InputArray src, OutputArray dst) = 0;
+
+    /** @brief Releases all internal buffers.
+    */
+    CV_WRAP virtual void collectGarbage() = 0;
+};
+
+/** @brief Factory method, create instance of BilateralTextureFilter.
+
+See bilateralTextureFilter for the description of the parameters.
+*/
+CV_EXPORTS_W Ptr<BilateralTextureFilter> createBilateralTextureFilter(int fr = 3, int numIter = 1, double sigmaAlpha = -1., double sigmaAvg = -1.);
+
 /** @brief Applies the bilateral texture filter to an image. It performs structure-preserving texture filter.
 For more details about this filter see @cite Cho2014.
 
@@ -341,6 +370,35 @@ void bilateralTextureFilter(InputArray src, OutputArray dst, int fr = 3, int num
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
+/** @brief Interface for the rolling guidance filter.
+
+Keeps the bordered source image, the range weight table and the intermediate guidance images between
+calls, so that filtering a sequence of images of the same size and type does not reallocate them.
+
+@sa rollingGuidanceFilter
+*/
+class CV_EXPORTS_W RollingGuidanceFilter : public Algorithm
+{
+public:
+    /** @brief Applies the rolling guidance filter to an image.
+
+    @param src Source 8-bit or floating-point, 1-channel or 3-channel image.
+
+    @param dst Destination image of the same size and type as src.
+    */
+    CV_WRAP virtual void filter(InputArray src, OutputArray dst) = 0;
+
+    /** @brief Releases all internal buffers.
+    */
+    CV_WRAP virtual void collectGarbage() = 0;
+};
+
+/** @brief Factory method, create instance of RollingGuidanceFilter.
+
+See rollingGuidanceFilter for the description of the parameters.
+*/
+CV_EXPORTS_W Ptr<RollingGuidanceFilter> createRollingGuidanceFilter(int d = -1, double sigmaColor = 25, double sigmaSpace = 3, int numOfIter = 4, int borderType = BORDER_DEFAULT);
+
 /** @brief Applies the rolling guidance filter to an image.
 
 For more details, please see @cite zhang2014rolling
@@ -391,6 +449,11 @@ public:
     @param dst destination image.
 
     @note Confidence images with CV_8U depth are expected to in [0, 255] and CV_32F in [0, 1] range.
+
+    @note The bilateral grid is built once for the guide. The system matrix and its preconditioner are
+    kept between calls and rebuilt only when the confidence changes, and all channels of @p src are solved
+    together, so filtering several images (or channels) with the same guide and confidence is cheaper
+    than separate fastBilateralSolverFilter calls.
     */
     CV_WRAP virtual void filter(InputArray src, InputArray confidence, OutputArray dst) = 0;
 };
@@ -129,6 +129,10 @@ typedef enum {
 *
 * The function calculates the fast Hough transform for full, half or quarter
 * range of angles.
+*
+* The intermediate buffers are kept per calling thread and reused by the next
+* calls, unless they take more than 32 MB, in which case they are released
+* when the function returns.
 */
 CV_EXPORTS_W void FastHoughTransform( InputArray  src,
                                       OutputArray dst,
@@ -98,6 +98,20 @@ public:
      */
     CV_WRAP virtual void iterate(InputArray img, int num_iterations=4) = 0;
 
+    /** @brief Refines the current superpixel segmentation on a new image of the same size.
+
+    @param img Input image, with the same size, channels and depth as for iterate().
+
+    @param num_iterations Number of pixel level iterations.
+
+    Instead of starting again from the initial grid, the segmentation computed by the last call to
+    iterate() or iterateIncremental() is used as a starting point and only the pixel level updates
+    are run. This is intended for video, where consecutive frames are similar: the superpixels then
+    follow the image content and only a few iterations are needed per frame. If no segmentation
+    was computed yet, this function is the same as iterate().
+     */
+    CV_WRAP virtual void iterateIncremental(InputArray img, int num_iterations=4) = 0;
+
     /** @brief Returns the segmentation labeling of the image.
 
     Each label represents a superpixel, and each pixel is assigned to one superpixel label.
@@ -59,6 +59,14 @@ namespace cv {
 
                             CV_WRAP virtual void setMinSize(int min_size) = 0;
                             CV_WRAP virtual int getMinSize() = 0;
+
+                            /** @brief Enable the tiled variant of the algorithm when tile_size > 0 (default: 0, disabled)
+                                Square tiles of tile_size pixels are segmented in parallel, then segments are merged across tile
+                                borders. The result is close to, but not the same as, the segmentation of the whole image at once.
+                                @param tile_size The size of the tiles, in pixels
+                            */
+                            CV_WRAP virtual void setTileSize(int tile_size) = 0;
+                            CV_WRAP virtual int getTileSize() = 0;
                     };
 
                     /** @brief Creates a graph based segmentor
@@ -89,6 +89,37 @@ enum WMFWeightType
 */
 CV_EXPORTS_W void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst,
                                        int r, double sigma = 25.5, int weightType = WMF_EXP, InputArray mask = noArray());
+
+/** @brief Interface for the weighted median filter that keeps its working memory between calls.
+
+The image is split into vertical stripes that are filtered in parallel, each one with its own
+joint-histogram. All buffers (quantized images, weight table and histograms) are kept by the object,
+so filtering a sequence of frames of the same size does not allocate after the first call.
+
+@note An instance must not be used from several threads at the same time.
+
+@sa weightedMedianFilter
+*/
+class CV_EXPORTS_W WeightedMedianFilter : public Algorithm
+{
+public:
+    /** @brief Applies the weighted median filter to an image.
+
+    @param joint Joint 8-bit, 1-channel or 3-channel image.
+    @param src Source 8-bit or floating-point, 1-channel or 3-channel image.
+    @param dst Destination image.
+    @param mask A 0-1 mask that has the same size with src, see weightedMedianFilter.
+    */
+    CV_WRAP virtual void filter(InputArray joint, InputArray src, OutputArray dst, InputArray mask = noArray()) = 0;
+};
+
+/** @brief Factory method, create instance of WeightedMedianFilter.
+
+@param r Radius of filtering kernel, should be a positive integer.
+@param sigma Filter range standard deviation for the joint image.
+@param weightType The type of weight definition, see WMFWeightType
+*/
+CV_EXPORTS_W Ptr<WeightedMedianFilter> createWeightedMedianFilter(int r, double sigma = 25.5, int weightType = WMF_EXP);
 }
 }
 
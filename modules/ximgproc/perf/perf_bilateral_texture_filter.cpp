@@ -38,5 +38,35 @@ PERF_TEST_P(BilateralTextureFilterTest, perf,
 
     SANITY_CHECK_NOTHING();
 }
+typedef tuple<Size, MatType, int> BTFSequenceTestParam;
+typedef TestBaseWithParam<BTFSequenceTestParam> BilateralTextureFilterSequenceTest;
+
+PERF_TEST_P(BilateralTextureFilterSequenceTest, reusedObject,
+    Combine(
+    SZ_TYPICAL,
+    Values(CV_8U, CV_32F),
+    Values(1, 3))
+)
+{
+    BTFSequenceTestParam params = GetParam();
+    Size sz           = get<0>(params);
+    int depth         = get<1>(params);
+    int srcCn         = get<2>(params);
+
+    Mat src(sz, CV_MAKE_TYPE(depth,srcCn));
+    Mat dst(sz, src.type());
+
+    declare.in(src, WARMUP_RNG).out(dst);
+
+    Ptr<BilateralTextureFilter> btf = createBilateralTextureFilter(2, 1, 0.5, 0.5);
+    btf->filter(src, dst);
+
+    TEST_CYCLE_N(3)
+    {
+        btf->filter(src, dst);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
 
 }} // namespace
@@ -0,0 +1,70 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static Mat makeShapeImage(Size sz)
+{
+    RNG rng(0);
+    Mat img(sz, CV_8UC1, Scalar::all(96));
+    for (int i = 0; i < 20; i++)
+    {
+        Point center(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Size axes(rng.uniform(10, sz.height / 6), rng.uniform(10, sz.height / 6));
+        ellipse(img, center, axes, rng.uniform(0, 180), 0, 360, Scalar::all(rng.uniform(0, 256)), rng.uniform(1, 4));
+        line(img, Point(rng.uniform(0, sz.width), rng.uniform(0, sz.height)),
+             Point(rng.uniform(0, sz.width), rng.uniform(0, sz.height)),
+             Scalar::all(rng.uniform(0, 256)), rng.uniform(1, 4));
+    }
+    GaussianBlur(img, img, Size(3, 3), 0.8);
+    return img;
+}
+
+typedef TestBaseWithParam<Size> EdgeDrawingTest;
+
+PERF_TEST_P(EdgeDrawingTest, detectEdges, Values(szVGA, sz720p, sz1080p))
+{
+    Mat src = makeShapeImage(GetParam());
+    Ptr<EdgeDrawing> ed = createEdgeDrawing();
+
+    TEST_CYCLE()
+    {
+        ed->detectEdges(src);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(EdgeDrawingTest, detectLines, Values(szVGA, sz720p, sz1080p))
+{
+    Mat src = makeShapeImage(GetParam());
+    Ptr<EdgeDrawing> ed = createEdgeDrawing();
+    ed->detectEdges(src);
+    std::vector<Vec4f> lines;
+
+    TEST_CYCLE()
+    {
+        ed->detectLines(lines);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(EdgeDrawingTest, detectEllipses, Values(szVGA, sz720p, sz1080p))
+{
+    Mat src = makeShapeImage(GetParam());
+    Ptr<EdgeDrawing> ed = createEdgeDrawing();
+    ed->detectEdges(src);
+    std::vector<Vec6d> ellipses;
+
+    TEST_CYCLE()
+    {
+        ed->detectEllipses(ellipses);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
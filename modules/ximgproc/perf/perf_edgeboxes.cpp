@@ -0,0 +1,57 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static void makeEdgeMaps(Size sz, Mat &edges, Mat &orientations)
+{
+    RNG rng(0);
+    Mat img(sz, CV_8UC1, Scalar::all(128));
+    for (int i = 0; i < 40; i++)
+    {
+        Point p1(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Point p2(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        rectangle(img, p1, p2, Scalar::all(rng.uniform(0, 256)), FILLED);
+        circle(img, p1, rng.uniform(5, sz.height / 4), Scalar::all(rng.uniform(0, 256)), FILLED);
+    }
+    GaussianBlur(img, img, Size(5, 5), 1.5);
+
+    Mat dx, dy;
+    Sobel(img, dx, CV_32F, 1, 0);
+    Sobel(img, dy, CV_32F, 0, 1);
+    magnitude(dx, dy, edges);
+    normalize(edges, edges, 0, 1, NORM_MINMAX);
+    phase(dx, dy, orientations);
+    orientations.forEach<float>([](float &o, const int *) { o = fmodf(o, (float)CV_PI); });
+}
+
+typedef tuple<Size, int> EdgeBoxesParams;
+typedef TestBaseWithParam<EdgeBoxesParams> EdgeBoxesTest;
+
+PERF_TEST_P(EdgeBoxesTest, getBoundingBoxes,
+    Combine(
+    Values(szVGA, sz720p),
+    Values(100, 1000, 10000))
+)
+{
+    Size sz = get<0>(GetParam());
+    int maxBoxes = get<1>(GetParam());
+
+    Mat edges, orientations;
+    makeEdgeMaps(sz, edges, orientations);
+
+    Ptr<EdgeBoxes> edgeboxes = createEdgeBoxes();
+    edgeboxes->setMaxBoxes(maxBoxes);
+    std::vector<Rect> boxes;
+
+    TEST_CYCLE()
+    {
+        edgeboxes->getBoundingBoxes(edges, orientations, boxes);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
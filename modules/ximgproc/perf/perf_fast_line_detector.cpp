@@ -0,0 +1,69 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static Mat makeLineImage(Size sz)
+{
+    RNG rng(0);
+    Mat img(sz, CV_8UC1, Scalar::all(128));
+    for (int i = 0; i < 40; i++)
+    {
+        Point p1(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Point p2(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        rectangle(img, p1, p2, Scalar::all(rng.uniform(0, 256)), FILLED);
+        line(img, p1, Point(rng.uniform(0, sz.width), rng.uniform(0, sz.height)),
+             Scalar::all(rng.uniform(0, 256)), rng.uniform(1, 4));
+    }
+    GaussianBlur(img, img, Size(3, 3), 0.8);
+    return img;
+}
+
+typedef TestBaseWithParam<Size> LineDetectorTest;
+
+PERF_TEST_P(LineDetectorTest, FastLineDetector, Values(szVGA, sz720p, sz1080p))
+{
+    Mat src = makeLineImage(GetParam());
+    Ptr<FastLineDetector> fld = createFastLineDetector();
+    std::vector<Vec4f> lines;
+
+    TEST_CYCLE()
+    {
+        fld->detect(src, lines);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(LineDetectorTest, LineSegmentDetector, Values(szVGA, sz720p, sz1080p))
+{
+    Mat src = makeLineImage(GetParam());
+    Ptr<LineSegmentDetector> lsd = createLineSegmentDetector();
+    std::vector<Vec4f> lines;
+
+    TEST_CYCLE()
+    {
+        lsd->detect(src, lines);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(LineDetectorTest, EdgeDrawing, Values(szVGA, sz720p, sz1080p))
+{
+    Mat src = makeLineImage(GetParam());
+    Ptr<EdgeDrawing> ed = createEdgeDrawing();
+    std::vector<Vec4f> lines;
+
+    TEST_CYCLE()
+    {
+        ed->detectEdges(src);
+        ed->detectLines(lines);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
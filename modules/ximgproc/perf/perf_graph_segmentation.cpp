@@ -0,0 +1,38 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::ximgproc::segmentation;
+
+typedef tuple<Size, int, int> GraphSegmentationParams;
+typedef TestBaseWithParam<GraphSegmentationParams> GraphSegmentationTest;
+
+PERF_TEST_P(GraphSegmentationTest, processImage,
+    Combine(
+    Values(szVGA, sz1080p),
+    Values(1, 3),
+    Values(0, 128))
+)
+{
+    Size sz = get<0>(GetParam());
+    int cn = get<1>(GetParam());
+    int tileSize = get<2>(GetParam());
+
+    Mat src(sz, CV_MAKE_TYPE(CV_8U, cn)), dst;
+    declare.in(src, WARMUP_RNG);
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation();
+    gs->setTileSize(tileSize);
+
+    TEST_CYCLE()
+    {
+        gs->processImage(src, dst);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -39,5 +39,35 @@ PERF_TEST_P(RollingGuidanceFilterTest, perf,
     SANITY_CHECK_NOTHING();
 }
 
+typedef tuple<Size, MatType, int> RGFSequenceTestParam;
+typedef TestBaseWithParam<RGFSequenceTestParam> RollingGuidanceFilterSequenceTest;
+
+PERF_TEST_P(RollingGuidanceFilterSequenceTest, reusedObject,
+    Combine(
+    SZ_TYPICAL,
+    Values(CV_8U, CV_32F),
+    Values(1, 3))
+)
+{
+    RGFSequenceTestParam params = GetParam();
+    Size sz         = get<0>(params);
+    int depth       = get<1>(params);
+    int srcCn       = get<2>(params);
+
+    Mat src(sz, CV_MAKE_TYPE(depth, srcCn));
+    Mat dst(sz, src.type());
+
+    declare.in(src, WARMUP_RNG).out(dst);
+
+    Ptr<RollingGuidanceFilter> rgf = createRollingGuidanceFilter(-1, 25.0, 3.0, 4);
+    rgf->filter(src, dst);
+
+    TEST_CYCLE_N(3)
+    {
+        rgf->filter(src, dst);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
 
 }} // namespace
@@ -0,0 +1,56 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<Size, int> SEEDSParams;
+typedef TestBaseWithParam<SEEDSParams> SEEDSTest;
+
+PERF_TEST_P(SEEDSTest, iterate,
+    Combine(
+    Values(szVGA, sz1080p),
+    Values(0, 2))
+)
+{
+    Size sz = get<0>(GetParam());
+    int prior = get<1>(GetParam());
+
+    Mat src(sz, CV_8UC3);
+    declare.in(src, WARMUP_RNG);
+
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(sz.width, sz.height, 3, 400, 4, prior);
+
+    TEST_CYCLE()
+    {
+        seeds->iterate(src, 4);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(SEEDSTest, iterateIncremental,
+    Combine(
+    Values(szVGA, sz1080p),
+    Values(0, 2))
+)
+{
+    Size sz = get<0>(GetParam());
+    int prior = get<1>(GetParam());
+
+    Mat src(sz, CV_8UC3), next(sz, CV_8UC3);
+    declare.in(src, next, WARMUP_RNG);
+
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(sz.width, sz.height, 3, 400, 4, prior);
+    seeds->iterate(src, 4);
+
+    TEST_CYCLE()
+    {
+        seeds->iterateIncremental(next, 2);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -0,0 +1,50 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::ximgproc::segmentation;
+
+typedef tuple<Size, bool> SelectiveSearchParams;
+typedef TestBaseWithParam<SelectiveSearchParams> SelectiveSearchTest;
+
+PERF_TEST_P(SelectiveSearchTest, process,
+    Combine(
+    Values(Size(250, 250), Size(500, 500)),
+    Values(false, true))
+)
+{
+    Size sz = get<0>(GetParam());
+    bool quality = get<1>(GetParam());
+
+    RNG rng(0);
+    Mat img(sz, CV_8UC3, Scalar::all(128));
+    for (int i = 0; i < 30; i++)
+    {
+        Point p1(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Point p2(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        rectangle(img, p1, p2, color, FILLED);
+        circle(img, p2, rng.uniform(5, sz.height / 4), color * 0.5, FILLED);
+    }
+
+    Ptr<SelectiveSearchSegmentation> ss = createSelectiveSearchSegmentation();
+    ss->setBaseImage(img);
+    if (quality)
+        ss->switchToSelectiveSearchQuality();
+    else
+        ss->switchToSelectiveSearchFast();
+
+    std::vector<Rect> rects;
+
+    TEST_CYCLE_N(1)
+    {
+        ss->process(rects);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -44,5 +44,34 @@ PERF_TEST_P(WeightedMedianFilterTest, perf,
     SANITY_CHECK_NOTHING();
 }
 
+typedef tuple<Size, int> WMFReuseTestParam;
+typedef TestBaseWithParam<WMFReuseTestParam> WeightedMedianFilterReuseTest;
+
+PERF_TEST_P(WeightedMedianFilterReuseTest, disparity,
+    Combine(
+    Values(szQVGA, szVGA),
+    Values(3, 7))
+)
+{
+    Size sz = get<0>(GetParam());
+    int r   = get<1>(GetParam());
+
+    Mat joint(sz, CV_8UC3);
+    Mat src(sz, CV_32FC1);
+    Mat dst(sz, src.type());
+
+    declare.in(joint, src, WARMUP_RNG).out(dst);
+
+    Ptr<WeightedMedianFilter> wmf = createWeightedMedianFilter(r);
+    wmf->filter(joint, src, dst); // allocate the workspace
+
+    TEST_CYCLE()
+    {
+        wmf->filter(joint, src, dst);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 
 }} // namespace
@@ -39,319 +39,349 @@
 
 #include "precomp.hpp"
 #include <opencv2/ximgproc.hpp>
+#include "opencv2/core/hal/hal.hpp"
 #include <vector>
 
 namespace cv
 {
 namespace ximgproc
 {
-  void compute_mRTV(const Mat& L, Mat& mRTV, int fr);
-  void compute_G(const Mat& B, const Mat& mRTV, Mat& G, Mat& alpha, int fr);
-  void joint_bilateral_filter(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg);
-  void joint_bilateral_filter3(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg);
-
-  void bilateralTextureFilter(InputArray src_, OutputArray dst_, int fr,
-                              int numIter, double sigmaAlpha, double sigmaAvg)
+  class BilateralTextureFilterImpl : public BilateralTextureFilter
   {
-    CV_Assert(!src_.empty());
+  public:
 
-    Mat src = src_.getMat();
-    CV_Assert(src.depth() == CV_8U || src.depth() == CV_32F);
+    BilateralTextureFilterImpl(int fr, int numIter, double sigmaAlpha, double sigmaAvg);
+
+    void filter(InputArray src, OutputArray dst) CV_OVERRIDE;
+
+    void collectGarbage() CV_OVERRIDE;
+
+  protected:
+
+    int fr, numIter;
+    double sigmaAlpha, sigmaAvg;
+
+    // buffers of the iterations, reused while the image size and type do not change
+    Mat I;                  // filtered image, updated in place by each iteration
+    Mat padI;               // I before the iteration, border extended by 2*fr
+    Mat B;                  // box filtered I
+    Mat grad, padGrad;      // gradient magnitude of I, border extended by fr
+    Mat mRTV;               // modified relative total variation of I
+    Mat Gtilde, padGtilde;  // guidance image, border extended by 2*fr
+
+    void computeGradient();
+    void computeMRTV();
+    void computeGuide();
+    void jointBilateralFilter(double sigma);
+
+    // rows of the blocks processed by computeGuide()
+    enum { GUIDE_BLOCK_ROWS = 32 };
+  };
 
+  BilateralTextureFilterImpl::BilateralTextureFilterImpl(int fr_, int numIter_, double sigmaAlpha_, double sigmaAvg_)
+    : fr(fr_), numIter(numIter_), sigmaAlpha(sigmaAlpha_), sigmaAvg(sigmaAvg_)
+  {
     CV_Assert(fr > 0 && numIter > 0);
 
     if (sigmaAlpha < 0)
       sigmaAlpha = 5. * fr;
-    if (sigmaAvg < 0)
-      sigmaAvg = 0.05 * sqrt(static_cast<float>(src.channels()));
+  }
 
-    Mat I;
-    src.copyTo(I);
-    if (src.type() == CV_8UC1) {
-      I.convertTo(I, CV_32FC1, 1.0 / 255.0);
-    }
-    else if (src.type() == CV_8UC3) {
-      I.convertTo(I, CV_32FC3, 1.0 / 255.0);
-    }
+  void BilateralTextureFilterImpl::filter(InputArray src_, OutputArray dst_)
+  {
+    CV_Assert(!src_.empty());
+
+    Mat src = src_.getMat();
+    CV_Assert(src.depth() == CV_8U || src.depth() == CV_32F);
+    CV_Assert(src.channels() == 1 || src.channels() == 3);
+
+    double sigma = sigmaAvg;
+    if (sigma < 0)
+      sigma = 0.05 * sqrt(static_cast<float>(src.channels()));
+
+    if (src.depth() == CV_8U)
+      src.convertTo(I, CV_MAKETYPE(CV_32F, src.channels()), 1.0 / 255.0);
+    else
+      src.copyTo(I);
 
+    const int fr2 = 2 * fr;
     for (int iter = 0; iter < numIter; iter++)
     {
-      Mat B;
+      copyMakeBorder(I, padI, fr2, fr2, fr2, fr2, BORDER_REFLECT);
       blur(I, B, Size(2 * fr + 1, 2 * fr + 1), Point(-1, -1), BORDER_REFLECT);
 
-      Mat mRTV;
-      compute_mRTV(I, mRTV, fr);
-
-      Mat G, minmRTV;
-      compute_G(B, mRTV, G, minmRTV, fr);
-
-      // alpha blending
-      Mat Gtilde;
-      Mat diff = mRTV - minmRTV;
-      Mat alpha = -diff.mul(sigmaAlpha);
-      exp(alpha, alpha);
-      alpha = alpha + 1.;
-      pow(alpha, -1, alpha);
-      alpha = (alpha - 0.5) * 2;
-      Mat alphainv = -(alpha - 1);
-
-      std::vector<Mat> Gi, Bi;
-      Gi.resize(I.channels());
-      Bi.resize(I.channels());
-      if (I.channels() == 3) {
-        split(G, &Gi[0]);
-        split(B, &Bi[0]);
-      }
-      else {
-        G.copyTo(Gi[0]);
-        B.copyTo(Bi[0]);
-      }
-
-      std::vector<Mat> Gtildei;
-      Gtildei.resize(I.channels());
-      for (int i = 0; i < B.channels(); i++)
-        Gtildei[i] = Gi[i].mul(alpha) + Bi[i].mul(alphainv);
-      merge(&Gtildei[0], B.channels(), Gtilde);
-
-      // joint bilateral filter
-      cv::Mat J;
-      if (I.channels() == 1)
-        joint_bilateral_filter(I, Gtilde, J, fr * 2, sigmaAvg);
-      else if (I.channels() == 3)
-        joint_bilateral_filter3(I, Gtilde, J, fr * 2, sigmaAvg);
-      I = J;
-    }
-    if (src.type() == CV_8UC1) {
-      I.convertTo(I, CV_8UC1, 255.0);
-    }
-    else if (src.type() == CV_8UC3) {
-      I.convertTo(I, CV_8UC3, 255.0);
+      computeGradient();
+      computeMRTV();
+      computeGuide();
+      jointBilateralFilter(sigma);
     }
 
-    I.copyTo(dst_);
+    if (src.depth() == CV_8U)
+      I.convertTo(dst_, src.type(), 255.0);
+    else
+      I.copyTo(dst_);
   }
 
-  void compute_mRTV(const Mat& L, Mat& mRTV, int fr)
+  void BilateralTextureFilterImpl::collectGarbage()
   {
-    mRTV = Mat::zeros(L.size(), CV_32FC1);
-
-    const float eps = 0.00001f;
+    I.release();
+    padI.release();
+    B.release();
+    grad.release();
+    padGrad.release();
+    mRTV.release();
+    Gtilde.release();
+    padGtilde.release();
+  }
 
-    // Calculate image derivative(gradient)
-    Mat G;
-    Mat Gx, Gy, kernelx, kernely;
-    kernelx = Mat::zeros(1, 3, CV_32F);
-    kernelx.at<float>(0, 1) = -1.0;
-    kernelx.at<float>(0, 2) = 1.0;
-    filter2D(L, Gx, -1, kernelx, Point(-1, -1), 0, BORDER_REFLECT);
-    kernely = Mat::zeros(3, 1, CV_32F);
-    kernely.at<float>(1, 0) = -1.0;
-    kernely.at<float>(2, 0) = 1.0;
-    filter2D(L, Gy, -1, kernely, Point(-1, -1), 0, BORDER_REFLECT);
-
-    Gx = Gx.mul(Gx);
-    Gy = Gy.mul(Gy);
-    sqrt(Gx + Gy, G);
-
-    // Pad image L and G
-    Mat padL;
-    Mat padG;
-    copyMakeBorder(L, padL, fr, fr, fr, fr, BORDER_REFLECT);
-    copyMakeBorder(G, padG, fr, fr, fr, fr, BORDER_REFLECT);
-
-    // Calculate maxL, minL, maxG, sumG
-    int pu = fr;
-    int pb = pu + L.rows;
-    int pl = fr;
-    int pr = pl + L.cols;
-
-    std::vector<Mat> Li, Gi;
-    Li.resize(L.channels());
-    Gi.resize(L.channels());
-    if (L.channels() == 3) {
-      split(padL, &Li[0]);
-      split(padG, &Gi[0]);
-    }
-    else {
-      padL.copyTo(Li[0]);
-      padG.copyTo(Gi[0]);
-    }
+  void BilateralTextureFilterImpl::computeGradient()
+  {
+    const int cn = I.channels();
+    const int fr2 = 2 * fr;
+    const int len = I.cols * cn;
 
-    for (int i = 0; i < L.channels(); i++)
+    grad.create(I.size(), I.type());
+    parallel_for_(Range(0, I.rows), [&](const Range& range)
     {
-      Mat maxL = Mat::zeros(L.size(), CV_32FC1);
-      Mat minL = Mat::ones(L.size(), CV_32FC1);
-      Mat maxG = Mat::zeros(L.size(), CV_32FC1);
-      Mat sumG = Mat::zeros(L.size(), CV_32FC1);
-      for (int y = -fr; y <= fr; y++)
+      for (int y = range.start; y < range.end; y++)
       {
-        for (int x = -fr; x <= fr; x++)
+        // forward differences, zero on the last row and column (reflected borders)
+        const float* L = padI.ptr<float>(y + fr2) + fr2 * cn;
+        const float* Ldown = padI.ptr<float>(y + fr2 + 1) + fr2 * cn;
+        float* G = grad.ptr<float>(y);
+        for (int i = 0; i < len; i++)
         {
-          Mat temp = Li[i](
-            Range(pu + y, pb + y),
-            Range(pl + x, pr + x)
-          );
-          maxL = max(maxL, temp);
-          minL = min(minL, temp);
-
-          temp = Gi[i](
-            Range(pu + y, pb + y),
-            Range(pl + x, pr + x)
-          );
-          maxG = max(maxG, temp);
-          sumG = sumG + temp;
+          float gx = L[i + cn] - L[i];
+          float gy = Ldown[i] - L[i];
+          G[i] = std::sqrt(gx * gx + gy * gy);
         }
       }
-      Mat deltai = maxL - minL;
-      sumG = max(sumG, eps);
-      Mat mRTVi = maxG / sumG * (2 * fr + 1);
-      mRTV = mRTV + mRTVi.mul(deltai);
-    }
-    if (L.channels() == 3)
-      mRTV = mRTV / 3;
+    });
+
+    copyMakeBorder(grad, padGrad, fr, fr, fr, fr, BORDER_REFLECT);
   }
 
-  void compute_G(const Mat& B, const Mat& mRTV, Mat& G, Mat& alpha, int fr)
+  void BilateralTextureFilterImpl::computeMRTV()
   {
-    B.copyTo(G);
-    alpha = Mat::ones(B.size(), CV_32FC1);
-    for (int y = -fr; y <= fr; y++)
+    const int cn = I.channels();
+    const int cols = I.cols;
+    const int ksize = 2 * fr + 1;
+    const int len = (cols + 2 * fr) * cn;
+    const float eps = 0.00001f;
+
+    mRTV.create(I.size(), CV_32FC1);
+    parallel_for_(Range(0, I.rows), [&](const Range& range)
     {
-      for (int x = -fr; x <= fr; x++)
+      AutoBuffer<float> buf(len * 4);
+      float *colMaxL = buf.data(), *colMinL = colMaxL + len;
+      float *colMaxG = colMinL + len, *colSumG = colMaxG + len;
+
+      for (int y = range.start; y < range.end; y++)
       {
-        Point pb;
-        Point pt;
-        for (pb.y = 0; pb.y < B.rows; pb.y++)
+        // max and min of L, max and sum of the gradient over the window rows,
+        // for all the columns of the images extended by fr
+        const float* L = padI.ptr<float>(y + fr) + fr * cn;
+        const float* G = padGrad.ptr<float>(y);
+        for (int i = 0; i < len; i++)
+        {
+          colMaxL[i] = colMinL[i] = L[i];
+          colMaxG[i] = colSumG[i] = G[i];
+        }
+        for (int dy = 1; dy < ksize; dy++)
+        {
+          L = padI.ptr<float>(y + fr + dy) + fr * cn;
+          G = padGrad.ptr<float>(y + dy);
+          for (int i = 0; i < len; i++)
+          {
+            colMaxL[i] = std::max(colMaxL[i], L[i]);
+            colMinL[i] = std::min(colMinL[i], L[i]);
+            colMaxG[i] = std::max(colMaxG[i], G[i]);
+            colSumG[i] += G[i];
+          }
+        }
+
+        float* dst = mRTV.ptr<float>(y);
+        for (int x = 0; x < cols; x++)
         {
-          for (pb.x = 0; pb.x < B.cols; pb.x++)
+          float value = 0.f;
+          for (int c = 0; c < cn; c++)
           {
-            pt.x = min(max(pb.x + x, 0), B.cols - 1);
-            pt.y = min(max(pb.y + y, 0), B.rows - 1);
-            if (alpha.at<float>(pb) > mRTV.at<float>(pt))
+            float maxL = 0.f, minL = 1.f, maxG = 0.f, sumG = 0.f;
+            for (int i = x * cn + c; i < (x + ksize) * cn; i += cn)
             {
-              alpha.at<float>(pb) = mRTV.at<float>(pt);
-              if (B.channels() == 3)
-                G.at<Vec3f>(pb) = B.at<Vec3f>(pt);
-              else if (B.channels() == 1)
-                G.at<float>(pb) = B.at<float>(pt);
+              maxL = std::max(maxL, colMaxL[i]);
+              minL = std::min(minL, colMinL[i]);
+              maxG = std::max(maxG, colMaxG[i]);
+              sumG += colSumG[i];
             }
+            value += maxG / std::max(sumG, eps) * ksize * (maxL - minL);
           }
+          dst[x] = cn == 3 ? value / 3 : value;
         }
       }
-    }
+    });
   }
 
-  void joint_bilateral_filter(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg)
+  void BilateralTextureFilterImpl::computeGuide()
   {
-    Mat p_G;
-    copyMakeBorder(G, p_G, fr2, fr2, fr2, fr2, BORDER_REFLECT);
-
-    Mat p_img;
-    copyMakeBorder(img, p_img, fr2, fr2, fr2, fr2, BORDER_REFLECT);
-
-    Mat SW;
-    if (SW.empty()) {
-      SW = Mat(2*fr2+1, 2*fr2+1, CV_32FC1);
-      int r, c;
-      float y, x;
-      for (r = 0, y = (float)-fr2; r < SW.rows; r++, y += 1.0) {
-        for(c = 0, x = (float)-fr2; c < SW.cols; c++, x += 1.0) {
-          SW.at<float>(r,c) = exp(-(x*x + y*y) / (2*fr2*fr2));
-        }
-      }
-    }
-
-    r_img = Mat::zeros(img.size(), CV_32FC1);
+    const int cn = I.channels();
+    const int rows = I.rows, cols = I.cols;
+    const int nblocks = (rows + GUIDE_BLOCK_ROWS - 1) / GUIDE_BLOCK_ROWS;
+    const float scale = (float)-sigmaAlpha;
+
+    Gtilde.create(I.size(), I.type());
+    CV_Assert(B.isContinuous());
+    parallel_for_(Range(0, nblocks), [&](const Range& range)
     {
-      Mat sum_d_W = Mat::zeros(img.size(), CV_32FC1);
-      Mat d_W = Mat::zeros(G.size(), CV_32FC1);
+      const int bufRows = GUIDE_BLOCK_ROWS + 2 * fr;
+      AutoBuffer<float> minBuf(bufRows * cols + cols);
+      AutoBuffer<int> argBuf(bufRows * cols + cols);
+      float* rowMin = minBuf.data();
+      int* rowArg = argBuf.data();
+      float* t = rowMin + bufRows * cols;
+      int* srcOfs = rowArg + bufRows * cols;
+
+      for (int block = range.start; block < range.end; block++)
+      {
+        const int y0 = block * GUIDE_BLOCK_ROWS;
+        const int y1 = std::min(y0 + GUIDE_BLOCK_ROWS, rows);
 
-      for (int x = -fr2; x <= fr2; x++) {
-        for (int y = -fr2; y <= fr2; y++) {
-          d_W = p_G(Rect(fr2+x, fr2+y, img.cols, img.rows)) - G;
-          multiply(d_W, d_W, d_W);
-          exp(-0.5 * d_W / (sigma_avg*sigma_avg), d_W);
+        // first minimum of mRTV over the window of each row, with replicated borders
+        for (int r = y0 - fr; r < y1 + fr; r++)
+        {
+          const float* m = mRTV.ptr<float>(std::min(std::max(r, 0), rows - 1));
+          float* minRow = rowMin + (r - y0 + fr) * cols;
+          int* argRow = rowArg + (r - y0 + fr) * cols;
+          for (int x = 0; x < cols; x++)
+          {
+            int best = std::max(x - fr, 0);
+            for (int xx = best + 1; xx <= std::min(x + fr, cols - 1); xx++)
+              if (m[xx] < m[best])
+                best = xx;
+            minRow[x] = m[best];
+            argRow[x] = best;
+          }
+        }
 
-          d_W = d_W * SW.at<float>(fr2+y, fr2+x); //Gaussian weight
+        for (int y = y0; y < y1; y++)
+        {
+          // first minimum below 1 over the rows of the window: the same pixel as
+          // a row by row scan of the whole window
+          const float* m = mRTV.ptr<float>(y);
+          for (int x = 0; x < cols; x++)
+          {
+            float alpha = 1.f;
+            int ofs = y * cols + x;
+            for (int dy = -fr; dy <= fr; dy++)
+            {
+              int i = (y + dy - y0 + fr) * cols + x;
+              if (rowMin[i] < alpha)
+              {
+                alpha = rowMin[i];
+                ofs = std::min(std::max(y + dy, 0), rows - 1) * cols + rowArg[i];
+              }
+            }
+            srcOfs[x] = ofs;
+            t[x] = (m[x] - alpha) * scale;
+          }
+          hal::exp32f(t, t, cols);
 
-          sum_d_W = sum_d_W + d_W;
-          multiply(d_W, p_img(Rect(fr2+x, fr2+y, img.cols, img.rows)), d_W);
-          r_img = r_img + d_W;
+          // alpha blending of the lowest mRTV patch and the box filtered image
+          const float* Bc = B.ptr<float>(y);
+          const float* B0 = B.ptr<float>(0);
+          float* dst = Gtilde.ptr<float>(y);
+          for (int x = 0; x < cols; x++)
+          {
+            float a = 1.f / (t[x] + 1.f) * 2.f - 1.f;
+            const float* G = B0 + (size_t)srcOfs[x] * cn;
+            for (int c = 0; c < cn; c++)
+              dst[x * cn + c] = G[c] * a + Bc[x * cn + c] * (1.f - a);
+          }
         }
       }
-      max(1e-5f, sum_d_W, sum_d_W);
-      divide(r_img, sum_d_W, r_img);
-    }
+    });
   }
 
-  void joint_bilateral_filter3(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg)
+  void BilateralTextureFilterImpl::jointBilateralFilter(double sigma)
   {
-    Mat p_G;
-    copyMakeBorder(G, p_G, fr2, fr2, fr2, fr2, BORDER_REFLECT);
-
-    Mat p_img;
-    copyMakeBorder(img, p_img, fr2, fr2, fr2, fr2, BORDER_REFLECT);
-
-    Mat SW;
-    if (SW.empty()) {
-      SW = Mat(2*fr2+1, 2*fr2+1, CV_32FC1);
-      int r, c;
-      float y, x;
-      for (r = 0, y = (float)-fr2; r < SW.rows; r++, y += 1.0) {
-        for(c = 0, x = (float)-fr2; c < SW.cols; c++, x += 1.0) {
-          SW.at<float>(r,c) = exp(-(x*x + y*y) / (2*fr2*fr2));
-        }
+    const int cn = I.channels();
+    const int cols = I.cols;
+    const int fr2 = 2 * fr;
+    const int ksize = 2 * fr2 + 1;
+    const float scale = (float)(-0.5 / (sigma * sigma));
+
+    AutoBuffer<float> SW(ksize * ksize);
+    for (int r = 0; r < ksize; r++)
+    {
+      for (int c = 0; c < ksize; c++)
+      {
+        float y = (float)(r - fr2), x = (float)(c - fr2);
+        SW[r * ksize + c] = std::exp(-(x*x + y*y) / (2*fr2*fr2));
       }
     }
 
-    std::vector<Mat> G_channels(3);
-    split(G, G_channels);
-    std::vector<Mat> p_G_channels(3);
-    split(p_G, p_G_channels);
-    std::vector<Mat> p_img_channels(3);
-    split(p_img, p_img_channels);
-
-    Mat sum_d_W = Mat::zeros(img.size(), CV_32FC1);
-    std::vector<Mat> d_W_channels(3);
-    for (int ch = 0; ch < 3; ch++) {
-      d_W_channels[ch] = Mat::zeros(G.size(), CV_32FC1);
-    }
-    Mat d_W = Mat::zeros(G.size(), CV_32FC1);
+    copyMakeBorder(Gtilde, padGtilde, fr2, fr2, fr2, fr2, BORDER_REFLECT);
 
-    std::vector<Mat> r_img_channels(3);
-    for (int ch = 0; ch < 3; ch++) {
-      r_img_channels[ch] = Mat::zeros(G.size(), CV_32FC1);
-    }
+    parallel_for_(Range(0, I.rows), [&](const Range& range)
+    {
+      AutoBuffer<float> buf(cols * (2 + cn));
+      float *W = buf.data(), *sumW = W + cols, *sum = sumW + cols;
 
-    for (int x = -fr2; x <= fr2; x++) {
-      for (int y = -fr2; y <= fr2; y++) {
-        d_W.setTo(0);
-        for (int ch = 0; ch < 3; ch++) {
-          subtract(p_G_channels[ch](Rect(fr2+x, fr2+y, img.cols, img.rows)), G_channels[ch], d_W_channels[ch]);
-          multiply(d_W_channels[ch], d_W_channels[ch], d_W_channels[ch]);
-        }
-        for (int ch = 0; ch < 3; ch++) {
-          add(d_W, d_W_channels[ch], d_W);
-        }
-        exp(-0.5 * d_W / (sigma_avg*sigma_avg), d_W);
+      for (int y = range.start; y < range.end; y++)
+      {
+        std::fill(sumW, sumW + cols * (1 + cn), 0.f);
+        const float* G = padGtilde.ptr<float>(y + fr2) + fr2 * cn;
 
-        d_W = d_W * SW.at<float>(fr2+y, fr2+x); //Gaussian weight
+        for (int dx = -fr2; dx <= fr2; dx++)
+        {
+          for (int dy = -fr2; dy <= fr2; dy++)
+          {
+            const float* Gn = padGtilde.ptr<float>(y + fr2 + dy) + (fr2 + dx) * cn;
+            const float* In = padI.ptr<float>(y + fr2 + dy) + (fr2 + dx) * cn;
+            const float sw = SW[(fr2 + dy) * ksize + fr2 + dx];
 
-        add(sum_d_W, d_W, sum_d_W);
+            for (int x = 0; x < cols; x++)
+            {
+              float d = 0.f;
+              for (int c = 0; c < cn; c++)
+              {
+                float diff = Gn[x * cn + c] - G[x * cn + c];
+                d += diff * diff;
+              }
+              W[x] = d * scale;
+            }
+            hal::exp32f(W, W, cols);
+
+            for (int x = 0; x < cols; x++)
+            {
+              float w = W[x] * sw; //Gaussian weight
+              sumW[x] += w;
+              for (int c = 0; c < cn; c++)
+                sum[x * cn + c] += w * In[x * cn + c];
+            }
+          }
+        }
 
-        for (int ch = 0; ch < 3; ch++) {
-          Mat n_p_img = p_img_channels[ch](Rect(fr2+x, fr2+y, img.cols, img.rows));
-          accumulateProduct(d_W, n_p_img, r_img_channels[ch]);
+        float* dst = I.ptr<float>(y);
+        for (int x = 0; x < cols; x++)
+        {
+          float s = std::max(sumW[x], 1e-5f);
+          for (int c = 0; c < cn; c++)
+            dst[x * cn + c] = sum[x * cn + c] / s;
         }
       }
-    }
+    });
+  }
 
-    max(1e-5f, sum_d_W, sum_d_W);
-    for (int ch = 0; ch < 3; ch++) {
-      divide(r_img_channels[ch], sum_d_W, r_img_channels[ch]);
-    }
-    merge(r_img_channels, r_img);
+  Ptr<BilateralTextureFilter> createBilateralTextureFilter(int fr, int numIter, double sigmaAlpha, double sigmaAvg)
+  {
+    return makePtr<BilateralTextureFilterImpl>(fr, numIter, sigmaAlpha, sigmaAvg);
   }
 
+  void bilateralTextureFilter(InputArray src, OutputArray dst, int fr,
+                              int numIter, double sigmaAlpha, double sigmaAvg)
+  {
+    createBilateralTextureFilter(fr, numIter, sigmaAlpha, sigmaAvg)->filter(src, dst);
+  }
 }
 }
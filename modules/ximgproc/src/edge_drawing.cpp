@@ -22,8 +22,6 @@ mutable Mat_<uchar> dirImage;
 int gradThresh;
 int op;
 bool SumFlag;
-int* grads;
-bool PFmode;
 };
 
 void ComputeGradientBody::operator() (const Range& range) const
@@ -78,9 +76,6 @@ void ComputeGradientBody::operator() (const Range& range) const
 
             gradRow[x] = (ushort)sum;
 
-            if (PFmode)
-                grads[sum]++;
-
             if (sum >= gradThresh)
             {
                 if (gx >= gy)
@@ -92,6 +87,27 @@ void ComputeGradientBody::operator() (const Range& range) const
     }
 }
 
+// Returns the data of a work buffer that holds at least size elements.
+// The buffer only grows, its contents are not preserved
+template<typename T> static T* growBuffer(vector<T>& buf, int size)
+{
+    if ((int)buf.size() < size)
+        buf.resize(size);
+    return buf.empty() ? NULL : &buf[0];
+}
+
+// Result of fitting a circle/ellipse to an almost closed segment in detectEllipses
+struct SegmentShapeFit
+{
+    enum { NONE = 0, CIRCLE = 1, ELLIPSE = 2, REJECTED = 3 };
+
+    int type;
+    double xc, yc, r;
+    double circleFitError;
+    EllipseEquation eq;
+    double ellipseFitError;
+};
+
 class EdgeDrawingImpl : public EdgeDrawing
 {
 public:
@@ -135,7 +151,7 @@ private:
     void ComputeGradient();
     void ComputeAnchorPoints();
     void JoinAnchorPointsUsingSortedAnchors();
-    int* sortAnchorsByGradValue1();
+    const int* sortAnchorsByGradValue1();
 
     static int LongestChain(Chain *chains, int root);
     static int RetrieveChainNos(Chain *chains, int root, int chainNos[]);
@@ -164,11 +180,13 @@ private:
     NFALUT* nfa;
 
     int ComputeMinLineLength();
-    void SplitSegment2Lines(double* x, double* y, int noPixels, int segmentNo);
+    void SplitSegment2Lines(double* x, double* y, int noPixels, int segmentNo, std::vector<EDLineSegment>& segmentLines) const;
+    void SplitSegmentsToLines();
     void JoinCollinearLines();
 
+    void UpdateNFALUT();
     void ValidateLineSegments();
-    bool ValidateLineSegmentRect(int* x, int* y, EDLineSegment* ls);
+    bool ValidateLineSegmentRect(int* x, int* y, EDLineSegment* ls) const;
     bool TryToJoinTwoLineSegments(EDLineSegment* ls1, EDLineSegment* ls2, int changeIndex);
 
     static double ComputeMinDistance(double x1, double y1, double a, double b, int invert);
@@ -195,18 +213,37 @@ private:
     int noCircles2;
     int noCircles3;
 
-    EDArcs* edarcs1;
-    EDArcs* edarcs2;
-    EDArcs* edarcs3;
-    EDArcs* edarcs4;
+    EDArcs edarcs1;
+    EDArcs edarcs2;
+    EDArcs edarcs3;
+    EDArcs edarcs4;
 
     int* segmentStartLines;
-    BufferManager* bm;
+    BufferManager bm;
     Info* info;
 
+    // Work buffers reused between calls, they only grow when a larger image or
+    // a longer list of segments, lines or circles is processed
+    std::vector<int> chainNoBuf;
+    std::vector<Point> pixelBuf;
+    std::vector<StackNode> stackBuf;
+    std::vector<Chain> chainBuf;
+    std::vector<int> gradCountBuf;
+    std::vector<int> sortedAnchorBuf;
+    std::vector<std::vector<Point> > stripeAnchors;
+    std::vector<std::vector<EDLineSegment> > blockLines;
+    std::vector<uchar> validFlags;
+    std::vector<Circle> circleBuf1, circleBuf2, circleBuf3;
+    std::vector<int> segmentStartLineBuf;
+    std::vector<Info> infoBuf;
+    std::vector<SegmentShapeFit> shapeFitBuf;
+    Mat smoothBuf;
+
+    void FitSegmentsForEllipses();
     void GenerateCandidateCircles();
     void DetectArcs();
     void ValidateCircles(bool validate);
+    bool ValidateCircle(Circle* circle, bool validate, double* px, double* py, int bufferSize) const;
     void JoinCircles();
     void JoinArcs1();
     void JoinArcs2();
@@ -368,16 +405,22 @@ void EdgeDrawingImpl::detectEdges(InputArray src)
     height = srcImage.rows;
     width = srcImage.cols;
 
-    edgeImage = Mat(height, width, CV_8UC1, Scalar(0)); // initialize edge Image
-    gradImage = Mat(height, width, CV_16UC1); // gradImage contains short values
-    dirImage = Mat(height, width, CV_8UC1);
+    // the images are only reallocated when the size of the source changes
+    edgeImage.create(height, width, CV_8UC1);
+    edgeImage.setTo(Scalar(0)); // initialize edge Image
+    gradImage.create(height, width, CV_16UC1); // gradImage contains short values
+    dirImage.create(height, width, CV_8UC1);
 
     if (params.Sigma < 1.0)
         smoothImage = srcImage;
-    else if (params.Sigma == 1.0)
-        GaussianBlur(srcImage, smoothImage, Size(5, 5), params.Sigma);
     else
-        GaussianBlur(srcImage, smoothImage, Size(), params.Sigma); // calculate kernel from sigma
+    {
+        if (params.Sigma == 1.0)
+            GaussianBlur(srcImage, smoothBuf, Size(5, 5), params.Sigma);
+        else
+            GaussianBlur(srcImage, smoothBuf, Size(), params.Sigma); // calculate kernel from sigma
+        smoothImage = smoothBuf;
+    }
 
     // Assign Pointers from Mat's data
     smoothImg = smoothImage.data;
@@ -459,67 +502,107 @@ void EdgeDrawingImpl::ComputeGradient()
     body.gradThresh = gradThresh;
     body.SumFlag = params.SumFlag;
     body.op = op;
-    body.grads = grads;
-    body.PFmode = params.PFmode;
 
     parallel_for_(Range(1, smoothImage.rows - 1), body);
-}
 
-void EdgeDrawingImpl::ComputeAnchorPoints()
-{
-    for (int i = 2; i < height - 2; i++)
+    // The gradient histogram is accumulated after the parallel pass, counting
+    // it from the workers would race on the shared bins
+    if (params.PFmode)
     {
-        int start = 2;
-        int inc = 1;
-        if (i % params.ScanInterval != 0)
+        for (int i = 1; i < height - 1; i++)
         {
-            start = params.ScanInterval;
-            inc = params.ScanInterval;
+            const ushort* gradRow = gradImg + i * width;
+            for (int j = 1; j < width - 1; j++)
+                grads[gradRow[j]]++;
         }
+    }
+}
 
-        for (int j = start; j < width - 2; j += inc)
+void EdgeDrawingImpl::ComputeAnchorPoints()
+{
+    // Rows are scanned in fixed stripes, the anchors of every stripe are kept in
+    // scan order and concatenated afterwards, so the anchor list does not depend
+    // on the number of threads
+    const int STRIPE_ROWS = 16;
+    int firstRow = 2, lastRow = height - 2;
+    int noStripes = lastRow > firstRow ? (lastRow - firstRow + STRIPE_ROWS - 1) / STRIPE_ROWS : 0;
+    if ((int)stripeAnchors.size() < noStripes)
+        stripeAnchors.resize(noStripes);
+
+    parallel_for_(Range(0, noStripes), [&](const Range& range)
+    {
+        for (int s = range.start; s < range.end; s++)
         {
-            if (gradImg[i * width + j] < gradThresh)
-                continue;
+            vector<Point>& stripe = stripeAnchors[s];
+            stripe.clear();
 
-            if (dirImg[i * width + j] == EDGE_VERTICAL)
+            int rowEnd = std::min(firstRow + (s + 1) * STRIPE_ROWS, lastRow);
+            for (int i = firstRow + s * STRIPE_ROWS; i < rowEnd; i++)
             {
-                // vertical edge
-                int diff1 = gradImg[i * width + j] - gradImg[i * width + j - 1];
-                int diff2 = gradImg[i * width + j] - gradImg[i * width + j + 1];
-                if (diff1 >= anchorThresh && diff2 >= anchorThresh)
+                int start = 2;
+                int inc = 1;
+                if (i % params.ScanInterval != 0)
                 {
-                    edgeImg[i * width + j] = ANCHOR_PIXEL;
-                    anchorPoints.push_back(Point(j, i));
+                    start = params.ScanInterval;
+                    inc = params.ScanInterval;
                 }
-            }
-            else
-            {
-                // horizontal edge
-                int diff1 = gradImg[i * width + j] - gradImg[(i - 1) * width + j];
-                int diff2 = gradImg[i * width + j] - gradImg[(i + 1) * width + j];
-                if (diff1 >= anchorThresh && diff2 >= anchorThresh)
+
+                const ushort* gradRow = gradImg + i * width;
+                const uchar* dirRow = dirImg + i * width;
+                uchar* edgeRow = edgeImg + i * width;
+
+                for (int j = start; j < width - 2; j += inc)
                 {
-                    edgeImg[i * width + j] = ANCHOR_PIXEL;
-                    anchorPoints.push_back(Point(j, i));
+                    if (gradRow[j] < gradThresh)
+                        continue;
+
+                    int diff1, diff2;
+                    if (dirRow[j] == EDGE_VERTICAL)
+                    {
+                        // vertical edge
+                        diff1 = gradRow[j] - gradRow[j - 1];
+                        diff2 = gradRow[j] - gradRow[j + 1];
+                    }
+                    else
+                    {
+                        // horizontal edge
+                        diff1 = gradRow[j] - gradRow[j - width];
+                        diff2 = gradRow[j] - gradRow[j + width];
+                    }
+
+                    if (diff1 >= anchorThresh && diff2 >= anchorThresh)
+                    {
+                        edgeRow[j] = ANCHOR_PIXEL;
+                        stripe.push_back(Point(j, i));
+                    }
                 }
             }
         }
-    }
+    });
+
+    for (int s = 0; s < noStripes; s++)
+        anchorPoints.insert(anchorPoints.end(), stripeAnchors[s].begin(), stripeAnchors[s].end());
 
     anchorNos = (int)anchorPoints.size(); // get the total number of anchor points
 }
 
 void EdgeDrawingImpl::JoinAnchorPointsUsingSortedAnchors()
 {
-    int* chainNos = new int[(width + height) * 8];
+    if ((int)pixelBuf.size() != width * height || (int)chainNoBuf.size() != (width + height) * 8)
+    {
+        chainNoBuf.resize((width + height) * 8);
+        pixelBuf.resize(width * height);
+        stackBuf.resize(width * height);
+        chainBuf.resize(width * height);
+    }
 
-    Point* pixels = new Point[width * height];
-    StackNode* stack = new StackNode[width * height];
-    Chain* chains = new Chain[width * height];
+    int* chainNos = &chainNoBuf[0];
+    Point* pixels = &pixelBuf[0];
+    StackNode* stack = &stackBuf[0];
+    Chain* chains = &chainBuf[0];
 
     // sort the anchor points by their gradient value in decreasing order
-    int* pAnchors = sortAnchorsByGradValue1();
+    const int* pAnchors = sortAnchorsByGradValue1();
 
     // Now join the anchors starting with the anchor having the greatest gradient value
 
@@ -1164,55 +1247,36 @@ StartOfWhile:
     // pop back last segment from vector
     // because of one preallocation in the beginning, it will always empty
     segmentPoints.pop_back();
-
-    // Clean up
-    delete[] pAnchors;
-    delete[] chains;
-    delete[] stack;
-    delete[] chainNos;
-    delete[] pixels;
 }
 
-int* EdgeDrawingImpl::sortAnchorsByGradValue1()
+const int* EdgeDrawingImpl::sortAnchorsByGradValue1()
 {
     int SIZE = 128 * 256;
-    int* C = new int[SIZE];
-    memset(C, 0, sizeof(int) * SIZE);
+    gradCountBuf.assign(SIZE, 0);
+    int* C = &gradCountBuf[0];
 
-    // Count the number of grad values
-    for (int i = 1; i < height - 1; i++)
+    // Count the number of grad values. The anchors are listed in the same
+    // row-major order as they appear in the edge image
+    for (int k = 0; k < anchorNos; k++)
     {
-        for (int j = 1; j < width - 1; j++)
-        {
-            if (edgeImg[i * width + j] != ANCHOR_PIXEL)
-                continue;
-
-            int grad = gradImg[i * width + j];
-            C[grad]++;
-        }
+        int grad = gradImg[anchorPoints[k].y * width + anchorPoints[k].x];
+        C[grad]++;
     }
 
     // Compute indices
     for (int i = 1; i < SIZE; i++)
         C[i] += C[i - 1];
 
-    int noAnchors = C[SIZE - 1];
-    int* A = new int[noAnchors];
+    sortedAnchorBuf.resize(std::max(anchorNos, 1));
+    int* A = &sortedAnchorBuf[0];
 
-    for (int i = 1; i < height - 1; i++)
+    for (int k = 0; k < anchorNos; k++)
     {
-        for (int j = 1; j < width - 1; j++)
-        {
-            if (edgeImg[i * width + j] != ANCHOR_PIXEL)
-                continue;
-
-            int grad = gradImg[i * width + j];
-            int index = --C[grad];
-            A[index] = i * width + j;    // anchor's offset
-        }
+        int offset = anchorPoints[k].y * width + anchorPoints[k].x;
+        int index = --C[gradImg[offset]];
+        A[index] = offset;    // anchor's offset
     }
 
-    delete[] C;
     return A;
 }
 
@@ -1283,23 +1347,8 @@ void EdgeDrawingImpl::detectLines(OutputArray _lines)
     if (min_line_len < 9) // avoids small line segments in the result. Might be deleted!
         min_line_len = 9;
 
-    // Temporary buffers used during line fitting
-    double* x = new double[(width + height) * 8];
-    double* y = new double[(width + height) * 8];
-
-    linesNo = 0;
-
     // Use the whole segment
-    for (size_t segmentNumber = 0; segmentNumber < segmentPoints.size(); segmentNumber++)
-    {
-        std::vector<Point> segment = segmentPoints[segmentNumber];
-        for (int k = 0; k < (int)segment.size(); k++)
-        {
-            x[k] = segment[k].x;
-            y[k] = segment[k].y;
-        }
-        SplitSegment2Lines(x, y, (int)segment.size(), (int)segmentNumber);
-    }
+    SplitSegmentsToLines();
 
     JoinCollinearLines();
 
@@ -1318,8 +1367,57 @@ void EdgeDrawingImpl::detectLines(OutputArray _lines)
         linePoints.push_back(line);
     }
     Mat(linePoints).copyTo(_lines);
-    delete[] x;
-    delete[] y;
+}
+
+// Splits all segments to lines. The segments are independent of each other, so they
+// are processed in parallel over fixed blocks and the lines of the blocks are then
+// appended in segment order, exactly as a serial pass over the segments would do
+void EdgeDrawingImpl::SplitSegmentsToLines()
+{
+    const int BLOCK_SEGMENTS = 64;
+    int noSegments = (int)segmentPoints.size();
+    int noBlocks = (noSegments + BLOCK_SEGMENTS - 1) / BLOCK_SEGMENTS;
+    if ((int)blockLines.size() < noBlocks)
+        blockLines.resize(noBlocks);
+
+    parallel_for_(Range(0, noBlocks), [&](const Range& range)
+    {
+        // Temporary buffers used during line fitting
+        vector<double> x, y;
+
+        for (int b = range.start; b < range.end; b++)
+        {
+            vector<EDLineSegment>& segmentLines = blockLines[b];
+            segmentLines.clear();
+
+            int blockEnd = std::min((b + 1) * BLOCK_SEGMENTS, noSegments);
+            for (int segmentNumber = b * BLOCK_SEGMENTS; segmentNumber < blockEnd; segmentNumber++)
+            {
+                const vector<Point>& segment = segmentPoints[segmentNumber];
+                int noPixels = (int)segment.size();
+                if (noPixels < min_line_len)
+                    continue;
+
+                if ((int)x.size() < noPixels)
+                {
+                    x.resize(noPixels);
+                    y.resize(noPixels);
+                }
+
+                for (int k = 0; k < noPixels; k++)
+                {
+                    x[k] = segment[k].x;
+                    y[k] = segment[k].y;
+                }
+                SplitSegment2Lines(&x[0], &y[0], noPixels, segmentNumber, segmentLines);
+            }
+        }
+    });
+
+    lines.clear();
+    for (int b = 0; b < noBlocks; b++)
+        lines.insert(lines.end(), blockLines[b].begin(), blockLines[b].end());
+    linesNo = (int)lines.size();
 }
 
 // Computes the minimum line length using the NFA formula given width & height values
@@ -1339,7 +1437,7 @@ int EdgeDrawingImpl::ComputeMinLineLength()
 // Given a full segment of pixels, splits the chain to lines
 // This code is used when we use the whole segment of pixels
 //
-void EdgeDrawingImpl::SplitSegment2Lines(double* x, double* y, int noPixels, int segmentNo)
+void EdgeDrawingImpl::SplitSegment2Lines(double* x, double* y, int noPixels, int segmentNo, std::vector<EDLineSegment>& segmentLines) const
 {
     // First pixel of the line segment within the segment of points
     int firstPixelIndex = 0;
@@ -1426,8 +1524,7 @@ void EdgeDrawingImpl::SplitSegment2Lines(double* x, double* y, int noPixels, int
                     break;
 
                 // Add the line segment to lines
-                lines.push_back(EDLineSegment(lastA, lastB, lastInvert, sx, sy, ex, ey, segmentNo, firstPixelIndex + noSkippedPixels, index - noSkippedPixels + 1));
-                linesNo++;
+                segmentLines.push_back(EDLineSegment(lastA, lastB, lastInvert, sx, sy, ex, ey, segmentNo, firstPixelIndex + noSkippedPixels, index - noSkippedPixels + 1));
                 len = index + 1;
 
                 break;
@@ -1489,110 +1586,129 @@ void EdgeDrawingImpl::JoinCollinearLines()
     linesNo = lastLineIndex + 1;
 }
 
-void EdgeDrawingImpl::ValidateLineSegments()
+void EdgeDrawingImpl::UpdateNFALUT()
 {
-#define PRECISION_ANGLE 22.5
-    precision = (PRECISION_ANGLE / 180) * CV_PI;
-#undef PRECISION_ANGLE
-
-    if (nfa->LUTSize == 1)
+    // The table and the NFA itself only depend on the image size, so they are rebuilt when the
+    // size changes. Sizes with the same (width + height) / 8 share a table length but not the NFA.
+    int lutSize = std::max((width + height) / 8, 1);
+    if (nfa->LUTSize != std::min(lutSize, 60) || nfa->w != width || nfa->h != height)
     {
-        int lutSize = (width + height) / 8;
         double prob = 1.0 / 8;  // probability of alignment
+        delete nfa;
         nfa = new NFALUT(lutSize, prob, width, height);
     }
+}
 
-    int* x = new int[(width + height) * 4];
-    int* y = new int[(width + height) * 4];
+void EdgeDrawingImpl::ValidateLineSegments()
+{
+#define PRECISION_ANGLE 22.5
+    precision = (PRECISION_ANGLE / 180) * CV_PI;
+#undef PRECISION_ANGLE
 
-    int noValidLines = 0;
+    UpdateNFALUT();
 
-    for (int i = 0; i < linesNo; i++)
-    {
-        EDLineSegment* ls = &lines[i];
+    // Every line is validated independently, the surviving lines are compacted in order afterwards
+    validFlags.resize(linesNo);
 
-        // Compute Line's angle
-        double lineAngle;
+    parallel_for_(Range(0, linesNo), [&](const Range& range)
+    {
+        AutoBuffer<int> xBuf((width + height) * 4), yBuf((width + height) * 4);
+        int* x = xBuf.data();
+        int* y = yBuf.data();
 
-        if (ls->invert == 0)
-        {
-            // y = a + bx
-            lineAngle = atan(ls->b);
-        }
-        else
+        for (int i = range.start; i < range.end; i++)
         {
-            // x = a + by
-            lineAngle = atan(1.0 / ls->b);
-        }
+            EDLineSegment* ls = &lines[i];
 
-        if (lineAngle < 0)
-            lineAngle += CV_PI;
+            // Compute Line's angle
+            double lineAngle;
 
-        Point* pixels = &(segmentPoints[ls->segmentNo][0]);
-        int noPixels = ls->len;
+            if (ls->invert == 0)
+            {
+                // y = a + bx
+                lineAngle = atan(ls->b);
+            }
+            else
+            {
+                // x = a + by
+                lineAngle = atan(1.0 / ls->b);
+            }
 
-        bool valid = false;
+            if (lineAngle < 0)
+                lineAngle += CV_PI;
 
-        // Accept very long lines without testing. They are almost never invalidated.
-        if (ls->len >= 80)
-        {
-            valid = true;
-            // Validate short line segments by a line support region rectangle having width=2
-        }
-        else if (ls->len <= 25)
-        {
-            valid = ValidateLineSegmentRect(x, y, ls);
-        }
-        else
-        {
-            // Longer line segments are first validated by a line support region rectangle having width=1 (for speed)
-            // If the line segment is still invalid, then a line support region rectangle having width=2 is tried
-            // If the line segment fails both tests, it is discarded
-            int aligned = 0;
-            int count = 0;
-            for (int j = 0; j < noPixels; j++)
+            Point* pixels = &(segmentPoints[ls->segmentNo][0]);
+            int noPixels = ls->len;
+
+            bool valid = false;
+
+            // Accept very long lines without testing. They are almost never invalidated.
+            if (ls->len >= 80)
+            {
+                valid = true;
+                // Validate short line segments by a line support region rectangle having width=2
+            }
+            else if (ls->len <= 25)
+            {
+                valid = ValidateLineSegmentRect(x, y, ls);
+            }
+            else
             {
-                int r = pixels[j].x;
-                int c = pixels[j].y;
+                // Longer line segments are first validated by a line support region rectangle having width=1 (for speed)
+                // If the line segment is still invalid, then a line support region rectangle having width=2 is tried
+                // If the line segment fails both tests, it is discarded
+                int aligned = 0;
+                int count = 0;
+                for (int j = 0; j < noPixels; j++)
+                {
+                    int r = pixels[j].x;
+                    int c = pixels[j].y;
 
-                if (r <= 0 || r >= height - 1 || c <= 0 || c >= width - 1)
-                    continue;
+                    if (r <= 0 || r >= height - 1 || c <= 0 || c >= width - 1)
+                        continue;
 
-                count++;
+                    count++;
 
-                // compute gx & gy using the simple [-1 -1 -1]
-                //                                  [ 1  1  1]  filter in both directions
-                // Faster method below
-                // A B C
-                // D x E
-                // F G H
-                // gx = (C-A) + (E-D) + (H-F)
-                // gy = (F-A) + (G-B) + (H-C)
-                //
-                // To make this faster:
-                // com1 = (H-A)
-                // com2 = (C-F)
-                // Then: gx = com1 + com2 + (E-D) = (H-A) + (C-F) + (E-D) = (C-A) + (E-D) + (H-F)
-                //       gy = com2 - com1 + (G-B) = (H-A) - (C-F) + (G-B) = (F-A) + (G-B) + (H-C)
-                //
-                int com1 = srcImg[(r + 1) * width + c + 1] - srcImg[(r - 1) * width + c - 1];
-                int com2 = srcImg[(r - 1) * width + c + 1] - srcImg[(r + 1) * width + c - 1];
+                    // compute gx & gy using the simple [-1 -1 -1]
+                    //                                  [ 1  1  1]  filter in both directions
+                    // Faster method below
+                    // A B C
+                    // D x E
+                    // F G H
+                    // gx = (C-A) + (E-D) + (H-F)
+                    // gy = (F-A) + (G-B) + (H-C)
+                    //
+                    // To make this faster:
+                    // com1 = (H-A)
+                    // com2 = (C-F)
+                    // Then: gx = com1 + com2 + (E-D) = (H-A) + (C-F) + (E-D) = (C-A) + (E-D) + (H-F)
+                    //       gy = com2 - com1 + (G-B) = (H-A) - (C-F) + (G-B) = (F-A) + (G-B) + (H-C)
+                    //
+                    int com1 = srcImg[(r + 1) * width + c + 1] - srcImg[(r - 1) * width + c - 1];
+                    int com2 = srcImg[(r - 1) * width + c + 1] - srcImg[(r + 1) * width + c - 1];
+
+                    int gx = com1 + com2 + srcImg[r * width + c + 1] - srcImg[r * width + c - 1];
+                    int gy = com1 - com2 + srcImg[(r + 1) * width + c] - srcImg[(r - 1) * width + c];
 
-                int gx = com1 + com2 + srcImg[r * width + c + 1] - srcImg[r * width + c - 1];
-                int gy = com1 - com2 + srcImg[(r + 1) * width + c] - srcImg[(r - 1) * width + c];
+                    double pixelAngle = nfa->myAtan2((double)gx, (double)-gy);
+                    double diff = fabs(lineAngle - pixelAngle);
 
-                double pixelAngle = nfa->myAtan2((double)gx, (double)-gy);
-                double diff = fabs(lineAngle - pixelAngle);
+                    if (diff <= precision || diff >= CV_PI - precision)
+                        aligned++;
+                }
 
-                if (diff <= precision || diff >= CV_PI - precision)
-                    aligned++;
+                // Check validation by NFA computation (fast due to LUT)
+                valid = nfa->checkValidationByNFA(count, aligned) || ValidateLineSegmentRect(x, y, ls);
             }
 
-            // Check validation by NFA computation (fast due to LUT)
-            valid = nfa->checkValidationByNFA(count, aligned) || ValidateLineSegmentRect(x, y, ls);
+            validFlags[i] = valid;
         }
+    });
 
-        if (valid)
+    int noValidLines = 0;
+    for (int i = 0; i < linesNo; i++)
+    {
+        if (validFlags[i])
         {
             if (i != noValidLines)
                 lines[noValidLines] = lines[i];
@@ -1601,12 +1717,9 @@ void EdgeDrawingImpl::ValidateLineSegments()
     }
 
     linesNo = noValidLines;
-
-    delete[] x;
-    delete[] y;
 }
 
-bool EdgeDrawingImpl::ValidateLineSegmentRect(int* x, int* y, EDLineSegment* ls)
+bool EdgeDrawingImpl::ValidateLineSegmentRect(int* x, int* y, EDLineSegment* ls) const
 {
     // Compute Line's angle
     double lineAngle;
@@ -2420,6 +2533,7 @@ void EdgeDrawingImpl::detectEllipses(OutputArray ellipses)
     }
 
     min_line_len = 6;
+    line_error = params.LineFitErrorThreshold;
     Circles.clear();
     Ellipses.clear();
     lines.clear();
@@ -2427,104 +2541,26 @@ void EdgeDrawingImpl::detectEllipses(OutputArray ellipses)
     // If the end-points of the segment is very close to each other,
     // then directly fit a circle/ellipse instread of line fitting
     noCircles1 = 0;
-    circles1 = new Circle[(width + height) * 8];
+    circles1 = growBuffer(circleBuf1, (width + height) * 8);
 
     int bufferSize = 0;
     for (int i = 0; i < (int)segmentPoints.size(); i++)
         bufferSize += (int)segmentPoints[i].size();
 
     // Compute the starting line number for each segment
-    segmentStartLines = new int[segmentNos + 1];
+    segmentStartLines = growBuffer(segmentStartLineBuf, segmentNos + 1);
 
-    bm = new BufferManager(bufferSize * 8);
+    bm.reset(bufferSize * 8);
 
 #define CIRCLE_MIN_LINE_LEN 6
 
-    for (int i = 0; i < segmentNos; i++)
-    {
-        // Make note of the starting line number for this segment
-        segmentStartLines[i] = (int)lines.size();
-
-        int noPixels = (int)segmentPoints[i].size();
-
-        if (noPixels < 2 * CIRCLE_MIN_LINE_LEN)
-            continue;
-
-        double* x = bm->getX();
-        double* y = bm->getY();
-
-        for (int j = 0; j < noPixels; j++)
-        {
-            x[j] = segmentPoints[i][j].x;
-            y[j] = segmentPoints[i][j].y;
-        }
-
-        // If the segment is reasonably long, then see if the segment traverses the boundary of a closed shape
-        if (noPixels >= 4 * CIRCLE_MIN_LINE_LEN)
-        {
-            // If the end-points of the segment is close to each other, then assume a circular/elliptic structure
-            double dx = x[0] - x[noPixels - 1];
-            double dy = y[0] - y[noPixels - 1];
-            double d = sqrt(dx * dx + dy * dy);
-            double r = noPixels / CV_2PI;      // Assume a complete circle
-
-            double maxDistanceBetweenEndPoints = std::max(3.0, r / 4.0);
-
-            // If almost closed loop, then try to fit a circle/ellipse
-            if (d <= maxDistanceBetweenEndPoints)
-            {
-                double xc, yc, circleFitError = 1e10;
-
-                CircleFit(x, y, noPixels, &xc, &yc, &r, &circleFitError);
-
-                EllipseEquation eq;
-                double ellipseFitError = 1e10;
-
-                if (circleFitError > LONG_ARC_ERROR)
-                {
-                    // Try fitting an ellipse
-                    if (EllipseFit(x, y, noPixels, &eq))
-                        ellipseFitError = ComputeEllipseError(&eq, x, y, noPixels);
-                }
-
-                if (circleFitError <= LONG_ARC_ERROR)
-                {
-                    addCircle(circles1, noCircles1, xc, yc, r, circleFitError, x, y, noPixels);
-                    bm->move(noPixels);
-                    continue;
-                }
-                else if (ellipseFitError <= ELLIPSE_ERROR)
-                {
-                    double major, minor;
-                    ComputeEllipseCenterAndAxisLengths(&eq, &xc, &yc, &major, &minor);
-
-                    // Assume major is longer. Otherwise, swap
-                    if (minor > major)
-                    {
-                        double tmp = major;
-                        major = minor;
-                        minor = tmp;
-                    }
-
-                    if (major < 8 * minor)
-                    {
-                        addCircle(circles1, noCircles1, xc, yc, r, circleFitError, &eq, ellipseFitError, x, y, noPixels);
-                        bm->move(noPixels);
-                    }
-                    continue;
-                }
-            }
-        }
-        // Otherwise, split to lines
-        SplitSegment2Lines(x, y, noPixels, i);
-    }
+    FitSegmentsForEllipses();
 
     min_line_len = params.MinLineLength;
-    segmentStartLines[segmentNos] = (int)lines.size();
 
     // ------------------------------- DETECT ARCS ---------------------------------
 
-    info = new Info[lines.size()];
+    info = growBuffer(infoBuf, (int)lines.size());
 
     // Compute the angle information for each line segment
     for (int i = 0; i < segmentNos; i++)
@@ -2575,20 +2611,20 @@ void EdgeDrawingImpl::detectEllipses(OutputArray ellipses)
     // This is how much space we will allocate for circles buffers
     int maxNoOfCircles = (int)lines.size() / 3 + noCircles1 * 2;
 
-    edarcs1 = new EDArcs(maxNoOfCircles);
+    edarcs1.reset(maxNoOfCircles);
     DetectArcs();    // Detect all arcs
 
     // Try to join arcs that are almost perfectly circular.
     // Use the distance between the arc end-points as a metric in choosing in choosing arcs to join
-    edarcs2 = new EDArcs(maxNoOfCircles);
+    edarcs2.reset(maxNoOfCircles);
     JoinArcs1();
 
     // Try to join arcs that belong to the same segment
-    edarcs3 = new EDArcs(maxNoOfCircles);
+    edarcs3.reset(maxNoOfCircles);
     JoinArcs2();
 
     // Try to combine arcs that belong to different segments
-    edarcs4 = new EDArcs(maxNoOfCircles);     // The remaining arcs
+    edarcs4.reset(maxNoOfCircles);     // The remaining arcs
     JoinArcs3();
 
     // Finally, go over the arcs & circles, and generate candidate circles
@@ -2596,14 +2632,16 @@ void EdgeDrawingImpl::detectEllipses(OutputArray ellipses)
 
     //----------------------------- VALIDATE CIRCLES --------------------------
     noCircles2 = 0;
-    circles2 = new Circle[maxNoOfCircles];
-    GaussianBlur(srcImage, smoothImage, Size(), 0.50); // calculate kernel from sigma;
+    circles2 = growBuffer(circleBuf2, maxNoOfCircles);
+    GaussianBlur(srcImage, smoothBuf, Size(), 0.50); // calculate kernel from sigma;
+    smoothImage = smoothBuf; // never blur into smoothImage, it may share the data of the source
+    smoothImg = smoothImage.data;
 
     ValidateCircles(params.NFAValidation);
 
     //----------------------------- JOIN CIRCLES --------------------------
     noCircles3 = 0;
-    circles3 = new Circle[maxNoOfCircles];
+    circles3 = growBuffer(circleBuf3, maxNoOfCircles);
     JoinCircles();
 
     noCircles = 0;
@@ -2641,26 +2679,170 @@ void EdgeDrawingImpl::detectEllipses(OutputArray ellipses)
     }
 
     Mat(_ellipses).copyTo(ellipses);
+}
+
+// Fits a circle or an ellipse to every almost closed segment and splits the other
+// segments to lines. The segments are fitted in parallel over fixed blocks; the
+// circles and the lines are then collected in segment order, so the result is the
+// same as for a serial pass over the segments
+void EdgeDrawingImpl::FitSegmentsForEllipses()
+{
+    const int BLOCK_SEGMENTS = 64;
+    int noBlocks = (segmentNos + BLOCK_SEGMENTS - 1) / BLOCK_SEGMENTS;
+    if ((int)blockLines.size() < noBlocks)
+        blockLines.resize(noBlocks);
+    shapeFitBuf.resize(segmentNos);
+
+    parallel_for_(Range(0, noBlocks), [&](const Range& range)
+    {
+        vector<double> xBuf, yBuf;
+
+        for (int b = range.start; b < range.end; b++)
+        {
+            vector<EDLineSegment>& segmentLines = blockLines[b];
+            segmentLines.clear();
+
+            int blockEnd = std::min((b + 1) * BLOCK_SEGMENTS, segmentNos);
+            for (int i = b * BLOCK_SEGMENTS; i < blockEnd; i++)
+            {
+                SegmentShapeFit& fit = shapeFitBuf[i];
+                fit.type = SegmentShapeFit::NONE;
+
+                int noPixels = (int)segmentPoints[i].size();
+
+                if (noPixels < 2 * CIRCLE_MIN_LINE_LEN)
+                    continue;
+
+                if ((int)xBuf.size() < noPixels)
+                {
+                    xBuf.resize(noPixels);
+                    yBuf.resize(noPixels);
+                }
+                double* x = &xBuf[0];
+                double* y = &yBuf[0];
+
+                for (int j = 0; j < noPixels; j++)
+                {
+                    x[j] = segmentPoints[i][j].x;
+                    y[j] = segmentPoints[i][j].y;
+                }
+
+                // If the segment is reasonably long, then see if the segment traverses the boundary of a closed shape
+                if (noPixels >= 4 * CIRCLE_MIN_LINE_LEN)
+                {
+                    // If the end-points of the segment is close to each other, then assume a circular/elliptic structure
+                    double dx = x[0] - x[noPixels - 1];
+                    double dy = y[0] - y[noPixels - 1];
+                    double d = sqrt(dx * dx + dy * dy);
+                    double r = noPixels / CV_2PI;      // Assume a complete circle
+
+                    double maxDistanceBetweenEndPoints = std::max(3.0, r / 4.0);
+
+                    // If almost closed loop, then try to fit a circle/ellipse
+                    if (d <= maxDistanceBetweenEndPoints)
+                    {
+                        double xc, yc, circleFitError = 1e10;
+
+                        CircleFit(x, y, noPixels, &xc, &yc, &r, &circleFitError);
+
+                        EllipseEquation eq;
+                        double ellipseFitError = 1e10;
 
-    delete edarcs1;
-    delete edarcs2;
-    delete edarcs3;
-    delete edarcs4;
+                        if (circleFitError > LONG_ARC_ERROR)
+                        {
+                            // Try fitting an ellipse
+                            if (EllipseFit(x, y, noPixels, &eq))
+                                ellipseFitError = ComputeEllipseError(&eq, x, y, noPixels);
+                        }
+
+                        fit.xc = xc;
+                        fit.yc = yc;
+                        fit.r = r;
+                        fit.circleFitError = circleFitError;
 
-    delete[] circles1;
-    delete[] circles2;
-    delete[] circles3;
+                        if (circleFitError <= LONG_ARC_ERROR)
+                        {
+                            fit.type = SegmentShapeFit::CIRCLE;
+                            continue;
+                        }
+                        else if (ellipseFitError <= ELLIPSE_ERROR)
+                        {
+                            double major, minor;
+                            ComputeEllipseCenterAndAxisLengths(&eq, &xc, &yc, &major, &minor);
+
+                            // Assume major is longer. Otherwise, swap
+                            if (minor > major)
+                            {
+                                double tmp = major;
+                                major = minor;
+                                minor = tmp;
+                            }
 
-    delete bm;
-    delete[] segmentStartLines;
-    delete[] info;
+                            if (major < 8 * minor)
+                            {
+                                fit.type = SegmentShapeFit::ELLIPSE;
+                                fit.xc = xc;
+                                fit.yc = yc;
+                                fit.eq = eq;
+                                fit.ellipseFitError = ellipseFitError;
+                            }
+                            else
+                                fit.type = SegmentShapeFit::REJECTED;
+                            continue;
+                        }
+                    }
+                }
+                // Otherwise, split to lines
+                SplitSegment2Lines(x, y, noPixels, i, segmentLines);
+            }
+        }
+    });
+
+    for (int b = 0; b < noBlocks; b++)
+    {
+        const vector<EDLineSegment>& segmentLines = blockLines[b];
+        size_t nextLine = 0;
+
+        int blockEnd = std::min((b + 1) * BLOCK_SEGMENTS, segmentNos);
+        for (int i = b * BLOCK_SEGMENTS; i < blockEnd; i++)
+        {
+            // Make note of the starting line number for this segment
+            segmentStartLines[i] = (int)lines.size();
+
+            while (nextLine < segmentLines.size() && segmentLines[nextLine].segmentNo == i)
+                lines.push_back(segmentLines[nextLine++]);
+
+            SegmentShapeFit& fit = shapeFitBuf[i];
+            if (fit.type != SegmentShapeFit::CIRCLE && fit.type != SegmentShapeFit::ELLIPSE)
+                continue;
+
+            // The pixels of a detected circle/ellipse stay in the buffer manager
+            int noPixels = (int)segmentPoints[i].size();
+            double* x = bm.getX();
+            double* y = bm.getY();
+
+            for (int j = 0; j < noPixels; j++)
+            {
+                x[j] = segmentPoints[i][j].x;
+                y[j] = segmentPoints[i][j].y;
+            }
+
+            if (fit.type == SegmentShapeFit::CIRCLE)
+                addCircle(circles1, noCircles1, fit.xc, fit.yc, fit.r, fit.circleFitError, x, y, noPixels);
+            else
+                addCircle(circles1, noCircles1, fit.xc, fit.yc, fit.r, fit.circleFitError, &fit.eq, fit.ellipseFitError, x, y, noPixels);
+            bm.move(noPixels);
+        }
+    }
+
+    segmentStartLines[segmentNos] = (int)lines.size();
 }
 
 void EdgeDrawingImpl::GenerateCandidateCircles()
 {
     // Now, go over the circular arcs & add them to circles1
-    MyArc* arcs = edarcs4->arcs;
-    for (int i = 0; i < edarcs4->noArcs; i++)
+    MyArc* arcs = edarcs4.arcs;
+    for (int i = 0; i < edarcs4.noArcs; i++)
     {
         if (arcs[i].isEllipse)
         {
@@ -2838,8 +3020,8 @@ void EdgeDrawingImpl::DetectArcs()
 
                 // Copy the pixels of this segment to an array
                 int noPixels = 0;
-                double* x = bm->getX();
-                double* y = bm->getY();
+                double* x = bm.getX();
+                double* y = bm.getY();
 
                 // wrapCase 1: Combine the first two lines with the last line of the segment
                 if (wrapCase == 1)
@@ -2880,7 +3062,7 @@ void EdgeDrawingImpl::DetectArcs()
                 }
 
                 // Move buffer pointers
-                bm->move(noPixels);
+                bm.move(noPixels);
 
                 // Try to fit a circle to the entire arc of lines
                 double xc = -1, yc = -1, radius = -1, circleFitError = -1;
@@ -2923,7 +3105,7 @@ void EdgeDrawingImpl::DetectArcs()
                         double sTheta, eTheta;
                         ComputeStartAndEndAngles(xc, yc, radius, x, y, noPixels, &sTheta, &eTheta);
 
-                        addArc(edarcs1->arcs, edarcs1->noArcs, xc, yc, radius, circleFitError, sTheta, eTheta, info[firstLine].sign, curSegmentNo,
+                        addArc(edarcs1.arcs, edarcs1.noArcs, xc, yc, radius, circleFitError, sTheta, eTheta, info[firstLine].sign, curSegmentNo,
                             (int)x[0], (int)y[0], (int)x[noPixels - 1], (int)y[noPixels - 1], x, y, noPixels);
                     }
 
@@ -2975,7 +3157,7 @@ void EdgeDrawingImpl::DetectArcs()
                             double sTheta, eTheta;
                             ComputeStartAndEndAngles(xc, yc, radius, x, y, noPixels, &sTheta, &eTheta);
 
-                            addArc(edarcs1->arcs, edarcs1->noArcs, xc, yc, radius, circleFitError, sTheta, eTheta, info[firstLine].sign, curSegmentNo, &eq, ellipseFitError,
+                            addArc(edarcs1.arcs, edarcs1.noArcs, xc, yc, radius, circleFitError, sTheta, eTheta, info[firstLine].sign, curSegmentNo, &eq, ellipseFitError,
                                 (int)x[0], (int)y[0], (int)x[noPixels - 1], (int)y[noPixels - 1], x, y, noPixels);
                         }
 
@@ -3070,7 +3252,7 @@ void EdgeDrawingImpl::DetectArcs()
                         double sTheta, eTheta;
                         ComputeStartAndEndAngles(XC, YC, R, x, y, noPixels, &sTheta, &eTheta);
 
-                        addArc(edarcs1->arcs, edarcs1->noArcs, XC, YC, R, Error, sTheta, eTheta, info[firstLine].sign, curSegmentNo,
+                        addArc(edarcs1.arcs, edarcs1.noArcs, XC, YC, R, Error, sTheta, eTheta, info[firstLine].sign, curSegmentNo,
                             (int)x[0], (int)y[0], (int)x[noPixels - 1], (int)y[noPixels - 1], x, y, noPixels);
                     }
 
@@ -3093,42 +3275,50 @@ void EdgeDrawingImpl::ValidateCircles(bool validate)
     precision = CV_PI / 16;  // Alignment precision
 
     int points_buffer_size = 8 * (width + height);
-    double *px = new double[points_buffer_size];
-    double *py = new double[points_buffer_size];
 
-    if (nfa->LUTSize == 1 && params.NFAValidation)
+    if (params.NFAValidation)
+        UpdateNFALUT(); // create look up table
+
+    // Validate circles & ellipses. Each candidate is validated independently,
+    // the valid ones are then copied to circles2 in their original order
+    validFlags.resize(noCircles1);
+
+    parallel_for_(Range(0, noCircles1), [&](const Range& range)
     {
-        int lutSize = (width + height) / 8;
-        double prob = 1.0 / 8;  // probability of alignment
-        nfa = new NFALUT(lutSize, prob, width, height); // create look up table
-    }
+        AutoBuffer<double> px(points_buffer_size), py(points_buffer_size);
+
+        for (int i = range.start; i < range.end; i++)
+            validFlags[i] = ValidateCircle(&circles1[i], validate, px.data(), py.data(), points_buffer_size);
+    });
 
-    // Validate circles & ellipses
-    bool validateAgain;
     int count = 0;
-    for (int i = 0; i < noCircles1; )
+    for (int i = 0; i < noCircles1; i++)
+    {
+        if (validFlags[i])
+            circles2[count++] = circles1[i];
+    }
+
+    noCircles2 = count;
+}
+
+// Validates a single circle/ellipse candidate. A circle that fails the validation
+// is replaced by its fitted ellipse when possible, and validated again
+bool EdgeDrawingImpl::ValidateCircle(Circle* circle, bool validate, double* px, double* py, int bufferSize) const
+{
+    for (;;)
     {
-        Circle* circle = &circles1[i];
         double xc = circle->xc;
         double yc = circle->yc;
         double radius = circle->r;
 
         // Skip potential invalid circles (sometimes these kinds of candidates get generated!)
         if (radius > MAX(width, height))
-        {
-            i++;
-            continue;
-        }
-
-        validateAgain = false;
+            return false;
 
         int noPoints = (int)(computeEllipsePerimeter(&circle->eq));
 
-        if (noPoints > points_buffer_size)
-        {
-            i++;
-            continue;
-        }
+        if (noPoints > bufferSize)
+            return false;
 
         if (circle->isEllipse)
         {
@@ -3315,10 +3505,9 @@ void EdgeDrawingImpl::ValidateCircles(bool validate)
         bool isValid = !validate || nfa->checkValidationByNFA(noPeripheryPixels, aligned);
 
         if (isValid)
-        {
-            circles2[count++] = circles1[i];
-        }
-        else if (circle->isEllipse == false && circle->coverRatio >= CANDIDATE_ELLIPSE_RATIO)
+            return true;
+
+        if (circle->isEllipse == false && circle->coverRatio >= CANDIDATE_ELLIPSE_RATIO)
         {
             // Fit an ellipse to this circle, and try to revalidate
             double ellipseFitError = 1e10;
@@ -3335,18 +3524,12 @@ void EdgeDrawingImpl::ValidateCircles(bool validate)
                 circle->ellipseFitError = ellipseFitError;
                 circle->eq = eq;
 
-                validateAgain = true;
+                continue;
             }
         }
 
-        if (validateAgain == false)
-            i++;
+        return false;
     }
-
-    noCircles2 = count;
-
-    delete[] px;
-    delete[] py;
 }
 
 void EdgeDrawingImpl::JoinCircles()
@@ -3446,8 +3629,8 @@ void EdgeDrawingImpl::JoinCircles()
         if (noCandidateCircles > 0)
         {
             int noPixels = circles[i].noPixels;
-            double* x = bm->getX();
-            double* y = bm->getY();
+            double* x = bm.getX();
+            double* y = bm.getY();
             memcpy(x, circles[i].x, noPixels * sizeof(double));
             memcpy(y, circles[i].y, noPixels * sizeof(double));
 
@@ -3533,10 +3716,10 @@ void EdgeDrawingImpl::JoinArcs1()
     AngleSet angles;
 
     // Sort the arcs with respect to their length so that longer arcs are at the beginning
-    sortArc(edarcs1->arcs, edarcs1->noArcs);
+    sortArc(edarcs1.arcs, edarcs1.noArcs);
 
-    int noArcs = edarcs1->noArcs;
-    MyArc* arcs = edarcs1->arcs;
+    int noArcs = edarcs1.noArcs;
+    MyArc* arcs = edarcs1.arcs;
 
     bool* taken = new bool[noArcs];
     for (int i = 0; i < noArcs; i++)
@@ -3558,7 +3741,7 @@ void EdgeDrawingImpl::JoinArcs1()
             continue;
         if (arcs[i].isEllipse)
         {
-            edarcs2->arcs[edarcs2->noArcs++] = arcs[i];
+            edarcs2.arcs[edarcs2.noArcs++] = arcs[i];
             continue;
         }
 
@@ -3579,8 +3762,8 @@ void EdgeDrawingImpl::JoinArcs1()
         // Take the pixels making up this arc
         int noPixels = arcs[i].noPixels;
 
-        double* x = bm->getX();
-        double* y = bm->getY();
+        double* x = bm.getX();
+        double* y = bm.getY();
         memcpy(x, arcs[i].x, noPixels * sizeof(double));
         memcpy(y, arcs[i].y, noPixels * sizeof(double));
 
@@ -3779,7 +3962,7 @@ void EdgeDrawingImpl::JoinArcs1()
         if (CircleEqValid == false)
         {
             // Add to arcs
-            edarcs2->arcs[edarcs2->noArcs++] = arcs[i];
+            edarcs2.arcs[edarcs2.noArcs++] = arcs[i];
         }
         else
         {
@@ -3791,9 +3974,9 @@ void EdgeDrawingImpl::JoinArcs1()
             if ((coverage >= FULL_CIRCLE_RATIO && CircleFitError <= LONG_ARC_ERROR))
                 addCircle(circles1, noCircles1, XC, YC, R, CircleFitError, x, y, NoPixels);
             else
-                addArc(edarcs2->arcs, edarcs2->noArcs, XC, YC, R, CircleFitError, sTheta, eTheta, Turn, arcs[i].segmentNo, SX, SY, EX, EY, x, y, NoPixels, angles.overlapRatio());
+                addArc(edarcs2.arcs, edarcs2.noArcs, XC, YC, R, CircleFitError, sTheta, eTheta, Turn, arcs[i].segmentNo, SX, SY, EX, EY, x, y, NoPixels, angles.overlapRatio());
 
-            bm->move(NoPixels);
+            bm.move(NoPixels);
         }
     }
 
@@ -3806,10 +3989,10 @@ void EdgeDrawingImpl::JoinArcs2()
     AngleSet angles;
 
     // Sort the arcs with respect to their length so that longer arcs are at the beginning
-    sortArc(edarcs2->arcs, edarcs2->noArcs);
+    sortArc(edarcs2.arcs, edarcs2.noArcs);
 
-    int noArcs = edarcs2->noArcs;
-    MyArc* arcs = edarcs2->arcs;
+    int noArcs = edarcs2.noArcs;
+    MyArc* arcs = edarcs2.arcs;
 
     bool* taken = new bool[noArcs];
     for (int i = 0; i < noArcs; i++)
@@ -3847,8 +4030,8 @@ void EdgeDrawingImpl::JoinArcs2()
         // Take the pixels making up this arc
         int noPixels = arcs[i].noPixels;
 
-        double* x = bm->getX();
-        double* y = bm->getY();
+        double* x = bm.getX();
+        double* y = bm.getY();
         memcpy(x, arcs[i].x, noPixels * sizeof(double));
         memcpy(y, arcs[i].y, noPixels * sizeof(double));
 
@@ -4036,7 +4219,7 @@ void EdgeDrawingImpl::JoinArcs2()
         if (EllipseEqValid == false)
         {
             // Add to arcs
-            edarcs3->arcs[edarcs3->noArcs++] = arcs[i];
+            edarcs3.arcs[edarcs3.noArcs++] = arcs[i];
         }
         else
         {
@@ -4051,10 +4234,10 @@ void EdgeDrawingImpl::JoinArcs2()
             if ((coverage >= FULL_CIRCLE_RATIO && CircleFitError <= LONG_ARC_ERROR))
                 addCircle(circles1, noCircles1, XC, YC, R, CircleFitError, x, y, NoPixels);
             else
-                addArc(edarcs3->arcs, edarcs3->noArcs, XC, YC, R, CircleFitError, sTheta, eTheta, Turn, arcs[i].segmentNo, &Eq, EllipseFitError, SX, SY, EX, EY, x, y, NoPixels, angles.overlapRatio());
+                addArc(edarcs3.arcs, edarcs3.noArcs, XC, YC, R, CircleFitError, sTheta, eTheta, Turn, arcs[i].segmentNo, &Eq, EllipseFitError, SX, SY, EX, EY, x, y, NoPixels, angles.overlapRatio());
 
             // Move buffer pointers
-            bm->move(NoPixels);
+            bm.move(NoPixels);
         }
     }
 
@@ -4067,10 +4250,10 @@ void EdgeDrawingImpl::JoinArcs3()
     AngleSet angles;
 
     // Sort the arcs with respect to their length so that longer arcs are at the beginning
-    sortArc(edarcs3->arcs, edarcs3->noArcs);
+    sortArc(edarcs3.arcs, edarcs3.noArcs);
 
-    int noArcs = edarcs3->noArcs;
-    MyArc* arcs = edarcs3->arcs;
+    int noArcs = edarcs3.noArcs;
+    MyArc* arcs = edarcs3.arcs;
 
     bool* taken = new bool[noArcs];
     for (int i = 0; i < noArcs; i++)
@@ -4108,8 +4291,8 @@ void EdgeDrawingImpl::JoinArcs3()
         // Take the pixels making up this arc
         int noPixels = arcs[i].noPixels;
 
-        double* x = bm->getX();
-        double* y = bm->getY();
+        double* x = bm.getX();
+        double* y = bm.getY();
         memcpy(x, arcs[i].x, noPixels * sizeof(double));
         memcpy(y, arcs[i].y, noPixels * sizeof(double));
 
@@ -4325,7 +4508,7 @@ void EdgeDrawingImpl::JoinArcs3()
         if (EllipseEqValid == false)
         {
             // Add to arcs
-            edarcs4->arcs[edarcs4->noArcs++] = arcs[i];
+            edarcs4.arcs[edarcs4.noArcs++] = arcs[i];
         }
         else
         {
@@ -4340,9 +4523,9 @@ void EdgeDrawingImpl::JoinArcs3()
             if ((coverage >= FULL_CIRCLE_RATIO && CircleFitError <= LONG_ARC_ERROR))
                 addCircle(circles1, noCircles1, XC, YC, R, CircleFitError, x, y, NoPixels);
             else
-                addArc(edarcs4->arcs, edarcs4->noArcs, XC, YC, R, CircleFitError, sTheta, eTheta, Turn, arcs[i].segmentNo, &Eq, EllipseFitError, SX, SY, EX, EY, x, y, NoPixels, angles.overlapRatio());
+                addArc(edarcs4.arcs, edarcs4.noArcs, XC, YC, R, CircleFitError, sTheta, eTheta, Turn, arcs[i].segmentNo, &Eq, EllipseFitError, SX, SY, EX, EY, x, y, NoPixels, angles.overlapRatio());
 
-            bm->move(NoPixels);
+            bm.move(NoPixels);
         }
     }
 
@@ -4363,6 +4546,7 @@ void EdgeDrawingImpl::addCircle(Circle* circles, int& noCircles, double xc, doub
     circles[noCircles].noPixels = noPixels;
 
     circles[noCircles].isEllipse = false;
+    circles[noCircles].eq = EllipseEquation(); // the buffers are reused, do not keep a stale equation
 
     noCircles++;
 }
@@ -4969,6 +5153,7 @@ void EdgeDrawingImpl::addArc(MyArc* arcs, int& noArcs, double xc, double yc, dou
     arcs[noArcs].segmentNo = segmentNo;
 
     arcs[noArcs].isEllipse = false;
+    arcs[noArcs].eq = EllipseEquation(); // the buffers are reused, do not keep a stale equation
 
     arcs[noArcs].sx = sx;
     arcs[noArcs].sy = sy;
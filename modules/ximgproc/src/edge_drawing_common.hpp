@@ -526,34 +526,45 @@ double AngleSet::coverRatio()
     return total / CV_2PI;
 }
 
+// Arc and pixel buffers are kept by EdgeDrawingImpl between calls and cleared by reset()
 struct EDArcs {
+	std::vector<MyArc> buf;
 	MyArc *arcs;
 	int noArcs;
 
 public:
-	EDArcs(int size = 10000) {
-		arcs = new MyArc[size];
+	EDArcs() {
+		arcs = NULL;
 		noArcs = 0;
 	}
 
-	~EDArcs() {
-		delete arcs;
+	void reset(int size) {
+		if ((int)buf.size() < size)
+			buf.resize(size);
+		arcs = buf.empty() ? NULL : &buf[0];
+		noArcs = 0;
 	}
 };
 
 struct BufferManager {
+	std::vector<double> xbuf, ybuf;
 	double *x, *y;
 	int index;
 
-	BufferManager(int maxSize) {
-		x = new double[maxSize];
-		y = new double[maxSize];
+	BufferManager() {
+		x = y = NULL;
 		index = 0;
 	}
 
-	~BufferManager() {
-		delete x;
-		delete y;
+	void reset(int maxSize) {
+		if ((int)xbuf.size() < maxSize)
+		{
+			xbuf.resize(maxSize);
+			ybuf.resize(maxSize);
+		}
+		x = xbuf.empty() ? NULL : &xbuf[0];
+		y = ybuf.empty() ? NULL : &ybuf[0];
+		index = 0;
 	}
 
 	double *getX() { return &x[index]; }
@@ -49,6 +49,28 @@ int getTotalNumberOfChannels(InputArrayOfArrays src);
 
 void checkSameSizeAndDepth(InputArrayOfArrays src, Size &sz, int &depth);
 
+/* Joint bilateral filtering of a fixed source image with changing joint images.
+ * The border extended source, the spatial kernel and the color lookup table are kept
+ * between the calls of apply(). */
+class JointBilateralFilterContext
+{
+public:
+
+    void init(const Mat& src, int jointType, int radius, double sigmaColor, double sigmaSpace, int borderType);
+
+    void apply(const Mat& joint, Mat& dst);
+
+    void release();
+
+private:
+
+    Mat src, srcTemp, jointTemp;
+    int jointType, radius, borderType, maxk;
+    double sigmaColor, sigmaSpace;
+    std::vector<float> spaceWeights, expLUT;
+    std::vector<int> spaceOfs;
+};
+
 namespace intrinsics
 {
     void add_(float *dst, float *src1, int w);
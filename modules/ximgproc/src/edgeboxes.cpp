@@ -160,19 +160,24 @@ private:
     vector<float> _scaleNorm;
     float _sxStep, _ayStep, _xyStepRatio;
 
-    // data structures for efficiency (see scoreBox)
-    Mat _sWts;
-    Mat _sDone, _sMap, _sIds;
-    int _sId;
+    // scratch buffers of scoreBox(); one instance per worker so that
+    // boxes can be scored concurrently
+    struct ScoreScratch
+    {
+        explicit ScoreScratch(int n) : wts(n, 0.f), done(n, -1), map(n, 0), ids(n, 0), id(0) {}
+        vector<float> wts;
+        vector<int> done, map, ids;
+        int id;
+    };
 
     // helper routines
     static bool boxesCompare(const Box &a, const Box &b) { return a.score < b.score; }
     void clusterEdges(Mat &edgeMap, Mat &orientationMap);
     void prepDataStructs(Mat &edgeMap);
     void scoreAllBoxes(Boxes &boxes);
-    void scoreBox(Box &box);
-    void refineBox(Box &box);
-    float boxesOverlap(Box &a, Box &b);
+    void scoreBox(Box &box, ScoreScratch &scratch) const;
+    void refineBox(Box &box, ScoreScratch &scratch) const;
+    static float boxesOverlap(const Box &a, const Box &b);
     void boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes);
 };
 
@@ -522,64 +527,63 @@ void EdgeBoxesImpl::prepDataStructs(Mat &edgeMap)
       }
     }
 
-    // create remaining data structures
-    int s = 0;
-    int s1;
-
-    _hIdxs.resize(h);
-    _hIdxImg = Mat::zeros(w, h, DataType<int>::type);
-    for (y = 0; y < h; y++)
+    // create remaining data structures (rows and columns are independent)
+    _hIdxs.assign(h, vector<int>());
+    _hIdxImg.create(w, h, DataType<int>::type);
+    parallel_for_(Range(0, h), [&](const Range& range)
     {
-        s = 0;
-        _hIdxs[y].push_back(s);
-        for (x = 0; x < w; x++)
+        for (int yy = range.start; yy < range.end; yy++)
         {
-            s1 = _segIds.at<int>(x, y);
-            if (s1 != s)
+            vector<int> &idxs = _hIdxs[yy];
+            int s = 0;
+            idxs.push_back(s);
+            for (int xx = 0; xx < w; xx++)
             {
-                s = s1;
-                _hIdxs[y].push_back(s);
+                int s1 = _segIds.at<int>(xx, yy);
+                if (s1 != s)
+                {
+                    s = s1;
+                    idxs.push_back(s);
+                }
+                _hIdxImg.at<int>(xx, yy) = (int)idxs.size() - 1;
             }
-            _hIdxImg.at<int>(x, y) = (int)_hIdxs[y].size() - 1;
         }
-    }
+    });
 
-    _vIdxs.resize(w);
-    _vIdxImg = Mat::zeros(w, h, DataType<int>::type);
-    for (x = 0; x < w; x++)
+    _vIdxs.assign(w, vector<int>());
+    _vIdxImg.create(w, h, DataType<int>::type);
+    parallel_for_(Range(0, w), [&](const Range& range)
     {
-        s = 0;
-        _vIdxs[x].push_back(s);
-        for (y = 0; y < h; y++)
+        for (int xx = range.start; xx < range.end; xx++)
         {
-            s1 = _segIds.at<int>(x, y);
-            if (s1 != s)
+            vector<int> &idxs = _vIdxs[xx];
+            const int *s_ptr = _segIds.ptr<int>(xx);
+            int *v_ptr = _vIdxImg.ptr<int>(xx);
+            int s = 0;
+            idxs.push_back(s);
+            for (int yy = 0; yy < h; yy++)
             {
-                s = s1;
-                _vIdxs[x].push_back(s);
+                int s1 = s_ptr[yy];
+                if (s1 != s)
+                {
+                    s = s1;
+                    idxs.push_back(s);
+                }
+                v_ptr[yy] = (int)idxs.size() - 1;
             }
-            _vIdxImg.at<int>(x, y) = (int)_vIdxs[x].size() - 1;
         }
-    }
-
-    // initialize scoreBox() data structures
-    int n = _segCnt + 1;
-    _sWts = Mat::zeros(n, 1, DataType<float>::type);
-    _sDone = Mat(n, 1, DataType<int>::type,Scalar(-1));
-    _sMap = Mat::zeros(n, 1, DataType<int>::type);
-    _sIds = Mat::zeros(n, 1, DataType<int>::type);
-    _sId = 0;
+    });
 }
 
 
-void EdgeBoxesImpl::scoreBox(Box &box)
+void EdgeBoxesImpl::scoreBox(Box &box, ScoreScratch &scratch) const
 {
     int i, j, k, q, bh, bw, y0, x0, y1, x1, y0m, y1m, x0m, x1m;
-    float *sWts = (float *)_sWts.data;
-    int *sDone = (int *)_sDone.data;
-    int *sMap = (int *)_sMap.data;
-    int *sIds = (int *)_sIds.data;
-    int sId = _sId++;
+    float *sWts = &scratch.wts[0];
+    int *sDone = &scratch.done[0];
+    int *sMap = &scratch.map[0];
+    int *sIds = &scratch.ids[0];
+    int sId = scratch.id++;
 
     // add edge count inside box
     y1 = clamp(box.y + box.h, 0, h - 1);
@@ -708,7 +712,7 @@ void EdgeBoxesImpl::scoreBox(Box &box)
 }
 
 
-void EdgeBoxesImpl::refineBox(Box &box)
+void EdgeBoxesImpl::refineBox(Box &box, ScoreScratch &scratch) const
 {
     int yStep = (int)(box.h * _xyStepRatio);
     int xStep = (int)(box.w * _xyStepRatio);
@@ -725,53 +729,53 @@ void EdgeBoxesImpl::refineBox(Box &box)
         B = box;
         B.y = box.y - yStep;
         B.h = B.h + yStep;
-        scoreBox(B);
+        scoreBox(B, scratch);
 
         if (B.score <= box.score)
         {
             B = box;
             B.y = box.y + yStep;
             B.h = B.h - yStep;
-            scoreBox(B);
+            scoreBox(B, scratch);
         }
         if (B.score > box.score) box = B;
         // search over y end
         B = box;
         B.h = B.h + yStep;
-        scoreBox(B);
+        scoreBox(B, scratch);
 
         if (B.score <= box.score)
         {
             B = box;
             B.h = B.h - yStep;
-            scoreBox(B);
+            scoreBox(B, scratch);
         }
         if (B.score > box.score) box = B;
         // search over x start
         B = box;
         B.x = box.x - xStep;
         B.w = B.w + xStep;
-        scoreBox(B);
+        scoreBox(B, scratch);
 
         if (B.score <= box.score)
         {
             B = box;
             B.x = box.x + xStep;
             B.w = B.w - xStep;
-            scoreBox(B);
+            scoreBox(B, scratch);
         }
 
         if (B.score > box.score) box = B;
         // search over x end
         B = box;
         B.w = B.w + xStep;
-        scoreBox(B);
+        scoreBox(B, scratch);
 
         if (B.score <= box.score)
         {
             B = box;
             B.w = B.w - xStep;
-            scoreBox(B);
+            scoreBox(B, scratch);
         }
         if (B.score > box.score) box = B;
     }
@@ -813,21 +817,34 @@ void EdgeBoxesImpl::scoreAllBoxes(Boxes &boxes)
         }
     }
 
-    // score all boxes, refine top candidates
-    int i, k = 0, m = (int)boxes.size();
-    for (i = 0; i < m; i++)
+    // score all boxes, refine top candidates; every box is scored independently,
+    // so the grid is split into contiguous chunks, each with its own scratch buffers
+    const int m = (int)boxes.size();
+    const int n = _segCnt + 1;
+    parallel_for_(Range(0, m), [&](const Range& range)
     {
-        scoreBox(boxes[i]);
-        if (!boxes[i].score) continue;
-        k++;
-        refineBox(boxes[i]);
+        ScoreScratch scratch(n);
+        for (int i = range.start; i < range.end; i++)
+        {
+            scoreBox(boxes[i], scratch);
+            if (!boxes[i].score) continue;
+            refineBox(boxes[i], scratch);
+        }
+    }, std::max(1, getNumThreads()) * 8);
+
+    // drop boxes that did not score in the original grid order, so that the
+    // result does not depend on the number of threads
+    int k = 0;
+    for (int i = 0; i < m; i++)
+    {
+        if (boxes[i].score) boxes[k++] = boxes[i];
     }
-    sort(boxes.rbegin(), boxes.rend(), boxesCompare);
     boxes.resize(k);
+    sort(boxes.rbegin(), boxes.rend(), boxesCompare);
 }
 
 
-float EdgeBoxesImpl::boxesOverlap(Box &a, Box &b)
+float EdgeBoxesImpl::boxesOverlap(const Box &a, const Box &b)
 {
     float areai, areaj, areaij;
     int y0, y1, x0, x1, y1i, x1i, y1j, x1j;
@@ -867,24 +884,79 @@ void EdgeBoxesImpl::boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes)
     int m = 0;
     int d = 1;
 
+    // Kept boxes are additionally registered in a coarse spatial grid. Two boxes
+    // can only have a non-zero overlap if they cover a common cell, so with a
+    // non-negative threshold it is enough to test the kept boxes of the cells
+    // covered by the candidate; the outcome is the same as testing all of them.
+    const bool useGrid = thr >= 0;
+    const int gridSize = 16;
+    const int cellW = max(1, (w + gridSize - 1) / gridSize);
+    const int cellH = max(1, (h + gridSize - 1) / gridSize);
+    vector<vector<int> > grid(useGrid ? gridSize * gridSize : 0);
+    Boxes keptBoxes;
+    vector<int> keptBins, keptStamp;
+
     while (i < n && m < maxBoxes)
     {
-        b = boxes[i].w * boxes[i].h;
+        const Box &box = boxes[i];
+        b = box.w * box.h;
 
         bool keep = 1;
         b = clamp((int)(ceil(log(float(b)) / lstep)), d, nBin - d);
-        for (j = b - d; j <= b + d; j++)
+        int gx0 = 0, gx1 = -1, gy0 = 0, gy1 = -1;
+        if (useGrid)
         {
-            for (k = 0; k < (int)kept[j].size(); k++)
+            if (box.w > 0 && box.h > 0)
             {
-                if (keep)
-                    keep = boxesOverlap(boxes[i], kept[j][k]) <= thr;
+                gx0 = clamp(box.x / cellW, 0, gridSize - 1);
+                gx1 = clamp((box.x + box.w - 1) / cellW, 0, gridSize - 1);
+                gy0 = clamp(box.y / cellH, 0, gridSize - 1);
+                gy1 = clamp((box.y + box.h - 1) / cellH, 0, gridSize - 1);
+            }
+            for (int gy = gy0; gy <= gy1 && keep; gy++)
+            {
+                for (int gx = gx0; gx <= gx1 && keep; gx++)
+                {
+                    const vector<int> &cell = grid[gy * gridSize + gx];
+                    for (k = 0; k < (int)cell.size(); k++)
+                    {
+                        int idx = cell[k];
+                        if (keptStamp[idx] == i) continue;
+                        keptStamp[idx] = i;
+                        if (keptBins[idx] < b - d || keptBins[idx] > b + d) continue;
+                        if (boxesOverlap(box, keptBoxes[idx]) > thr)
+                        {
+                            keep = 0;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        else
+        {
+            for (j = b - d; j <= b + d && keep; j++)
+            {
+                for (k = 0; k < (int)kept[j].size() && keep; k++)
+                {
+                    keep = boxesOverlap(box, kept[j][k]) <= thr;
+                }
             }
         }
 
         if (keep)
         {
-            kept[b].push_back(boxes[i]);
+            kept[b].push_back(box);
+            if (useGrid)
+            {
+                int idx = (int)keptBoxes.size();
+                keptBoxes.push_back(box);
+                keptBins.push_back(b);
+                keptStamp.push_back(-1);
+                for (int gy = gy0; gy <= gy1; gy++)
+                    for (int gx = gx0; gx <= gx1; gx++)
+                        grid[gy * gridSize + gx].push_back(idx);
+            }
             m++;
         }
 
@@ -42,6 +42,9 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
+#include <algorithm>
+#include <vector>
 
 namespace cv { namespace ximgproc {
 
@@ -49,66 +52,188 @@ namespace cv { namespace ximgproc {
     typedef __int32 int32_t;
 #endif
 
-template<typename T, int D, HoughOp Op>
+//----------------------hough operators----------------------------------------
+
+// per element operations, with the same rounding and saturation as
+// cv::add, cv::min, cv::max and cv::addWeighted(src0, 0.5, src1, 0.5, 0)
+template <typename T> struct HoughAveType { typedef float type; };
+template <> struct HoughAveType<int> { typedef double type; };
+template <> struct HoughAveType<double> { typedef double type; };
+
+template <typename T, HoughOp Op>
 struct HoughOperator { };
-#define SPECIALIZE_HOUGHOP(TOp, body)                                         \
-    template<typename T, int D>                                               \
-    struct HoughOperator<T, D, TOp> {                                         \
-        static void operate(T *pDst, T *pSrc0, T* pSrc1, int len) {           \
-            Mat dst (Size(1, len), D, pDst);                                  \
-            Mat src0(Size(1, len), D, pSrc0);                                 \
-            Mat src1(Size(1, len), D, pSrc1);                                 \
-            body;                                                             \
-        }                                                                     \
+template <typename T>
+struct HoughOperator<T, FHT_ADD> {
+    static inline T apply(T a, T b) { return saturate_cast<T>(a + b); }
+};
+template <typename T>
+struct HoughOperator<T, FHT_MIN> {
+    static inline T apply(T a, T b) { return std::min(a, b); }
+};
+template <typename T>
+struct HoughOperator<T, FHT_MAX> {
+    static inline T apply(T a, T b) { return std::max(a, b); }
+};
+template <typename T>
+struct HoughOperator<T, FHT_AVE> {
+    static inline T apply(T a, T b)
+    {
+        typedef typename HoughAveType<T>::type WT;
+        return saturate_cast<T>((WT)a * (WT)0.5 + (WT)b * (WT)0.5);
+    }
+};
+
+// vectorized head of a line operation, returns the number of processed elements
+template <typename T, HoughOp Op>
+struct HoughVecOperator {
+    static inline int operate(T *, const T *, const T *, int) { return 0; }
+};
+
+#if CV_SIMD128
+#define SPECIALIZE_HOUGHVECOP(T, VT, TOp, body)                                \
+    template <>                                                                \
+    struct HoughVecOperator<T, TOp> {                                          \
+        static inline int operate(T *pDst, const T *pSrc0, const T *pSrc1,     \
+                                  int len) {                                   \
+            int i = 0;                                                         \
+            for (; i <= len - VT::nlanes; i += VT::nlanes)                     \
+            {                                                                  \
+                VT a = v_load(pSrc0 + i), b = v_load(pSrc1 + i);               \
+                v_store(pDst + i, body);                                       \
+            }                                                                  \
+            return i;                                                          \
+        }                                                                      \
     };
-SPECIALIZE_HOUGHOP(FHT_ADD, add(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_MIN, min(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_MAX, max(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_AVE, addWeighted(src0, 0.5, src1, 0.5, 0.0, dst));
-#undef SPECIALIZE_HOUGHOP
+#define SPECIALIZE_HOUGHVECOP_ALL(T, VT)                                       \
+    SPECIALIZE_HOUGHVECOP(T, VT, FHT_ADD, a + b)                               \
+    SPECIALIZE_HOUGHVECOP(T, VT, FHT_MIN, v_min(a, b))                         \
+    SPECIALIZE_HOUGHVECOP(T, VT, FHT_MAX, v_max(a, b))
+// saturating for 8 and 16 bit lanes and wrapping for 32 bit ones, as cv::add
+SPECIALIZE_HOUGHVECOP_ALL(uchar,  v_uint8x16)
+SPECIALIZE_HOUGHVECOP_ALL(schar,  v_int8x16)
+SPECIALIZE_HOUGHVECOP_ALL(ushort, v_uint16x8)
+SPECIALIZE_HOUGHVECOP_ALL(short,  v_int16x8)
+SPECIALIZE_HOUGHVECOP_ALL(int,    v_int32x4)
+SPECIALIZE_HOUGHVECOP_ALL(float,  v_float32x4)
+// rounding up average, corrected to round half to even
+SPECIALIZE_HOUGHVECOP(uchar, v_uint8x16, FHT_AVE,
+                      v_avg(a, b) - ((a ^ b) & v_avg(a, b) & v_setall_u8(1)))
+SPECIALIZE_HOUGHVECOP(ushort, v_uint16x8, FHT_AVE,
+                      v_avg(a, b) - ((a ^ b) & v_avg(a, b) & v_setall_u16(1)))
+SPECIALIZE_HOUGHVECOP(float, v_float32x4, FHT_AVE,
+                      a * v_setall_f32(0.5f) + b * v_setall_f32(0.5f))
+#undef SPECIALIZE_HOUGHVECOP_ALL
+#undef SPECIALIZE_HOUGHVECOP
+#endif
+
+template <typename T, HoughOp Op>
+static inline void houghOperate(T *pDst, const T *pSrc0, const T *pSrc1, int len)
+{
+    int i = HoughVecOperator<T, Op>::operate(pDst, pSrc0, pSrc1, len);
+    for (; i < len; i++)
+        pDst[i] = HoughOperator<T, Op>::apply(pSrc0[i], pSrc1[i]);
+}
 
 //----------------------fht----------------------------------------------------
 
-template <typename T, int D, HoughOp OP>
-void fhtCore(Mat     &img0,
-             Mat     &img1,
-             int32_t  y0,
-             int32_t  h,
-             bool     isPositiveShift,
-             int      level,
-             double   aspl)
+// One step of the recursive FHT: the lines [y0, y0 + h) of the upper buffer
+// are combined from the two halves computed one recursion level deeper.
+// Steps of the same recursion depth touch disjoint lines, so the whole
+// transform is computed depth by depth, from the deepest one, with the
+// lines of each depth processed in parallel.
+struct FHTStep
+{
+    int32_t y0;
+    int32_t h;
+    int     level;
+};
+
+struct FHTSchedule
 {
-    if (level <= 0)
-        return;
+    FHTSchedule() : rows(-1) {}
 
-    CV_Assert(h > 0);
-    if (h == 1)
+    int rows;
+    std::vector<std::vector<FHTStep> > steps;  // per recursion depth
+    std::vector<std::vector<int> > offsets;    // prefix sums of processed lines
+
+    void create(int ht)
     {
-        if ((aspl != 0.0) && (level == 1))
-        {
-            int w = img0.cols;
-            uchar* pLine0 = img0.data + img0.step * y0;
-            uchar* pLine1 = img1.data + img1.step * y0;
-            int dLine = cvRound(y0 * aspl);
-            dLine = dLine % w;
-            dLine = dLine * (int)(img1.elemSize());
-            int wLine = img0.cols * (int)(img0.elemSize());
-            memcpy(pLine0, pLine1 + wLine - dLine, dLine);
-            memcpy(pLine0 + dLine, pLine1, wLine - dLine);
-        }
-        else
+        if (ht == rows)
+            return;
+        rows = ht;
+        steps.clear();
+        offsets.clear();
+
+        int level = 0;
+        for (int thres = 1; ht > thres; thres <<= 1)
+            level++;
+        addStep(0, ht, level, 0);
+    }
+
+    int depth() const { return (int)steps.size(); }
+    int lines(int d) const { return offsets[d].back(); }
+
+private:
+    void addStep(int32_t y0, int32_t h, int level, int d)
+    {
+        if (level <= 0)
+            return;
+
+        CV_Assert(h > 0);
+        if ((int)steps.size() <= d)
         {
-            memcpy(img0.data + img0.step * y0,
-                   img1.data + img1.step * y0,
-                   img0.cols * (int)(img0.elemSize()));
+            steps.resize(d + 1);
+            offsets.resize(d + 1, std::vector<int>(1, 0));
         }
-        return;
+        FHTStep step = { y0, h, level };
+        steps[d].push_back(step);
+        offsets[d].push_back(offsets[d].back() + h);
+        if (h == 1)
+            return;
+
+        const int32_t k = h >> 1;
+        addStep(y0, k, level - 1, d + 1);
+        addStep(y0 + k, h - k, level - 1, d + 1);
+    }
+};
+
+static void fhtCopyLine(Mat    &img0,
+                        Mat    &img1,
+                        int32_t y0,
+                        int     level,
+                        double  aspl)
+{
+    if ((aspl != 0.0) && (level == 1))
+    {
+        int w = img0.cols;
+        uchar* pLine0 = img0.data + img0.step * y0;
+        uchar* pLine1 = img1.data + img1.step * y0;
+        int dLine = cvRound(y0 * aspl);
+        dLine = dLine % w;
+        dLine = dLine * (int)(img1.elemSize());
+        int wLine = img0.cols * (int)(img0.elemSize());
+        memcpy(pLine0, pLine1 + wLine - dLine, dLine);
+        memcpy(pLine0 + dLine, pLine1, wLine - dLine);
+    }
+    else
+    {
+        memcpy(img0.data + img0.step * y0,
+               img1.data + img1.step * y0,
+               img0.cols * (int)(img0.elemSize()));
     }
+}
+
+template <typename T, HoughOp OP>
+static void fhtCombineLine(Mat           &img0,
+                           Mat           &img1,
+                           const FHTStep &step,
+                           int32_t        s,
+                           bool           isPositiveShift,
+                           double         aspl)
+{
+    const int32_t y0 = step.y0;
+    const int32_t h = step.h;
     const int32_t k = h >> 1;
-    fhtCore<T, D, OP>(img1, img0, y0, k,
-                      isPositiveShift, level - 1, aspl);
-    fhtCore<T, D, OP>(img1, img0, y0 + k, h - k,
-                      isPositiveShift, level - 1, aspl);
 
     int au = 2 * k - 2;
     int ad = 2 * h - 2 * k - 2;
@@ -117,125 +242,198 @@ void fhtCore(Mat     &img0,
     int w = img0.cols;
     int wm = (h / w + 1) * w;
 
-    for (int32_t s = 0; s < h; s++)
+    int su = (s * au + b) / d;
+    int sd = (s * ad + b) / d;
+    int rd = isPositiveShift ? sd - s : s - sd;
+    rd = (rd + wm) % w;
+    T *pLine0 = (T *)(img0.data + img0.step * (y0 + s));
+    const T *pLineU = (const T *)(img1.data + img1.step * (y0 + su));
+    const T *pLineD = (const T *)(img1.data + img1.step * (y0 + k + sd));
+    int w0 = img0.channels() * rd;
+    int w1 = img0.channels() * (w - rd);
+
+    if ((aspl != 0.0) && (step.level == 1))
     {
-        int su = (s * au + b) / d;
-        int sd = (s * ad + b) / d;
-        int rd = isPositiveShift ? sd - s : s - sd;
-        rd = (rd + wm) % w;
-        uchar *pLine0 = img0.data + img0.step * (y0 + s);
-        uchar *pLineU = img1.data + img1.step * (y0 + su);
-        uchar *pLineD = img1.data + img1.step * (y0 + k + sd);
-        int w0 = img0.channels() * rd;
-        int w1 = img0.channels() * (w - rd);
-
-        if ((aspl != 0.0) && (level == 1))
+        int dU = cvRound((y0 + su) * aspl);
+        dU = dU % w;
+        dU *= img0.channels();
+        int dD = cvRound((y0 + k + sd) * aspl);
+        dD = dD % w;
+        dD *= img0.channels();
+        int wB = w * img0.channels();
+
+        int dX = dD - dU;
+        if (w0 >= dX)
         {
-            int dU = cvRound((y0 + su) * aspl);
-            dU = dU % w;
-            dU *= img0.channels();
-            int dD = cvRound((y0 + k + sd) * aspl);
-            dD = dD % w;
-            dD *= img0.channels();
-            int wB = w * img0.channels();
-
-            int dX = dD - dU;
-            if (w0 >= dX)
+            if (w0 >= dD)
             {
-                if (w0 >= dD)
-                {
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                               (T *)pLineU,
-                                               (T *)pLineD + (w0 - dX),
-                                               w1 + dX);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + (w1 + dD),
-                                               (T *)pLineU + (w1 + dX),
-                                               (T *)pLineD,
-                                               w0 - dD);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                               (T *)pLineU + (wB - dU),
-                                               (T *)pLineD + (w0 - dD),
-                                               dU);
-                }
-                else
-                {
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                               (T *)pLineU,
-                                               (T *)pLineD + (w0 - dX),
-                                               wB - dU);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                               (T *)pLineU + (wB - dU),
-                                               (T *)pLineD + (w0 + wB - dD),
-                                               dD - w0);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
-                                               (T *)pLineU + (w1 + dX),
-                                               (T *)pLineD,
-                                               w0 - dX);
-                }
+                houghOperate<T, OP>(pLine0 + dU,
+                                    pLineU,
+                                    pLineD + (w0 - dX),
+                                    w1 + dX);
+                houghOperate<T, OP>(pLine0 + (w1 + dD),
+                                    pLineU + (w1 + dX),
+                                    pLineD,
+                                    w0 - dD);
+                houghOperate<T, OP>(pLine0,
+                                    pLineU + (wB - dU),
+                                    pLineD + (w0 - dD),
+                                    dU);
             }
             else
             {
-                HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                           (T *)pLineU,
-                                           (T *)pLineD + (wB - (dX - w0)),
-                                           dX - w0);
-                HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
-                                           (T *)pLineU + (dX - w0),
-                                           (T *)pLineD,
-                                           wB - (dX - w0) - dU);
-                HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                           (T *)pLineU + (wB - dU),
-                                           (T *)pLineD + (wB - (dX - w0) - dU),
-                                           dU);
+                houghOperate<T, OP>(pLine0 + dU,
+                                    pLineU,
+                                    pLineD + (w0 - dX),
+                                    wB - dU);
+                houghOperate<T, OP>(pLine0,
+                                    pLineU + (wB - dU),
+                                    pLineD + (w0 + wB - dD),
+                                    dD - w0);
+                houghOperate<T, OP>(pLine0 + (dD - w0),
+                                    pLineU + (w1 + dX),
+                                    pLineD,
+                                    w0 - dX);
             }
         }
         else
         {
-            HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                        (T *)pLineU,
-                                        (T *)pLineD + w0,
-                                        w1);
-            HoughOperator<T, D, OP>::operate((T *)pLine0 + w1,
-                                        (T *)pLineU + w1,
-                                        (T *)pLineD,
-                                        w0);
+            houghOperate<T, OP>(pLine0 + dU,
+                                pLineU,
+                                pLineD + (wB - (dX - w0)),
+                                dX - w0);
+            houghOperate<T, OP>(pLine0 + (dD - w0),
+                                pLineU + (dX - w0),
+                                pLineD,
+                                wB - (dX - w0) - dU);
+            houghOperate<T, OP>(pLine0,
+                                pLineU + (wB - dU),
+                                pLineD + (wB - (dX - w0) - dU),
+                                dU);
         }
     }
+    else
+    {
+        houghOperate<T, OP>(pLine0,
+                            pLineU,
+                            pLineD + w0,
+                            w1);
+        houghOperate<T, OP>(pLine0 + w1,
+                            pLineU + w1,
+                            pLineD,
+                            w0);
+    }
 }
 
-template <typename T, int D, HoughOp Op>
-void fhtVoT(Mat    &img0,
-            Mat    &img1,
-            bool    isPositiveShift,
-            double  aspl)
+// FHT of one quadrant: dst holds the result, buf is the second buffer of
+// the recursion; both are filled with the source image before the transform
+struct FHTQuadrant
+{
+    int          quadrant;
+    Mat          dst;
+    Mat          buf;
+    const Mat   *src;
+    FHTSchedule *schedule;
+    bool         isVertical;
+    bool         isPositiveShift;
+    double       aspl;
+};
+
+template <typename T, HoughOp OP>
+class FHTDepthInvoker : public ParallelLoopBody
 {
-    int level = 0;
-    for (int thres = 1; img0.rows > thres; thres <<= 1)
-        level++;
+public:
+    FHTDepthInvoker(FHTQuadrant *quads, const int *depths, int nquads)
+        : quads_(quads), depths_(depths), nquads_(nquads) { }
 
-    fhtCore<T, D, Op>(img0, img1, 0, img0.rows, isPositiveShift, level, aspl);
+    void operator()(const Range &range) const CV_OVERRIDE
+    {
+        int base = 0;
+        for (int q = 0; q < nquads_ && base < range.end; q++)
+        {
+            if (depths_[q] < 0)
+                continue;
+            FHTQuadrant &quad = quads_[q];
+            const std::vector<FHTStep> &steps = quad.schedule->steps[depths_[q]];
+            const std::vector<int> &offsets = quad.schedule->offsets[depths_[q]];
+            const int lines = offsets.back();
+            const int begin = std::max(range.start - base, 0);
+            const int end = std::min(range.end - base, lines);
+            base += lines;
+            if (begin >= end)
+                continue;
+
+            // the recursion swaps the buffers at each level
+            Mat &img0 = (depths_[q] & 1) ? quad.buf : quad.dst;
+            Mat &img1 = (depths_[q] & 1) ? quad.dst : quad.buf;
+            int i = (int)(std::upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin()) - 1;
+            for (int line = begin; line < end; i++)
+            {
+                const FHTStep &step = steps[i];
+                int32_t s = line - offsets[i];
+                int32_t stop = std::min(end - offsets[i], step.h);
+                if (step.h == 1)
+                    fhtCopyLine(img0, img1, step.y0, step.level, quad.aspl);
+                else
+                {
+                    for (; s < stop; s++)
+                        fhtCombineLine<T, OP>(img0, img1, step, s, quad.isPositiveShift, quad.aspl);
+                }
+                line = offsets[i] + stop;
+            }
+        }
+    }
+
+private:
+    FHTQuadrant *quads_;
+    const int   *depths_;
+    int          nquads_;
+};
+
+// runs the transforms of all the quadrants concurrently, aligning their
+// recursions on the deepest level
+template <typename T, HoughOp OP>
+static void fhtQuadrantsT(FHTQuadrant *quads, int nquads)
+{
+    int maxDepth = 0;
+    for (int q = 0; q < nquads; q++)
+        maxDepth = std::max(maxDepth, quads[q].schedule->depth());
+
+    int depths[4];
+    for (int t = 0; t < maxDepth; t++)
+    {
+        int lines = 0;
+        double work = 0;
+        for (int q = 0; q < nquads; q++)
+        {
+            depths[q] = quads[q].schedule->depth() - 1 - t;
+            if (depths[q] < 0)
+                continue;
+            int qlines = quads[q].schedule->lines(depths[q]);
+            lines += qlines;
+            work += (double)qlines * quads[q].dst.cols * quads[q].dst.channels();
+        }
+        parallel_for_(Range(0, lines), FHTDepthInvoker<T, OP>(quads, depths, nquads),
+                      work / (1 << 16));
+    }
 }
 
-template <typename T, int D>
-void fhtVo(Mat    &img0,
-           Mat    &img1,
-           bool    isPositiveShift,
-           int     operation,
-           double  aspl)
+template <typename T>
+static void fhtQuadrantsT(FHTQuadrant *quads, int nquads, int operation)
 {
     switch (operation)
     {
     case FHT_ADD:
-        fhtVoT<T, D, FHT_ADD>(img0, img1, isPositiveShift, aspl);
+        fhtQuadrantsT<T, FHT_ADD>(quads, nquads);
         break;
     case FHT_AVE:
-        fhtVoT<T, D, FHT_AVE>(img0, img1, isPositiveShift, aspl);
+        fhtQuadrantsT<T, FHT_AVE>(quads, nquads);
         break;
     case FHT_MAX:
-        fhtVoT<T, D, FHT_MAX>(img0, img1, isPositiveShift, aspl);
+        fhtQuadrantsT<T, FHT_MAX>(quads, nquads);
         break;
     case FHT_MIN:
-        fhtVoT<T, D, FHT_MIN>(img0, img1, isPositiveShift, aspl);
+        fhtQuadrantsT<T, FHT_MIN>(quads, nquads);
         break;
     default:
         CV_Error_(Error::StsNotImplemented, ("Unknown operation %d", operation));
@@ -243,35 +441,31 @@ void fhtVo(Mat    &img0,
     }
 }
 
-static void fhtVo(Mat    &img0,
-                  Mat    &img1,
-                  bool    isPositiveShift,
-                  int     operation,
-                  double  aspl)
+static void fhtQuadrants(FHTQuadrant *quads, int nquads, int operation)
 {
-    int const depth = img0.depth();
+    int const depth = quads[0].dst.depth();
     switch (depth)
     {
     case CV_8U:
-        fhtVo<uchar, CV_8UC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtQuadrantsT<uchar>(quads, nquads, operation);
         break;
     case CV_8S:
-        fhtVo<schar, CV_8SC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtQuadrantsT<schar>(quads, nquads, operation);
         break;
     case CV_16U:
-        fhtVo<ushort, CV_16UC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtQuadrantsT<ushort>(quads, nquads, operation);
         break;
     case CV_16S:
-        fhtVo<short, CV_16SC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtQuadrantsT<short>(quads, nquads, operation);
         break;
     case CV_32S:
-        fhtVo<int, CV_32SC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtQuadrantsT<int>(quads, nquads, operation);
         break;
     case CV_32F:
-        fhtVo<float, CV_32FC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtQuadrantsT<float>(quads, nquads, operation);
         break;
     case CV_64F:
-        fhtVo<double, CV_64FC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtQuadrantsT<double>(quads, nquads, operation);
         break;
     default:
         CV_Error_(Error::StsNotImplemented, ("Unknown depth %d", depth));
@@ -279,43 +473,14 @@ static void fhtVo(Mat    &img0,
     }
 }
 
-static void FHT(Mat       &dst,
-                const Mat &src,
-                int        operation,
-                bool       isVertical,
-                bool       isClockwise,
-                double     aspl)
-{
-    CV_Assert(dst.cols > 0 && dst.rows > 0);
-    CV_Assert(src.channels() == dst.channels());
-    if (isVertical)
-        CV_Assert(src.cols == dst.cols && src.rows == dst.rows);
-    else
-        CV_Assert(src.cols == dst.rows && src.rows == dst.cols);
-
-    int level = 0;
-    for (int thres = 1; dst.rows > thres; thres <<= 1)
-        level++;
-
-    Mat tmp;
-    src.convertTo(tmp, dst.type());
-    if (!isVertical)
-        transpose(tmp, tmp);
-    tmp.copyTo(dst);
-
-    fhtVo(dst, tmp,
-          isVertical ? isClockwise : !isClockwise,
-          operation, aspl);
-}
-
-static void calculateFHTQuadrant(Mat       &dst,
-                                 const Mat &src,
-                                 int        operation,
-                                 int        quadrant)
+static void getFHTQuadrantParams(int     quadrant,
+                                 bool   &isVertical,
+                                 bool   &isPositiveShift,
+                                 double &aspl)
 {
     bool bVert = true;
     bool bClock = true;
-    double aspl = 0.0;
+    aspl = 0.0;
     switch (quadrant)
     {
     case ARO_315_0:
@@ -348,7 +513,8 @@ static void calculateFHTQuadrant(Mat       &dst,
         CV_Error_(Error::StsNotImplemented, ("Unknown quadrant %d", quadrant));
     }
 
-  FHT(dst, src, operation, bVert, bClock, aspl);
+    isVertical = bVert;
+    isPositiveShift = bVert ? bClock : !bClock;
 }
 
 static void createDstFhtMat(OutputArray dst,
@@ -416,7 +582,7 @@ static void createFHTSrc(Mat       &srcFull,
 
     int wd = verticalTiling ? src.cols : src.cols + src.rows;
     int ht = verticalTiling ? src.cols + src.rows : src.rows;
-    srcFull = Mat(ht, wd, src.type());
+    srcFull.create(ht, wd, src.type());
 
     Mat imgReg;
     if (verticalTiling)
@@ -545,6 +711,55 @@ static void skewQuadrant(Mat         &quad,
     }
 }
 
+// the image buffers of a workspace are released after the call when they
+// take more than this, so that a thread does not hold the buffers of a
+// large image for the rest of the process
+static const size_t maxFHTWorkspaceBytes = (size_t)32 << 20;
+
+// intermediate buffers of FastHoughTransform, kept between the calls made
+// from the same thread
+struct FHTWorkspace
+{
+    Mat srcFull[2];             // vertically and horizontally tiled sources
+    Mat srcConverted[2];        // ... converted to the destination type
+    Mat converted;
+    Mat buf[4];
+    std::vector<uchar> skewBuf[4];
+    FHTSchedule schedule[2];    // for vertical and horizontal quadrants
+
+    size_t imageBytes() const
+    {
+        size_t bytes = converted.total() * converted.elemSize();
+        for (int v = 0; v < 2; v++)
+            bytes += srcFull[v].total() * srcFull[v].elemSize() +
+                     srcConverted[v].total() * srcConverted[v].elemSize();
+        for (int q = 0; q < 4; q++)
+            bytes += buf[q].total() * buf[q].elemSize() + skewBuf[q].size();
+        return bytes;
+    }
+
+    void releaseImages()
+    {
+        converted.release();
+        for (int v = 0; v < 2; v++)
+        {
+            srcFull[v].release();
+            srcConverted[v].release();
+        }
+        for (int q = 0; q < 4; q++)
+        {
+            buf[q].release();
+            std::vector<uchar>().swap(skewBuf[q]);
+        }
+    }
+};
+
+static FHTWorkspace &getFHTWorkspace()
+{
+    static TLSData<FHTWorkspace> workspace;
+    return *workspace.get();
+}
+
 void FastHoughTransform(InputArray  src,
                         OutputArray dst,
                         int         dstMatDepth,
@@ -560,112 +775,118 @@ void FastHoughTransform(InputArray  src,
     createDstFhtMat(dst, src, dstMatDepth, angleRange);
     Mat dstMat = dst.getMat();
 
-    Mat imgRegDst;
     const int len = dstMat.cols * static_cast<int>(dstMat.elemSize());
     CV_Assert(len > 0);
-    std::vector<uchar> buf_(len);
-    uchar *buf(&buf_[0]);
-
-    if (angleRange == ARO_315_135)
-    {
-        {
-            Mat imgSrc;
-            createFHTSrc(imgSrc, srcMat, ARO_315_45);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_315_0, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0);
-            flip(imgRegDst, imgRegDst, 0);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_315_0);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_0_45, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_0_45);
-        }
-        {
-            Mat imgSrc;
-            createFHTSrc(imgSrc, srcMat, ARO_45_135);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_45_90, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90);
-            flip(imgRegDst, imgRegDst, 0);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_45_90);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_90_135, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_90_135);
-        }
-        return;
-    }
-
-    Mat imgSrc;
-    createFHTSrc(imgSrc, srcMat, angleRange);
 
+    int quadrants[4];
+    int nquads = 0;
+    bool subRegions = true;
     switch (angleRange)
     {
     case ARO_315_0:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
     case ARO_0_45:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
     case ARO_45_90:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
     case ARO_90_135:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_315_45:
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_315_0, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0);
-        flip(imgRegDst, imgRegDst, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_315_0);
-
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_0_45, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_0_45);
-        return;
-    case ARO_45_135:
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_45_90, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90);
-        flip(imgRegDst, imgRegDst, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_45_90);
-
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_90_135, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_90_135);
-        return;
     case ARO_CTR_VER:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
     case ARO_CTR_HOR:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
+        quadrants[nquads++] = angleRange;
+        subRegions = false;
+        break;
+    case ARO_315_45:
+        quadrants[nquads++] = ARO_315_0;
+        quadrants[nquads++] = ARO_0_45;
+        break;
+    case ARO_45_135:
+        quadrants[nquads++] = ARO_45_90;
+        quadrants[nquads++] = ARO_90_135;
+        break;
+    case ARO_315_135:
+        quadrants[nquads++] = ARO_315_0;
+        quadrants[nquads++] = ARO_0_45;
+        quadrants[nquads++] = ARO_45_90;
+        quadrants[nquads++] = ARO_90_135;
+        break;
     default:
         CV_Error_(Error::StsNotImplemented, ("Unknown angleRange %d", angleRange));
     }
+
+    FHTWorkspace &ws = getFHTWorkspace();
+    FHTQuadrant quads[4];
+    bool usedSrc[2] = { false, false };
+    for (int q = 0; q < nquads; q++)
+    {
+        FHTQuadrant &quad = quads[q];
+        quad.quadrant = quadrants[q];
+        getFHTQuadrantParams(quad.quadrant, quad.isVertical, quad.isPositiveShift, quad.aspl);
+        const int v = quad.isVertical ? 0 : 1;
+        usedSrc[v] = true;
+        quad.src = &ws.srcFull[v];
+        quad.schedule = &ws.schedule[v];
+        if (subRegions)
+            setFHTDstRegion(quad.dst, dstMat, srcMat, quad.quadrant, angleRange);
+        else
+            quad.dst = dstMat;
+    }
+
+    // the sources of the quadrants, oriented and converted to the
+    // destination type, are shared by the quadrants of the same direction
+    for (int v = 0; v < 2; v++)
+    {
+        if (!usedSrc[v])
+            continue;
+        Mat &srcFull = ws.srcFull[v];
+        createFHTSrc(srcFull, srcMat, v == 0 ? ARO_315_45 : ARO_45_135);
+        Mat &converted = ws.srcConverted[v];
+        if (v == 0)
+        {
+            if (srcFull.type() == dstMat.type())
+                converted = srcFull;
+            else
+                srcFull.convertTo(converted, dstMat.type());
+        }
+        else if (srcFull.depth() == dstMat.depth())
+            transpose(srcFull, converted);
+        else
+        {
+            srcFull.convertTo(ws.converted, dstMat.type());
+            transpose(ws.converted, converted);
+        }
+        ws.schedule[v].create(converted.rows);
+    }
+
+    parallel_for_(Range(0, nquads), [&](const Range &range)
+    {
+        for (int q = range.start; q < range.end; q++)
+        {
+            FHTQuadrant &quad = quads[q];
+            const Mat &converted = ws.srcConverted[quad.isVertical ? 0 : 1];
+            CV_Assert(converted.size() == quad.dst.size());
+            converted.copyTo(quad.dst);
+            converted.copyTo(ws.buf[q]);
+            quad.buf = ws.buf[q];
+        }
+    });
+
+    fhtQuadrants(quads, nquads, operation);
+
+    for (int q = 0; q < nquads; q++)
+        ws.skewBuf[q].resize(len);
+
+    parallel_for_(Range(0, nquads), [&](const Range &range)
+    {
+        for (int q = range.start; q < range.end; q++)
+        {
+            FHTQuadrant &quad = quads[q];
+            if (quad.quadrant == ARO_315_0 || quad.quadrant == ARO_45_90 ||
+                quad.quadrant == ARO_CTR_VER)
+                flip(quad.dst, quad.dst, 0);
+            if (HDO_DESKEW == makeSkew)
+                skewQuadrant(quad.dst, *quad.src, &ws.skewBuf[q][0], quad.quadrant);
+        }
+    });
+
+    if (ws.imageBytes() > maxFHTWorkspaceBytes)
+        ws.releaseImages();
 }
 
 //-----------------------------------------------------------------------------
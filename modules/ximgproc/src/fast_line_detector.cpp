@@ -3,6 +3,8 @@
 // of this distribution and at http://opencv.org/license.html.
 
 #include "precomp.hpp"
+#include <algorithm>
+#include <iterator>
 #include <vector>
 #include <iostream>
 
@@ -11,6 +13,65 @@ struct SEGMENT
     float x1, y1, x2, y2, angle;
 };
 
+// Edge pixel chains traced in a horizontal stripe of the edge map. The points of all the
+// chains of a stripe are stored one after another in a single buffer.
+struct EDGE_CHAINS
+{
+    std::vector<cv::Point2i> points;
+    std::vector<int> offsets;       // chain i is points[offsets[i]] ... points[offsets[i + 1] - 1]
+    std::vector<float> directions;  // tracing direction at the last point of each chain
+    std::vector<int> steps;         // number of tracing steps of each chain
+
+    void clear()
+    {
+        points.clear();
+        offsets.assign(1, 0);
+        directions.clear();
+        steps.clear();
+    }
+    int size() const { return (int)offsets.size() - 1; }
+};
+
+// Chains ending on a stripe border, continued by chains of the stripe below. The chains of
+// all the stripes are numbered one after another.
+struct CHAIN_LINKS
+{
+    std::vector<int> first;         // number of the first chain of each stripe
+    std::vector<int> next;          // chain appended after each chain, or -1
+    std::vector<uchar> appended;    // whether each chain was appended to another chain
+    std::vector<uchar> reversed;    // whether each chain was appended from its last point
+    std::vector<float> directions;  // tracing direction and number of tracing steps at the
+    std::vector<int> steps;         // end of the linked chains ending with each chain
+};
+
+// index of the step (dy, dx) between neighbour pixels in the table of getPointChain(),
+// with the same wrapping to [-3, 4]
+static inline int chainDirection(int dy, int dx)
+{
+    static const int directions[3][3] = { { 4, -3, -2 }, { 3, 0, -1 }, { 2, 1, 0 } };
+    return directions[dy + 1][dx + 1];
+}
+
+// homogeneous line through (x1, y1) and (x2, y2), normalized so that l . (x, y, 1) is
+// the signed distance of (x, y) to the line
+static inline void lineThroughPoints(double x1, double y1, double x2, double y2, double l[3])
+{
+    l[0] = y1 - y2;
+    l[1] = x2 - x1;
+    l[2] = x1 * y2 - y1 * x2;
+    double w = sqrt(l[0] * l[0] + l[1] * l[1]);
+    l[0] /= w;
+    l[1] /= w;
+    l[2] /= w;
+}
+
+static inline void cross3(const double a[3], const double b[3], double c[3])
+{
+    c[0] = a[1] * b[2] - a[2] * b[1];
+    c[1] = a[2] * b[0] - a[0] * b[2];
+    c[2] = a[0] * b[1] - a[1] * b[0];
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////
 
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -38,18 +99,36 @@ class FastLineDetectorImpl : public FastLineDetector
         bool do_merge;
 
         FastLineDetectorImpl& operator= (const FastLineDetectorImpl&); // to quiet MSVC
+        // chains are traced in stripes of this many rows (at least) and then linked
+        enum { CHAIN_STRIPE_ROWS = 64 };
+        std::vector<EDGE_CHAINS> stripe_chains;
+        CHAIN_LINKS links;
+        std::vector<int> border_ends;
+        std::vector<Point2i> linked_points;
+        std::vector<Vec3i> chain_refs;  // stripe (-1: linked_points), offset, size of each chain
+        std::vector<std::vector<SEGMENT> > chain_segments;
+
         template<class T>
-            void incidentPoint(const Mat& l, T& pt);
+            void incidentPoint(const double l[3], T& pt);
 
         void mergeLines(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged);
 
         bool mergeSegments(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged);
 
-        bool getPointChain(const Mat& img, Point pt, Point& chained_pt, float& direction, int step);
+        bool getPointChain(const Mat& img, const Range& rows, Point pt, Point& chained_pt,
+                float& direction, int step);
+
+        void traceChains(Mat& img, const Range& rows, EDGE_CHAINS& chains);
+
+        void linkChains(int stripe, int border_row);
+
+        const Point2i* chainPoints(int chain, int& size) const;
 
-        double distPointLine(const Mat& p, Mat& l);
+        void fitLineToPoints(const Point2i* points, int count, double l[3]);
 
-        void extractSegments(const std::vector<Point2i>& points, std::vector<SEGMENT>& segments);
+        void extractSegments(const Point2i* points, int total, std::vector<SEGMENT>& segments);
+
+        void filterSegments(const Mat& src, std::vector<SEGMENT>& segments);
 
         void lineDetection(const Mat& src, std::vector<SEGMENT>& segments_all);
 
@@ -221,40 +300,11 @@ void FastLineDetectorImpl::mergeLines(const SEGMENT& seg1, const SEGMENT& seg2,
     seg_merged.y2 = (float)delta2y;
 }
 
-double FastLineDetectorImpl::distPointLine(const Mat& p, Mat& l)
-{
-    double x = l.at<double>(0,0);
-    double y = l.at<double>(1,0);
-    double w = sqrt(x*x+y*y);
-
-    l.at<double>(0,0) = x / w;
-    l.at<double>(1,0) = y / w;
-    l.at<double>(2,0) = l.at<double>(2,0) / w;
-
-    return l.dot(p);
-}
-
 bool FastLineDetectorImpl::mergeSegments(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged)
 {
-    double o[] = { 0.0, 0.0, 1.0 };
-    double a[] = { 0.0, 0.0, 1.0 };
-    double b[] = { 0.0, 0.0, 1.0 };
-    double c[3];
-
-    o[0] = ( seg2.x1 + seg2.x2 ) / 2.0;
-    o[1] = ( seg2.y1 + seg2.y2 ) / 2.0;
-
-    a[0] = seg1.x1;
-    a[1] = seg1.y1;
-    b[0] = seg1.x2;
-    b[1] = seg1.y2;
-
-    Mat ori = Mat(3, 1, CV_64FC1, o).clone();
-    Mat p1 = Mat(3, 1, CV_64FC1, a).clone();
-    Mat p2 = Mat(3, 1, CV_64FC1, b).clone();
-    Mat l1 = Mat(3, 1, CV_64FC1, c).clone();
-
-    l1 = p1.cross(p2);
+    double o[] = { ( seg2.x1 + seg2.x2 ) / 2.0, ( seg2.y1 + seg2.y2 ) / 2.0 };
+    double l1[3];
+    lineThroughPoints(seg1.x1, seg1.y1, seg1.x2, seg1.y2, l1);
 
     Point2f seg1mid, seg2mid;
     seg1mid.x = (seg1.x1 + seg1.x2) /2.0f;
@@ -267,7 +317,7 @@ bool FastLineDetectorImpl::mergeSegments(const SEGMENT& seg1, const SEGMENT& seg
     float middist = sqrt((seg1mid.x - seg2mid.x)*(seg1mid.x - seg2mid.x) + (seg1mid.y - seg2mid.y)*(seg1mid.y - seg2mid.y));
     float angdiff = fabs(seg1.angle - seg2.angle);
 
-    float dist = (float)distPointLine(ori, l1);
+    float dist = (float)(l1[0] * o[0] + l1[1] * o[1] + l1[2]);
 
     if ( fabs( dist ) <= threshold_dist * 2.0f && middist <= seg1len / 2.0f + seg2len / 2.0f + 20.0f
             && angdiff <= CV_PI / 180.0f * 5.0f)
@@ -282,142 +332,84 @@ bool FastLineDetectorImpl::mergeSegments(const SEGMENT& seg1, const SEGMENT& seg
 }
 
 template<class T>
-    void FastLineDetectorImpl::incidentPoint(const Mat& l, T& pt)
+    void FastLineDetectorImpl::incidentPoint(const double l[3], T& pt)
     {
-        double a[] = { (double)pt.x, (double)pt.y, 1.0 };
-        double b[] = { l.at<double>(0,0), l.at<double>(1,0), 0.0 };
-        double c[3];
+        double xk[] = { (double)pt.x, (double)pt.y, 1.0 };
+        double lh[] = { l[0], l[1], 0.0 };
+        double lk[3];
 
-        Mat xk = Mat(3, 1, CV_64FC1, a).clone();
-        Mat lh = Mat(3, 1, CV_64FC1, b).clone();
-        Mat lk = Mat(3, 1, CV_64FC1, c).clone();
+        cross3(xk, lh, lk);
+        cross3(lk, l, xk);
 
-        lk = xk.cross(lh);
-        xk = lk.cross(l);
-
-        xk.convertTo(xk, -1, 1.0 / xk.at<double>(2,0));
+        double scale = 1.0 / xk[2];
+        float x = (float)(xk[0] * scale);
+        float y = (float)(xk[1] * scale);
 
         Point2f pt_tmp;
-        pt_tmp.x = (float)xk.at<double>(0,0) < 0.0f ? 0.0f : (float)xk.at<double>(0,0)
-            >= (imagewidth - 1.0f) ? (imagewidth - 1.0f) : (float)xk.at<double>(0,0);
-        pt_tmp.y = (float)xk.at<double>(1,0) < 0.0f ? 0.0f : (float)xk.at<double>(1,0)
-            >= (imageheight - 1.0f) ? (imageheight - 1.0f) : (float)xk.at<double>(1,0);
+        pt_tmp.x = x < 0.0f ? 0.0f : x >= (imagewidth - 1.0f) ? (imagewidth - 1.0f) : x;
+        pt_tmp.y = y < 0.0f ? 0.0f : y >= (imageheight - 1.0f) ? (imageheight - 1.0f) : y;
         pt = T(pt_tmp);
     }
 
-void FastLineDetectorImpl::extractSegments(const std::vector<Point2i>& points, std::vector<SEGMENT>& segments)
+void FastLineDetectorImpl::fitLineToPoints(const Point2i* points, int count, double l[3])
 {
-    bool is_line;
+    Vec4f line;
+    fitLine(Mat(count, 1, CV_32SC2, (void*)points), line, DIST_L2, 0, 0.01, 0.01);
+    lineThroughPoints(line[2], line[3], line[2] + line[0], line[3] + line[1], l);
+}
 
+void FastLineDetectorImpl::extractSegments(const Point2i* points, int total, std::vector<SEGMENT>& segments)
+{
     int i, j;
     SEGMENT seg;
-    Point2i ps, pe, pt;
-
-    std::vector<Point2i> l_points;
-
-    int total = (int)points.size();
+    Point2i ps, pe;
+    double l[3];
 
     for ( i = 0; i + threshold_length < total; i++ )
     {
         ps = points[i];
         pe = points[i + threshold_length];
 
-        double a[] = { (double)ps.x, (double)ps.y, 1 };
-        double b[] = { (double)pe.x, (double)pe.y, 1 };
-        double c[3], d[3];
-
-        Mat p1 = Mat(3, 1, CV_64FC1, a).clone();
-        Mat p2 = Mat(3, 1, CV_64FC1, b).clone();
-        Mat p = Mat(3, 1, CV_64FC1, c).clone();
-        Mat l = Mat(3, 1, CV_64FC1, d).clone();
-        l = p1.cross(p2);
-
-        is_line = true;
-
-        l_points.clear();
-        l_points.push_back(ps);
+        lineThroughPoints(ps.x, ps.y, pe.x, pe.y, l);
 
+        bool is_line = true;
         for ( j = 1; j < threshold_length; j++ )
         {
-            pt.x = points[i+j].x;
-            pt.y = points[i+j].y;
-
-            p.at<double>(0,0) = (double)pt.x;
-            p.at<double>(1,0) = (double)pt.y;
-            p.at<double>(2,0) = 1.0;
-
-            double dist = distPointLine(p, l);
-
-            if ( fabs( dist ) > threshold_dist )
+            const Point2i& pt = points[i + j];
+            if ( fabs( l[0] * pt.x + l[1] * pt.y + l[2] ) > threshold_dist )
             {
                 is_line = false;
                 break;
             }
-            l_points.push_back(pt);
         }
 
         // Line check fail, test next point
         if ( is_line == false )
             continue;
 
-        l_points.push_back(pe);
-
-        Vec4f line;
-        fitLine( Mat(l_points), line, DIST_L2, 0, 0.01, 0.01);
-        a[0] = line[2];
-        a[1] = line[3];
-        b[0] = line[2] + line[0];
-        b[1] = line[3] + line[1];
-
-        p1 = Mat(3, 1, CV_64FC1, a).clone();
-        p2 = Mat(3, 1, CV_64FC1, b).clone();
-
-        l = p1.cross(p2);
+        // the points of the line are always points[i] ... points[i + count - 1]
+        int count = threshold_length + 1;
+        fitLineToPoints(points + i, count, l);
 
         incidentPoint(l, ps);
 
         // Extending line
         for ( j = threshold_length + 1; i + j < total; j++ )
         {
-            pt.x = points[i+j].x;
-            pt.y = points[i+j].y;
-
-            p.at<double>(0,0) = (double)pt.x;
-            p.at<double>(1,0) = (double)pt.y;
-            p.at<double>(2,0) = 1.0;
+            const Point2i& pt = points[i + j];
 
-            double dist = distPointLine(p, l);
-            if ( fabs( dist ) > threshold_dist )
+            if ( fabs( l[0] * pt.x + l[1] * pt.y + l[2] ) > threshold_dist )
             {
-                fitLine( Mat(l_points), line, DIST_L2, 0, 0.01, 0.01);
-                a[0] = line[2];
-                a[1] = line[3];
-                b[0] = line[2] + line[0];
-                b[1] = line[3] + line[1];
-
-                p1 = Mat(3, 1, CV_64FC1, a).clone();
-                p2 = Mat(3, 1, CV_64FC1, b).clone();
-
-                l = p1.cross(p2);
-                dist = distPointLine(p, l);
-                if ( fabs( dist ) > threshold_dist ) {
+                fitLineToPoints(points + i, count, l);
+                if ( fabs( l[0] * pt.x + l[1] * pt.y + l[2] ) > threshold_dist ) {
                     j--;
                     break;
                 }
             }
             pe = pt;
-            l_points.push_back(pt);
+            count++;
         }
-        fitLine( Mat(l_points), line, DIST_L2, 0, 0.01, 0.01);
-        a[0] = line[2];
-        a[1] = line[3];
-        b[0] = line[2] + line[0];
-        b[1] = line[3] + line[1];
-
-        p1 = Mat(3, 1, CV_64FC1, a).clone();
-        p2 = Mat(3, 1, CV_64FC1, b).clone();
-
-        l = p1.cross(p2);
+        fitLineToPoints(points + i, count, l);
 
         Point2f e1, e2;
         e1.x = (float)ps.x;
@@ -443,7 +435,7 @@ void FastLineDetectorImpl::pointInboardTest(const Size srcSize, Point2i& pt)
     pt.y = pt.y <= 5 ? 5 : pt.y >= srcSize.height - 5 ? srcSize.height - 5 : pt.y;
 }
 
-bool FastLineDetectorImpl::getPointChain(const Mat& img, Point pt,
+bool FastLineDetectorImpl::getPointChain(const Mat& img, const Range& rows, Point pt,
         Point& chained_pt, float& direction, int step)
 {
     int ri, ci;
@@ -458,7 +450,7 @@ bool FastLineDetectorImpl::getPointChain(const Mat& img, Point pt,
         ci = pt.x + indices[i][1];
         ri = pt.y + indices[i][0];
 
-        if ( ri < 0 || ri == img.rows || ci < 0 || ci == img.cols )
+        if ( ri < rows.start || ri >= rows.end || ci < 0 || ci == img.cols )
             continue;
 
         if ( img.at<unsigned char>(ri, ci) == 0 )
@@ -497,17 +489,176 @@ bool FastLineDetectorImpl::getPointChain(const Mat& img, Point pt,
     return false;
 }
 
+void FastLineDetectorImpl::traceChains(Mat& img, const Range& rows, EDGE_CHAINS& chains)
+{
+    chains.clear();
+    for ( int r = rows.start; r < rows.end; r++ )
+    {
+        for ( int c = 0; c < img.cols; c++ )
+        {
+            // Find seeds - skip for non-seeds
+            if ( img.at<unsigned char>(r,c) == 0 )
+                continue;
+
+            // Found seeds
+            Point2i pt = Point2i(c,r);
+
+            chains.points.push_back(pt);
+            img.at<unsigned char>(pt.y, pt.x) = 0;
+
+            float direction = 0.0f;
+            int step = 0;
+            while(getPointChain(img, rows, pt, pt, direction, step))
+            {
+                chains.points.push_back(pt);
+                step++;
+                img.at<unsigned char>(pt.y, pt.x) = 0;
+            }
+            chains.offsets.push_back((int)chains.points.size());
+            chains.directions.push_back(direction);
+            chains.steps.push_back(step);
+        }
+    }
+}
+
+const Point2i* FastLineDetectorImpl::chainPoints(int chain, int& size) const
+{
+    int stripe = (int)(std::upper_bound(links.first.begin(), links.first.end(), chain) - links.first.begin()) - 1;
+    const EDGE_CHAINS& chains = stripe_chains[stripe];
+    int i = chain - links.first[stripe];
+    size = chains.offsets[i + 1] - chains.offsets[i];
+    return &chains.points[chains.offsets[i]];
+}
+
+void FastLineDetectorImpl::linkChains(int stripe, int border_row)
+{
+    static const int indices[8][2] = { {1,1}, {1,0}, {1,-1}, {0,-1},
+        {-1,-1},{-1,0}, {-1,1}, {0,1} };
+    const EDGE_CHAINS& upper = stripe_chains[stripe];
+    const EDGE_CHAINS& lower = stripe_chains[stripe + 1];
+    const int upper_first = links.first[stripe], lower_first = links.first[stripe + 1];
+
+    // ends of the chains of the lower stripe lying on its first row: 2 * chain + 1 if it is
+    // the last point of the chain, 2 * chain otherwise
+    border_ends.assign(imagewidth, -1);
+    for ( int k = 0; k < lower.size(); k++ )
+    {
+        const Point2i& last = lower.points[lower.offsets[k + 1] - 1];
+        if ( last.y == border_row )
+            border_ends[last.x] = 2 * k + 1;
+        const Point2i& first = lower.points[lower.offsets[k]];
+        if ( first.y == border_row )
+            border_ends[first.x] = 2 * k;
+    }
+
+    // Continue the chains stopped by the border as they would have been traced without it,
+    // older chains (appended to chains from the stripes above) first.
+    for ( int pass = 0; pass < 2; pass++ )
+    {
+        for ( int i = 0; i < upper.size(); i++ )
+        {
+            int chain = upper_first + i;
+            if ( links.appended[chain] != (pass == 0) || links.next[chain] >= 0 )
+                continue;
+
+            int size;
+            const Point2i* points = chainPoints(chain, size);
+            Point2i tail = links.reversed[chain] ? points[0] : points[size - 1];
+            if ( tail.y != border_row - 1 )
+                continue;
+
+            float direction = links.directions[chain];
+            int step = links.steps[chain];
+            for ( ;; )
+            {
+                // same choice as getPointChain()
+                int best = -1, best_direction = 0;
+                float min_dir_diff = 7.0f;
+                for ( int n = 0; n < 8; n++ )
+                {
+                    int ri = tail.y + indices[n][0], ci = tail.x + indices[n][1];
+                    if ( ri != border_row || ci < 0 || ci >= imagewidth )
+                        continue;
+                    int end = border_ends[ci];
+                    if ( end < 0 || links.appended[lower_first + end / 2] )
+                        continue;
+
+                    int curr_dir = n > 4 ? n - 8 : n;
+                    float dir_diff = abs((float)curr_dir - direction);
+                    dir_diff = dir_diff > 4.0f ? 8.0f - dir_diff : dir_diff;
+                    if ( step == 0 || dir_diff <= min_dir_diff )
+                    {
+                        min_dir_diff = step == 0 ? 0.0f : dir_diff;
+                        best = end;
+                        best_direction = curr_dir;
+                        if ( step == 0 )
+                            break;
+                    }
+                }
+                if ( best < 0 || min_dir_diff >= 2.0f )
+                    break;
+
+                int next = lower_first + best / 2;
+                bool reversed = (best & 1) != 0;
+                links.next[chain] = next;
+                links.appended[next] = 1;
+                links.reversed[next] = reversed;
+
+                points = chainPoints(next, size);
+                direction = (direction * (float)step + (float)best_direction) / (float)(step + 1);
+                step++;
+                for ( int j = 1; j < size; j++ )
+                {
+                    Point2i a = reversed ? points[size - j] : points[j - 1];
+                    Point2i b = reversed ? points[size - j - 1] : points[j];
+                    direction = (direction * (float)step + (float)chainDirection(b.y - a.y, b.x - a.x))
+                        / (float)(step + 1);
+                    step++;
+                }
+                links.directions[next] = direction;
+                links.steps[next] = step;
+
+                chain = next;
+                tail = reversed ? points[0] : points[size - 1];
+                // only the chains starting or ending along the border can be continued
+                if ( tail.y != border_row )
+                    break;
+            }
+        }
+    }
+}
+
+void FastLineDetectorImpl::filterSegments(const Mat& src, std::vector<SEGMENT>& segments)
+{
+    size_t nkept = 0;
+    for ( size_t i = 0; i < segments.size(); i++ )
+    {
+        SEGMENT seg = segments[i];
+        float length = sqrt((seg.x1 - seg.x2)*(seg.x1 - seg.x2) +
+                (seg.y1 - seg.y2)*(seg.y1 - seg.y2));
+        if(length < threshold_length)
+            continue;
+        if( (seg.x1 <= 5.0f && seg.x2 <= 5.0f) ||
+            (seg.y1 <= 5.0f && seg.y2 <= 5.0f) ||
+            (seg.x1 >= imagewidth - 5.0f && seg.x2 >= imagewidth - 5.0f) ||
+            (seg.y1 >= imageheight - 5.0f && seg.y2 >= imageheight - 5.0f) )
+            continue;
+        additionalOperationsOnSegment(src, seg);
+        segments[nkept++] = seg;
+    }
+    segments.resize(nkept);
+}
+
 void FastLineDetectorImpl::lineDetection(const Mat& src, std::vector<SEGMENT>& segments_all)
 {
-    int r, c;
     imageheight=src.rows; imagewidth=src.cols;
 
-    std::vector<Point2i> points;
-    std::vector<SEGMENT> segments, segments_tmp;
+    std::vector<SEGMENT> segments_tmp;
     Mat canny;
     if (canny_aperture_size == 0)
     {
-        canny = src;
+        // edge pixels are cleared while they are chained
+        src.copyTo(canny);
     }
     else
     {
@@ -516,67 +667,100 @@ void FastLineDetectorImpl::lineDetection(const Mat& src, std::vector<SEGMENT>& s
     canny.colRange(0,6).rowRange(0,6).setTo(cv::Scalar::all(0));
     canny.colRange(src.cols-5,src.cols).rowRange(src.rows-5,src.rows).setTo(cv::Scalar::all(0));
 
-    SEGMENT seg, seg1, seg2;
+    SEGMENT seg1, seg2;
 
-    for ( r = 0; r < imageheight; r++ )
+    // Edge pixels are chained in parallel in horizontal stripes of a fixed height, so that
+    // the result does not depend on the number of threads. A chain stops at the bottom of
+    // its stripe and is then linked to the chains ending next to it in the stripe below.
+    const int nstripes = std::max(imageheight / CHAIN_STRIPE_ROWS, 1);
+    stripe_chains.resize(nstripes);
+    parallel_for_(Range(0, nstripes), [&](const Range& range)
     {
-        for ( c = 0; c < imagewidth; c++ )
-        {
-            // Find seeds - skip for non-seeds
-            if ( canny.at<unsigned char>(r,c) == 0 )
-                continue;
+        for ( int s = range.start; s < range.end; s++ )
+            traceChains(canny, Range(imageheight * s / nstripes, imageheight * (s + 1) / nstripes),
+                    stripe_chains[s]);
+    });
+
+    int nchains = 0;
+    links.first.resize(nstripes);
+    links.directions.clear();
+    links.steps.clear();
+    for ( int s = 0; s < nstripes; s++ )
+    {
+        links.first[s] = nchains;
+        nchains += stripe_chains[s].size();
+        links.directions.insert(links.directions.end(), stripe_chains[s].directions.begin(),
+                stripe_chains[s].directions.end());
+        links.steps.insert(links.steps.end(), stripe_chains[s].steps.begin(), stripe_chains[s].steps.end());
+    }
+    links.next.assign(nchains, -1);
+    links.appended.assign(nchains, 0);
+    links.reversed.assign(nchains, 0);
 
-            // Found seeds
-            Point2i pt = Point2i(c,r);
+    for ( int s = 0; s + 1 < nstripes; s++ )
+        linkChains(s, imageheight * (s + 1) / nstripes);
 
-            points.push_back(pt);
-            canny.at<unsigned char>(pt.y, pt.x) = 0;
+    linked_points.clear();
+    chain_refs.clear();
+    for ( int s = 0; s < nstripes; s++ )
+    {
+        const EDGE_CHAINS& chains = stripe_chains[s];
+        for ( int i = 0; i < chains.size(); i++ )
+        {
+            int chain = links.first[s] + i;
+            if ( links.appended[chain] )
+                continue;
 
-            float direction = 0.0f;
-            int step = 0;
-            while(getPointChain(canny, pt, pt, direction, step))
+            Vec3i ref(s, chains.offsets[i], chains.offsets[i + 1] - chains.offsets[i]);
+            if ( links.next[chain] >= 0 )
             {
-                points.push_back(pt);
-                step++;
-                canny.at<unsigned char>(pt.y, pt.x) = 0;
+                ref = Vec3i(-1, (int)linked_points.size(), 0);
+                for ( ; chain >= 0; chain = links.next[chain] )
+                {
+                    int size;
+                    const Point2i* points = chainPoints(chain, size);
+                    if ( links.reversed[chain] )
+                        linked_points.insert(linked_points.end(), std::reverse_iterator<const Point2i*>(points + size),
+                                std::reverse_iterator<const Point2i*>(points));
+                    else
+                        linked_points.insert(linked_points.end(), points, points + size);
+                }
+                ref[2] = (int)linked_points.size() - ref[1];
             }
+            if ( ref[2] >= threshold_length + 1 )
+                chain_refs.push_back(ref);
+        }
+    }
 
-            if ( points.size() < (unsigned int)threshold_length + 1 )
+    // fit the segments of blocks of chains in parallel
+    const int block_size = 32;
+    nchains = (int)chain_refs.size();
+    const int nblocks = (nchains + block_size - 1) / block_size;
+    chain_segments.resize(nblocks);
+    parallel_for_(Range(0, nblocks), [&](const Range& range)
+    {
+        for ( int b = range.start; b < range.end; b++ )
+        {
+            std::vector<SEGMENT>& segments = chain_segments[b];
+            segments.clear();
+            for ( int c = b * block_size; c < std::min((b + 1) * block_size, nchains); c++ )
             {
-                points.clear();
-                continue;
+                const Vec3i& ref = chain_refs[c];
+                const Point2i* points = ref[0] < 0 ? &linked_points[0] : &stripe_chains[ref[0]].points[0];
+                extractSegments(points + ref[1], ref[2], segments);
             }
+            filterSegments(src, segments);
+        }
+    });
 
-            extractSegments(points, segments);
+    for ( int b = 0; b < nblocks; b++ )
+        segments_tmp.insert(segments_tmp.end(), chain_segments[b].begin(), chain_segments[b].end());
 
-            if ( segments.size() == 0 )
-            {
-                points.clear();
-                continue;
-            }
-            for ( int i = 0; i < (int)segments.size(); i++ )
-            {
-                seg = segments[i];
-                float length = sqrt((seg.x1 - seg.x2)*(seg.x1 - seg.x2) +
-                        (seg.y1 - seg.y2)*(seg.y1 - seg.y2));
-                if(length < threshold_length)
-                    continue;
-                if( (seg.x1 <= 5.0f && seg.x2 <= 5.0f) ||
-                    (seg.y1 <= 5.0f && seg.y2 <= 5.0f) ||
-                    (seg.x1 >= imagewidth - 5.0f && seg.x2 >= imagewidth - 5.0f) ||
-                    (seg.y1 >= imageheight - 5.0f && seg.y2 >= imageheight - 5.0f) )
-                    continue;
-                additionalOperationsOnSegment(src, seg);
-                if(!do_merge)
-                    segments_all.push_back(seg);
-                segments_tmp.push_back(seg);
-            }
-            points.clear();
-            segments.clear();
-        }
-    }
     if(!do_merge)
+    {
+        segments_all.swap(segments_tmp);
         return;
+    }
 
     bool is_merged = false;
     int ith = (int)segments_tmp.size() - 1;
@@ -629,8 +813,8 @@ void FastLineDetectorImpl::additionalOperationsOnSegment(const Mat& src, SEGMENT
     dx = (double) end.x - (double) start.x;
     dy = (double) end.y - (double) start.y;
 
-    int num_points = 10;
-    Point2f *points = new Point2f[num_points];
+    const int num_points = 10;
+    Point2f points[num_points];
 
     points[0] = start;
     points[num_points - 1] = end;
@@ -642,8 +826,8 @@ void FastLineDetectorImpl::additionalOperationsOnSegment(const Mat& src, SEGMENT
         points[i].y = points[0].y + ((float)dy / float(num_points - 1) * (float) i);
     }
 
-    Point2i *points_right = new Point2i[num_points];
-    Point2i *points_left = new Point2i[num_points];
+    Point2i points_right[num_points];
+    Point2i points_left[num_points];
     double gap = 1.0;
 
     for(int i = 0; i < num_points; i++)
@@ -669,12 +853,6 @@ void FastLineDetectorImpl::additionalOperationsOnSegment(const Mat& src, SEGMENT
         std::swap(seg.y1, seg.y2);
         getAngle(seg);
     }
-
-    delete[] points;
-    delete[] points_right;
-    delete[] points_left;
-
-    return;
 }
 
 } // namespace cv
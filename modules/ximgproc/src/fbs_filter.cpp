@@ -40,7 +40,7 @@
 #include <vector>
 #include <memory>
 #include <stdlib.h>
-#include <iostream>
+#include <limits>
 #include <iterator>
 #include <algorithm>
 
@@ -58,19 +58,65 @@
 
 
 
-#if __cplusplus <= 199711L
-    #include <map>
-    typedef std::map<long long /* hash */, int /* vert id */>  mapId;
-#else
-    #include <unordered_map>
-    typedef std::unordered_map<long long /* hash */, int /* vert id */>  mapId;
-#endif
-
 namespace cv
 {
 namespace ximgproc
 {
 
+    /* Open-addressed (linear probing) table from the hash of a bilateral-space
+     * coordinate to the id of the corresponding grid vertex. */
+    class VertexHashTable
+    {
+    public:
+        explicit VertexHashTable(int expected)
+        {
+            size_t capacity = 16;
+            while (capacity < (size_t)expected * 2)
+                capacity <<= 1;
+            mask = capacity - 1;
+            keys.resize(capacity);
+            values.assign(capacity, -1);
+        }
+
+        // returns the vertex stored for "key", or inserts "id" and returns it
+        int insert(long long key, int id)
+        {
+            for (size_t i = slot(key); ; i = (i + 1) & mask)
+            {
+                if (values[i] < 0)
+                {
+                    keys[i] = key;
+                    values[i] = id;
+                    return id;
+                }
+                if (keys[i] == key)
+                    return values[i];
+            }
+        }
+
+        // returns the vertex stored for "key" or -1
+        int find(long long key) const
+        {
+            for (size_t i = slot(key); values[i] >= 0; i = (i + 1) & mask)
+            {
+                if (keys[i] == key)
+                    return values[i];
+            }
+            return -1;
+        }
+
+    private:
+        size_t slot(long long key) const
+        {
+            uint64 h = (uint64)key * CV_BIG_UINT(0x9E3779B97F4A7C15);
+            return (size_t)(h ^ (h >> 32)) & mask;
+        }
+
+        size_t mask;
+        std::vector<long long> keys;
+        std::vector<int> values;
+    };
+
     class FastBilateralSolverFilterImpl : public FastBilateralSolverFilter
     {
     public:
@@ -101,7 +147,6 @@ namespace ximgproc
             }
 
             std::vector<Mat> src_channels;
-            std::vector<Mat> dst_channels;
             if(src.channels()==1)
                 src_channels.push_back(src.getMat());
             else
@@ -109,18 +154,16 @@ namespace ximgproc
 
             Mat conf = confidence.getMat();
 
-            for(int i=0;i<src.channels();i++)
-            {
-                Mat cur_res = src_channels[i].clone();
+            // all channels share the confidence, hence the system matrix: solve them together
+            std::vector<Mat> dst_channels(src_channels.size());
+            for(size_t i=0;i<src_channels.size();i++)
+                dst_channels[i].create(rows, cols, src_channels[i].depth());
 
-                solve(cur_res,conf,cur_res);
-                cur_res.convertTo(cur_res, src.type());
-                dst_channels.push_back(cur_res);
-            }
+            solve(src_channels,conf,dst_channels);
 
-            dst.create(src.size(),src_channels[0].type());
             if(src.channels()==1)
             {
+                dst.create(src.size(),src.type());
                 Mat& dstMat = dst.getMatRef();
                 dstMat = dst_channels[0];
             }
@@ -130,12 +173,12 @@ namespace ximgproc
         }
 
     // protected:
-        void solve(cv::Mat& src, cv::Mat& confidence, cv::Mat& dst);
+        void solve(const std::vector<Mat>& src, const cv::Mat& confidence, std::vector<Mat>& dst);
         void init(cv::Mat& reference, double sigma_spatial, double sigma_luma, double sigma_chroma, double lambda, int num_iter, double max_tol);
 
-        void Splat(Eigen::VectorXf& input, Eigen::VectorXf& dst);
+        void Splat(const float* input, Eigen::VectorXf& dst) const;
         void Blur(Eigen::VectorXf& input, Eigen::VectorXf& dst);
-        void Slice(Eigen::VectorXf& input, Eigen::VectorXf& dst);
+        void Slice(const Eigen::VectorXf& input, Mat& dst) const;
 
         void diagonal(Eigen::VectorXf& v,Eigen::SparseMatrix<float>& mat)
         {
@@ -155,14 +198,22 @@ namespace ximgproc
         int dim;
         int cols;
         int rows;
-        std::vector<int> splat_idx;
+        std::vector<int> splat_idx;                 // pixel -> vertex
+        std::vector<int> vert_pix_ofs, vert_pix;   // vertex -> pixels, in increasing pixel order
         std::vector<std::pair<int, int> > blur_idx;
         Eigen::VectorXf m;
         Eigen::VectorXf n;
+        Eigen::VectorXf counts;                     // number of pixels splatted to each vertex
         Eigen::SparseMatrix<float, Eigen::ColMajor> blurs;
         Eigen::SparseMatrix<float, Eigen::ColMajor> S;
         Eigen::SparseMatrix<float, Eigen::ColMajor> Dn;
         Eigen::SparseMatrix<float, Eigen::ColMajor> Dm;
+        Eigen::SparseMatrix<float, Eigen::ColMajor> A_smooth; // lam * (Dm - Dn * blurs * Dn), fixed by the guide
+
+        // system matrix and Jacobi preconditioner of the last confidence, reused while it does not change
+        Eigen::VectorXf cached_w_splat;
+        Eigen::SparseMatrix<float, Eigen::ColMajor> A;
+        Eigen::VectorXf A_invdiag;
 
         struct grid_params
         {
@@ -206,235 +257,148 @@ namespace ximgproc
         bs_param.cg_maxiter = num_iter;
         bs_param.cg_tol = max_tol;
 
+        cv::Mat reference_yuv;
         if(reference.channels()==1)
         {
             dim = 3;
-            cols = reference.cols;
-            rows = reference.rows;
-            npixels = cols*rows;
-            long long hash_vec[3];
-            for (int i = 0; i < 3; ++i)
-            hash_vec[i] = static_cast<long long>(std::pow(255, i));
-
-            mapId hashed_coords;
-#if __cplusplus <= 199711L
-#else
-            hashed_coords.reserve(cols*rows);
-#endif
-
-            const unsigned char* pref = (const unsigned char*)reference.data;
-            int vert_idx = 0;
-            int pix_idx = 0;
-
-            // construct Splat(Slice) matrices
-            splat_idx.resize(npixels);
-            for (int y = 0; y < rows; ++y)
-            {
-                for (int x = 0; x < cols; ++x)
-                {
-                    long long coord[3];
-                    coord[0] = int(x / sigma_spatial);
-                    coord[1] = int(y / sigma_spatial);
-                    coord[2] = int(pref[0] / sigma_luma);
-
-                    // convert the coordinate to a hash value
-                    long long hash_coord = 0;
-                    for (int i = 0; i < 3; ++i)
-                        hash_coord += coord[i] * hash_vec[i];
-
-                    // pixels whom are alike will have the same hash value.
-                    // We only want to keep a unique list of hash values, therefore make sure we only insert
-                    // unique hash values.
-                    mapId::iterator it = hashed_coords.find(hash_coord);
-                    if (it == hashed_coords.end())
-                    {
-                        hashed_coords.insert(std::pair<long long, int>(hash_coord, vert_idx));
-                        splat_idx[pix_idx] = vert_idx;
-                        ++vert_idx;
-                    }
-                    else
-                    {
-                        splat_idx[pix_idx] = it->second;
-                    }
-
-                    pref += 1; // skip 1 bytes (y)
-                    ++pix_idx;
-                }
-            }
-            nvertices = hashed_coords.size();
-
-            // construct Blur matrices
-            Eigen::VectorXf ones_nvertices = Eigen::VectorXf::Ones(nvertices);
-            diagonal(ones_nvertices,blurs);
-            blurs *= 10;
-            for(int offset = -1; offset <= 1;++offset)
-            {
-                if(offset == 0) continue;
-                for (int i = 0; i < dim; ++i)
-                {
-                    Eigen::SparseMatrix<float, Eigen::ColMajor> blur_temp(hashed_coords.size(), hashed_coords.size());
-                    blur_temp.reserve(Eigen::VectorXi::Constant(nvertices,6));
-                    long long offset_hash_coord = offset * hash_vec[i];
-                    for (mapId::iterator it = hashed_coords.begin(); it != hashed_coords.end(); ++it)
-                    {
-                        long long neighb_coord = it->first + offset_hash_coord;
-                        mapId::iterator it_neighb = hashed_coords.find(neighb_coord);
-                        if (it_neighb != hashed_coords.end())
-                        {
-                            blur_temp.insert(it->second,it_neighb->second) = 1.0f;
-                            blur_idx.push_back(std::pair<int,int>(it->second, it_neighb->second));
-                        }
-                    }
-                    blurs += blur_temp;
-                }
-            }
-            blurs.finalize();
-
-            //bistochastize
-            int maxiter = 10;
-            n = ones_nvertices;
-            m = Eigen::VectorXf::Zero(nvertices);
-            for (int i = 0; i < int(splat_idx.size()); i++)
-            {
-                m(splat_idx[i]) += 1.0f;
-            }
-
-            Eigen::VectorXf bluredn(nvertices);
-
-            for (int i = 0; i < maxiter; i++)
-            {
-                Blur(n,bluredn);
-                n = ((n.array()*m.array()).array()/bluredn.array()).array().sqrt();
-            }
-            Blur(n,bluredn);
-
-            m = n.array() * (bluredn).array();
-            diagonal(m,Dm);
-            diagonal(n,Dn);
-
+            reference_yuv = reference;
         }
         else
         {
             dim = 5;
-            cv::Mat reference_yuv;
             cv::cvtColor(reference, reference_yuv, COLOR_BGR2YCrCb);
+        }
 
-            cols = reference_yuv.cols;
-            rows = reference_yuv.rows;
-            npixels = cols*rows;
-            long long hash_vec[5];
-            for (int i = 0; i < 5; ++i)
+        cols = reference_yuv.cols;
+        rows = reference_yuv.rows;
+        npixels = cols*rows;
+        long long hash_vec[5];
+        for (int i = 0; i < dim; ++i)
             hash_vec[i] = static_cast<long long>(std::pow(255, i));
 
-            mapId hashed_coords;
-#if __cplusplus <= 199711L
-#else
-            hashed_coords.reserve(cols*rows);
-#endif
-
-            const unsigned char* pref = (const unsigned char*)reference_yuv.data;
-            int vert_idx = 0;
-            int pix_idx = 0;
-
-            // construct Splat(Slice) matrices
-            splat_idx.resize(npixels);
-            for (int y = 0; y < rows; ++y)
+        // convert the bilateral-space coordinate of every pixel to a hash value
+        std::vector<long long> pix_hash(npixels);
+        const int cn = reference_yuv.channels();
+        parallel_for_(Range(0, rows), [&](const Range& range)
+        {
+            for (int y = range.start; y < range.end; ++y)
             {
-                for (int x = 0; x < cols; ++x)
+                const unsigned char* pref = reference_yuv.ptr<unsigned char>(y);
+                long long* phash = &pix_hash[(size_t)y*cols];
+                for (int x = 0; x < cols; ++x, pref += cn)
                 {
                     long long coord[5];
                     coord[0] = int(x / sigma_spatial);
                     coord[1] = int(y / sigma_spatial);
                     coord[2] = int(pref[0] / sigma_luma);
-                    coord[3] = int(pref[1] / sigma_chroma);
-                    coord[4] = int(pref[2] / sigma_chroma);
-
-                    // convert the coordinate to a hash value
-                    long long hash_coord = 0;
-                    for (int i = 0; i < 5; ++i)
-                        hash_coord += coord[i] * hash_vec[i];
-
-                    // pixels whom are alike will have the same hash value.
-                    // We only want to keep a unique list of hash values, therefore make sure we only insert
-                    // unique hash values.
-                    mapId::iterator it = hashed_coords.find(hash_coord);
-                    if (it == hashed_coords.end())
-                    {
-                        hashed_coords.insert(std::pair<long long, int>(hash_coord, vert_idx));
-                        splat_idx[pix_idx] = vert_idx;
-                        ++vert_idx;
-                    }
-                    else
+                    if (cn == 3)
                     {
-                        splat_idx[pix_idx] = it->second;
+                        coord[3] = int(pref[1] / sigma_chroma);
+                        coord[4] = int(pref[2] / sigma_chroma);
                     }
 
-                    pref += 3; // skip 3 bytes (y u v)
-                    ++pix_idx;
+                    long long hash_coord = 0;
+                    for (int i = 0; i < dim; ++i)
+                        hash_coord += coord[i] * hash_vec[i];
+                    phash[x] = hash_coord;
                 }
             }
-            nvertices = hashed_coords.size();
+        });
+
+        // pixels whom are alike will have the same hash value.
+        // We only want to keep a unique list of hash values, numbered in order of first appearance.
+        VertexHashTable hashed_coords(npixels);
+        std::vector<long long> vert_hash;
+        splat_idx.resize(npixels);
+        for (int i = 0; i < npixels; ++i)
+        {
+            int vert_idx = hashed_coords.insert(pix_hash[i], (int)vert_hash.size());
+            if (vert_idx == (int)vert_hash.size())
+                vert_hash.push_back(pix_hash[i]);
+            splat_idx[i] = vert_idx;
+        }
+        nvertices = (int)vert_hash.size();
+
+        // group the pixels of each vertex (counting sort keeps them in increasing order)
+        vert_pix_ofs.assign(nvertices + 1, 0);
+        for (int i = 0; i < npixels; ++i)
+            vert_pix_ofs[splat_idx[i] + 1]++;
+        for (int v = 0; v < nvertices; ++v)
+            vert_pix_ofs[v + 1] += vert_pix_ofs[v];
+        vert_pix.resize(npixels);
+        {
+            std::vector<int> fill(vert_pix_ofs.begin(), vert_pix_ofs.end() - 1);
+            for (int i = 0; i < npixels; ++i)
+                vert_pix[fill[splat_idx[i]]++] = i;
+        }
 
-            // construct Blur matrices
-            Eigen::VectorXf ones_nvertices = Eigen::VectorXf::Ones(nvertices);
-            diagonal(ones_nvertices,blurs);
-            blurs *= 10;
-            for(int offset = -1; offset <= 1;++offset)
+        // construct Blur matrices
+        Eigen::VectorXf ones_nvertices = Eigen::VectorXf::Ones(nvertices);
+        std::vector<Eigen::Triplet<float> > blur_triplets;
+        blur_triplets.reserve((size_t)nvertices * (2 * dim + 1));
+        for (int v = 0; v < nvertices; ++v)
+            blur_triplets.push_back(Eigen::Triplet<float>(v, v, 10.0f));
+        blur_idx.clear();
+        for(int offset = -1; offset <= 1;++offset)
+        {
+            if(offset == 0) continue;
+            for (int i = 0; i < dim; ++i)
             {
-                if(offset == 0) continue;
-                for (int i = 0; i < dim; ++i)
+                long long offset_hash_coord = offset * hash_vec[i];
+                for (int v = 0; v < nvertices; ++v)
                 {
-                    Eigen::SparseMatrix<float, Eigen::ColMajor> blur_temp(hashed_coords.size(), hashed_coords.size());
-                    blur_temp.reserve(Eigen::VectorXi::Constant(nvertices,6));
-                    long long offset_hash_coord = offset * hash_vec[i];
-                    for (mapId::iterator it = hashed_coords.begin(); it != hashed_coords.end(); ++it)
+                    int neighb = hashed_coords.find(vert_hash[v] + offset_hash_coord);
+                    if (neighb >= 0)
                     {
-                        long long neighb_coord = it->first + offset_hash_coord;
-                        mapId::iterator it_neighb = hashed_coords.find(neighb_coord);
-                        if (it_neighb != hashed_coords.end())
-                        {
-                            blur_temp.insert(it->second,it_neighb->second) = 1.0f;
-                            blur_idx.push_back(std::pair<int,int>(it->second, it_neighb->second));
-                        }
+                        blur_triplets.push_back(Eigen::Triplet<float>(v, neighb, 1.0f));
+                        blur_idx.push_back(std::pair<int,int>(v, neighb));
                     }
-                    blurs += blur_temp;
                 }
             }
-            blurs.finalize();
+        }
+        blurs = Eigen::SparseMatrix<float, Eigen::ColMajor>(nvertices, nvertices);
+        blurs.setFromTriplets(blur_triplets.begin(), blur_triplets.end());
 
+        //bistochastize
+        int maxiter = 10;
+        n = ones_nvertices;
+        counts.resize(nvertices);
+        for (int v = 0; v < nvertices; ++v)
+            counts(v) = (float)(vert_pix_ofs[v + 1] - vert_pix_ofs[v]);
+        m = counts;
 
-            //bistochastize
-            int maxiter = 10;
-            n = ones_nvertices;
-            m = Eigen::VectorXf::Zero(nvertices);
-            for (int i = 0; i < int(splat_idx.size()); i++)
-            {
-                m(splat_idx[i]) += 1.0f;
-            }
+        Eigen::VectorXf bluredn(nvertices);
 
-            Eigen::VectorXf bluredn(nvertices);
-
-            for (int i = 0; i < maxiter; i++)
-            {
-                Blur(n,bluredn);
-                n = ((n.array()*m.array()).array()/bluredn.array()).array().sqrt();
-            }
+        for (int i = 0; i < maxiter; i++)
+        {
             Blur(n,bluredn);
-
-            m = n.array() * (bluredn).array();
-            diagonal(m,Dm);
-            diagonal(n,Dn);
+            n = ((n.array()*m.array()).array()/bluredn.array()).array().sqrt();
         }
+        Blur(n,bluredn);
+
+        m = n.array() * (bluredn).array();
+        diagonal(m,Dm);
+        diagonal(n,Dn);
+
+        // the smoothness term only depends on the guide
+        A_smooth = bs_param.lam * (Dm - Dn * (blurs*Dn));
+        cached_w_splat.resize(0);
     }
 
-    void FastBilateralSolverFilterImpl::Splat(Eigen::VectorXf& input, Eigen::VectorXf& output)
+    void FastBilateralSolverFilterImpl::Splat(const float* input, Eigen::VectorXf& output) const
     {
-        output.setZero();
-        for (int i = 0; i < int(splat_idx.size()); i++)
+        output.resize(nvertices);
+        // gather per vertex: each sum is accumulated in increasing pixel order
+        parallel_for_(Range(0, nvertices), [&](const Range& range)
         {
-            output(splat_idx[i]) += input(i);
-        }
-
+            for (int v = range.start; v < range.end; v++)
+            {
+                float s = 0.f;
+                for (int k = vert_pix_ofs[v]; k < vert_pix_ofs[v + 1]; k++)
+                    s += input[vert_pix[k]];
+                output(v) = s;
+            }
+        });
     }
 
     void FastBilateralSolverFilterImpl::Blur(Eigen::VectorXf& input, Eigen::VectorXf& output)
@@ -447,159 +411,174 @@ namespace ximgproc
         }
     }
 
-
-    void FastBilateralSolverFilterImpl::Slice(Eigen::VectorXf& input, Eigen::VectorXf& output)
+    template <typename T>
+    static void sliceRows(const Eigen::VectorXf& y, const std::vector<int>& splat_idx, Mat& dst, float scale, float shift)
     {
-        output.setZero();
-        for (int i = 0; i < int(splat_idx.size()); i++)
+        const int cols = dst.cols;
+        parallel_for_(Range(0, dst.rows), [&](const Range& range)
         {
-            output(i) = input(splat_idx[i]);
-        }
+            for (int r = range.start; r < range.end; r++)
+            {
+                T* pdst = dst.ptr<T>(r);
+                const int* pidx = &splat_idx[(size_t)r*cols];
+                for (int c = 0; c < cols; c++)
+                    pdst[c] = cv::saturate_cast<T>(y(pidx[c]) * scale + shift);
+            }
+        });
     }
 
-
-    void FastBilateralSolverFilterImpl::solve(cv::Mat& target,
-               cv::Mat& confidence,
-               cv::Mat& output)
+    void FastBilateralSolverFilterImpl::Slice(const Eigen::VectorXf& y, Mat& output) const
     {
+        if(output.depth() == CV_16S)
+            sliceRows<short>(y, splat_idx, output, 65535.0f, -32768.0f);
+        else if(output.depth() == CV_16U)
+            sliceRows<ushort>(y, splat_idx, output, 65535.0f, 0.0f);
+        else if(output.depth() == CV_8U)
+            sliceRows<uchar>(y, splat_idx, output, 255.0f, 0.0f);
+        else
+            sliceRows<float>(y, splat_idx, output, 1.0f, 0.0f);
+    }
 
-        Eigen::SparseMatrix<float, Eigen::ColMajor> M(nvertices,nvertices);
-        Eigen::SparseMatrix<float, Eigen::ColMajor> A_data(nvertices,nvertices);
-        Eigen::SparseMatrix<float, Eigen::ColMajor> A(nvertices,nvertices);
-        Eigen::VectorXf b(nvertices);
-        Eigen::VectorXf y(nvertices);
-        Eigen::VectorXf y0(nvertices);
-        Eigen::VectorXf y1(nvertices);
-        Eigen::VectorXf w_splat(nvertices);
-
-        Eigen::VectorXf x(npixels);
-        Eigen::VectorXf w(npixels);
-
-        if(target.depth() == CV_16S)
+    template <typename T>
+    static void toFloat(const Mat& src, float* dst, float shift, float divider)
+    {
+        const int cols = src.cols;
+        parallel_for_(Range(0, src.rows), [&](const Range& range)
         {
-            const int16_t *pft = reinterpret_cast<const int16_t*>(target.data);
-            for (int i = 0; i < npixels; i++)
+            for (int r = range.start; r < range.end; r++)
             {
-                x(i) = (cv::saturate_cast<float>(pft[i])+32768.0f)/65535.0f;
+                const T* psrc = src.ptr<T>(r);
+                float* pdst = dst + (size_t)r*cols;
+                for (int c = 0; c < cols; c++)
+                    pdst[c] = (cv::saturate_cast<float>(psrc[c]) + shift) / divider;
             }
-        }
-        else if(target.depth() == CV_16U)
+        });
+    }
+
+    /* Jacobi-preconditioned conjugate gradient on all columns of B at once, so that every
+     * iteration performs a single sparse matrix-matrix product. Each column follows
+     * Eigen::ConjugateGradient: it stops once |r|^2 < tol^2 |b|^2 or after maxIters iterations. */
+    static void batchedConjugateGradient(const Eigen::SparseMatrix<float, Eigen::ColMajor>& A, const Eigen::VectorXf& invdiag,
+                                         const Eigen::MatrixXf& B, Eigen::MatrixXf& X, int maxIters, float tol)
+    {
+        const int nrhs = (int)B.cols();
+        Eigen::MatrixXf R = B - A * X;
+        Eigen::MatrixXf P(B.rows(), nrhs), Z(B.rows(), nrhs), AP(B.rows(), nrhs);
+        std::vector<float> absNew(nrhs), threshold(nrhs);
+        std::vector<char> active(nrhs, 0);
+        int nactive = 0;
+        for (int c = 0; c < nrhs; c++)
         {
-            const uint16_t *pft = reinterpret_cast<const uint16_t*>(target.data);
-            for (int i = 0; i < npixels; i++)
+            const float rhsNorm2 = B.col(c).squaredNorm();
+            if (rhsNorm2 == 0)
             {
-                x(i) = cv::saturate_cast<float>(pft[i])/65535.0f;
+                X.col(c).setZero();
+                P.col(c).setZero();
+                continue;
             }
-        }
-        else if(target.depth() == CV_8U)
-        {
-            const uchar *pft = reinterpret_cast<const uchar*>(target.data);
-            for (int i = 0; i < npixels; i++)
+            threshold[c] = std::max(tol*tol*rhsNorm2, std::numeric_limits<float>::min());
+            if (R.col(c).squaredNorm() < threshold[c])
             {
-                x(i) = cv::saturate_cast<float>(pft[i])/255.0f;
-            }
-        }
-        else if(target.depth() == CV_32F)
-        {
-            const float *pft = reinterpret_cast<const float*>(target.data);
-            for (int i = 0; i < npixels; i++)
-            {
-                x(i) = pft[i];
+                P.col(c).setZero();
+                continue;
             }
+            P.col(c) = invdiag.cwiseProduct(R.col(c));
+            absNew[c] = R.col(c).dot(P.col(c));
+            active[c] = 1;
+            nactive++;
         }
 
-        if(confidence.depth() == CV_8U)
-        {
-            const uchar *pfc = reinterpret_cast<const uchar*>(confidence.data);
-            for (int i = 0; i < npixels; i++)
-            {
-                w(i) = cv::saturate_cast<float>(pfc[i])/255.0f;
-            }
-        }
-        else if(confidence.depth() == CV_32F)
+        for (int it = 0; it < maxIters && nactive > 0; it++)
         {
-            const float *pfc = reinterpret_cast<const float*>(confidence.data);
-            for (int i = 0; i < npixels; i++)
+            AP.noalias() = A * P;
+            for (int c = 0; c < nrhs; c++)
             {
-                w(i) = pfc[i];
+                if (!active[c])
+                    continue;
+                const float alpha = absNew[c] / P.col(c).dot(AP.col(c));
+                X.col(c) += alpha * P.col(c);
+                R.col(c) -= alpha * AP.col(c);
+                if (R.col(c).squaredNorm() < threshold[c])
+                {
+                    // converged: a zero direction keeps it out of the next products
+                    P.col(c).setZero();
+                    active[c] = 0;
+                    nactive--;
+                    continue;
+                }
+                Z.col(c) = invdiag.cwiseProduct(R.col(c));
+                const float absOld = absNew[c];
+                absNew[c] = R.col(c).dot(Z.col(c));
+                P.col(c) = Z.col(c) + (absNew[c] / absOld) * P.col(c);
             }
         }
+    }
 
-        //construct A
-        Splat(w,w_splat);
-
-        diagonal(w_splat,A_data);
-        A = bs_param.lam * (Dm - Dn * (blurs*Dn)) + A_data ;
+    void FastBilateralSolverFilterImpl::solve(const std::vector<Mat>& target,
+               const cv::Mat& confidence,
+               std::vector<Mat>& output)
+    {
+        const int nchannels = (int)target.size();
+        std::vector<float> x((size_t)npixels * nchannels);
+        std::vector<float> w(npixels), xw(npixels);
 
-        //construct b
-        b.setZero();
-        for (int i = 0; i < int(splat_idx.size()); i++)
+        for (int c = 0; c < nchannels; c++)
         {
-            b(splat_idx[i]) += x(i) * w(i);
+            float* px = &x[(size_t)c * npixels];
+            if(target[c].depth() == CV_16S)
+                toFloat<short>(target[c], px, 32768.0f, 65535.0f);
+            else if(target[c].depth() == CV_16U)
+                toFloat<ushort>(target[c], px, 0.0f, 65535.0f);
+            else if(target[c].depth() == CV_8U)
+                toFloat<uchar>(target[c], px, 0.0f, 255.0f);
+            else
+                toFloat<float>(target[c], px, 0.0f, 1.0f);
         }
 
-        //construct guess for y
-        y0.setZero();
-        for (int i = 0; i < int(splat_idx.size()); i++)
-        {
-            y0(splat_idx[i]) += x(i);
-        }
-        y1.setZero();
-        for (int i = 0; i < int(splat_idx.size()); i++)
+        if(confidence.depth() == CV_8U)
+            toFloat<uchar>(confidence, &w[0], 0.0f, 255.0f);
+        else
+            toFloat<float>(confidence, &w[0], 0.0f, 1.0f);
+
+        //construct A, unless the confidence is the same as in the previous call
+        Eigen::VectorXf w_splat;
+        Splat(&w[0],w_splat);
+        if (cached_w_splat.size() != nvertices || cached_w_splat != w_splat)
         {
-            y1(splat_idx[i]) += 1.0f;
+            Eigen::SparseMatrix<float, Eigen::ColMajor> A_data(nvertices,nvertices);
+            diagonal(w_splat,A_data);
+            A = A_smooth + A_data;
+
+            // Jacobi preconditioner, as Eigen::DiagonalPreconditioner
+            Eigen::VectorXf A_diag = A.diagonal();
+            A_invdiag.resize(nvertices);
+            for (int i = 0; i < nvertices; i++)
+                A_invdiag(i) = A_diag(i) == 0.f ? 1.f : 1.f / A_diag(i);
+            cached_w_splat = w_splat;
         }
-        for (int i = 0; i < nvertices; i++)
+
+        //construct b and the guess for y, one column per channel
+        Eigen::MatrixXf b(nvertices, nchannels), y(nvertices, nchannels);
+        Eigen::VectorXf tmp;
+        for (int c = 0; c < nchannels; c++)
         {
-            y0(i) = y0(i)/y1(i);
+            const float* px = &x[(size_t)c * npixels];
+            for (int i = 0; i < npixels; i++)
+                xw[i] = px[i] * w[i];
+            Splat(&xw[0], tmp);
+            b.col(c) = tmp;
+            Splat(px, tmp);
+            y.col(c) = tmp.cwiseQuotient(counts);
         }
 
-
         // solve Ay = b
-        Eigen::ConjugateGradient<Eigen::SparseMatrix<float>, Eigen::Lower|Eigen::Upper> cg;
-        cg.compute(A);
-        cg.setMaxIterations(bs_param.cg_maxiter);
-        cg.setTolerance(bs_param.cg_tol);
-        // y = cg.solve(b);
-        y = cg.solveWithGuess(b,y0);
-        std::cout << "#iterations:     " << cg.iterations() << std::endl;
-        std::cout << "estimated error: " << cg.error()      << std::endl;
+        batchedConjugateGradient(A, A_invdiag, b, y, bs_param.cg_maxiter, bs_param.cg_tol);
 
         //slice
-        if(target.depth() == CV_16S)
-        {
-            int16_t *pftar = (int16_t*) output.data;
-            for (int i = 0; i < int(splat_idx.size()); i++)
-            {
-                pftar[i] = cv::saturate_cast<short>(y(splat_idx[i]) * 65535.0f - 32768.0f);
-            }
-        }
-        else if(target.depth() == CV_16U)
-        {
-            uint16_t *pftar = (uint16_t*) output.data;
-            for (int i = 0; i < int(splat_idx.size()); i++)
-            {
-                pftar[i] = cv::saturate_cast<ushort>(y(splat_idx[i]) * 65535.0f);
-            }
-        }
-        else if (target.depth() == CV_8U)
-        {
-            uchar *pftar = (uchar*) output.data;
-            for (int i = 0; i < int(splat_idx.size()); i++)
-            {
-                pftar[i] = cv::saturate_cast<uchar>(y(splat_idx[i]) * 255.0f);
-            }
-        }
-        else
+        for (int c = 0; c < nchannels; c++)
         {
-            float *pftar = (float*)(output.data);
-            for (int i = 0; i < int(splat_idx.size()); i++)
-            {
-                pftar[i] = y(splat_idx[i]);
-            }
+            Slice(y.col(c), output[c]);
         }
-
-
     }
 
 
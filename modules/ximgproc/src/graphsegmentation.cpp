@@ -40,6 +40,7 @@ the use of this software, even if advised of the possibility of such damage.
 
 #include "precomp.hpp"
 #include "opencv2/ximgproc/segmentation.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #include <iostream>
 
@@ -78,10 +79,8 @@ namespace cv {
             // An object to manage set of points, who can be fusionned
             class PointSet {
                 public:
-                    PointSet(int nb_elements_);
-                    ~PointSet();
-
-                    int nb_elements;
+                    // (Re)initialize the set with nb_elements points, each in its own set
+                    void reset(int nb_elements);
 
                     // Return the main point of the point's set
                     int getBasePoint(int p);
@@ -93,8 +92,20 @@ namespace cv {
                     int size(unsigned int p) { return mapping[p].size; }
 
                 private:
-                    PointSetElement* mapping;
+                    std::vector<PointSetElement> mapping;
+
+            };
 
+            // Buffers kept between two calls of processImage, so that images of the same size
+            // are segmented without reallocation
+            struct GraphSegmentationWorkspace {
+                Mat img_filtered;
+                Mat weights_right; // Weight of the edge between each pixel and its right neighbour
+                Mat weights_down;  // Weight of the edge between each pixel and its bottom neighbour
+                std::vector<Edge> edges, edges_tmp;
+                std::vector<float> thresholds;
+                std::vector<int> mapped_id;
+                PointSet es;
             };
 
             class GraphSegmentationImpl : public GraphSegmentation {
@@ -103,6 +114,7 @@ namespace cv {
                         sigma = 0.5;
                         k = 300;
                         min_size = 100;
+                        tile_size = 0;
                         name_ = "GraphSegmentation";
                     }
 
@@ -120,11 +132,15 @@ namespace cv {
                     virtual void setMinSize(int min_size_) CV_OVERRIDE { min_size = min_size_; }
                     virtual int getMinSize() CV_OVERRIDE { return min_size; }
 
+                    virtual void setTileSize(int tile_size_) CV_OVERRIDE { tile_size = std::max(tile_size_, 0); }
+                    virtual int getTileSize() CV_OVERRIDE { return tile_size; }
+
                     virtual void write(FileStorage& fs) const CV_OVERRIDE {
                         fs << "name" << name_
                         << "sigma" << sigma
                         << "k" << k
-                        << "min_size" << (int)min_size;
+                        << "min_size" << (int)min_size
+                        << "tile_size" << tile_size;
                     }
 
                     virtual void read(const FileNode& fn) CV_OVERRIDE {
@@ -133,30 +149,180 @@ namespace cv {
                         sigma = (double)fn["sigma"];
                         k = (float)fn["k"];
                         min_size = (int)(int)fn["min_size"];
+                        tile_size = fn["tile_size"].empty() ? 0 : (int)fn["tile_size"];
                     }
 
                 private:
                     double sigma;
                     float k;
                     int min_size;
+                    int tile_size;
                     String name_;
 
+                    // Reused buffers. processImage may be called concurrently (e.g. by the selective
+                    // search), so a call takes the workspace out while it uses it; a concurrent call
+                    // finding it empty works on a temporary one.
+                    Ptr<GraphSegmentationWorkspace> workspace;
+                    Mutex workspace_mutex;
+
+                    Ptr<GraphSegmentationWorkspace> acquireWorkspace();
+                    void releaseWorkspace(const Ptr<GraphSegmentationWorkspace>& ws);
+
                     // Pre-filter the image
                     void filter(const Mat &img, Mat &img_filtered);
 
+                    // Compute the weights of the edges between each pixels and its right and bottom neighbours
+                    void computeWeights(const Mat &img_filtered, Mat &weights_right, Mat &weights_down);
+
                     // Build the graph between each pixels
-                    void buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered);
+                    void buildGraph(std::vector<Edge> &edges, const Mat &weights_right, const Mat &weights_down);
 
                     // Segment the graph
-                    void segmentGraph(Edge * edges, const int &nb_edges, const Mat & img_filtered, PointSet **es);
+                    void segmentGraph(Edge *edges, int nb_edges, PointSet &es, float *thresholds);
 
                     // Remove areas too small
-                    void filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es);
+                    void filterSmallAreas(const Edge *edges, int nb_edges, PointSet &es);
+
+                    // Segment tiles of the image in parallel, then merge the segments across tile borders
+                    void segmentTiles(GraphSegmentationWorkspace &ws);
 
                     // Map the segemented graph to a Mat with uniques, sequentials ids
-                    void finalMapping(PointSet *es, Mat &output);
+                    void finalMapping(PointSet &es, std::vector<int> &mapped_id, Mat &output);
             };
 
+            static inline void setEdge(Edge &e, int from, int to, float weight) {
+                e.from = from;
+                e.to = to;
+                e.weight = weight;
+            }
+
+            // Euclidean distance between len pixels of a and the corresponding pixels of b
+            static void pixelDistances(const float* a, const float* b, float* dst, int len, int nb_channels) {
+                int j = 0;
+#if CV_SIMD128
+                if (nb_channels == 1) {
+                    for (; j <= len - 4; j += 4) {
+                        v_float32x4 d = v_load(a + j) - v_load(b + j);
+                        v_store(dst + j, v_sqrt(d * d));
+                    }
+                } else if (nb_channels == 3) {
+                    for (; j <= len - 4; j += 4) {
+                        v_float32x4 a0, a1, a2, b0, b1, b2;
+                        v_load_deinterleave(a + j * 3, a0, a1, a2);
+                        v_load_deinterleave(b + j * 3, b0, b1, b2);
+                        v_float32x4 d0 = a0 - b0, d1 = a1 - b1, d2 = a2 - b2;
+                        v_store(dst + j, v_sqrt(d0 * d0 + d1 * d1 + d2 * d2));
+                    }
+                } else if (nb_channels == 4) {
+                    for (; j <= len - 4; j += 4) {
+                        v_float32x4 a0, a1, a2, a3, b0, b1, b2, b3;
+                        v_load_deinterleave(a + j * 4, a0, a1, a2, a3);
+                        v_load_deinterleave(b + j * 4, b0, b1, b2, b3);
+                        v_float32x4 d0 = a0 - b0, d1 = a1 - b1, d2 = a2 - b2, d3 = a3 - b3;
+                        v_store(dst + j, v_sqrt(d0 * d0 + d1 * d1 + d2 * d2 + d3 * d3));
+                    }
+                }
+#endif
+                for (; j < len; j++) {
+                    float tmp_total = 0;
+
+                    for (int channel = 0; channel < nb_channels; channel++) {
+                        float tmp_diff = a[j * nb_channels + channel] - b[j * nb_channels + channel];
+                        tmp_total += tmp_diff * tmp_diff;
+                    }
+
+                    dst[j] = sqrt(tmp_total);
+                }
+            }
+
+            // Stable LSD radix sort of the edges by weight. Weights are never negative, so their
+            // IEEE bit patterns sort in the same order as their values: the order is exact, not
+            // quantized. Every pass counts digits per chunk in parallel, then each chunk scatters
+            // its edges to its own offsets, which keeps the sort stable for any number of threads.
+            static void sortEdges(std::vector<Edge> &edges, std::vector<Edge> &edges_tmp) {
+                const int nb_edges = (int)edges.size();
+                const int digit_bits = 11;
+                const int nb_digits = 1 << digit_bits;
+                const int nb_chunks = std::max(1, std::min(getNumThreads(), nb_edges / (1 << 16)));
+
+                edges_tmp.resize(nb_edges);
+                std::vector<int> offsets(nb_chunks * nb_digits);
+
+                for (int shift = 0; shift < 32; shift += digit_bits) {
+
+                    std::fill(offsets.begin(), offsets.end(), 0);
+
+                    parallel_for_(Range(0, nb_chunks), [&](const Range& range) {
+                        for (int c = range.start; c < range.end; c++) {
+                            int* count = &offsets[c * nb_digits];
+                            int start = (int)((int64)nb_edges * c / nb_chunks);
+                            int end = (int)((int64)nb_edges * (c + 1) / nb_chunks);
+
+                            for (int i = start; i < end; i++) {
+                                Cv32suf key;
+                                key.f = edges[i].weight;
+                                count[(key.u >> shift) & (nb_digits - 1)]++;
+                            }
+                        }
+                    });
+
+                    // Turn counts into output positions: digit by digit, then chunk by chunk
+                    int position = 0;
+                    bool single_digit = false;
+
+                    for (int d = 0; d < nb_digits && !single_digit; d++) {
+                        int digit_start = position;
+
+                        for (int c = 0; c < nb_chunks; c++) {
+                            int n = offsets[c * nb_digits + d];
+                            offsets[c * nb_digits + d] = position;
+                            position += n;
+                        }
+
+                        single_digit = position - digit_start == nb_edges;
+                    }
+
+                    // All the edges share this digit: the pass would not change the order
+                    if (single_digit) {
+                        continue;
+                    }
+
+                    parallel_for_(Range(0, nb_chunks), [&](const Range& range) {
+                        for (int c = range.start; c < range.end; c++) {
+                            int* position_ = &offsets[c * nb_digits];
+                            int start = (int)((int64)nb_edges * c / nb_chunks);
+                            int end = (int)((int64)nb_edges * (c + 1) / nb_chunks);
+
+                            for (int i = start; i < end; i++) {
+                                Cv32suf key;
+                                key.f = edges[i].weight;
+                                edges_tmp[position_[(key.u >> shift) & (nb_digits - 1)]++] = edges[i];
+                            }
+                        }
+                    });
+
+                    edges.swap(edges_tmp);
+                }
+            }
+
+            Ptr<GraphSegmentationWorkspace> GraphSegmentationImpl::acquireWorkspace() {
+                AutoLock lock(workspace_mutex);
+
+                Ptr<GraphSegmentationWorkspace> ws;
+                std::swap(ws, workspace);
+
+                if (!ws) {
+                    ws = makePtr<GraphSegmentationWorkspace>();
+                }
+
+                return ws;
+            }
+
+            void GraphSegmentationImpl::releaseWorkspace(const Ptr<GraphSegmentationWorkspace>& ws) {
+                AutoLock lock(workspace_mutex);
+                workspace = ws;
+            }
+
             void GraphSegmentationImpl::filter(const Mat &img, Mat &img_filtered) {
 
                 Mat img_converted;
@@ -168,113 +334,196 @@ namespace cv {
                 GaussianBlur(img_converted, img_filtered, Size(0, 0), sigma, sigma);
             }
 
-            void GraphSegmentationImpl::buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered) {
-
-                *edges = new Edge[img_filtered.rows * img_filtered.cols * 4];
-
-                nb_edges = 0;
+            void GraphSegmentationImpl::computeWeights(const Mat &img_filtered, Mat &weights_right, Mat &weights_down) {
 
-                int nb_channels = img_filtered.channels();
+                const int rows = img_filtered.rows;
+                const int cols = img_filtered.cols;
+                const int nb_channels = img_filtered.channels();
 
-                for (int i = 0; i < (int)img_filtered.rows; i++) {
-                    const float* p = img_filtered.ptr<float>(i);
+                if (cols > 1) {
+                    weights_right.create(rows, cols - 1, CV_32F);
+                } else {
+                    weights_right.release();
+                }
 
-                    for (int j = 0; j < (int)img_filtered.cols; j++) {
+                if (rows > 1) {
+                    weights_down.create(rows - 1, cols, CV_32F);
+                } else {
+                    weights_down.release();
+                }
 
-                        //Take the right, left, top and down pixel
-                        for (int delta = -1; delta <= 1; delta += 2) {
-                            for (int delta_j = 0, delta_i = 1; delta_j <= 1; delta_j++ || delta_i--) {
+                parallel_for_(Range(0, rows), [&](const Range& range) {
+                    for (int i = range.start; i < range.end; i++) {
+                        const float* p = img_filtered.ptr<float>(i);
 
-                                int i2 = i + delta * delta_i;
-                                int j2 = j + delta * delta_j;
+                        if (cols > 1) {
+                            pixelDistances(p, p + nb_channels, weights_right.ptr<float>(i), cols - 1, nb_channels);
+                        }
 
-                                if (i2 >= 0 && i2 < img_filtered.rows && j2 >= 0 && j2 < img_filtered.cols) {
-                                    const float* p2 = img_filtered.ptr<float>(i2);
+                        if (i < rows - 1) {
+                            pixelDistances(p, img_filtered.ptr<float>(i + 1), weights_down.ptr<float>(i), cols, nb_channels);
+                        }
+                    }
+                });
+            }
 
-                                    float tmp_total = 0;
+            void GraphSegmentationImpl::buildGraph(std::vector<Edge> &edges, const Mat &weights_right, const Mat &weights_down) {
 
-                                    for ( int channel = 0; channel < nb_channels; channel++) {
-                                        float tmp_diff = p[j * nb_channels + channel] - p2[j2 * nb_channels + channel];
-                                        tmp_total += tmp_diff * tmp_diff;
-                                    }
+                const int rows = weights_right.empty() ? weights_down.rows + 1 : weights_right.rows;
+                const int cols = weights_down.empty() ? weights_right.cols + 1 : weights_down.cols;
 
-                                    float diff = 0;
-                                    diff = sqrt(tmp_total);
+                // Each pixel is linked to its right and bottom neighbours, so every row but the last
+                // one holds 2 * cols - 1 edges
+                edges.resize((size_t)rows * (cols - 1) + (size_t)(rows - 1) * cols);
 
-                                    (*edges)[nb_edges].weight = diff;
-                                    (*edges)[nb_edges].from = i * img_filtered.cols +  j;
-                                    (*edges)[nb_edges].to = i2 * img_filtered.cols + j2;
+                parallel_for_(Range(0, rows), [&](const Range& range) {
+                    for (int i = range.start; i < range.end; i++) {
+                        Edge* e = edges.empty() ? NULL : &edges[(size_t)i * (2 * cols - 1)];
+                        const float* w_right = cols > 1 ? weights_right.ptr<float>(i) : NULL;
+                        const float* w_down = i < rows - 1 ? weights_down.ptr<float>(i) : NULL;
+                        int p = i * cols;
 
-                                    nb_edges++;
-                                }
+                        for (int j = 0; j < cols; j++, p++) {
+                            if (j < cols - 1) {
+                                setEdge(*e++, p, p + 1, w_right[j]);
+                            }
+                            if (w_down) {
+                                setEdge(*e++, p, p + cols, w_down[j]);
                             }
                         }
                     }
-                }
+                });
             }
 
-            void GraphSegmentationImpl::segmentGraph(Edge *edges, const int &nb_edges, const Mat &img_filtered, PointSet **es) {
+            void GraphSegmentationImpl::segmentGraph(Edge *edges, int nb_edges, PointSet &es, float *thresholds) {
 
-                int total_points = ( int)(img_filtered.rows * img_filtered.cols);
+                for ( int i = 0; i < nb_edges; i++) {
 
-                // Sort edges
-                std::sort(edges, edges + nb_edges);
+                    int p_a = es.getBasePoint(edges[i].from);
+                    int p_b = es.getBasePoint(edges[i].to);
 
-                // Create a set with all point (by default mapped to themselves)
-                *es = new PointSet(img_filtered.cols * img_filtered.rows);
+                    if (p_a != p_b) {
+                        if (edges[i].weight <= thresholds[p_a] && edges[i].weight <= thresholds[p_b]) {
+                            es.joinPoints(p_a, p_b);
+                            p_a = es.getBasePoint(p_a);
+                            thresholds[p_a] = edges[i].weight + k / es.size(p_a);
 
-                // Thresholds
-                float* thresholds = new float[total_points];
+                            edges[i].weight = 0;
+                        }
+                    }
+                }
+            }
 
-                for (int i = 0; i < total_points; i++)
-                    thresholds[i] = k;
+            void GraphSegmentationImpl::filterSmallAreas(const Edge *edges, int nb_edges, PointSet &es) {
 
                 for ( int i = 0; i < nb_edges; i++) {
 
-                    int p_a = (*es)->getBasePoint(edges[i].from);
-                    int p_b = (*es)->getBasePoint(edges[i].to);
+                    if (edges[i].weight > 0) {
 
-                    if (p_a != p_b) {
-                        if (edges[i].weight <= thresholds[p_a] && edges[i].weight <= thresholds[p_b]) {
-                            (*es)->joinPoints(p_a, p_b);
-                            p_a = (*es)->getBasePoint(p_a);
-                            thresholds[p_a] = edges[i].weight + k / (*es)->size(p_a);
+                        int p_a = es.getBasePoint(edges[i].from);
+                        int p_b = es.getBasePoint(edges[i].to);
+
+                        if (p_a != p_b && (es.size(p_a) < min_size || es.size(p_b) < min_size)) {
+                            es.joinPoints(p_a, p_b);
 
-                            edges[i].weight = 0;
                         }
                     }
                 }
 
-                delete [] thresholds;
             }
 
-            void GraphSegmentationImpl::filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es) {
+            void GraphSegmentationImpl::segmentTiles(GraphSegmentationWorkspace &ws) {
 
-                for ( int i = 0; i < nb_edges; i++) {
+                const int rows = ws.img_filtered.rows;
+                const int cols = ws.img_filtered.cols;
+                const int tiles_x = (cols + tile_size - 1) / tile_size;
+                const int tiles_y = (rows + tile_size - 1) / tile_size;
+                const int nb_tiles = tiles_x * tiles_y;
 
-                    if (edges[i].weight > 0) {
+                // Edges inside each tile are stored contiguously, tile after tile, followed by the
+                // edges crossing a tile border
+                std::vector<int> tile_offsets(nb_tiles + 1, 0);
+
+                for (int t = 0; t < nb_tiles; t++) {
+                    int w = std::min(tile_size, cols - (t % tiles_x) * tile_size);
+                    int h = std::min(tile_size, rows - (t / tiles_x) * tile_size);
+                    tile_offsets[t + 1] = tile_offsets[t] + h * (w - 1) + (h - 1) * w;
+                }
 
-                        int p_a = es->getBasePoint(edges[i].from);
-                        int p_b = es->getBasePoint(edges[i].to);
+                const int nb_inner_edges = tile_offsets[nb_tiles];
+                const int nb_edges = rows * (cols - 1) + (rows - 1) * cols;
 
-                        if (p_a != p_b && (es->size(p_a) < min_size || es->size(p_b) < min_size)) {
-                            es->joinPoints(p_a, p_b);
+                std::vector<Edge>& edges = ws.edges;
+                edges.resize(nb_edges);
 
+                // Segment each tile on its own. Tiles are disjoint sets of pixels, so they can
+                // share the point set and the thresholds.
+                parallel_for_(Range(0, nb_tiles), [&](const Range& range) {
+                    for (int t = range.start; t < range.end; t++) {
+                        int x0 = (t % tiles_x) * tile_size, x1 = std::min(x0 + tile_size, cols);
+                        int y0 = (t / tiles_x) * tile_size, y1 = std::min(y0 + tile_size, rows);
+                        Edge* tile_edges = edges.empty() ? NULL : &edges[tile_offsets[t]];
+                        int nb_tile_edges = tile_offsets[t + 1] - tile_offsets[t];
+                        Edge* e = tile_edges;
+
+                        for (int i = y0; i < y1; i++) {
+                            const float* w_right = x1 - x0 > 1 ? ws.weights_right.ptr<float>(i) : NULL;
+                            const float* w_down = i < y1 - 1 ? ws.weights_down.ptr<float>(i) : NULL;
+
+                            for (int j = x0; j < x1; j++) {
+                                int p = i * cols + j;
+
+                                if (j < x1 - 1) {
+                                    setEdge(*e++, p, p + 1, w_right[j]);
+                                }
+                                if (w_down) {
+                                    setEdge(*e++, p, p + cols, w_down[j]);
+                                }
+                            }
                         }
+
+                        std::stable_sort(tile_edges, tile_edges + nb_tile_edges);
+                        segmentGraph(tile_edges, nb_tile_edges, ws.es, &ws.thresholds[0]);
+                        filterSmallAreas(tile_edges, nb_tile_edges, ws.es);
+                    }
+                });
+
+                // Then merge the segments across tile borders, with the thresholds reached inside the tiles
+                Edge* e = edges.empty() ? NULL : &edges[nb_inner_edges];
+
+                for (int i = 0; i < rows && cols > tile_size; i++) {
+                    const float* w_right = ws.weights_right.ptr<float>(i);
+
+                    for (int j = tile_size - 1; j < cols - 1; j += tile_size) {
+                        setEdge(*e++, i * cols + j, i * cols + j + 1, w_right[j]);
+                    }
+                }
+
+                for (int i = tile_size - 1; i < rows - 1; i += tile_size) {
+                    const float* w_down = ws.weights_down.ptr<float>(i);
+
+                    for (int j = 0; j < cols; j++) {
+                        setEdge(*e++, i * cols + j, (i + 1) * cols + j, w_down[j]);
                     }
                 }
 
+                int nb_border_edges = nb_edges - nb_inner_edges;
+
+                if (nb_border_edges > 0) {
+                    Edge* border_edges = &edges[nb_inner_edges];
+
+                    std::stable_sort(border_edges, border_edges + nb_border_edges);
+                    segmentGraph(border_edges, nb_border_edges, ws.es, &ws.thresholds[0]);
+                    filterSmallAreas(border_edges, nb_border_edges, ws.es);
+                }
             }
 
-            void GraphSegmentationImpl::finalMapping(PointSet *es, Mat &output) {
+            void GraphSegmentationImpl::finalMapping(PointSet &es, std::vector<int> &mapped_id, Mat &output) {
 
                 int maximum_size = ( int)(output.rows * output.cols);
 
                 int last_id = 0;
-                int * mapped_id = new int[maximum_size];
-
-                for ( int i = 0; i < maximum_size; i++)
-                    mapped_id[i] = -1;
+                mapped_id.assign(maximum_size, -1);
 
                 int rows = output.rows;
                 int cols = output.cols;
@@ -290,7 +539,7 @@ namespace cv {
 
                     for (int j = 0; j < cols; j++) {
 
-                        int point = es->getBasePoint(i * cols + j);
+                        int point = es.getBasePoint(i * cols + j);
 
                         if (mapped_id[point] == -1) {
                             mapped_id[point] = last_id;
@@ -300,8 +549,6 @@ namespace cv {
                         p[j] = mapped_id[point];
                     }
                 }
-
-                delete [] mapped_id;
             }
 
             void GraphSegmentationImpl::processImage(InputArray src, OutputArray dst) {
@@ -312,30 +559,46 @@ namespace cv {
                 Mat output = dst.getMat();
                 output.setTo(0);
 
+                if (img.empty()) {
+                    return;
+                }
+
+                Ptr<GraphSegmentationWorkspace> ws = acquireWorkspace();
+
                 // Filter graph
-                Mat img_filtered;
-                filter(img, img_filtered);
+                filter(img, ws->img_filtered);
 
-                // Build graph
-                Edge *edges;
-                int nb_edges;
+                // Compute edge weights
+                computeWeights(ws->img_filtered, ws->weights_right, ws->weights_down);
 
-                buildGraph(&edges, nb_edges, img_filtered);
+                // Create a set with all point (by default mapped to themselves)
+                int total_points = (int)img.total();
+                ws->es.reset(total_points);
 
-                // Segment graph
-                PointSet *es;
+                // Thresholds
+                ws->thresholds.assign(total_points, k);
 
-                segmentGraph(edges, nb_edges, img_filtered, &es);
+                if (tile_size > 0 && (img.rows > tile_size || img.cols > tile_size)) {
+                    segmentTiles(*ws);
+                } else {
+                    // Build and sort graph
+                    buildGraph(ws->edges, ws->weights_right, ws->weights_down);
+                    sortEdges(ws->edges, ws->edges_tmp);
 
-                // Remove small areas
-                filterSmallAreas(edges, nb_edges, es);
+                    int nb_edges = (int)ws->edges.size();
+                    Edge* edges = nb_edges > 0 ? &ws->edges[0] : NULL;
 
-                // Map to final output
-                finalMapping(es, output);
+                    // Segment graph
+                    segmentGraph(edges, nb_edges, ws->es, &ws->thresholds[0]);
 
-                delete [] edges;
-                delete es;
+                    // Remove small areas
+                    filterSmallAreas(edges, nb_edges, ws->es);
+                }
+
+                // Map to final output
+                finalMapping(ws->es, ws->mapped_id, output);
 
+                releaseWorkspace(ws);
             }
 
             Ptr<GraphSegmentation> createGraphSegmentation(double sigma, float k, int min_size) {
@@ -349,20 +612,14 @@ namespace cv {
                 return graphseg;
             }
 
-            PointSet::PointSet(int nb_elements_) {
-                nb_elements = nb_elements_;
-
-                mapping = new PointSetElement[nb_elements];
+            void PointSet::reset(int nb_elements) {
+                mapping.resize(nb_elements);
 
                 for ( int i = 0; i < nb_elements; i++) {
                     mapping[i] = PointSetElement(i);
                 }
             }
 
-            PointSet::~PointSet() {
-                delete [] mapping;
-            }
-
             int PointSet::getBasePoint( int p) {
 
                  int base_p = p;
@@ -385,8 +642,6 @@ namespace cv {
 
                 mapping[p_b].p = p_a;
                 mapping[p_a].size += mapping[p_b].size;
-
-                nb_elements--;
             }
 
         }
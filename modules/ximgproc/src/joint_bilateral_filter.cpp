@@ -35,6 +35,7 @@
  */
 
 #include "precomp.hpp"
+#include "edgeaware_filters_common.hpp"
 #include <climits>
 #include <iostream>
 using namespace std;
@@ -55,10 +56,6 @@ typedef Vec<uchar, 1> Vec1b;
 #define SQR(a) ((a)*(a))
 #endif
 
-void jointBilateralFilter_32f(Mat& joint, Mat& src, Mat& dst, int radius, double sigmaColor, double sigmaSpace, int borderType);
-
-void jointBilateralFilter_8u(Mat& joint, Mat& src, Mat& dst, int radius, double sigmaColor, double sigmaSpace, int borderType);
-
 template<typename JointVec, typename SrcVec>
 class JointBilateralFilter_32f : public ParallelLoopBody
 {
@@ -119,92 +116,6 @@ public:
     }
 };
 
-void jointBilateralFilter_32f(Mat& joint, Mat& src, Mat& dst, int radius, double sigmaColor, double sigmaSpace, int borderType)
-{
-    CV_DbgAssert(joint.depth() == CV_32F && src.depth() == CV_32F);
-
-    int d = 2*radius + 1;
-    int jCn = joint.channels();
-    const int kExpNumBinsPerChannel = 1 << 12;
-    double minValJoint, maxValJoint;
-
-    minMaxLoc(joint, &minValJoint, &maxValJoint);
-    if (abs(maxValJoint - minValJoint) < FLT_EPSILON)
-    {
-        //TODO: make circle pattern instead of square
-        GaussianBlur(src, dst, Size(d, d), sigmaSpace, 0, borderType);
-        return;
-    }
-    float colorRange = (float)(maxValJoint - minValJoint) * jCn;
-    colorRange = std::max(0.01f, colorRange);
-
-    int kExpNumBins = kExpNumBinsPerChannel * jCn;
-    vector<float> expLUTv(kExpNumBins + 2);
-    float *expLUT = &expLUTv[0];
-    float scaleIndex = kExpNumBins/colorRange;
-
-    double gaussColorCoeff = -0.5 / (sigmaColor*sigmaColor);
-    double gaussSpaceCoeff = -0.5 / (sigmaSpace*sigmaSpace);
-
-    for (int i = 0; i < kExpNumBins + 2; i++)
-    {
-        double val = i / scaleIndex;
-        expLUT[i] = (float) std::exp(val * val * gaussColorCoeff);
-    }
-
-    Mat jointTemp, srcTemp;
-    copyMakeBorder(joint, jointTemp, radius, radius, radius, radius, borderType);
-    copyMakeBorder(src, srcTemp, radius, radius, radius, radius, borderType);
-    size_t srcElemStep = srcTemp.step / srcTemp.elemSize();
-    size_t jElemStep = jointTemp.step / jointTemp.elemSize();
-    CV_Assert(srcElemStep == jElemStep);
-
-    vector<float> spaceWeightsv(d*d);
-    vector<int> spaceOfsJointv(d*d);
-    float *spaceWeights = &spaceWeightsv[0];
-    int *spaceOfsJoint = &spaceOfsJointv[0];
-
-    int maxk = 0;
-    for (int i = -radius; i <= radius; i++)
-    {
-        for (int j = -radius; j <= radius; j++)
-        {
-            double r2 = i*i + j*j;
-            if (r2 > SQR(radius))
-                continue;
-
-            spaceWeights[maxk] = (float) std::exp(r2 * gaussSpaceCoeff);
-            spaceOfsJoint[maxk] = (int) (i*jElemStep + j);
-            maxk++;
-        }
-    }
-
-    Range range(0, joint.rows);
-    if (joint.type() == CV_32FC1)
-    {
-        if (src.type() == CV_32FC1)
-        {
-            parallel_for_(range, JointBilateralFilter_32f<Vec1f, Vec1f>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, spaceOfsJoint, spaceWeights, expLUT));
-        }
-        if (src.type() == CV_32FC3)
-        {
-            parallel_for_(range, JointBilateralFilter_32f<Vec1f, Vec3f>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, spaceOfsJoint, spaceWeights, expLUT));
-        }
-    }
-
-    if (joint.type() == CV_32FC3)
-    {
-        if (src.type() == CV_32FC1)
-        {
-            parallel_for_(range, JointBilateralFilter_32f<Vec3f, Vec1f>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, spaceOfsJoint, spaceWeights, expLUT));
-        }
-        if (src.type() == CV_32FC3)
-        {
-            parallel_for_(range, JointBilateralFilter_32f<Vec3f, Vec3f>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, spaceOfsJoint, spaceWeights, expLUT));
-        }
-    }
-}
-
 template<typename JointVec, typename SrcVec>
 class JointBilateralFilter_8u : public ParallelLoopBody
 {
@@ -265,37 +176,27 @@ public:
     }
 };
 
-void jointBilateralFilter_8u(Mat& joint, Mat& src, Mat& dst, int radius, double sigmaColor, double sigmaSpace, int borderType)
+void JointBilateralFilterContext::init(const Mat& src_, int jointType_, int radius_, double sigmaColor_, double sigmaSpace_, int borderType_)
 {
-    CV_DbgAssert(joint.depth() == CV_8U && src.depth() == CV_8U);
-
-    int d = 2 * radius + 1;
-    int jCn = joint.channels();
-
-    double gaussColorCoeff = -0.5 / (sigmaColor*sigmaColor);
-    double gaussSpaceCoeff = -0.5 / (sigmaSpace*sigmaSpace);
-
-    vector<float> expLUTv(jCn*256);
-    float *expLUT = &expLUTv[0];
+    CV_DbgAssert(src_.depth() == CV_MAT_DEPTH(jointType_) && (src_.depth() == CV_8U || src_.depth() == CV_32F));
 
-    for (int i = 0; i < (int)expLUTv.size(); i++)
-    {
-        expLUT[i] = (float)std::exp(i * i * gaussColorCoeff);
-    }
+    src = src_;
+    jointType = jointType_;
+    radius = radius_;
+    sigmaColor = sigmaColor_;
+    sigmaSpace = sigmaSpace_;
+    borderType = borderType_;
 
-    Mat jointTemp, srcTemp;
-    copyMakeBorder(joint, jointTemp, radius, radius, radius, radius, borderType);
     copyMakeBorder(src, srcTemp, radius, radius, radius, radius, borderType);
     size_t srcElemStep = srcTemp.step / srcTemp.elemSize();
-    size_t jElemStep = jointTemp.step / jointTemp.elemSize();
-    CV_Assert(srcElemStep == jElemStep);
 
-    vector<float> spaceWeightsv(d*d);
-    vector<int> spaceOfsJointv(d*d);
-    float *spaceWeights = &spaceWeightsv[0];
-    int *spaceOfsJoint = &spaceOfsJointv[0];
+    int d = 2*radius + 1;
+    double gaussSpaceCoeff = -0.5 / (sigmaSpace*sigmaSpace);
+
+    spaceWeights.resize(d*d);
+    spaceOfs.resize(d*d);
 
-    int maxk = 0;
+    maxk = 0;
     for (int i = -radius; i <= radius; i++)
     {
         for (int j = -radius; j <= radius; j++)
@@ -304,36 +205,134 @@ void jointBilateralFilter_8u(Mat& joint, Mat& src, Mat& dst, int radius, double
             if (r2 > SQR(radius))
                 continue;
 
-            spaceWeights[maxk] = (float)std::exp(r2 * gaussSpaceCoeff);
-            spaceOfsJoint[maxk] = (int)(i*jElemStep + j);
+            spaceWeights[maxk] = (float) std::exp(r2 * gaussSpaceCoeff);
+            spaceOfs[maxk] = (int) (i*srcElemStep + j);
             maxk++;
         }
     }
 
-    Range range(0, src.rows);
-    if (joint.type() == CV_8UC1)
+    if (src.depth() == CV_8U)
     {
-        if (src.type() == CV_8UC1)
+        // the color weights of 8-bit images do not depend on the joint image
+        int jCn = CV_MAT_CN(jointType);
+        double gaussColorCoeff = -0.5 / (sigmaColor*sigmaColor);
+        expLUT.resize(jCn*256);
+        for (int i = 0; i < (int)expLUT.size(); i++)
         {
-            parallel_for_(range, JointBilateralFilter_8u<Vec1b, Vec1b>(jointTemp, srcTemp, dst, radius, maxk, spaceOfsJoint, spaceWeights, expLUT));
+            expLUT[i] = (float)std::exp(i * i * gaussColorCoeff);
         }
-        if (src.type() == CV_8UC3)
+    }
+}
+
+void JointBilateralFilterContext::apply(const Mat& joint, Mat& dst)
+{
+    CV_DbgAssert(joint.type() == jointType && joint.size() == src.size());
+    CV_DbgAssert(dst.type() == src.type() && dst.size() == src.size());
+
+    int jCn = joint.channels();
+    Range range(0, joint.rows);
+
+    if (joint.depth() == CV_8U)
+    {
+        copyMakeBorder(joint, jointTemp, radius, radius, radius, radius, borderType);
+        CV_Assert(jointTemp.step / jointTemp.elemSize() == srcTemp.step / srcTemp.elemSize());
+
+        float *pSpaceWeights = &spaceWeights[0];
+        int *pSpaceOfs = &spaceOfs[0];
+        float *pExpLUT = &expLUT[0];
+        if (joint.type() == CV_8UC1)
         {
-            parallel_for_(range, JointBilateralFilter_8u<Vec1b, Vec3b>(jointTemp, srcTemp, dst, radius, maxk, spaceOfsJoint, spaceWeights, expLUT));
+            if (src.type() == CV_8UC1)
+            {
+                parallel_for_(range, JointBilateralFilter_8u<Vec1b, Vec1b>(jointTemp, srcTemp, dst, radius, maxk, pSpaceOfs, pSpaceWeights, pExpLUT));
+            }
+            if (src.type() == CV_8UC3)
+            {
+                parallel_for_(range, JointBilateralFilter_8u<Vec1b, Vec3b>(jointTemp, srcTemp, dst, radius, maxk, pSpaceOfs, pSpaceWeights, pExpLUT));
+            }
+        }
+
+        if (joint.type() == CV_8UC3)
+        {
+            if (src.type() == CV_8UC1)
+            {
+                parallel_for_(range, JointBilateralFilter_8u<Vec3b, Vec1b>(jointTemp, srcTemp, dst, radius, maxk, pSpaceOfs, pSpaceWeights, pExpLUT));
+            }
+            if (src.type() == CV_8UC3)
+            {
+                parallel_for_(range, JointBilateralFilter_8u<Vec3b, Vec3b>(jointTemp, srcTemp, dst, radius, maxk, pSpaceOfs, pSpaceWeights, pExpLUT));
+            }
         }
+        return;
     }
 
-    if (joint.type() == CV_8UC3)
+    const int kExpNumBinsPerChannel = 1 << 12;
+
+    double minValJoint, maxValJoint;
+    minMaxLoc(joint, &minValJoint, &maxValJoint);
+
+    if (abs(maxValJoint - minValJoint) < FLT_EPSILON)
     {
-        if (src.type() == CV_8UC1)
+        //TODO: make circle pattern instead of square
+        int d = 2*radius + 1;
+        GaussianBlur(src, dst, Size(d, d), sigmaSpace, 0, borderType);
+        return;
+    }
+
+    float colorRange = (float)(maxValJoint - minValJoint) * jCn;
+    colorRange = std::max(0.01f, colorRange);
+
+    int kExpNumBins = kExpNumBinsPerChannel * jCn;
+    expLUT.resize(kExpNumBins + 2);
+    float scaleIndex = kExpNumBins/colorRange;
+
+    double gaussColorCoeff = -0.5 / (sigmaColor*sigmaColor);
+
+    for (int i = 0; i < kExpNumBins + 2; i++)
+    {
+        double val = i / scaleIndex;
+        expLUT[i] = (float) std::exp(val * val * gaussColorCoeff);
+    }
+
+    copyMakeBorder(joint, jointTemp, radius, radius, radius, radius, borderType);
+    CV_Assert(jointTemp.step / jointTemp.elemSize() == srcTemp.step / srcTemp.elemSize());
+
+    float *pSpaceWeights = &spaceWeights[0];
+    int *pSpaceOfs = &spaceOfs[0];
+    float *pExpLUT = &expLUT[0];
+    if (joint.type() == CV_32FC1)
+    {
+        if (src.type() == CV_32FC1)
         {
-            parallel_for_(range, JointBilateralFilter_8u<Vec3b, Vec1b>(jointTemp, srcTemp, dst, radius, maxk, spaceOfsJoint, spaceWeights, expLUT));
+            parallel_for_(range, JointBilateralFilter_32f<Vec1f, Vec1f>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, pSpaceOfs, pSpaceWeights, pExpLUT));
         }
-        if (src.type() == CV_8UC3)
+        if (src.type() == CV_32FC3)
         {
-            parallel_for_(range, JointBilateralFilter_8u<Vec3b, Vec3b>(jointTemp, srcTemp, dst, radius, maxk, spaceOfsJoint, spaceWeights, expLUT));
+            parallel_for_(range, JointBilateralFilter_32f<Vec1f, Vec3f>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, pSpaceOfs, pSpaceWeights, pExpLUT));
         }
     }
+
+    if (joint.type() == CV_32FC3)
+    {
+        if (src.type() == CV_32FC1)
+        {
+            parallel_for_(range, JointBilateralFilter_32f<Vec3f, Vec1f>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, pSpaceOfs, pSpaceWeights, pExpLUT));
+        }
+        if (src.type() == CV_32FC3)
+        {
+            parallel_for_(range, JointBilateralFilter_32f<Vec3f, Vec3f>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, pSpaceOfs, pSpaceWeights, pExpLUT));
+        }
+    }
+}
+
+void JointBilateralFilterContext::release()
+{
+    src.release();
+    srcTemp.release();
+    jointTemp.release();
+    spaceWeights.clear();
+    spaceOfs.clear();
+    expLUT.clear();
 }
 
 void jointBilateralFilter(InputArray joint_, InputArray src_, OutputArray dst_, int d, double sigmaColor, double sigmaSpace, int borderType)
@@ -383,14 +382,9 @@ void jointBilateralFilter(InputArray joint_, InputArray src_, OutputArray dst_,
 
     if ( (srcCnNum == 1 || srcCnNum == 3) && (jointCnNum == 1 || jointCnNum == 3) )
     {
-        if (joint.depth() == CV_8U)
-        {
-            jointBilateralFilter_8u(joint, src, dst, radius, sigmaColor, sigmaSpace, borderType);
-        }
-        else
-        {
-            jointBilateralFilter_32f(joint, src, dst, radius, sigmaColor, sigmaSpace, borderType);
-        }
+        JointBilateralFilterContext context;
+        context.init(src, joint.type(), radius, sigmaColor, sigmaSpace, borderType);
+        context.apply(joint, dst);
     }
     else
     {
@@ -35,49 +35,107 @@
  */
 
 #include "precomp.hpp"
+#include "edgeaware_filters_common.hpp"
 #include <opencv2/ximgproc.hpp>
 
 namespace cv
 {
 namespace ximgproc
 {
-    void rollingGuidanceFilter(InputArray src_, OutputArray dst_, int d,
-                               double sigmaColor, double sigmaSpace,  int numOfIter, int borderType)
-    {
-        CV_Assert(!src_.empty());
 
-        Mat guidance = src_.getMat();
-        Mat src = src_.getMat();
+class RollingGuidanceFilterImpl : public RollingGuidanceFilter
+{
+public:
+
+    RollingGuidanceFilterImpl(int d, double sigmaColor, double sigmaSpace, int numOfIter, int borderType);
+
+    void filter(InputArray src, OutputArray dst) CV_OVERRIDE;
 
-        CV_Assert(src.size() == guidance.size());
-        CV_Assert(src.depth() == guidance.depth() && (src.depth() == CV_8U || src.depth() == CV_32F) );
+    void collectGarbage() CV_OVERRIDE;
 
-        if (sigmaColor <= 0)
-            sigmaColor = 1;
-        if (sigmaSpace <= 0)
-            sigmaSpace = 1;
+protected:
 
-        dst_.create(src.size(), src.type());
-        Mat dst = dst_.getMat();
+    int d, numOfIter, borderType;
+    double sigmaColor, sigmaSpace;
+
+    JointBilateralFilterContext context;
+    Mat guide[2]; // guidance images of the iterations, used in turn
+};
+
+RollingGuidanceFilterImpl::RollingGuidanceFilterImpl(int d_, double sigmaColor_, double sigmaSpace_, int numOfIter_, int borderType_)
+    : d(d_), numOfIter(numOfIter_), borderType(borderType_), sigmaColor(sigmaColor_), sigmaSpace(sigmaSpace_)
+{
+    if (sigmaColor <= 0)
+        sigmaColor = 1;
+    if (sigmaSpace <= 0)
+        sigmaSpace = 1;
+}
+
+void RollingGuidanceFilterImpl::filter(InputArray src_, OutputArray dst_)
+{
+    CV_Assert(!src_.empty());
+
+    Mat src = src_.getMat();
+    CV_Assert(src.depth() == CV_8U || src.depth() == CV_32F);
+
+    int srcCnNum = src.channels();
+    if (srcCnNum != 1 && srcCnNum != 3)
+        CV_Error(Error::BadNumChannels, "Unsupported number of channels");
+
+    dst_.create(src.size(), src.type());
+    Mat dst = dst_.getMat();
+
+    if (numOfIter <= 0)
+    {
+        src.copyTo(dst);
+        return;
+    }
 
-        if (src.data == guidance.data)
-            guidance = guidance.clone();
-        if (dst.data == src.data)
-            src = src.clone();
+    int radius;
+    if (d <= 0)
+        radius = cvRound(sigmaSpace*1.5);
+    else
+        radius = d / 2;
+    radius = std::max(radius, 1);
 
-        int srcCnNum = src.channels();
+    context.init(src, src.type(), radius, sigmaColor, sigmaSpace, borderType);
 
-        if (srcCnNum == 1 || srcCnNum == 3)
-        {
-            while(numOfIter--){
-                jointBilateralFilter(guidance, src, guidance, d, sigmaColor, sigmaSpace, borderType);
-            }
-            guidance.copyTo(dst_);
-        }
+    // the source is border extended by the context, so only the last guidance
+    // image may be written to dst, and only if dst does not share the source data
+    const Mat *joint = &src;
+    for (int iter = 0; iter < numOfIter; iter++)
+    {
+        Mat *out = &guide[iter & 1];
+        if (iter == numOfIter - 1 && dst.data != src.data)
+            out = &dst;
         else
-        {
-            CV_Error(Error::BadNumChannels, "Unsupported number of channels");
-        }
+            out->create(src.size(), src.type());
+
+        context.apply(*joint, *out);
+        joint = out;
     }
+
+    if (joint != &dst)
+        joint->copyTo(dst);
+}
+
+void RollingGuidanceFilterImpl::collectGarbage()
+{
+    context.release();
+    guide[0].release();
+    guide[1].release();
+}
+
+Ptr<RollingGuidanceFilter> createRollingGuidanceFilter(int d, double sigmaColor, double sigmaSpace, int numOfIter, int borderType)
+{
+    return makePtr<RollingGuidanceFilterImpl>(d, sigmaColor, sigmaSpace, numOfIter, borderType);
+}
+
+void rollingGuidanceFilter(InputArray src, OutputArray dst, int d,
+                           double sigmaColor, double sigmaSpace,  int numOfIter, int borderType)
+{
+    createRollingGuidanceFilter(d, sigmaColor, sigmaSpace, numOfIter, borderType)->filter(src, dst);
+}
+
 }
 }
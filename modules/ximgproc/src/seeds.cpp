@@ -40,6 +40,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 /******************************************************************************\
 *                            SEEDS Superpixels                                *
@@ -83,6 +84,8 @@ public:
 
     virtual void iterate(InputArray img, int num_iterations = 4) CV_OVERRIDE;
 
+    virtual void iterateIncremental(InputArray img, int num_iterations = 4) CV_OVERRIDE;
+
 
     virtual void getLabels(OutputArray labels_out) CV_OVERRIDE;
     virtual void getLabelContourMask(OutputArray image, bool thick_line = false) CV_OVERRIDE;
@@ -91,6 +94,7 @@ private:
     /* initialization */
     void initialize(int num_superpixels, int num_levels);
     void initImage(InputArray img);
+    void computeImageBins(InputArray img);
     void assignLabels();
     void computeHistograms(int until_level = -1);
     template<typename _Tp>
@@ -109,6 +113,10 @@ private:
     inline void updateLabels();
     // main loop for pixel updating
     void updatePixels();
+    // proposes to move the pixel (x, y) to the superpixel of its right/bottom neighbour or
+    // the other way round; returns one of the SWEEP_* values
+    int updatePixelH(int x, int y, int tile_x, int tile_y);
+    int updatePixelV(int x, int y, int tile_x, int tile_y);
 
 
     /* block operations */
@@ -122,6 +130,19 @@ private:
 
     //main loop for block updates
     void updateBlocks(int level, float req_confidence = 0.0f);
+    // same as updatePixelH/V for the block (x, y) of the given level
+    int updateBlockH(int level, int x, int y, float req_confidence, int tile_x, int tile_y);
+    int updateBlockV(int level, int x, int y, float req_confidence, int tile_x, int tile_y);
+
+    /* parallel updates */
+    enum { SWEEP_NEXT = 0, SWEEP_SKIP = 1, SWEEP_DEFER = 2 };
+    void initTiles();
+    int initialToplevelLabel(int level, int label) const;
+    bool computeTileBounds(int level, int nr_units, bool horizontal, vector<int>& bounds) const;
+    inline bool ownsLabels(int label1, int label2, int tile_x, int tile_y) const;
+    template<typename Visitor>
+    void checkerboardSweep(int level, int x_begin, int x_end, int y_begin, int y_end,
+            bool row_major, const Visitor& visit);
 
     /* go to next block level */
     int goDownOneLevel();
@@ -172,6 +193,13 @@ private:
     vector<HISTN*> histogram; //[level][label * histogram_size_aligned + j]
     vector<HISTN*> T; //[level][label] how many pixels with this label
 
+    bool labels_valid; // labels hold the result of a previous call (for iterateIncremental)
+
+    // tiles used to run updates concurrently, see checkerboardSweep()
+    // [level + 1][tile] first column/row of the units (level -1: pixels) of each tile,
+    // empty if the level cannot be updated concurrently
+    vector<vector<int> > tile_cols, tile_rows;
+
     /* OpenCV containers for our memory arrays. This makes sure memory is
      * allocated & released properly */
     Mat labels_mat;
@@ -207,6 +235,7 @@ SuperpixelSEEDSImpl::SuperpixelSEEDSImpl(int image_width, int image_height, int
         histogram_size *= nr_bins;
     histogram_size_aligned = (histogram_size
         + ((CV_MALLOC_ALIGN / sizeof(HISTN)) - 1)) & -static_cast<int>(CV_MALLOC_ALIGN / sizeof(HISTN));
+    labels_valid = false;
 
     initialize(num_superpixels, num_levels);
 }
@@ -233,6 +262,30 @@ void SuperpixelSEEDSImpl::iterate(InputArray img, int num_iterations)
 
     for (int i = 0; i < num_iterations; ++i)
         updatePixels();
+
+    labels_valid = true;
+}
+
+void SuperpixelSEEDSImpl::iterateIncremental(InputArray img, int num_iterations)
+{
+    if( !labels_valid )
+    {
+        iterate(img, num_iterations);
+        return;
+    }
+
+    computeImageBins(img);
+
+    // rebuild the superpixel histograms from the current labels and the new image,
+    // then only refine the boundaries at pixel level
+    int nr_labels = nrLabels(seeds_top_level);
+    memset(histogram[seeds_top_level], 0, sizeof(HISTN) * histogram_size_aligned * nr_labels);
+    memset(T[seeds_top_level], 0, sizeof(HISTN) * nr_labels);
+    for (int i = 0; i < width * height; ++i)
+        addPixel(seeds_top_level, labels[i], i);
+
+    for (int i = 0; i < num_iterations; ++i)
+        updatePixels();
 }
 void SuperpixelSEEDSImpl::getLabels(OutputArray labels_out)
 {
@@ -329,6 +382,174 @@ void SuperpixelSEEDSImpl::initialize(int num_superpixels, int num_levels)
         T_mat[level] = Mat(nr_wh[2 * level + 1], nr_wh[2 * level], CV_32FC1);
         T[level] = (HISTN*)T_mat[level].data;
     }
+
+    initTiles();
+}
+
+/* Updates at a given level are proposed for every pair of neighbouring units (pixels or
+ * blocks) and only modify the histograms of the two superpixels involved, plus the labels
+ * of the two units. To run them concurrently, the units are grouped in tiles: the units
+ * initially belonging to the same superpixel. Tiles are processed in 9 phases, so that
+ * tiles of the same phase are 3 tiles apart. A tile only handles the pairs whose two
+ * superpixels come from its 3x3 tile neighbourhood: those neighbourhoods do not overlap
+ * within a phase. The rare pairs of superpixels that drifted further are handled
+ * sequentially afterwards. Updates read and write at most 2 units past a tile, while
+ * tiles of the same phase are at least 4 units apart.
+ * The processing order only depends on the image size, not on the number of threads. */
+void SuperpixelSEEDSImpl::initTiles()
+{
+    tile_cols.assign(seeds_nr_levels, vector<int>());
+    tile_rows.assign(seeds_nr_levels, vector<int>());
+
+    for (int level = -1; level < seeds_top_level; level++)
+    {
+        int units_x = level < 0 ? width : nr_wh[2 * level];
+        int units_y = level < 0 ? height : nr_wh[2 * level + 1];
+        vector<int> cols, rows;
+
+        if( computeTileBounds(level, units_x, true, cols) &&
+                computeTileBounds(level, units_y, false, rows) )
+        {
+            tile_cols[level + 1].swap(cols);
+            tile_rows[level + 1].swap(rows);
+        }
+    }
+}
+
+int SuperpixelSEEDSImpl::initialToplevelLabel(int level, int label) const
+{
+    if( level < 0 )
+    {
+        label = labels_bottom[label];
+        level = 0;
+    }
+    for (; level < seeds_top_level; level++)
+        label = parent_pre_init[level][label];
+    return label;
+}
+
+bool SuperpixelSEEDSImpl::computeTileBounds(int level, int nr_units, bool horizontal,
+        vector<int>& bounds) const
+{
+    const int nr_w = nr_wh[2 * seeds_top_level];
+    const int nr_tiles = horizontal ? nr_w : nr_wh[2 * seeds_top_level + 1];
+    const int unit_step = horizontal ? 1 : (level < 0 ? width : nr_wh[2 * level]);
+
+    vector<int> unit_tile(nr_units);
+    for (int unit = 0; unit < nr_units; unit++)
+    {
+        int label = initialToplevelLabel(level, unit * unit_step);
+        unit_tile[unit] = horizontal ? label % nr_w : label / nr_w;
+        if( unit > 0 && unit_tile[unit] < unit_tile[unit - 1] )
+            return false;
+    }
+
+    bounds.resize(nr_tiles + 1);
+    int unit = 0;
+    for (int t = 0; t <= nr_tiles; t++)
+    {
+        while( unit < nr_units && unit_tile[unit] < t )
+            unit++;
+        bounds[t] = unit;
+    }
+
+    for (int t = 0; t < nr_tiles; t++)
+    {
+        if( bounds[t + 1] - bounds[t] < 2 )
+            return false;
+    }
+    return true;
+}
+
+bool SuperpixelSEEDSImpl::ownsLabels(int label1, int label2, int tile_x, int tile_y) const
+{
+    if( tile_x < 0 )
+        return true;
+    const int nr_w = nr_wh[2 * seeds_top_level];
+    return std::abs(label1 % nr_w - tile_x) <= 1 && std::abs(label1 / nr_w - tile_y) <= 1 &&
+           std::abs(label2 % nr_w - tile_x) <= 1 && std::abs(label2 / nr_w - tile_y) <= 1;
+}
+
+template<typename Visitor>
+void SuperpixelSEEDSImpl::checkerboardSweep(int level, int x_begin, int x_end, int y_begin,
+        int y_end, bool row_major, const Visitor& visit)
+{
+    const vector<int>& cols = tile_cols[level + 1];
+    const vector<int>& rows = tile_rows[level + 1];
+
+    if( cols.empty() )
+    {
+        // tiles too small: plain sequential sweep
+        if( row_major )
+        {
+            for (int y = y_begin; y < y_end; y++)
+                for (int x = x_begin; x < x_end; x++)
+                    if( visit(x, y, -1, -1) == SWEEP_SKIP )
+                        x++;
+        }
+        else
+        {
+            for (int x = x_begin; x < x_end; x++)
+                for (int y = y_begin; y < y_end; y++)
+                    if( visit(x, y, -1, -1) == SWEEP_SKIP )
+                        y++;
+        }
+        return;
+    }
+
+    const int tiles_x = (int)cols.size() - 1;
+    const int tiles_y = (int)rows.size() - 1;
+    vector<vector<Point> > deferred(tiles_x * tiles_y);
+
+    for (int phase = 0; phase < 9; phase++)
+    {
+        const int phase_x = phase % 3, phase_y = phase / 3;
+        const int nx = (tiles_x - phase_x + 2) / 3;
+        const int ny = (tiles_y - phase_y + 2) / 3;
+        if( nx <= 0 || ny <= 0 )
+            continue;
+
+        parallel_for_(Range(0, nx * ny), [&](const Range& range)
+        {
+            for (int i = range.start; i < range.end; i++)
+            {
+                const int tx = phase_x + 3 * (i % nx);
+                const int ty = phase_y + 3 * (i / nx);
+                const int x0 = std::max(cols[tx], x_begin), x1 = std::min(cols[tx + 1], x_end);
+                const int y0 = std::max(rows[ty], y_begin), y1 = std::min(rows[ty + 1], y_end);
+                vector<Point>& tile_deferred = deferred[ty * tiles_x + tx];
+
+                if( row_major )
+                {
+                    for (int y = y0; y < y1; y++)
+                        for (int x = x0; x < x1; x++)
+                        {
+                            int res = visit(x, y, tx, ty);
+                            if( res == SWEEP_SKIP )
+                                x++;
+                            else if( res == SWEEP_DEFER )
+                                tile_deferred.push_back(Point(x, y));
+                        }
+                }
+                else
+                {
+                    for (int x = x0; x < x1; x++)
+                        for (int y = y0; y < y1; y++)
+                        {
+                            int res = visit(x, y, tx, ty);
+                            if( res == SWEEP_SKIP )
+                                y++;
+                            else if( res == SWEEP_DEFER )
+                                tile_deferred.push_back(Point(x, y));
+                        }
+                }
+            }
+        });
+    }
+
+    for (size_t t = 0; t < deferred.size(); t++)
+        for (size_t i = 0; i < deferred[t].size(); i++)
+            visit(deferred[t][i].x, deferred[t][i].y, -1, -1);
 }
 
 
@@ -339,17 +560,20 @@ void SuperpixelSEEDSImpl::initImageBins(const Mat& img, int max_value)
     int img_height = img.size().height;
     int channels = img.channels();
 
-    for (int y = 0; y < img_height; ++y)
+    parallel_for_(Range(0, img_height), [&](const Range& range)
     {
-        for (int x = 0; x < img_width; ++x)
+        for (int y = range.start; y < range.end; ++y)
         {
-            const _Tp* ptr = img.ptr<_Tp>(y, x);
-            int bin = 0;
-            for (int i = 0; i < channels; ++i)
-                bin = bin * nr_bins + (int) ptr[i] * nr_bins / max_value;
-            image_bins[y * img_width + x] = bin;
+            for (int x = 0; x < img_width; ++x)
+            {
+                const _Tp* ptr = img.ptr<_Tp>(y, x);
+                int bin = 0;
+                for (int i = 0; i < channels; ++i)
+                    bin = bin * nr_bins + (int) ptr[i] * nr_bins / max_value;
+                image_bins[y * img_width + x] = bin;
+            }
         }
-    }
+    });
 }
 
 /* specialization for float: max_value is assumed to be 1.0f */
@@ -360,20 +584,35 @@ void SuperpixelSEEDSImpl::initImageBins<float>(const Mat& img, int)
     int img_height = img.size().height;
     int channels = img.channels();
 
-    for (int y = 0; y < img_height; ++y)
+    parallel_for_(Range(0, img_height), [&](const Range& range)
     {
-        for (int x = 0; x < img_width; ++x)
+        for (int y = range.start; y < range.end; ++y)
         {
-            const float* ptr = img.ptr<float>(y, x);
-            int bin = 0;
-            for(int i=0; i<channels; ++i)
-                bin = bin * nr_bins + std::min((int)(ptr[i] * (float)nr_bins), nr_bins-1);
-            image_bins[y*img_width + x] = bin;
+            for (int x = 0; x < img_width; ++x)
+            {
+                const float* ptr = img.ptr<float>(y, x);
+                int bin = 0;
+                for(int i=0; i<channels; ++i)
+                    bin = bin * nr_bins + std::min((int)(ptr[i] * (float)nr_bins), nr_bins-1);
+                image_bins[y*img_width + x] = bin;
+            }
         }
-    }
+    });
 }
 
 void SuperpixelSEEDSImpl::initImage(InputArray img)
+{
+    seeds_current_level = seeds_nr_levels - 2;
+    forwardbackward = true;
+
+    assignLabels();
+
+    computeImageBins(img);
+
+    computeHistograms();
+}
+
+void SuperpixelSEEDSImpl::computeImageBins(InputArray img)
 {
     Mat src;
 
@@ -401,10 +640,6 @@ void SuperpixelSEEDSImpl::initImage(InputArray img)
       CV_Error( Error::StsInternal, "Invalid InputArray." );
 
     int depth = src.depth();
-    seeds_current_level = seeds_nr_levels - 2;
-    forwardbackward = true;
-
-    assignLabels();
 
     CV_Assert(src.size().width == width && src.size().height == height);
     CV_Assert(depth == CV_8U || depth == CV_16U || depth == CV_32F);
@@ -423,8 +658,6 @@ void SuperpixelSEEDSImpl::initImage(InputArray img)
         initImageBins<float>(src, 1);
         break;
     }
-
-    computeHistograms();
 }
 
 // adds labeling to all the blocks at all levels and sets the correct parents
@@ -473,136 +706,144 @@ void SuperpixelSEEDSImpl::computeHistograms(int until_level)
 
 void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
 {
-    int labelA;
-    int labelB;
-    int sublabel;
-    bool done;
+    // horizontal bidirectional block updating
+    checkerboardSweep(level, 1, nr_wh[2 * level] - 2, 1, nr_wh[2 * level + 1] - 1, true,
+        [&](int x, int y, int tile_x, int tile_y)
+        {
+            return updateBlockH(level, x, y, req_confidence, tile_x, tile_y);
+        });
+
+    // vertical bidirectional
+    checkerboardSweep(level, 1, nr_wh[2 * level] - 1, 1, nr_wh[2 * level + 1] - 2, false,
+        [&](int x, int y, int tile_x, int tile_y)
+        {
+            return updateBlockV(level, x, y, req_confidence, tile_x, tile_y);
+        });
+}
+
+int SuperpixelSEEDSImpl::updateBlockH(int level, int x, int y, float req_confidence,
+        int tile_x, int tile_y)
+{
     int step = nr_wh[2 * level];
+    // choose a label at the current level
+    int sublabel = y * step + x;
+    // get the label at the top level (= superpixel label)
+    int labelA = parent[level][y * step + x];
+    // get the neighboring label at the top level (= superpixel label)
+    int labelB = parent[level][y * step + x + 1];
+
+    if( labelA == labelB )
+        return SWEEP_NEXT;
+    if( !ownsLabels(labelA, labelB, tile_x, tile_y) )
+        return SWEEP_DEFER;
+
+    // get the surrounding labels at the top level, to check for splitting
+    int a11 = parent[level][(y - 1) * step + (x - 1)];
+    int a12 = parent[level][(y - 1) * step + (x)];
+    int a21 = parent[level][(y) * step + (x - 1)];
+    int a22 = parent[level][(y) * step + (x)];
+    int a31 = parent[level][(y + 1) * step + (x - 1)];
+    int a32 = parent[level][(y + 1) * step + (x)];
+
+    if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
+            && checkSplit_hf(a11, a12, a21, a22, a31, a32)) )
+    {
+        // run algorithm as usual
+        float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
+        if( conf > req_confidence )
+        {
+            deleteBlockToplevel(labelA, level, sublabel);
+            addBlockToplevel(labelB, level, sublabel);
+            return SWEEP_NEXT;
+        }
+    }
 
-    // horizontal bidirectional block updating
-    for (int y = 1; y < nr_wh[2 * level + 1] - 1; y++)
+    if( nr_partitions[labelB] > MINIMUM_NR_SUBLABELS )
     {
-        for (int x = 1; x < nr_wh[2 * level] - 2; x++)
+        // try opposite direction
+        sublabel = y * step + x + 1;
+        int a13 = parent[level][(y - 1) * step + (x + 1)];
+        int a14 = parent[level][(y - 1) * step + (x + 2)];
+        int a23 = parent[level][(y) * step + (x + 1)];
+        int a24 = parent[level][(y) * step + (x + 2)];
+        int a33 = parent[level][(y + 1) * step + (x + 1)];
+        int a34 = parent[level][(y + 1) * step + (x + 2)];
+        if( nr_partitions[labelB] <= 2 // == 2
+                || (nr_partitions[labelB] > 2 && checkSplit_hb(a13, a14, a23, a24, a33, a34)) )
         {
-            // choose a label at the current level
-            sublabel = y * step + x;
-            // get the label at the top level (= superpixel label)
-            labelA = parent[level][y * step + x];
-            // get the neighboring label at the top level (= superpixel label)
-            labelB = parent[level][y * step + x + 1];
-
-            if( labelA == labelB )
-                continue;
-
-            // get the surrounding labels at the top level, to check for splitting
-            int a11 = parent[level][(y - 1) * step + (x - 1)];
-            int a12 = parent[level][(y - 1) * step + (x)];
-            int a21 = parent[level][(y) * step + (x - 1)];
-            int a22 = parent[level][(y) * step + (x)];
-            int a31 = parent[level][(y + 1) * step + (x - 1)];
-            int a32 = parent[level][(y + 1) * step + (x)];
-            done = false;
-
-            if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
-                    && checkSplit_hf(a11, a12, a21, a22, a31, a32)) )
+            // run algorithm as usual
+            float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
+            if( conf > req_confidence )
             {
-                // run algorithm as usual
-                float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
-                if( conf > req_confidence )
-                {
-                    deleteBlockToplevel(labelA, level, sublabel);
-                    addBlockToplevel(labelB, level, sublabel);
-                    done = true;
-                }
+                deleteBlockToplevel(labelB, level, sublabel);
+                addBlockToplevel(labelA, level, sublabel);
+                return SWEEP_SKIP;
             }
+        }
+    }
+    return SWEEP_NEXT;
+}
 
-            if( !done && (nr_partitions[labelB] > MINIMUM_NR_SUBLABELS) )
-            {
-                // try opposite direction
-                sublabel = y * step + x + 1;
-                int a13 = parent[level][(y - 1) * step + (x + 1)];
-                int a14 = parent[level][(y - 1) * step + (x + 2)];
-                int a23 = parent[level][(y) * step + (x + 1)];
-                int a24 = parent[level][(y) * step + (x + 2)];
-                int a33 = parent[level][(y + 1) * step + (x + 1)];
-                int a34 = parent[level][(y + 1) * step + (x + 2)];
-                if( nr_partitions[labelB] <= 2 // == 2
-                        || (nr_partitions[labelB] > 2 && checkSplit_hb(a13, a14, a23, a24, a33, a34)) )
-                {
-                    // run algorithm as usual
-                    float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
-                    if( conf > req_confidence )
-                    {
-                        deleteBlockToplevel(labelB, level, sublabel);
-                        addBlockToplevel(labelA, level, sublabel);
-                        x++;
-                    }
-                }
-            }
+int SuperpixelSEEDSImpl::updateBlockV(int level, int x, int y, float req_confidence,
+        int tile_x, int tile_y)
+{
+    int step = nr_wh[2 * level];
+    // choose a label at the current level
+    int sublabel = y * step + x;
+    // get the label at the top level (= superpixel label)
+    int labelA = parent[level][y * step + x];
+    // get the neighboring label at the top level (= superpixel label)
+    int labelB = parent[level][(y + 1) * step + x];
+
+    if( labelA == labelB )
+        return SWEEP_NEXT;
+    if( !ownsLabels(labelA, labelB, tile_x, tile_y) )
+        return SWEEP_DEFER;
+
+    int a11 = parent[level][(y - 1) * step + (x - 1)];
+    int a12 = parent[level][(y - 1) * step + (x)];
+    int a13 = parent[level][(y - 1) * step + (x + 1)];
+    int a21 = parent[level][(y) * step + (x - 1)];
+    int a22 = parent[level][(y) * step + (x)];
+    int a23 = parent[level][(y) * step + (x + 1)];
+
+    if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
+            && checkSplit_vf(a11, a12, a13, a21, a22, a23)) )
+    {
+        // run algorithm as usual
+        float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
+        if( conf > req_confidence )
+        {
+            deleteBlockToplevel(labelA, level, sublabel);
+            addBlockToplevel(labelB, level, sublabel);
+            return SWEEP_NEXT;
         }
     }
 
-    // vertical bidirectional
-    for (int x = 1; x < nr_wh[2 * level] - 1; x++)
+    if( nr_partitions[labelB] > MINIMUM_NR_SUBLABELS )
     {
-        for (int y = 1; y < nr_wh[2 * level + 1] - 2; y++)
+        // try opposite direction
+        sublabel = (y + 1) * step + x;
+        int a31 = parent[level][(y + 1) * step + (x - 1)];
+        int a32 = parent[level][(y + 1) * step + (x)];
+        int a33 = parent[level][(y + 1) * step + (x + 1)];
+        int a41 = parent[level][(y + 2) * step + (x - 1)];
+        int a42 = parent[level][(y + 2) * step + (x)];
+        int a43 = parent[level][(y + 2) * step + (x + 1)];
+        if( nr_partitions[labelB] <= 2 // == 2
+                || (nr_partitions[labelB] > 2 && checkSplit_vb(a31, a32, a33, a41, a42, a43)) )
         {
-            // choose a label at the current level
-            sublabel = y * step + x;
-            // get the label at the top level (= superpixel label)
-            labelA = parent[level][y * step + x];
-            // get the neighboring label at the top level (= superpixel label)
-            labelB = parent[level][(y + 1) * step + x];
-
-            if( labelA == labelB )
-                continue;
-
-            int a11 = parent[level][(y - 1) * step + (x - 1)];
-            int a12 = parent[level][(y - 1) * step + (x)];
-            int a13 = parent[level][(y - 1) * step + (x + 1)];
-            int a21 = parent[level][(y) * step + (x - 1)];
-            int a22 = parent[level][(y) * step + (x)];
-            int a23 = parent[level][(y) * step + (x + 1)];
-
-            done = false;
-            if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
-                    && checkSplit_vf(a11, a12, a13, a21, a22, a23)) )
+            // run algorithm as usual
+            float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
+            if( conf > req_confidence )
             {
-                // run algorithm as usual
-                float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
-                if( conf > req_confidence )
-                {
-                    deleteBlockToplevel(labelA, level, sublabel);
-                    addBlockToplevel(labelB, level, sublabel);
-                    done = true;
-                }
-            }
-
-            if( !done && (nr_partitions[labelB] > MINIMUM_NR_SUBLABELS) )
-            {
-                // try opposite direction
-                sublabel = (y + 1) * step + x;
-                int a31 = parent[level][(y + 1) * step + (x - 1)];
-                int a32 = parent[level][(y + 1) * step + (x)];
-                int a33 = parent[level][(y + 1) * step + (x + 1)];
-                int a41 = parent[level][(y + 2) * step + (x - 1)];
-                int a42 = parent[level][(y + 2) * step + (x)];
-                int a43 = parent[level][(y + 2) * step + (x + 1)];
-                if( nr_partitions[labelB] <= 2 // == 2
-                        || (nr_partitions[labelB] > 2 && checkSplit_vb(a31, a32, a33, a41, a42, a43)) )
-                {
-                    // run algorithm as usual
-                    float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
-                    if( conf > req_confidence )
-                    {
-                        deleteBlockToplevel(labelB, level, sublabel);
-                        addBlockToplevel(labelA, level, sublabel);
-                        y++;
-                    }
-                }
+                deleteBlockToplevel(labelB, level, sublabel);
+                addBlockToplevel(labelA, level, sublabel);
+                return SWEEP_SKIP;
             }
         }
     }
+    return SWEEP_NEXT;
 }
 
 int SuperpixelSEEDSImpl::goDownOneLevel()
@@ -639,192 +880,19 @@ void SuperpixelSEEDSImpl::updatePixels()
 {
     int labelA;
     int labelB;
-    int priorA = 0;
-    int priorB = 0;
 
-    for (int y = 1; y < height - 1; y++)
-    {
-        for (int x = 1; x < width - 2; x++)
+    checkerboardSweep(-1, 1, width - 2, 1, height - 1, true,
+        [&](int x, int y, int tile_x, int tile_y)
         {
+            return updatePixelH(x, y, tile_x, tile_y);
+        });
 
-            labelA = labels[(y) * width + (x)];
-            labelB = labels[(y) * width + (x + 1)];
-
-            if( labelA != labelB )
-            {
-                int a22 = labelA;
-                int a23 = labelB;
-                if( forwardbackward )
-                {
-                    // horizontal bidirectional
-                    int a11 = labels[(y - 1) * width + (x - 1)];
-                    int a12 = labels[(y - 1) * width + (x)];
-                    int a21 = labels[(y) * width + (x - 1)];
-                    int a31 = labels[(y + 1) * width + (x - 1)];
-                    int a32 = labels[(y + 1) * width + (x)];
-                    if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
-                    {
-                        if( seeds_prior )
-                        {
-                            priorA = threebyfour(x, y, labelA);
-                            priorB = threebyfour(x, y, labelB);
-                        }
-
-                        if( probability(y * width + x, labelA, labelB, priorA, priorB) )
-                        {
-                            update(labelB, y * width + x, labelA);
-                        }
-                        else
-                        {
-                            int a13 = labels[(y - 1) * width + (x + 1)];
-                            int a14 = labels[(y - 1) * width + (x + 2)];
-                            int a24 = labels[(y) * width + (x + 2)];
-                            int a33 = labels[(y + 1) * width + (x + 1)];
-                            int a34 = labels[(y + 1) * width + (x + 2)];
-                            if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
-                            {
-                                if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
-                                {
-                                    update(labelA, y * width + x + 1, labelB);
-                                    x++;
-                                }
-                            }
-                        }
-                    }
-                }
-                else
-                { // forward backward
-                    // horizontal bidirectional
-                    int a13 = labels[(y - 1) * width + (x + 1)];
-                    int a14 = labels[(y - 1) * width + (x + 2)];
-                    int a24 = labels[(y) * width + (x + 2)];
-                    int a33 = labels[(y + 1) * width + (x + 1)];
-                    int a34 = labels[(y + 1) * width + (x + 2)];
-                    if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
-                    {
-                        if( seeds_prior )
-                        {
-                            priorA = threebyfour(x, y, labelA);
-                            priorB = threebyfour(x, y, labelB);
-                        }
-
-                        if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
-                        {
-                            update(labelA, y * width + x + 1, labelB);
-                            x++;
-                        }
-                        else
-                        {
-                            int a11 = labels[(y - 1) * width + (x - 1)];
-                            int a12 = labels[(y - 1) * width + (x)];
-                            int a21 = labels[(y) * width + (x - 1)];
-                            int a31 = labels[(y + 1) * width + (x - 1)];
-                            int a32 = labels[(y + 1) * width + (x)];
-                            if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
-                            {
-                                if( probability(y * width + x, labelA, labelB, priorA, priorB) )
-                                {
-                                    update(labelB, y * width + x, labelA);
-                                }
-                            }
-                        }
-                    }
-                }
-            } // labelA != labelB
-        } // for x
-    } // for y
-
-    for (int x = 1; x < width - 1; x++)
-    {
-        for (int y = 1; y < height - 2; y++)
+    checkerboardSweep(-1, 1, width - 1, 1, height - 2, false,
+        [&](int x, int y, int tile_x, int tile_y)
         {
+            return updatePixelV(x, y, tile_x, tile_y);
+        });
 
-            labelA = labels[(y) * width + (x)];
-            labelB = labels[(y + 1) * width + (x)];
-            if( labelA != labelB )
-            {
-                int a22 = labelA;
-                int a32 = labelB;
-
-                if( forwardbackward )
-                {
-                    // vertical bidirectional
-                    int a11 = labels[(y - 1) * width + (x - 1)];
-                    int a12 = labels[(y - 1) * width + (x)];
-                    int a13 = labels[(y - 1) * width + (x + 1)];
-                    int a21 = labels[(y) * width + (x - 1)];
-                    int a23 = labels[(y) * width + (x + 1)];
-                    if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
-                    {
-                        if( seeds_prior )
-                        {
-                            priorA = fourbythree(x, y, labelA);
-                            priorB = fourbythree(x, y, labelB);
-                        }
-
-                        if( probability(y * width + x, labelA, labelB, priorA, priorB) )
-                        {
-                            update(labelB, y * width + x, labelA);
-                        }
-                        else
-                        {
-                            int a31 = labels[(y + 1) * width + (x - 1)];
-                            int a33 = labels[(y + 1) * width + (x + 1)];
-                            int a41 = labels[(y + 2) * width + (x - 1)];
-                            int a42 = labels[(y + 2) * width + (x)];
-                            int a43 = labels[(y + 2) * width + (x + 1)];
-                            if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
-                            {
-                                if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
-                                {
-                                    update(labelA, (y + 1) * width + x, labelB);
-                                    y++;
-                                }
-                            }
-                        }
-                    }
-                }
-                else
-                { // forwardbackward
-                    // vertical bidirectional
-                    int a31 = labels[(y + 1) * width + (x - 1)];
-                    int a33 = labels[(y + 1) * width + (x + 1)];
-                    int a41 = labels[(y + 2) * width + (x - 1)];
-                    int a42 = labels[(y + 2) * width + (x)];
-                    int a43 = labels[(y + 2) * width + (x + 1)];
-                    if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
-                    {
-                        if( seeds_prior )
-                        {
-                            priorA = fourbythree(x, y, labelA);
-                            priorB = fourbythree(x, y, labelB);
-                        }
-
-                        if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
-                        {
-                            update(labelA, (y + 1) * width + x, labelB);
-                            y++;
-                        }
-                        else
-                        {
-                            int a11 = labels[(y - 1) * width + (x - 1)];
-                            int a12 = labels[(y - 1) * width + (x)];
-                            int a13 = labels[(y - 1) * width + (x + 1)];
-                            int a21 = labels[(y) * width + (x - 1)];
-                            int a23 = labels[(y) * width + (x + 1)];
-                            if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
-                            {
-                                if( probability(y * width + x, labelA, labelB, priorA, priorB) )
-                                {
-                                    update(labelB, y * width + x, labelA);
-                                }
-                            }
-                        }
-                    }
-                }
-            } // labelA != labelB
-        } // for y
-    } // for x
     forwardbackward = !forwardbackward;
 
     // update border pixels
@@ -852,6 +920,193 @@ void SuperpixelSEEDSImpl::updatePixels()
     }
 }
 
+int SuperpixelSEEDSImpl::updatePixelH(int x, int y, int tile_x, int tile_y)
+{
+    int labelA = labels[(y) * width + (x)];
+    int labelB = labels[(y) * width + (x + 1)];
+    int priorA = 0;
+    int priorB = 0;
+
+    if( labelA == labelB )
+        return SWEEP_NEXT;
+    if( !ownsLabels(labelA, labelB, tile_x, tile_y) )
+        return SWEEP_DEFER;
+
+    int a22 = labelA;
+    int a23 = labelB;
+    if( forwardbackward )
+    {
+        // horizontal bidirectional
+        int a11 = labels[(y - 1) * width + (x - 1)];
+        int a12 = labels[(y - 1) * width + (x)];
+        int a21 = labels[(y) * width + (x - 1)];
+        int a31 = labels[(y + 1) * width + (x - 1)];
+        int a32 = labels[(y + 1) * width + (x)];
+        if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
+        {
+            if( seeds_prior )
+            {
+                priorA = threebyfour(x, y, labelA);
+                priorB = threebyfour(x, y, labelB);
+            }
+
+            if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+            {
+                update(labelB, y * width + x, labelA);
+            }
+            else
+            {
+                int a13 = labels[(y - 1) * width + (x + 1)];
+                int a14 = labels[(y - 1) * width + (x + 2)];
+                int a24 = labels[(y) * width + (x + 2)];
+                int a33 = labels[(y + 1) * width + (x + 1)];
+                int a34 = labels[(y + 1) * width + (x + 2)];
+                if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
+                {
+                    if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
+                    {
+                        update(labelA, y * width + x + 1, labelB);
+                        return SWEEP_SKIP;
+                    }
+                }
+            }
+        }
+    }
+    else
+    { // forward backward
+        // horizontal bidirectional
+        int a13 = labels[(y - 1) * width + (x + 1)];
+        int a14 = labels[(y - 1) * width + (x + 2)];
+        int a24 = labels[(y) * width + (x + 2)];
+        int a33 = labels[(y + 1) * width + (x + 1)];
+        int a34 = labels[(y + 1) * width + (x + 2)];
+        if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
+        {
+            if( seeds_prior )
+            {
+                priorA = threebyfour(x, y, labelA);
+                priorB = threebyfour(x, y, labelB);
+            }
+
+            if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
+            {
+                update(labelA, y * width + x + 1, labelB);
+                return SWEEP_SKIP;
+            }
+            else
+            {
+                int a11 = labels[(y - 1) * width + (x - 1)];
+                int a12 = labels[(y - 1) * width + (x)];
+                int a21 = labels[(y) * width + (x - 1)];
+                int a31 = labels[(y + 1) * width + (x - 1)];
+                int a32 = labels[(y + 1) * width + (x)];
+                if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
+                {
+                    if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                    {
+                        update(labelB, y * width + x, labelA);
+                    }
+                }
+            }
+        }
+    }
+    return SWEEP_NEXT;
+}
+
+int SuperpixelSEEDSImpl::updatePixelV(int x, int y, int tile_x, int tile_y)
+{
+    int labelA = labels[(y) * width + (x)];
+    int labelB = labels[(y + 1) * width + (x)];
+    int priorA = 0;
+    int priorB = 0;
+
+    if( labelA == labelB )
+        return SWEEP_NEXT;
+    if( !ownsLabels(labelA, labelB, tile_x, tile_y) )
+        return SWEEP_DEFER;
+
+    int a22 = labelA;
+    int a32 = labelB;
+
+    if( forwardbackward )
+    {
+        // vertical bidirectional
+        int a11 = labels[(y - 1) * width + (x - 1)];
+        int a12 = labels[(y - 1) * width + (x)];
+        int a13 = labels[(y - 1) * width + (x + 1)];
+        int a21 = labels[(y) * width + (x - 1)];
+        int a23 = labels[(y) * width + (x + 1)];
+        if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
+        {
+            if( seeds_prior )
+            {
+                priorA = fourbythree(x, y, labelA);
+                priorB = fourbythree(x, y, labelB);
+            }
+
+            if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+            {
+                update(labelB, y * width + x, labelA);
+            }
+            else
+            {
+                int a31 = labels[(y + 1) * width + (x - 1)];
+                int a33 = labels[(y + 1) * width + (x + 1)];
+                int a41 = labels[(y + 2) * width + (x - 1)];
+                int a42 = labels[(y + 2) * width + (x)];
+                int a43 = labels[(y + 2) * width + (x + 1)];
+                if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
+                {
+                    if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
+                    {
+                        update(labelA, (y + 1) * width + x, labelB);
+                        return SWEEP_SKIP;
+                    }
+                }
+            }
+        }
+    }
+    else
+    { // forwardbackward
+        // vertical bidirectional
+        int a31 = labels[(y + 1) * width + (x - 1)];
+        int a33 = labels[(y + 1) * width + (x + 1)];
+        int a41 = labels[(y + 2) * width + (x - 1)];
+        int a42 = labels[(y + 2) * width + (x)];
+        int a43 = labels[(y + 2) * width + (x + 1)];
+        if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
+        {
+            if( seeds_prior )
+            {
+                priorA = fourbythree(x, y, labelA);
+                priorB = fourbythree(x, y, labelB);
+            }
+
+            if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
+            {
+                update(labelA, (y + 1) * width + x, labelB);
+                return SWEEP_SKIP;
+            }
+            else
+            {
+                int a11 = labels[(y - 1) * width + (x - 1)];
+                int a12 = labels[(y - 1) * width + (x)];
+                int a13 = labels[(y - 1) * width + (x + 1)];
+                int a21 = labels[(y) * width + (x - 1)];
+                int a23 = labels[(y) * width + (x + 1)];
+                if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
+                {
+                    if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                    {
+                        update(labelB, y * width + x, labelA);
+                    }
+                }
+            }
+        }
+    }
+    return SWEEP_NEXT;
+}
+
 void SuperpixelSEEDSImpl::update(int label_new, int image_idx, int label_old)
 {
     //change the label of a single pixel
@@ -882,15 +1137,12 @@ void SuperpixelSEEDSImpl::addBlock(int level, int label, int sublevel,
 
     //add the (sublevel, sublabel) block to the block (level, label)
     int n = 0;
-#if CV_SSSE3
+#if CV_SIMD128
     const int loop_end = histogram_size - 3;
     for (; n < loop_end; n += 4)
     {
         //this does exactly the same as the loop peeling below, but 4 elements at a time
-        __m128 h_labelp = _mm_load_ps(h_label + n);
-        __m128 h_sublabelp = _mm_load_ps(h_sublabel + n);
-        h_labelp = _mm_add_ps(h_labelp, h_sublabelp);
-        _mm_store_ps(h_label + n, h_labelp);
+        v_store_aligned(h_label + n, v_load_aligned(h_label + n) + v_load_aligned(h_sublabel + n));
     }
 #endif
 
@@ -914,15 +1166,12 @@ void SuperpixelSEEDSImpl::deleteBlockToplevel(int label, int sublevel, int subla
 
     //do the reverse operation of add_block_toplevel
     int n = 0;
-#if CV_SSSE3
+#if CV_SIMD128
     const int loop_end = histogram_size - 3;
     for (; n < loop_end; n += 4)
     {
         //this does exactly the same as the loop peeling below, but 4 elements at a time
-        __m128 h_labelp = _mm_load_ps(h_label + n);
-        __m128 h_sublabelp = _mm_load_ps(h_sublabel + n);
-        h_labelp = _mm_sub_ps(h_labelp, h_sublabelp);
-        _mm_store_ps(h_label + n, h_labelp);
+        v_store_aligned(h_label + n, v_load_aligned(h_label + n) - v_load_aligned(h_sublabel + n));
     }
 #endif
 
@@ -988,28 +1237,18 @@ int SuperpixelSEEDSImpl::threebyfour(int x, int y, int label)
      * x x x x
      */
 
-#if CV_SSSE3
-    __m128i addp = _mm_set1_epi32(1);
-    __m128i addp_middle = _mm_set_epi32(1, 0, 0, 1);
-    __m128i labelp = _mm_set1_epi32(label);
+#if CV_SIMD128
+    v_int32x4 addp = v_setall_s32(1);
+    v_int32x4 addp_middle(1, 0, 0, 1);
+    v_int32x4 labelp = v_setall_s32(label);
     /* 1. row */
-    __m128i data1 = _mm_loadu_si128((__m128i*) (labels + (y-1)*width + x -1));
-    __m128i mask1 = _mm_cmpeq_epi32(data1, labelp);
-    __m128i countp = _mm_and_si128(mask1, addp);
+    v_int32x4 countp = (v_load(labels + (y-1)*width + x - 1) == labelp) & addp;
     /* 2. row */
-    __m128i data2 = _mm_loadu_si128((__m128i*) (labels + y*width + x -1));
-    __m128i mask2 = _mm_cmpeq_epi32(data2, labelp);
-    __m128i count1 = _mm_and_si128(mask2, addp_middle);
-    countp = _mm_add_epi32(countp, count1);
+    countp += (v_load(labels + y*width + x - 1) == labelp) & addp_middle;
     /* 3. row */
-    __m128i data3 = _mm_loadu_si128((__m128i*) (labels + (y+1)*width + x -1));
-    __m128i mask3 = _mm_cmpeq_epi32(data3, labelp);
-    __m128i count3 = _mm_and_si128(mask3, addp);
-    countp = _mm_add_epi32(count3, countp);
-
-    countp = _mm_hadd_epi32(countp, countp);
-    countp = _mm_hadd_epi32(countp, countp);
-    return _mm_cvtsi128_si32(countp);
+    countp += (v_load(labels + (y+1)*width + x - 1) == labelp) & addp;
+
+    return v_reduce_sum(countp);
 #else
     int count = 0;
     count += (labels[(y - 1) * width + x - 1] == label);
@@ -1039,33 +1278,20 @@ int SuperpixelSEEDSImpl::fourbythree(int x, int y, int label)
      * x x x o
      */
 
-#if CV_SSSE3
-    __m128i addp_border = _mm_set_epi32(0, 1, 1, 1);
-    __m128i addp_middle = _mm_set_epi32(1, 0, 0, 1);
-    __m128i labelp = _mm_set1_epi32(label);
+#if CV_SIMD128
+    v_int32x4 addp_border(1, 1, 1, 0);
+    v_int32x4 addp_middle(1, 0, 0, 1);
+    v_int32x4 labelp = v_setall_s32(label);
     /* 1. row */
-    __m128i data1 = _mm_loadu_si128((__m128i*) (labels + (y-1)*width + x -1));
-    __m128i mask1 = _mm_cmpeq_epi32(data1, labelp);
-    __m128i countp = _mm_and_si128(mask1, addp_border);
+    v_int32x4 countp = (v_load(labels + (y-1)*width + x - 1) == labelp) & addp_border;
     /* 2. row */
-    __m128i data2 = _mm_loadu_si128((__m128i*) (labels + y*width + x -1));
-    __m128i mask2 = _mm_cmpeq_epi32(data2, labelp);
-    __m128i count1 = _mm_and_si128(mask2, addp_middle);
-    countp = _mm_add_epi32(countp, count1);
+    countp += (v_load(labels + y*width + x - 1) == labelp) & addp_middle;
     /* 3. row */
-    __m128i data3 = _mm_loadu_si128((__m128i*) (labels + (y+1)*width + x -1));
-    __m128i mask3 = _mm_cmpeq_epi32(data3, labelp);
-    __m128i count3 = _mm_and_si128(mask3, addp_middle);
-    countp = _mm_add_epi32(count3, countp);
+    countp += (v_load(labels + (y+1)*width + x - 1) == labelp) & addp_middle;
     /* 4. row */
-    __m128i data4 = _mm_loadu_si128((__m128i*) (labels + (y+2)*width + x -1));
-    __m128i mask4 = _mm_cmpeq_epi32(data4, labelp);
-    __m128i count4 = _mm_and_si128(mask4, addp_border);
-    countp = _mm_add_epi32(countp, count4);
-
-    countp = _mm_hadd_epi32(countp, countp);
-    countp = _mm_hadd_epi32(countp, countp);
-    return _mm_cvtsi128_si32(countp);
+    countp += (v_load(labels + (y+2)*width + x - 1) == labelp) & addp_border;
+
+    return v_reduce_sum(countp);
 #else
     int count = 0;
     count += (labels[(y - 1) * width + x - 1] == label);
@@ -1109,12 +1335,12 @@ float SuperpixelSEEDSImpl::intersectConf(int level1, int label1A, int label1B,
      */
 
     int n = 0;
-#if CV_SSSE3
-    __m128 count1Ap = _mm_set1_ps(count1A);
-    __m128 count2p = _mm_set1_ps(count2);
-    __m128 count1Bp = _mm_set1_ps(count1B);
-    __m128 sumAp = _mm_set1_ps(0.0f);
-    __m128 sumBp = _mm_set1_ps(0.0f);
+#if CV_SIMD128
+    v_float32x4 count1Ap = v_setall_f32(count1A);
+    v_float32x4 count2p = v_setall_f32(count2);
+    v_float32x4 count1Bp = v_setall_f32(count1B);
+    v_float32x4 sumAp = v_setzero_f32();
+    v_float32x4 sumBp = v_setzero_f32();
 
     const int loop_end = histogram_size - 3;
     for(; n < loop_end; n += 4)
@@ -1122,41 +1348,16 @@ float SuperpixelSEEDSImpl::intersectConf(int level1, int label1A, int label1B,
         //this does exactly the same as the loop peeling below, but 4 elements at a time
 
         // normal
-        __m128 h1Ap = _mm_load_ps(h1A + n);
-        __m128 h1Bp = _mm_load_ps(h1B + n);
-        __m128 h2p = _mm_load_ps(h2 + n);
-
-        __m128 h1ApC2 = _mm_mul_ps(h1Ap, count2p);
-        __m128 h2pC1A = _mm_mul_ps(h2p, count1Ap);
-        __m128 maskA = _mm_cmple_ps(h1ApC2, h2pC1A);
-        __m128 sum1AddA = _mm_and_ps(maskA, h1ApC2);
-        __m128 sum2AddA = _mm_andnot_ps(maskA, h2pC1A);
-        sumAp = _mm_add_ps(sumAp, sum1AddA);
-        sumAp = _mm_add_ps(sumAp, sum2AddA);
+        v_float32x4 h1Ap = v_load_aligned(h1A + n);
+        v_float32x4 h1Bp = v_load_aligned(h1B + n);
+        v_float32x4 h2p = v_load_aligned(h2 + n);
+        sumAp += v_min(h1Ap * count2p, h2p * count1Ap);
 
         // del
-        __m128 diffp = _mm_sub_ps(h1Bp, h2p);
-        __m128 h1BpC2 = _mm_mul_ps(diffp, count2p);
-        __m128 h2pC1B = _mm_mul_ps(h2p, count1Bp);
-        __m128 maskB = _mm_cmple_ps(h1BpC2, h2pC1B);
-        __m128 sum1AddB = _mm_and_ps(maskB, h1BpC2);
-        __m128 sum2AddB = _mm_andnot_ps(maskB, h2pC1B);
-        sumBp = _mm_add_ps(sumBp, sum1AddB);
-        sumBp = _mm_add_ps(sumBp, sum2AddB);
+        sumBp += v_min((h1Bp - h2p) * count2p, h2p * count1Bp);
     }
-    // merge results (quite expensive)
-    float sum1Asse;
-    sumAp = _mm_hadd_ps(sumAp, sumAp);
-    sumAp = _mm_hadd_ps(sumAp, sumAp);
-    _mm_store_ss(&sum1Asse, sumAp);
-
-    float sum1Bsse;
-    sumBp = _mm_hadd_ps(sumBp, sumBp);
-    sumBp = _mm_hadd_ps(sumBp, sumBp);
-    _mm_store_ss(&sum1Bsse, sumBp);
-
-    sumA += sum1Asse;
-    sumB += sum1Bsse;
+    sumA += v_reduce_sum(sumAp);
+    sumB += v_reduce_sum(sumBp);
 #endif
 
     //loop peeling
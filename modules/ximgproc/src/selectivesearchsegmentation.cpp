@@ -111,6 +111,98 @@ namespace cv {
                     }
             };
 
+            // Max-heap of neighbour indices ordered by similarity. The position of every
+            // neighbour in the heap is tracked, so pairs touching a merged region can be
+            // removed directly instead of re-sorting the whole list after each merge.
+            class NeighbourQueue {
+                public:
+                    explicit NeighbourQueue(const std::vector<Neighbour>& neighbours_) : neighbours(neighbours_) {}
+
+                    bool empty() const {
+                        return heap.empty();
+                    }
+
+                    bool contains(int n) const {
+                        return n < (int)positions.size() && positions[n] >= 0;
+                    }
+
+                    int top() const {
+                        return heap[0];
+                    }
+
+                    void push(int n) {
+                        if ((int)positions.size() <= n) {
+                            positions.resize(n + 1, -1);
+                        }
+                        positions[n] = (int)heap.size();
+                        heap.push_back(n);
+                        siftUp(positions[n]);
+                    }
+
+                    void remove(int n) {
+                        int pos = positions[n];
+                        int last = heap.back();
+                        heap.pop_back();
+                        positions[n] = -1;
+
+                        if (last != n) {
+                            heap[pos] = last;
+                            positions[last] = pos;
+                            siftUp(pos);
+                            siftDown(positions[last]);
+                        }
+                    }
+
+                private:
+                    const std::vector<Neighbour>& neighbours;
+                    std::vector<int> heap;
+                    std::vector<int> positions; // -1 if not in the heap
+
+                    // Ties are broken by index so that the merge order is deterministic
+                    bool higher(int a, int b) const {
+                        float sa = neighbours[a].similarity, sb = neighbours[b].similarity;
+                        return sa > sb || (sa == sb && a < b);
+                    }
+
+                    void place(int pos, int n) {
+                        heap[pos] = n;
+                        positions[n] = pos;
+                    }
+
+                    void siftUp(int pos) {
+                        int n = heap[pos];
+                        while (pos > 0) {
+                            int parent = (pos - 1) / 2;
+                            if (!higher(n, heap[parent])) {
+                                break;
+                            }
+                            place(pos, heap[parent]);
+                            pos = parent;
+                        }
+                        place(pos, n);
+                    }
+
+                    void siftDown(int pos) {
+                        int n = heap[pos];
+                        int size = (int)heap.size();
+                        for (;;) {
+                            int child = 2 * pos + 1;
+                            if (child >= size) {
+                                break;
+                            }
+                            if (child + 1 < size && higher(heap[child + 1], heap[child])) {
+                                child++;
+                            }
+                            if (!higher(heap[child], n)) {
+                                break;
+                            }
+                            place(pos, heap[child]);
+                            pos = child;
+                        }
+                        place(pos, n);
+                    }
+            };
+
             /****************************************
              * Stragegy / Color
              ***************************************/
@@ -258,6 +350,9 @@ namespace cv {
                     virtual void addStrategy(Ptr<SelectiveSearchSegmentationStrategy> g, float weight) CV_OVERRIDE;
                     virtual void clearStrategies() CV_OVERRIDE;
 
+                    const std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& getStrategies() const { return strategies; }
+                    const std::vector<float>& getWeights() const { return weights; }
+
                 private:
                     String name_;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
@@ -686,6 +781,46 @@ namespace cv {
                 return s;
             }
 
+            // Creates a fresh instance of a built-in strategy, so that several images can be
+            // grouped concurrently. Sub-strategies shared between strategies stay shared in the
+            // copy (they cache per-image data). Returns an empty pointer for user-defined strategies.
+            static Ptr<SelectiveSearchSegmentationStrategy> cloneStrategy(const Ptr<SelectiveSearchSegmentationStrategy>& s,
+                std::map<const SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> >& clones) {
+
+                std::map<const SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> >::iterator it = clones.find(s.get());
+                if (it != clones.end()) {
+                    return it->second;
+                }
+
+                Ptr<SelectiveSearchSegmentationStrategy> c;
+
+                if (dynamic_cast<SelectiveSearchSegmentationStrategyColorImpl*>(s.get())) {
+                    c = createSelectiveSearchSegmentationStrategyColor();
+                } else if (dynamic_cast<SelectiveSearchSegmentationStrategySizeImpl*>(s.get())) {
+                    c = createSelectiveSearchSegmentationStrategySize();
+                } else if (dynamic_cast<SelectiveSearchSegmentationStrategyFillImpl*>(s.get())) {
+                    c = createSelectiveSearchSegmentationStrategyFill();
+                } else if (dynamic_cast<SelectiveSearchSegmentationStrategyTextureImpl*>(s.get())) {
+                    c = createSelectiveSearchSegmentationStrategyTexture();
+                } else if (SelectiveSearchSegmentationStrategyMultipleImpl* m = dynamic_cast<SelectiveSearchSegmentationStrategyMultipleImpl*>(s.get())) {
+                    Ptr<SelectiveSearchSegmentationStrategyMultiple> cm = createSelectiveSearchSegmentationStrategyMultiple();
+
+                    for (size_t i = 0; i < m->getStrategies().size(); i++) {
+                        Ptr<SelectiveSearchSegmentationStrategy> sub = cloneStrategy(m->getStrategies()[i], clones);
+                        if (!sub) {
+                            return Ptr<SelectiveSearchSegmentationStrategy>();
+                        }
+                        cm->addStrategy(sub, m->getWeights()[i]);
+                    }
+                    c = cm;
+                }
+
+                if (c) {
+                    clones[s.get()] = c;
+                }
+                return c;
+            }
+
             // Core
 
             class SelectiveSearchSegmentationImpl CV_FINAL : public SelectiveSearchSegmentation {
@@ -731,7 +866,8 @@ namespace cv {
                     std::vector<Ptr<GraphSegmentation> > segmentations;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
 
-                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int region_id);
+                    void processImageSegmentation(const Mat& img, const Ptr<GraphSegmentation>& gs, std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& local_strategies, int image_id, std::vector<std::vector<Region> >& regions);
+                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const std::vector<Neighbour>& initial_neighbours, const Mat_<int>& sizes, int nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id);
             };
 
             void SelectiveSearchSegmentationImpl::setBaseImage(InputArray img) {
@@ -889,98 +1025,157 @@ namespace cv {
 
             void SelectiveSearchSegmentationImpl::process(std::vector<Rect>& rects) {
 
-                std::vector<Region> all_regions;
+                const int nb_segmentations = (int)segmentations.size();
+                const int nb_combinations = (int)images.size() * nb_segmentations;
 
-                int image_id = 0;
+                // Regions found for each (image, segmentation) combination and each strategy
+                std::vector<std::vector<std::vector<Region> > > combination_regions(nb_combinations);
 
-                for(std::vector<Mat>::iterator image = images.begin(); image != images.end(); ++image) {
-                    for(std::vector<Ptr<GraphSegmentation> >::iterator gs = segmentations.begin(); gs != segmentations.end(); ++gs) {
+                // Combinations are independent, but the strategies keep per-image state, so each
+                // combination works on its own copy of them. User-defined strategies cannot be
+                // copied: in that case the combinations are processed one after another.
+                bool parallel = true;
+                {
+                    std::map<const SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> > clones;
+                    for (size_t i = 0; i < strategies.size() && parallel; i++) {
+                        parallel = !cloneStrategy(strategies[i], clones).empty();
+                    }
+                }
 
-                        Mat img_regions;
-                        Mat_<char> is_neighbour;
-                        Mat_<int> sizes;
+                auto body = [&](const Range& range) {
+                    for (int c = range.start; c < range.end; c++) {
+                        std::vector<Ptr<SelectiveSearchSegmentationStrategy> > local_strategies = strategies;
 
-                        // Compute initial segmentation
-                        (*gs)->processImage(*image, img_regions);
+                        if (parallel) {
+                            std::map<const SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> > clones;
+                            for (size_t i = 0; i < local_strategies.size(); i++) {
+                                local_strategies[i] = cloneStrategy(strategies[i], clones);
+                            }
+                        }
 
-                        // Get number of regions
-                        double min, max;
-                        minMaxLoc(img_regions, &min, &max);
-                        int nb_segs = (int)max + 1;
+                        processImageSegmentation(images[c / nb_segmentations], segmentations[c % nb_segmentations], local_strategies, c, combination_regions[c]);
+                    }
+                };
 
-                        // Compute bouding rects and neighbours
-                        std::vector<Rect> bounding_rects;
-                        bounding_rects.resize(nb_segs);
+                if (parallel) {
+                    parallel_for_(Range(0, nb_combinations), body);
+                } else {
+                    body(Range(0, nb_combinations));
+                }
 
-                        std::vector<std::vector<cv::Point> > points;
+                // Compute regions' rank, in the same order as a sequential run would
+                std::vector<Region> all_regions;
 
-                        points.resize(nb_segs);
+                for (int c = 0; c < nb_combinations; c++) {
+                    for (size_t i = 0; i < combination_regions[c].size(); i++) {
+                        std::vector<Region>& regions = combination_regions[c][i];
 
-                        is_neighbour = Mat::zeros(nb_segs, nb_segs, CV_8UC1);
-                        sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
+                        for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
+                            // Note: this is inverted from the paper, but we keep the lover region first so it's works
+                            (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
+                            all_regions.push_back(*region);
+                        }
+                    }
+                }
 
-                        const int* previous_p = NULL;
+                std::sort(all_regions.begin(), all_regions.end());
 
-                        for (int i = 0; i < (int)img_regions.rows; i++) {
-                            const int* p = img_regions.ptr<int>(i);
+                std::map<Rect, char, rectComparator> processed_rect;
 
-                            for (int j = 0; j < (int)img_regions.cols; j++) {
+                rects.clear();
 
-                                points[p[j]].push_back(cv::Point(j, i));
-                                sizes.at<int>(p[j], 0) = sizes.at<int>(p[j], 0) + 1;
+                // Remove duplicate in rect list
+                for(std::vector<Region>::iterator region = all_regions.begin(); region != all_regions.end(); ++region) {
+                    if (processed_rect.find((*region).bounding_box) == processed_rect.end()) {
+                        processed_rect[(*region).bounding_box] = true;
+                        rects.push_back((*region).bounding_box);
+                    }
+                }
 
-                                if (i > 0 && j > 0) {
+            }
 
-                                    is_neighbour.at<char>(p[j], p[j - 1]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j - 1]) = 1;
+            void SelectiveSearchSegmentationImpl::processImageSegmentation(const Mat& img, const Ptr<GraphSegmentation>& gs, std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& local_strategies, int image_id, std::vector<std::vector<Region> >& regions) {
 
-                                    is_neighbour.at<char>(p[j - 1], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j - 1], p[j]) = 1;
-                                }
-                            }
-                            previous_p = p;
-                        }
+                Mat img_regions;
 
-                        for(int seg = 0; seg < nb_segs; seg++) {
-                            bounding_rects[seg] = cv::boundingRect(points[seg]);
-                        }
+                // Compute initial segmentation
+                gs->processImage(img, img_regions);
 
-                        for(std::vector<Ptr<SelectiveSearchSegmentationStrategy> >::iterator strategy = strategies.begin(); strategy != strategies.end(); ++strategy) {
-                            std::vector<Region> regions;
-                            hierarchicalGrouping(*image, *strategy, img_regions, is_neighbour, sizes, nb_segs, bounding_rects, regions, image_id);
+                // Get number of regions
+                double min, max;
+                minMaxLoc(img_regions, &min, &max);
+                int nb_segs = (int)max + 1;
 
-                            for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                                all_regions.push_back(*region);
+                // Compute sizes, bouding rects and neighbours
+                Mat_<int> sizes = Mat_<int>::zeros(nb_segs, 1);
+                std::vector<Point> tl(nb_segs, Point(img_regions.cols, img_regions.rows)), br(nb_segs, Point(-1, -1));
+                std::vector<std::pair<int, int> > pairs;
+
+                const int* previous_p = NULL;
+
+                for (int i = 0; i < (int)img_regions.rows; i++) {
+                    const int* p = img_regions.ptr<int>(i);
+
+                    for (int j = 0; j < (int)img_regions.cols; j++) {
+
+                        int r = p[j];
+                        sizes(r, 0)++;
+                        tl[r].x = std::min(tl[r].x, j);
+                        tl[r].y = std::min(tl[r].y, i);
+                        br[r].x = std::max(br[r].x, j);
+                        br[r].y = std::max(br[r].y, i);
+
+                        if (i > 0 && j > 0) {
+                            const int others[3] = { p[j - 1], previous_p[j], previous_p[j - 1] };
+
+                            for (int o = 0; o < 3; o++) {
+                                if (others[o] != r) {
+                                    pairs.push_back(std::make_pair(std::min(r, others[o]), std::max(r, others[o])));
+                                }
                             }
                         }
-
-                        image_id++;
                     }
+                    previous_p = p;
                 }
 
-                std::sort(all_regions.begin(), all_regions.end());
+                std::vector<Rect> bounding_rects(nb_segs);
 
-                std::map<Rect, char, rectComparator> processed_rect;
+                for(int seg = 0; seg < nb_segs; seg++) {
+                    if (sizes(seg, 0) > 0) {
+                        bounding_rects[seg] = Rect(tl[seg], br[seg] + Point(1, 1));
+                    }
+                }
 
-                rects.clear();
+                // Unique neighbour pairs, ordered by (from, to)
+                std::sort(pairs.begin(), pairs.end());
+                pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
 
-                // Remove duplicate in rect list
-                for(std::vector<Region>::iterator region = all_regions.begin(); region != all_regions.end(); ++region) {
-                    if (processed_rect.find((*region).bounding_box) == processed_rect.end()) {
-                        processed_rect[(*region).bounding_box] = true;
-                        rects.push_back((*region).bounding_box);
-                    }
+                std::vector<Neighbour> initial_neighbours(pairs.size());
+
+                for (size_t i = 0; i < pairs.size(); i++) {
+                    initial_neighbours[i].from = pairs[i].first;
+                    initial_neighbours[i].to = pairs[i].second;
+                    initial_neighbours[i].similarity = 0;
                 }
 
+                regions.resize(local_strategies.size());
+
+                for (size_t i = 0; i < local_strategies.size(); i++) {
+                    hierarchicalGrouping(img, local_strategies[i], img_regions, initial_neighbours, sizes, nb_segs, bounding_rects, regions[i], image_id);
+                }
             }
 
-            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes_, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id) {
+            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const std::vector<Neighbour>& initial_neighbours, const Mat_<int>& sizes_, int nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id) {
 
                 Mat sizes = sizes_.clone();
 
-                std::vector<Neighbour> similarities;
+                std::vector<Neighbour> similarities(initial_neighbours);
+                NeighbourQueue queue(similarities);
+
+                // Indices in similarities of the pairs each region is part of
+                std::vector<std::vector<int> > adjacency(nb_segs);
+                std::vector<int> visited(nb_segs, -1);
+
                 regions.clear();
 
                 /////////////////////////////////////////
@@ -997,29 +1192,25 @@ namespace cv {
                     r.bounding_box = bounding_rects[i];
 
                     regions.push_back(r);
+                }
 
-                    for (int j = i + 1; j < nb_segs; j++) {
-                        if (is_neighbour.at<char>(i, j)) {
-                            Neighbour n;
-                            n.from = i;
-                            n.to = j;
-                            n.similarity = s->get(i, j);
+                for (int i = 0; i < (int)similarities.size(); i++) {
+                    Neighbour& n = similarities[i];
+                    n.similarity = s->get(n.from, n.to);
 
-                            similarities.push_back(n);
-                        }
-                    }
+                    adjacency[n.from].push_back(i);
+                    adjacency[n.to].push_back(i);
+                    queue.push(i);
                 }
 
-                while(similarities.size() > 0) {
+                std::vector<int> local_neighbours;
 
-                    std::sort(similarities.begin(), similarities.end());
+                while(!queue.empty()) {
 
-                    // for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end(); ++similarity) {
-                    //     std::cout << *similarity << std::endl;
-                    // }
+                    int best = queue.top();
+                    queue.remove(best);
 
-                    Neighbour p = similarities.back();
-                    similarities.pop_back();
+                    Neighbour p = similarities[best];
 
                     Region region_from = regions[p.from];
                     Region region_to = regions[p.to];
@@ -1032,8 +1223,10 @@ namespace cv {
 
                     regions.push_back(new_r);
 
-                    regions[p.from].merged_to = (int)regions.size() - 1;
-                    regions[p.to].merged_to = (int)regions.size() - 1;
+                    const int new_index = (int)regions.size() - 1;
+
+                    regions[p.from].merged_to = new_index;
+                    regions[p.to].merged_to = new_index;
 
                     // Merge
                     s->merge(region_from.id, region_to.id);
@@ -1042,53 +1235,50 @@ namespace cv {
                     sizes.at<int>(region_from.id, 0) += sizes.at<int>(region_to.id, 0);
                     sizes.at<int>(region_to.id, 0) = sizes.at<int>(region_from.id, 0);
 
-                    std::vector<int> local_neighbours;
+                    // Drop every pair involving one of the merged regions, and collect their other ends
+                    local_neighbours.clear();
 
-                    for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end();) {
-                        if ((*similarity).from == p.from || (*similarity).to == p.from || (*similarity).from == p.to || (*similarity).to == p.to) {
-                            int from = 0;
-
-                            if ((*similarity).from == p.from || (*similarity).from == p.to) {
-                                from = (*similarity).to;
-                            } else {
-                                from = (*similarity).from;
-                            }
+                    const int merged[2] = { p.from, p.to };
 
-                            bool already_neighboor = false;
+                    for (int m = 0; m < 2; m++) {
+                        std::vector<int>& pairs = adjacency[merged[m]];
 
-                            for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
-                                if (*local_neighbour == from) {
-                                    already_neighboor = true;
-                                }
+                        for (size_t k = 0; k < pairs.size(); k++) {
+                            if (!queue.contains(pairs[k])) {
+                                continue;
                             }
+                            queue.remove(pairs[k]);
 
-                            if (!already_neighboor) {
-                                local_neighbours.push_back(from);
-                            }
+                            const Neighbour& n = similarities[pairs[k]];
+                            int other = n.from == merged[m] ? n.to : n.from;
 
-                            similarity = similarities.erase(similarity);
-                        } else {
-                            similarity++;
+                            if (visited[other] != new_index) {
+                                visited[other] = new_index;
+                                local_neighbours.push_back(other);
+                            }
                         }
+
+                        std::vector<int>().swap(pairs);
                     }
 
+                    adjacency.push_back(std::vector<int>());
+                    visited.push_back(-1);
+
                     for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
 
                         Neighbour n;
-                        n.from = (int)regions.size() - 1;
+                        n.from = new_index;
                         n.to = *local_neighbour;
                         n.similarity = s->get(regions[n.from].id, regions[n.to].id);
 
+                        int index = (int)similarities.size();
                         similarities.push_back(n);
-                    }
-                }
 
-                // Compute regions' rank
-                for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                    // Note: this is inverted from the paper, but we keep the lover region first so it's works
-                    (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
+                        adjacency[n.from].push_back(index);
+                        adjacency[n.to].push_back(index);
+                        queue.push(index);
+                    }
                 }
-
             }
 
             Ptr<SelectiveSearchSegmentation> createSelectiveSearchSegmentation() {
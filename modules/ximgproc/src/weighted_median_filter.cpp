@@ -44,6 +44,8 @@ namespace{
 
 using namespace cv::ximgproc;
 
+typedef pair<float,int> pairFI;
+
 /***************************************************************/
 /* Function: from32FTo32S
  * Description: adaptive quantization for changing a floating-point 1D image to integer image.
@@ -51,17 +53,18 @@ using namespace cv::ximgproc;
  *                upper bound of quantization error.
  *                The function also return a mapping between quantized value (32F) and quantized index (32S).
  *                The mapping is used to convert integer image back to floating-point image after filtering.
+ *                "data" is a scratch buffer kept by the caller between calls.
  ***************************************************************/
-void from32FTo32S(Mat &img, Mat &outImg, int nI, float *mapping)
+void from32FTo32S(const Mat &img, Mat &outImg, int nI, float *mapping, std::vector<pairFI> &data)
 {
     int rows = img.rows, cols = img.cols;
     size_t alls = (size_t)rows * cols;
     CV_Assert(alls < INT_MAX);
 
     CV_Assert(img.isContinuous());
-    float *imgPtr = img.ptr<float>();
-    typedef pair<float,int> pairFI;
-    std::vector<pairFI> data(alls);
+    CV_Assert(outImg.data != img.data);
+    const float *imgPtr = img.ptr<float>();
+    data.resize(alls);
 
     // Sort all pixels of the image by ascending order of pixel value
     for (size_t i = 0; i < alls; i++)
@@ -112,9 +115,9 @@ void from32FTo32S(Mat &img, Mat &outImg, int nI, float *mapping)
             l = m;
     }
 
-    Mat retImg(img.size(),CV_32SC1);
-    CV_Assert(retImg.isContinuous());
-    int *retImgPtr = retImg.ptr<int>();
+    outImg.create(img.size(),CV_32SC1);
+    CV_Assert(outImg.isContinuous());
+    int *retImgPtr = outImg.ptr<int>();
 
     // In the sorted list, divide pixel values into clusters according to the minimum error bound
     // Quantize each value to the median of its cluster
@@ -137,21 +140,20 @@ void from32FTo32S(Mat &img, Mat &outImg, int nI, float *mapping)
     mapping[cnt] = data[(baseI+alls-1)>>1].first; // median
 
     //end of the function
-    swap(outImg, retImg);
 }
 
 /***************************************************************/
 /* Function: from32STo32F
  * Description: convert the quantization index image back to the floating-point image accroding to the mapping
 ***************************************************************/
-void from32STo32F(Mat &img, Mat &outImg, float *mapping)
+void from32STo32F(const Mat &img, Mat &outImg, const float *mapping)
 {
-    Mat retImg(img.size(),CV_32F);
+    outImg.create(img.size(),CV_32F);
     CV_Assert(img.isContinuous());
-    CV_Assert(retImg.isContinuous());
+    CV_Assert(outImg.isContinuous());
     int rows = img.rows, cols = img.cols, alls = rows*cols;
-    float *retImgPtr = retImg.ptr<float>();
-    int *imgPtr = img.ptr<int>();
+    float *retImgPtr = outImg.ptr<float>();
+    const int *imgPtr = img.ptr<int>();
 
     // convert 32S index to 32F real value
     for(int i=0;i<alls;i++)
@@ -160,54 +162,6 @@ void from32STo32F(Mat &img, Mat &outImg, float *mapping)
     }
 
     // end of the function
-    outImg = retImg;
-}
-
-
-/***************************************************************
- * Function: float2D
- * Description: allocate a 2D float array with dimension "dim1 x dim2"
- ***************************************************************/
-float** float2D(int dim1, int dim2)
-{
-    float **ret = new float*[dim1];
-    ret[0] = new float[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
-
-    return ret;
-}
-
-/***************************************************************
- * Function: float2D_release
- * Description: deallocate the 2D array created by float2D()
- ***************************************************************/
-void float2D_release(float **p)
-{
-    delete []p[0];
-    delete []p;
-}
-
-/***************************************************************
- * Function: int2D
- * Description: allocate a 2D integer array with dimension "dim1 x dim2"
- ***************************************************************/
-int** int2D(int dim1, int dim2)
-{
-    int **ret = new int*[dim1];
-    ret[0] = new int[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
-
-    return ret;
-}
-
-/***************************************************************
- * Function: int2D_release
- * Description: deallocate the 2D array created by int2D()
- ***************************************************************/
-void int2D_release(int **p)
-{
-    delete []p[0];
-    delete []p;
 }
 
 /***************************************************************
@@ -216,7 +170,7 @@ void int2D_release(int **p)
  ***************************************************************/
 inline void updateBCB(int &num,int *f,int *b,int i,int v)
 {
-    static int p1,p2;
+    int p1,p2;
 
     if(i)
     {
@@ -242,13 +196,13 @@ inline void updateBCB(int &num,int *f,int *b,int i,int v)
 
 /***************************************************************
  * Function: featureIndexing
- * Description: convert uchar feature image "F" to CV_32SC1 type.
+ * Description: convert uchar feature image "F" to CV_32SC1 type "FNew".
  *                If F is 3-channel, perform k-means clustering
  *                If F is 1-channel, only perform type-casting
+ *                "wMap" receives the nF x nF weight table, "hash" is a scratch buffer.
  ***************************************************************/
-void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightType){
+void featureIndexing(const Mat &F, Mat &FNew, Mat &wMap, int &nF, float sigmaI, int weightType, std::vector<int> &hash){
     // Configuration and Declaration
-    Mat FNew;
     int cols = F.cols, rows = F.rows;
     int alls = cols * rows;
     int KmeansAttempts=1;
@@ -262,7 +216,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
         F.convertTo(FNew, CV_32S);
 
         // Compute weight map (weight between each pair of feature index)
-        wMap = float2D(nF,nF);
+        wMap.create(nF,nF,CV_32F);
         float nSigmaI = sigmaI;
         float divider = (1.0f/(2*nSigmaI*nSigmaI));
 
@@ -284,7 +238,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
                     default: val = exp(-(diff*diff)*divider);
                 }
 
-                wMap[i][j] = wMap[j][i] = val;
+                wMap.at<float>(i,j) = wMap.at<float>(j,i) = val;
             }
         }
     }
@@ -294,25 +248,27 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
     {
         const int shift = 2; // 256(8-bit)->64(6-bit)
         const int LOW_NUM = 256>>shift;
-        static int hash[LOW_NUM][LOW_NUM][LOW_NUM]={{{0}}};
+        CV_Assert(F.isContinuous());
 
-        memset(hash,0,sizeof(hash));
+        hash.assign(LOW_NUM*LOW_NUM*LOW_NUM, 0);
+        int *hashPtr = &hash[0];
+#define WMF_HASH(b,g,r) hashPtr[((b)*LOW_NUM+(g))*LOW_NUM+(r)]
 
         // throw pixels into a 2D histogram
         int candCnt = 0;
         {
             int lowR,lowG,lowB;
-            uchar *FPtr = F.ptr<uchar>();
+            const uchar *FPtr = F.ptr<uchar>();
             for(int i=0,i3=0;i<alls;i++,i3+=3)
             {
                 lowB = FPtr[i3]>>shift;
                 lowG = FPtr[i3+1]>>shift;
                 lowR = FPtr[i3+2]>>shift;
 
-                if(hash[lowB][lowG][lowR]==0)
+                if(WMF_HASH(lowB,lowG,lowR)==0)
                 {
                     candCnt++;
-                    hash[lowB][lowG][lowR]=1;
+                    WMF_HASH(lowB,lowG,lowR)=1;
                 }
             }
         }
@@ -323,7 +279,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
         //prepare for K-means
         int top=0;
         for(int i=0;i<LOW_NUM;i++)for(int j=0;j<LOW_NUM;j++)for(int k=0;k<LOW_NUM;k++){
-            if(hash[i][j][k]){
+            if(WMF_HASH(i,j,k)){
                 samples.ptr<float>(top)[0] = (float)i;
                 samples.ptr<float>(top)[1] = (float)j;
                 samples.ptr<float>(top)[2] = (float)k;
@@ -340,33 +296,35 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
         top = 0;
         for(int i=0;i<LOW_NUM;i++)for(int j=0;j<LOW_NUM;j++)for(int k=0;k<LOW_NUM;k++)
         {
-            if(hash[i][j][k])
+            if(WMF_HASH(i,j,k))
             {
-                hash[i][j][k] = labels.ptr<int>(top)[0];
+                WMF_HASH(i,j,k) = labels.ptr<int>(top)[0];
                 top++;
             }
         }
 
         // generate index map
-        FNew = Mat(F.size(),CV_32SC1);
+        FNew.create(F.size(),CV_32SC1);
 
         int lowR,lowG,lowB;
-        uchar *FPtr = F.ptr<uchar>();
+        const uchar *FPtr = F.ptr<uchar>();
+        int *FNewPtr = FNew.ptr<int>();
         for(int i=0,i3=0;i<alls;i++,i3+=3)
         {
             lowB = FPtr[i3]>>shift;
             lowG = FPtr[i3+1]>>shift;
             lowR = FPtr[i3+2]>>shift;
 
-            FNew.ptr<int>()[i] = hash[lowB][lowG][lowR];
+            FNewPtr[i] = WMF_HASH(lowB,lowG,lowR);
         }
+#undef WMF_HASH
 
         // Compute weight map (weight between each pair of feature index)
-        wMap = float2D(nF,nF);
+        wMap.create(nF,nF,CV_32F);
         float nSigmaI = sigmaI/256.0f*LOW_NUM;
         float divider = (1.0f/(2*nSigmaI*nSigmaI));
 
-        float *length = new float[nF];
+        std::vector<float> length(nF);
         for(int i=0;i<nF;i++)
         {
             float a0 = centers.ptr<float>(i)[0];
@@ -399,50 +357,73 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
                     default: val = exp(-(diff0*diff0+diff1*diff1+diff2*diff2)*divider);
                 }
 
-                wMap[i][j] = wMap[j][i] = val;
+                wMap.at<float>(i,j) = wMap.at<float>(j,i) = val;
             }
         }
-
-        delete []length;
     }
     //end of the function
-    F = FNew;
 }
 
-Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, Mat mask=Mat())
+/***************************************************************
+ * Struct: JointHistogram
+ * Description: joint-histogram, BCB and their necklace tables used by one stripe.
+ *                Between two columns the histogram is kept all-zero, so only the link
+ *                heads have to be reset when the next column starts.
+ ***************************************************************/
+struct JointHistogram
 {
-    // Check validation
-    assert(I.depth() == CV_32S && I.channels()==1);//input image: 32SC1
-    assert(F.depth() == CV_32S && F.channels()==1);//feature image: 32SC1
-
-    // Configuration and declaration
-    int rows = I.rows, cols = I.cols;
-    Mat outImg = I.clone();
+    JointHistogram() : nI(0), nF(0), clean(true) {}
 
-    // Handle Mask
-    if(mask.empty())
+    void init(int _nI, int _nF)
     {
-        mask = Mat(I.size(),CV_8U);
-        mask = Scalar(1);
+        if(!clean || (size_t)_nI*_nF > H.size())
+        {
+            H.assign((size_t)_nI*_nF, 0);
+            Hf.resize(H.size());
+            Hb.resize(H.size());
+            clean = true;
+        }
+        nI = _nI; nF = _nF;
+        BCB.resize(nF); BCBf.resize(nF); BCBb.resize(nF);
     }
 
-    // Allocate memory for joint-histogram and BCB
-    int **H = int2D(nI,nF);
-    int *BCB = new int[nF];
+    int *hist(int fval) { return &H[(size_t)fval*nF]; }
+    int *histF(int fval) { return &Hf[(size_t)fval*nF]; }
+    int *histB(int fval) { return &Hb[(size_t)fval*nF]; }
+
+    int nI, nF;
+    bool clean; // false while a column is being processed
+    std::vector<int> H, Hf, Hb;       // joint-histogram with forward/backward links
+    std::vector<int> BCB, BCBf, BCBb; // balance counting box with forward/backward links
+};
 
-    // Allocate links for necklace table
-    int **Hf = int2D(nI,nF);//forward link
-    int **Hb = int2D(nI,nF);//backward link
-    int *BCBf = new int[nF];//forward link
-    int *BCBb = new int[nF];//backward link
+/***************************************************************
+ * Function: filterStripe
+ * Description: joint-histogram weighted median of columns [xBegin, xEnd).
+ *                Each column is scanned with its own histogram, so a stripe reads r
+ *                columns beyond its borders and stripes can be filtered independently.
+ *                Pixels of outImg are written only where a median is defined; the
+ *                caller initializes outImg with I.
+ ***************************************************************/
+void filterStripe(const Mat &I, const Mat &F, const Mat &wMap, const Mat &mask, Mat &outImg,
+                  int r, int nF, int nI, int xBegin, int xEnd, JointHistogram &jh)
+{
+    // Configuration and declaration
+    int rows = I.rows, cols = I.cols;
+
+    jh.init(nI, nF);
+    int *BCB = &jh.BCB[0];
+    int *BCBf = &jh.BCBf[0];//forward link
+    int *BCBb = &jh.BCBb[0];//backward link
 
     // Column Scanning
-    for(int x=0;x<cols;x++)
+    for(int x=xBegin;x<xEnd;x++)
     {
-        // Reset histogram and BCB for each column
+        jh.clean = false;
+
+        // Reset BCB and link heads for each column, the histogram itself is already empty
         memset(BCB, 0, sizeof(int)*nF);
-        memset(H[0], 0, sizeof(int)*nF*nI);
-        for(int i=0;i<nI;i++)Hf[i][0]=Hb[i][0]=0;
+        for(int i=0;i<nI;i++)jh.histF(i)[0]=jh.histB(i)[0]=0;
         BCBf[0]=BCBb[0]=0;
 
         // Reset cut-point
@@ -456,23 +437,23 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
         int upY = min(rows-1,r);
         for(int i=0;i<=upY;i++)
         {
-            int *IPtr = I.ptr<int>(i);
-            int *FPtr = F.ptr<int>(i);
-            uchar *maskPtr = mask.ptr<uchar>(i);
+            const int *IPtr = I.ptr<int>(i);
+            const int *FPtr = F.ptr<int>(i);
+            const uchar *maskPtr = mask.empty() ? NULL : mask.ptr<uchar>(i);
 
             for(int j=downX;j<=upX;j++)
             {
-                if(!maskPtr[j])continue;
+                if(maskPtr && !maskPtr[j])continue;
 
                 int fval = IPtr[j];
-                int *curHist = H[fval];
+                int *curHist = jh.hist(fval);
                 int gval = FPtr[j];
 
                 // Maintain necklace table of joint-histogram
                 if(!curHist[gval] && gval)
                 {
-                    int *curHf = Hf[fval];
-                    int *curHb = Hb[fval];
+                    int *curHf = jh.histF(fval);
+                    int *curHb = jh.histB(fval);
 
                     int p1=0,p2=curHf[0];
                     curHf[p1]=gval;
@@ -492,7 +473,7 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
             // Find weighted median with help of BCB and joint-histogram
             float balanceWeight = 0;
             int curIndex = F.ptr<int>(y,x)[0];
-            float *fPtr = wMap[curIndex];
+            const float *fPtr = wMap.ptr<float>(curIndex);
             int &curMedianVal = medianVal;
 
             // Compute current balance
@@ -511,8 +492,8 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                 for(;balanceWeight >= 0 && curMedianVal > 0; curMedianVal--)
                 {
                     float curWeight = 0;
-                    int *nextHist = H[curMedianVal];
-                    int *nextHf = Hf[curMedianVal];
+                    int *nextHist = jh.hist(curMedianVal);
+                    int *nextHf = jh.histF(curMedianVal);
 
                     // Compute weight change by shift cut-point
                     int i=0;
@@ -535,8 +516,8 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                 for(;balanceWeight < 0 && curMedianVal != nI-1; curMedianVal++)
                 {
                     float curWeight = 0;
-                    int *nextHist = H[curMedianVal+1];
-                    int *nextHf = Hf[curMedianVal+1];
+                    int *nextHist = jh.hist(curMedianVal+1);
+                    int *nextHf = jh.histF(curMedianVal+1);
 
                     // Compute weight change by shift cut-point
                     int i=0;
@@ -569,23 +550,23 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
             int rownum = y + r + 1;
             if(rownum < rows)
             {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
+                    const int *inputImgPtr = I.ptr<int>(rownum);
+                    const int *guideImgPtr = F.ptr<int>(rownum);
+                    const uchar *maskPtr = mask.empty() ? NULL : mask.ptr<uchar>(rownum);
 
                     for(int j=downX;j<=upX;j++)
                     {
-                        if(!maskPtr[j])continue;
+                        if(maskPtr && !maskPtr[j])continue;
 
                         fval = inputImgPtr[j];
-                        curHist = H[fval];
+                        curHist = jh.hist(fval);
                         gval = guideImgPtr[j];
 
                         // Maintain necklace table of joint-histogram
                         if(!curHist[gval] && gval)
                         {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
+                            int *curHf = jh.histF(fval);
+                            int *curHb = jh.histB(fval);
 
                             int p1=0,p2=curHf[0];
                             curHf[gval]=p2;
@@ -605,16 +586,16 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                 rownum = y - r;
                 if(rownum >= 0)
                 {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
+                    const int *inputImgPtr = I.ptr<int>(rownum);
+                    const int *guideImgPtr = F.ptr<int>(rownum);
+                    const uchar *maskPtr = mask.empty() ? NULL : mask.ptr<uchar>(rownum);
 
                     for(int j=downX;j<=upX;j++)
                     {
-                        if(!maskPtr[j])continue;
+                        if(maskPtr && !maskPtr[j])continue;
 
                         fval = inputImgPtr[j];
-                        curHist = H[fval];
+                        curHist = jh.hist(fval);
                         gval = guideImgPtr[j];
 
                         curHist[gval]--;
@@ -622,8 +603,8 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                         // Maintain necklace table of joint-histogram
                         if(!curHist[gval] && gval)
                         {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
+                            int *curHf = jh.histF(fval);
+                            int *curHb = jh.histB(fval);
 
                             int p1=curHb[gval],p2=curHf[gval];
                             curHf[p1]=p2;
@@ -635,20 +616,19 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                     }
                 }
         }
-    }
 
-    // Deallocate the memory
-    {
-        delete []BCB;
-        delete []BCBf;
-        delete []BCBb;
-        int2D_release(H);
-        int2D_release(Hf);
-        int2D_release(Hb);
+        // Empty the histogram: only the cells of the last window can be non-zero
+        for(int i=max(0,rows-r);i<rows;i++)
+        {
+            const int *IPtr = I.ptr<int>(i);
+            const int *FPtr = F.ptr<int>(i);
+            for(int j=downX;j<=upX;j++)
+                jh.hist(IPtr[j])[FPtr[j]] = 0;
+        }
+        jh.clean = true;
     }
 
     // end of the function
-    return outImg;
 }
 }
 
@@ -656,10 +636,35 @@ namespace cv
 {
 namespace ximgproc
 {
-void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int r, double sigma, int weightType, InputArray mask)
+
+class WeightedMedianFilterImpl CV_FINAL : public WeightedMedianFilter
+{
+public:
+    WeightedMedianFilterImpl(int _r, double _sigma, int _weightType)
+        : r(_r), sigma(_sigma), weightType(_weightType)
+    {
+        CV_Assert(r > 0 && sigma > 0);
+    }
+
+    void filter(InputArray joint, InputArray src, OutputArray dst, InputArray mask) CV_OVERRIDE;
+
+protected:
+    int r;
+    double sigma;
+    int weightType;
+
+    // Workspace reused between calls
+    std::vector<Mat> Is, Qs, Os;             // split source, quantized channels and filtered channels
+    std::vector<std::vector<float> > iMap;   // quantized index -> value mapping for floating-point sources
+    std::vector<pairFI> sortBuf;             // adaptive quantization scratch
+    Mat Fidx, wMap;                          // feature indexes and weight table
+    std::vector<int> hashBuf;                // feature clustering scratch
+    std::vector<JointHistogram> histograms;  // one per stripe
+};
+
+void WeightedMedianFilterImpl::filter(InputArray joint, InputArray src, OutputArray dst, InputArray _mask)
 {
     CV_Assert(!src.empty());
-    CV_Assert(r > 0 && sigma > 0);
 
     int nI = 256;
     int nF = 256;
@@ -675,6 +680,9 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
     CV_Assert(I.depth() == CV_32F || I.depth() == CV_8U);
     CV_Assert(F.depth() == CV_8U && (F.channels() == 1 || F.channels() == 3));
 
+    Mat mask = _mask.getMat();
+    CV_Assert(mask.empty() || mask.size() == I.size());
+
     dst.create(src.size(), src.type());
     Mat D = dst.getMat();
 
@@ -682,62 +690,89 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
         F = F.clone();
     if(D.data == I.data)
         I = I.clone();
+    if(!F.isContinuous())
+        F = F.clone();
 
     //Preprocess I
-    //OUTPUT OF THIS STEP: Is, iMap
+    //OUTPUT OF THIS STEP: Qs, iMap
     //If I is floating point image, "adaptive quantization" is done in from32FTo32S.
     //The mapping of floating value to integer value is stored in iMap (for each channel).
-    //"Is" stores each channel of "I". The channels are converted to CV_32S type after this step.
-    vector<float *> iMap(I.channels());
-    vector<Mat> Is;
+    //"Qs" stores each channel of "I". The channels are converted to CV_32S type after this step.
+    const int cn = I.channels();
+    Is.resize(cn);
+    Qs.resize(cn);
+    Os.resize(cn);
+    iMap.resize(cn);
     split(I,Is);
-    for(int i=0;i<(int)Is.size();i++)
+    for(int i=0;i<cn;i++)
     {
         if(I.depth() == CV_32F)
         {
-            iMap[i] = new float[nI];
-            from32FTo32S(Is[i],Is[i],nI,iMap[i]);
+            iMap[i].resize(nI);
+            from32FTo32S(Is[i],Qs[i],nI,&iMap[i][0],sortBuf);
         }
         else if(I.depth() == CV_8U)
         {
-            Is[i].convertTo(Is[i],CV_32S);
+            Is[i].convertTo(Qs[i],CV_32S);
         }
     }
 
     //Preprocess F
-    //OUTPUT OF THIS STEP: F(new), wMap
+    //OUTPUT OF THIS STEP: Fidx, wMap
     //If "F" is 3-channel image, "clustering feature image" is done in featureIndexing.
     //If "F" is 1-channel image, featureIndexing only does a type-casting on "F".
-    //The output "F" is CV_32S type, containing indexes of feature values.
-    //"wMap" is a 2D array that defines the distance between each pair of feature indexes.
-    // wMap[i][j] is the weight between feature index "i" and "j".
-    float **wMap = NULL;
-    featureIndexing(F, wMap, nF, float(sigma), weightType);
+    //The output "Fidx" is CV_32S type, containing indexes of feature values.
+    //"wMap" is a nF x nF table that defines the distance between each pair of feature indexes.
+    // wMap(i,j) is the weight between feature index "i" and "j".
+    featureIndexing(F, Fidx, wMap, nF, float(sigma), weightType, hashBuf);
 
     //Filtering - Joint-Histogram Framework
-    for(int i=0; i<(int)Is.size(); i++)
+    //Columns are split into stripes filtered in parallel, each with its own joint-histogram.
+    const int cols = I.cols;
+    const int nStripes = std::max(1, std::min(cols, getNumThreads()));
+    histograms.resize(nStripes);
+    for(int i=0; i<cn; i++)
     {
-        Is[i] = filterCore(Is[i], F, wMap, r, nF, nI, mask.getMat());
+        Qs[i].copyTo(Os[i]);
+        const Mat& Q = Qs[i];
+        Mat& O = Os[i];
+        parallel_for_(Range(0, nStripes), [&](const Range& range)
+        {
+            for(int s = range.start; s < range.end; s++)
+            {
+                int xBegin = (int)((int64)cols*s/nStripes);
+                int xEnd = (int)((int64)cols*(s+1)/nStripes);
+                filterStripe(Q, Fidx, wMap, mask, O, r, nF, nI, xBegin, xEnd, histograms[s]);
+            }
+        }, nStripes);
     }
-    float2D_release(wMap);
 
     //Postprocess F
     //Convert input image back to the original type.
-    for(int i = 0; i < (int)Is.size(); i++)
+    for(int i = 0; i < cn; i++)
     {
         if(I.depth()==CV_32F)
         {
-            from32STo32F(Is[i],Is[i],iMap[i]);
-            delete []iMap[i];
+            from32STo32F(Os[i],Is[i],&iMap[i][0]);
         }
         else if(I.depth()==CV_8U)
         {
-            Is[i].convertTo(Is[i],CV_8U);
+            Os[i].convertTo(Is[i],CV_8U);
         }
     }
 
     //merge the channels
     merge(Is, D);
 }
+
+Ptr<WeightedMedianFilter> createWeightedMedianFilter(int r, double sigma, int weightType)
+{
+    return makePtr<WeightedMedianFilterImpl>(r, sigma, weightType);
+}
+
+void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int r, double sigma, int weightType, InputArray mask)
+{
+    WeightedMedianFilterImpl(r, sigma, weightType).filter(joint, src, dst, mask);
+}
 }
 }
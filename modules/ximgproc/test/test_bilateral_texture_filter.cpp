@@ -86,6 +86,184 @@ TEST_P(BilateralTextureFilterTest, MultiThreadReproducibility)
     }
 }
 
+// Single-shot implementation the filter had before it became a reusable object, built from
+// whole-image operations only. Used as an independent reference for the optimized one.
+static void refComputeMRTV(const Mat& L, Mat& mRTV, int fr)
+{
+    const float eps = 0.00001f;
+    mRTV = Mat::zeros(L.size(), CV_32FC1);
+
+    Mat Gx, Gy, G;
+    Mat kernelx = Mat::zeros(1, 3, CV_32F), kernely = Mat::zeros(3, 1, CV_32F);
+    kernelx.at<float>(0, 1) = -1.0; kernelx.at<float>(0, 2) = 1.0;
+    kernely.at<float>(1, 0) = -1.0; kernely.at<float>(2, 0) = 1.0;
+    filter2D(L, Gx, -1, kernelx, Point(-1, -1), 0, BORDER_REFLECT);
+    filter2D(L, Gy, -1, kernely, Point(-1, -1), 0, BORDER_REFLECT);
+    sqrt(Gx.mul(Gx) + Gy.mul(Gy), G);
+
+    Mat padL, padG;
+    copyMakeBorder(L, padL, fr, fr, fr, fr, BORDER_REFLECT);
+    copyMakeBorder(G, padG, fr, fr, fr, fr, BORDER_REFLECT);
+    std::vector<Mat> Li, Gi;
+    split(padL, Li);
+    split(padG, Gi);
+
+    for (int i = 0; i < L.channels(); i++)
+    {
+        Mat maxL = Mat::zeros(L.size(), CV_32FC1), minL = Mat::ones(L.size(), CV_32FC1);
+        Mat maxG = Mat::zeros(L.size(), CV_32FC1), sumG = Mat::zeros(L.size(), CV_32FC1);
+        for (int y = -fr; y <= fr; y++)
+        {
+            for (int x = -fr; x <= fr; x++)
+            {
+                Rect r(fr + x, fr + y, L.cols, L.rows);
+                maxL = max(maxL, Li[i](r));
+                minL = min(minL, Li[i](r));
+                maxG = max(maxG, Gi[i](r));
+                sumG = sumG + Gi[i](r);
+            }
+        }
+        sumG = max(sumG, eps);
+        Mat mRTVi = maxG / sumG * (2 * fr + 1);
+        mRTV = mRTV + mRTVi.mul(maxL - minL);
+    }
+    if (L.channels() == 3)
+        mRTV = mRTV / 3;
+}
+
+static void refComputeGuide(const Mat& B, const Mat& mRTV, Mat& G, Mat& minmRTV, int fr)
+{
+    B.copyTo(G);
+    minmRTV = Mat::ones(B.size(), CV_32FC1);
+    for (int y = -fr; y <= fr; y++)
+        for (int x = -fr; x <= fr; x++)
+            for (int i = 0; i < B.rows; i++)
+                for (int j = 0; j < B.cols; j++)
+                {
+                    Point pt(std::min(std::max(j + x, 0), B.cols - 1), std::min(std::max(i + y, 0), B.rows - 1));
+                    if (minmRTV.at<float>(i, j) > mRTV.at<float>(pt))
+                    {
+                        minmRTV.at<float>(i, j) = mRTV.at<float>(pt);
+                        if (B.channels() == 3)
+                            G.at<Vec3f>(i, j) = B.at<Vec3f>(pt);
+                        else
+                            G.at<float>(i, j) = B.at<float>(pt);
+                    }
+                }
+}
+
+static void refJointBilateral(const Mat& img, const Mat& G, Mat& dst, int fr2, double sigmaAvg)
+{
+    const int cn = img.channels();
+    Mat padG, padImg;
+    copyMakeBorder(G, padG, fr2, fr2, fr2, fr2, BORDER_REFLECT);
+    copyMakeBorder(img, padImg, fr2, fr2, fr2, fr2, BORDER_REFLECT);
+    std::vector<Mat> Gc, padGc, padImgc;
+    split(G, Gc);
+    split(padG, padGc);
+    split(padImg, padImgc);
+
+    Mat sumW = Mat::zeros(img.size(), CV_32FC1);
+    std::vector<Mat> acc(cn);
+    for (int c = 0; c < cn; c++)
+        acc[c] = Mat::zeros(img.size(), CV_32FC1);
+
+    for (int x = -fr2; x <= fr2; x++)
+    {
+        for (int y = -fr2; y <= fr2; y++)
+        {
+            Rect r(fr2 + x, fr2 + y, img.cols, img.rows);
+            Mat W = Mat::zeros(img.size(), CV_32FC1);
+            for (int c = 0; c < cn; c++)
+            {
+                Mat d = padGc[c](r) - Gc[c];
+                W += d.mul(d);
+            }
+            exp(-0.5 * W / (sigmaAvg * sigmaAvg), W);
+            W = W * (float)std::exp(-(float)(x * x + y * y) / (2 * fr2 * fr2));
+            sumW += W;
+            for (int c = 0; c < cn; c++)
+                accumulateProduct(W, padImgc[c](r), acc[c]);
+        }
+    }
+    max(sumW, 1e-5f, sumW);
+    for (int c = 0; c < cn; c++)
+        divide(acc[c], sumW, acc[c]);
+    merge(acc, dst);
+}
+
+static void refBilateralTextureFilter(const Mat& src, Mat& dst, int fr, int numIter, double sigmaAlpha, double sigmaAvg)
+{
+    Mat I;
+    if (src.depth() == CV_8U)
+        src.convertTo(I, CV_32F, 1.0 / 255.0);
+    else
+        src.copyTo(I);
+
+    for (int iter = 0; iter < numIter; iter++)
+    {
+        Mat B, mRTV, G, minmRTV;
+        blur(I, B, Size(2 * fr + 1, 2 * fr + 1), Point(-1, -1), BORDER_REFLECT);
+        refComputeMRTV(I, mRTV, fr);
+        refComputeGuide(B, mRTV, G, minmRTV, fr);
+
+        // alpha blending of the guide and the blurred image
+        Mat alpha;
+        exp(-(mRTV - minmRTV) * sigmaAlpha, alpha);
+        alpha = alpha + 1.;
+        pow(alpha, -1, alpha);
+        alpha = (alpha - 0.5) * 2;
+        Mat alphainv = -(alpha - 1);
+
+        std::vector<Mat> Gi, Bi;
+        split(G, Gi);
+        split(B, Bi);
+        for (size_t c = 0; c < Gi.size(); c++)
+            Gi[c] = Gi[c].mul(alpha) + Bi[c].mul(alphainv);
+        Mat Gtilde;
+        merge(Gi, Gtilde);
+
+        Mat J;
+        refJointBilateral(I, Gtilde, J, fr * 2, sigmaAvg);
+        I = J;
+    }
+
+    if (src.depth() == CV_8U)
+        I.convertTo(dst, src.type(), 255.0);
+    else
+        I.copyTo(dst);
+}
+
+TEST_P(BilateralTextureFilterTest, ReusedObjectMatchesReference)
+{
+    BTFParams params = GetParam();
+    int fr            = get<0>(params);
+    double sigmaAlpha = get<1>(params);
+    double sigmaAvg   = get<2>(params);
+    int depth         = get<3>(params);
+    int srcCn         = get<4>(params);
+
+    RNG rnd(2);
+    Ptr<BilateralTextureFilter> btf = createBilateralTextureFilter(fr, 2, sigmaAlpha, sigmaAvg);
+
+    // the object keeps its buffers from one size to the next
+    const Size sizes[] = { Size(160, 120), Size(97, 131), Size(64, 48) };
+    for (int i = 0; i < 3; i++)
+    {
+        Mat src(sizes[i], CV_MAKE_TYPE(depth, srcCn));
+        if (depth == CV_8U)
+            rnd.fill(src, RNG::UNIFORM, 0, 255);
+        else
+            rnd.fill(src, RNG::UNIFORM, 0.0f, 1.0f);
+
+        Mat res, ref;
+        btf->filter(src, res);
+        refBilateralTextureFilter(src, ref, fr, 2, sigmaAlpha, sigmaAvg);
+        // only the float summation order differs from the reference
+        EXPECT_LE(cvtest::norm(ref, res, NORM_INF), depth == CV_8U ? 1.0 : 1e-4);
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(
   TypicalSet1,
   BilateralTextureFilterTest,
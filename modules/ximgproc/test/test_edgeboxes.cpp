@@ -45,4 +45,39 @@ TEST(ximgproc_Edgeboxes, regression)
     EXPECT_EQ(expectedProposal.width, boxes[0].width);
 }
 
+TEST(ximgproc_Edgeboxes, same_result_for_any_thread_count)
+{
+    cv::String testImagePath = cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/" + "pascal_voc_bird.png";
+    Mat testImg = imread(testImagePath);
+    ASSERT_FALSE(testImg.empty()) << "Could not load input image " << testImagePath;
+    cvtColor(testImg, testImg, COLOR_BGR2RGB);
+    testImg.convertTo(testImg, CV_32F, 1.0 / 255.0f);
+
+    cv::String model_path = cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/" + "model.yml.gz";
+    Ptr<StructuredEdgeDetection> sed = createStructuredEdgeDetection(model_path);
+    Mat edgeImage, edgeOrientations;
+    sed->detectEdges(testImg, edgeImage);
+    sed->computeOrientation(edgeImage, edgeOrientations);
+
+    Ptr<EdgeBoxes> edgeboxes = createEdgeBoxes();
+    edgeboxes->setMaxBoxes(1000);
+
+    std::vector<Rect> boxesParallel, boxesSerial;
+    std::vector<float> scoresParallel, scoresSerial;
+    edgeboxes->getBoundingBoxes(edgeImage, edgeOrientations, boxesParallel, scoresParallel);
+
+    int nThreads = getNumThreads();
+    setNumThreads(1);
+    edgeboxes->getBoundingBoxes(edgeImage, edgeOrientations, boxesSerial, scoresSerial);
+    setNumThreads(nThreads);
+
+    ASSERT_EQ(boxesSerial.size(), boxesParallel.size());
+    ASSERT_EQ(scoresSerial.size(), scoresParallel.size());
+    for (size_t i = 0; i < boxesSerial.size(); i++)
+    {
+        EXPECT_EQ(boxesSerial[i], boxesParallel[i]) << "i=" << i;
+        EXPECT_EQ(scoresSerial[i], scoresParallel[i]) << "i=" << i;
+    }
+}
+
 }} // namespace
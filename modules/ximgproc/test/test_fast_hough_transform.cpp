@@ -459,4 +459,32 @@ INSTANTIATE_TEST_CASE_P(FullSet, FastHoughTransformTest,
 #undef FHT_ALL_DEPTHS
 #undef FHT_ALL_CHANNELS
 
+TEST(FastHoughTransformTest, sameResultForAnyThreadCount)
+{
+    RNG rng(0x46485420);
+    Mat src(97, 131, CV_8UC1);
+    rng.fill(src, RNG::UNIFORM, 0, 256);
+
+    const int angleRanges[] = { ARO_0_45, ARO_45_90, ARO_90_135, ARO_315_0, ARO_315_45,
+                                ARO_45_135, ARO_315_135, ARO_CTR_HOR, ARO_CTR_VER };
+    const int operations[] = { FHT_MIN, FHT_MAX, FHT_ADD, FHT_AVE };
+    const int depths[] = { CV_8U, CV_16S, CV_32S, CV_32F };
+
+    int nthreads = getNumThreads();
+    for (size_t r = 0; r < sizeof(angleRanges) / sizeof(angleRanges[0]); r++)
+    for (size_t o = 0; o < sizeof(operations) / sizeof(operations[0]); o++)
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++)
+    {
+        Mat reference, fht;
+        setNumThreads(1);
+        FastHoughTransform(src, reference, depths[d], angleRanges[r], operations[o]);
+        setNumThreads(nthreads);
+        FastHoughTransform(src, fht, depths[d], angleRanges[r], operations[o]);
+
+        ASSERT_EQ(reference.size(), fht.size());
+        EXPECT_EQ(0, cvtest::norm(reference, fht, NORM_INF))
+            << "angleRange=" << angleRanges[r] << " op=" << operations[o] << " depth=" << depths[d];
+    }
+}
+
 }} // namespace
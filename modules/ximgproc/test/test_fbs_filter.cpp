@@ -123,6 +123,40 @@ TEST(FastBilateralSolverTest, ReferenceAccuracy)
 #endif
 }
 
+TEST(FastBilateralSolverTest, BatchedChannelsMatchSeparateCalls)
+{
+    RNG rnd(0);
+    Size sz(320, 240);
+    Mat guide(sz, CV_8UC3);
+    rnd.fill(guide, RNG::UNIFORM, 0, 255);
+    Mat src(sz, CV_32FC3);
+    rnd.fill(src, RNG::UNIFORM, 0.f, 1.f);
+    Mat confidence(sz, CV_8UC1);
+    rnd.fill(confidence, RNG::UNIFORM, 0, 255);
+
+    Ptr<FastBilateralSolverFilter> fbs = createFastBilateralSolverFilter(guide, 8.0, 8.0, 8.0);
+
+    // the three channels are solved in one batch, each one must match its own solve
+    Mat res;
+    fbs->filter(src, confidence, res);
+    std::vector<Mat> src_channels, res_channels;
+    split(src, src_channels);
+    split(res, res_channels);
+    for (int c = 0; c < 3; c++)
+    {
+        Mat single;
+        fbs->filter(src_channels[c], confidence, single);
+        EXPECT_LE(cvtest::norm(single, res_channels[c], NORM_INF), 1e-4) << "channel " << c;
+    }
+
+    // a new confidence must not reuse the previous system
+    Mat confidence2 = 255 - confidence;
+    Mat res2, ref2;
+    fbs->filter(src_channels[0], confidence2, res2);
+    fastBilateralSolverFilter(guide, src_channels[0], confidence2, ref2, 8.0, 8.0, 8.0);
+    EXPECT_LE(cvtest::norm(res2, ref2, NORM_INF), 1e-4);
+}
+
 INSTANTIATE_TEST_CASE_P(FullSet, FastBilateralSolverTest,Combine(Values(szODD, szQVGA), SrcTypes::all(), GuideTypes::all()));
 
 }
@@ -211,6 +211,29 @@ TEST_F(ximgproc_FLD, rotatedRect)
     ASSERT_EQ(EPOCHS, passedtests);
 }
 
+TEST_F(ximgproc_FLD, sameResultForAnyThreadCount)
+{
+    test_image = Mat(Size(640, 480), CV_8UC1, Scalar::all(0));
+    for (int i = 0; i < 30; ++i)
+    {
+        Point p1(rng.uniform(0, test_image.cols), rng.uniform(0, test_image.rows));
+        Point p2(rng.uniform(0, test_image.cols), rng.uniform(0, test_image.rows));
+        line(test_image, p1, p2, Scalar::all(rng.uniform(64, 256)), rng.uniform(1, 4));
+    }
+    Ptr<FastLineDetector> detector = createFastLineDetector(10, 1.414213562f, 50, 50, 3, true);
+
+    int nthreads = getNumThreads();
+    setNumThreads(1);
+    vector<Vec4f> reference;
+    detector->detect(test_image, reference);
+    setNumThreads(nthreads);
+    detector->detect(test_image, lines);
+
+    ASSERT_FALSE(reference.empty());
+    ASSERT_EQ(reference.size(), lines.size());
+    EXPECT_EQ(0, cvtest::norm(Mat(reference), Mat(lines), NORM_INF));
+}
+
 //************** EDGE DRAWING *******************
 
 TEST_F(ximgproc_ED, whiteNoise)
@@ -295,4 +318,41 @@ TEST_F(ximgproc_ED, ManySmallCircles)
     EXPECT_EQ(lines.size(), lines_size);
     EXPECT_EQ(ellipses.size(), ellipses_size);
 }
+
+TEST_F(ximgproc_ED, sameResultForAnyThreadCount)
+{
+    test_image = Mat(Size(640, 480), CV_8UC1, Scalar::all(64));
+    for (int i = 0; i < 20; ++i)
+    {
+        Point center(rng.uniform(0, test_image.cols), rng.uniform(0, test_image.rows));
+        Size axes(rng.uniform(10, 80), rng.uniform(10, 80));
+        ellipse(test_image, center, axes, rng.uniform(0, 180), 0, 360, Scalar::all(rng.uniform(128, 256)), rng.uniform(1, 3));
+        line(test_image, Point(rng.uniform(0, test_image.cols), rng.uniform(0, test_image.rows)),
+             Point(rng.uniform(0, test_image.cols), rng.uniform(0, test_image.rows)),
+             Scalar::all(rng.uniform(128, 256)), rng.uniform(1, 3));
+    }
+
+    int nthreads = getNumThreads();
+    setNumThreads(1);
+    vector<Vec4f> refLines;
+    vector<Vec6d> refEllipses, ellipses;
+    detector->detectEdges(test_image);
+    vector<vector<Point> > refSegments = detector->getSegments();
+    detector->detectLines(refLines);
+    detector->detectEllipses(refEllipses);
+    setNumThreads(nthreads);
+
+    // the same object is reused, so this also checks that no state leaks between calls
+    detector->detectEdges(test_image);
+    detector->detectLines(lines);
+    detector->detectEllipses(ellipses);
+
+    ASSERT_FALSE(refLines.empty());
+    EXPECT_TRUE(refSegments == detector->getSegments());
+    ASSERT_EQ(refLines.size(), lines.size());
+    EXPECT_EQ(0, cvtest::norm(Mat(refLines), Mat(lines), NORM_INF));
+    ASSERT_EQ(refEllipses.size(), ellipses.size());
+    if (!ellipses.empty())
+        EXPECT_EQ(0, cvtest::norm(Mat(refEllipses), Mat(ellipses), NORM_INF));
+}
 }} // namespace
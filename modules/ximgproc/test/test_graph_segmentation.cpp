@@ -0,0 +1,255 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::ximgproc::segmentation;
+
+struct RefEdge
+{
+    int from, to;
+    float weight;
+    bool operator<(const RefEdge& e) const { return weight < e.weight; }
+};
+
+static int refFind(std::vector<int>& parent, int p)
+{
+    while (parent[p] != p)
+        p = parent[p] = parent[parent[p]];
+    return p;
+}
+
+// Straightforward single-channel version of the algorithm, with the edges sorted by std::stable_sort.
+// Edges are enumerated like GraphSegmentation does (right then bottom neighbour of every pixel),
+// so equal weights keep the same relative order in both implementations.
+static void referenceSegmentation(const Mat& img, double sigma, float k, int min_size, Mat& labels)
+{
+    CV_Assert(img.type() == CV_8UC1);
+    Mat f;
+    img.convertTo(f, CV_32F);
+    GaussianBlur(f, f, Size(0, 0), sigma, sigma);
+
+    const int rows = f.rows, cols = f.cols;
+    std::vector<RefEdge> edges;
+    for (int i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < cols; j++)
+        {
+            int p = i * cols + j;
+            if (j < cols - 1)
+            {
+                float d = f.at<float>(i, j) - f.at<float>(i, j + 1);
+                RefEdge e = { p, p + 1, std::sqrt(d * d) };
+                edges.push_back(e);
+            }
+            if (i < rows - 1)
+            {
+                float d = f.at<float>(i, j) - f.at<float>(i + 1, j);
+                RefEdge e = { p, p + cols, std::sqrt(d * d) };
+                edges.push_back(e);
+            }
+        }
+    }
+    std::stable_sort(edges.begin(), edges.end());
+
+    std::vector<int> parent(rows * cols), size(rows * cols, 1);
+    std::vector<float> threshold(rows * cols, k);
+    for (size_t p = 0; p < parent.size(); p++)
+        parent[p] = (int)p;
+
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        int a = refFind(parent, edges[i].from), b = refFind(parent, edges[i].to);
+        if (a != b && edges[i].weight <= threshold[a] && edges[i].weight <= threshold[b])
+        {
+            parent[b] = a;
+            size[a] += size[b];
+            threshold[a] = edges[i].weight + k / size[a];
+            edges[i].weight = 0;
+        }
+    }
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        if (edges[i].weight > 0)
+        {
+            int a = refFind(parent, edges[i].from), b = refFind(parent, edges[i].to);
+            if (a != b && (size[a] < min_size || size[b] < min_size))
+            {
+                parent[b] = a;
+                size[a] += size[b];
+            }
+        }
+    }
+
+    labels.create(rows, cols, CV_32SC1);
+    std::vector<int> ids(rows * cols, -1);
+    int last_id = 0;
+    for (int p = 0; p < rows * cols; p++)
+    {
+        int r = refFind(parent, p);
+        if (ids[r] < 0)
+            ids[r] = last_id++;
+        labels.at<int>(p / cols, p % cols) = ids[r];
+    }
+}
+
+// A few gray levels only, so most edge weights are exactly tied
+static Mat createQuantizedImage(Size sz, uint64 seed)
+{
+    RNG rng(seed);
+    Mat small(sz.height / 8, sz.width / 8, CV_8UC1), img;
+    rng.fill(small, RNG::UNIFORM, 0, 4);
+    resize(small, img, sz, 0, 0, INTER_NEAREST);
+    Mat noise(sz, CV_8UC1);
+    rng.fill(noise, RNG::UNIFORM, 0, 3);
+    return img * 60 + noise * 20;
+}
+
+static void checkSegmentsProperties(const Mat& labels)
+{
+    ASSERT_EQ(CV_32SC1, labels.type());
+    double maxVal = 0;
+    minMaxLoc(labels, NULL, &maxVal);
+    const int nb_segs = (int)maxVal + 1;
+
+    // ids are sequential, in order of first appearance
+    int next_id = 0;
+    for (int i = 0; i < labels.rows; i++)
+        for (int j = 0; j < labels.cols; j++)
+        {
+            int l = labels.at<int>(i, j);
+            ASSERT_LE(l, next_id) << "at " << Point(j, i);
+            if (l == next_id)
+                next_id++;
+        }
+    ASSERT_EQ(nb_segs, next_id);
+
+    // every segment is 4-connected
+    Mat visited = Mat::zeros(labels.size(), CV_8UC1);
+    std::vector<int> components(nb_segs, 0);
+    std::vector<Point> stack;
+    for (int i = 0; i < labels.rows; i++)
+        for (int j = 0; j < labels.cols; j++)
+        {
+            if (visited.at<uchar>(i, j))
+                continue;
+            int l = labels.at<int>(i, j);
+            components[l]++;
+            stack.push_back(Point(j, i));
+            visited.at<uchar>(i, j) = 1;
+            while (!stack.empty())
+            {
+                Point p = stack.back();
+                stack.pop_back();
+                const Point nbs[4] = { p + Point(1, 0), p - Point(1, 0), p + Point(0, 1), p - Point(0, 1) };
+                for (int n = 0; n < 4; n++)
+                {
+                    if (nbs[n].x < 0 || nbs[n].y < 0 || nbs[n].x >= labels.cols || nbs[n].y >= labels.rows)
+                        continue;
+                    if (visited.at<uchar>(nbs[n]) || labels.at<int>(nbs[n]) != l)
+                        continue;
+                    visited.at<uchar>(nbs[n]) = 1;
+                    stack.push_back(nbs[n]);
+                }
+            }
+        }
+    for (int l = 0; l < nb_segs; l++)
+        EXPECT_EQ(1, components[l]) << "segment " << l;
+}
+
+TEST(ximgproc_GraphSegmentation, matches_stable_sort_reference)
+{
+    // 400x300 has enough edges for the radix sort to work on several chunks
+    const Size sizes[] = { Size(37, 23), Size(400, 300) };
+    for (size_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); s++)
+    {
+        SCOPED_TRACE(cv::format("size=%dx%d", sizes[s].width, sizes[s].height));
+        Mat img = createQuantizedImage(sizes[s], 0x6A5E + s);
+
+        Ptr<GraphSegmentation> gs = createGraphSegmentation(0.001, 300.f, 20);
+        Mat labels, ref;
+        gs->processImage(img, labels);
+        referenceSegmentation(img, 0.001, 300.f, 20, ref);
+
+        ASSERT_EQ(ref.size(), labels.size());
+        EXPECT_EQ(0, cvtest::norm(labels, ref, NORM_INF));
+    }
+}
+
+TEST(ximgproc_GraphSegmentation, same_labels_on_repeated_calls)
+{
+    Mat img1 = createQuantizedImage(Size(320, 240), 1);
+    Mat img2 = createQuantizedImage(Size(160, 200), 2);
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation(0.8, 300.f, 50);
+    Ptr<GraphSegmentation> gs_fresh = createGraphSegmentation(0.8, 300.f, 50);
+
+    Mat first, second, other, fresh;
+    gs->processImage(img1, first);
+    // a call on another image size in between must not leak into the reused buffers
+    gs->processImage(img2, other);
+    gs->processImage(img1, second);
+    gs_fresh->processImage(img1, fresh);
+
+    EXPECT_EQ(0, cvtest::norm(first, second, NORM_INF));
+    EXPECT_EQ(0, cvtest::norm(first, fresh, NORM_INF));
+
+    const int numThreads = getNumThreads();
+    Mat single;
+    setNumThreads(1);
+    gs->processImage(img1, single);
+    setNumThreads(numThreads);
+    EXPECT_EQ(0, cvtest::norm(first, single, NORM_INF));
+}
+
+TEST(ximgproc_GraphSegmentation, tile_mode)
+{
+    Mat img = createQuantizedImage(Size(320, 240), 3);
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation(0.8, 300.f, 50);
+    Mat labels;
+    gs->processImage(img, labels);
+
+    gs->setTileSize(64);
+    EXPECT_EQ(64, gs->getTileSize());
+    Mat tiled;
+    gs->processImage(img, tiled);
+    ASSERT_EQ(img.size(), tiled.size());
+    checkSegmentsProperties(tiled);
+
+    // tiles are segmented in parallel, the result must not depend on the number of threads
+    const int numThreads = getNumThreads();
+    Mat tiledSingle;
+    setNumThreads(1);
+    gs->processImage(img, tiledSingle);
+    setNumThreads(numThreads);
+    EXPECT_EQ(0, cvtest::norm(tiled, tiledSingle, NORM_INF));
+
+    // tiles covering the whole image fall back to the regular algorithm
+    gs->setTileSize(320);
+    Mat oneTile;
+    gs->processImage(img, oneTile);
+    EXPECT_EQ(0, cvtest::norm(labels, oneTile, NORM_INF));
+
+    // segments spanning several tiles are merged back across the tile borders
+    Mat stripes(240, 320, CV_8UC3);
+    stripes.colRange(0, 100).setTo(Scalar(20, 20, 20));
+    stripes.colRange(100, 250).setTo(Scalar(220, 20, 120));
+    stripes.colRange(250, 320).setTo(Scalar(120, 220, 20));
+    gs->setSigma(0.001);
+    gs->setTileSize(0);
+    Mat stripesLabels;
+    gs->processImage(stripes, stripesLabels);
+    gs->setTileSize(48);
+    Mat stripesTiled;
+    gs->processImage(stripes, stripesTiled);
+    double maxVal = 0;
+    minMaxLoc(stripesTiled, NULL, &maxVal);
+    EXPECT_EQ(2, (int)maxVal);
+    EXPECT_EQ(0, cvtest::norm(stripesLabels, stripesTiled, NORM_INF));
+}
+
+}} // namespace
@@ -125,6 +125,41 @@ TEST_P(RollingGuidanceFilterTest, MultiThreadReproducibility)
     }
 }
 
+// Previous single-shot implementation: every iteration is a separate jointBilateralFilter call,
+// each one building its own kernel state
+static void refRollingGuidanceFilter(const Mat& src, Mat& dst, int d, double sigmaColor, double sigmaSpace, int numOfIter)
+{
+    Mat guide = src.clone();
+    for (int iter = 0; iter < numOfIter; iter++)
+        jointBilateralFilter(guide, src, guide, d, sigmaColor, sigmaSpace);
+    dst = guide;
+}
+
+TEST_P(RollingGuidanceFilterTest, ReusedObjectMatchesReference)
+{
+    RGFParams params = GetParam();
+    double sigmaS   = get<0>(params);
+    int depth       = get<1>(params);
+    int srcCn       = get<2>(params);
+
+    RNG rnd(2);
+    double sigmaC = rnd.uniform(1.0, 255.0);
+    Ptr<RollingGuidanceFilter> rgf = createRollingGuidanceFilter(-1, sigmaC, sigmaS, 3);
+
+    // the object keeps its buffers from one size to the next
+    const Size sizes[] = { Size(160, 120), Size(97, 131), Size(64, 48) };
+    for (int i = 0; i < 3; i++)
+    {
+        Mat src(sizes[i], CV_MAKE_TYPE(depth, srcCn));
+        rnd.fill(src, RNG::UNIFORM, 0, 255);
+
+        Mat res, ref;
+        rgf->filter(src, res);
+        refRollingGuidanceFilter(src, ref, -1, sigmaC, sigmaS, 3);
+        EXPECT_EQ(0, cvtest::norm(ref, res, NORM_INF));
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(TypicalSet1, RollingGuidanceFilterTest,
     Combine(
     Values(2.0, 5.0),
@@ -0,0 +1,62 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+TEST(ximgproc_SuperpixelSEEDS, smoke)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    ASSERT_FALSE(img.empty());
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(), 400, 4);
+    seeds->iterate(img, 4);
+    Mat outLabels;
+    seeds->getLabels(outLabels);
+    EXPECT_EQ(img.size(), outLabels.size());
+    EXPECT_GT(seeds->getNumberOfSuperpixels(), 0);
+}
+
+TEST(ximgproc_SuperpixelSEEDS, same_result_for_any_thread_count)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    ASSERT_FALSE(img.empty());
+    Mat next;
+    GaussianBlur(img, next, Size(3, 3), 0);
+
+    Mat labels[2], nextLabels[2];
+    int nThreads = getNumThreads();
+    for (int i = 0; i < 2; i++)
+    {
+        setNumThreads(i == 0 ? 1 : nThreads);
+        Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(), 400, 4, 2, 5, true);
+        seeds->iterate(img, 4);
+        seeds->getLabels(labels[i]);
+        seeds->iterateIncremental(next, 2);
+        seeds->getLabels(nextLabels[i]);
+    }
+    setNumThreads(nThreads);
+
+    EXPECT_EQ(0, cvtest::norm(labels[0], labels[1], NORM_INF));
+    EXPECT_EQ(0, cvtest::norm(nextLabels[0], nextLabels[1], NORM_INF));
+}
+
+TEST(ximgproc_SuperpixelSEEDS, incremental_without_previous_result_is_iterate)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    ASSERT_FALSE(img.empty());
+
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(), 400, 4);
+    seeds->iterate(img, 4);
+    Mat expected;
+    seeds->getLabels(expected);
+
+    seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(), 400, 4);
+    seeds->iterateIncremental(img, 4);
+    Mat labels;
+    seeds->getLabels(labels);
+
+    EXPECT_EQ(0, cvtest::norm(expected, labels, NORM_INF));
+}
+
+}} // namespace
@@ -0,0 +1,94 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::ximgproc::segmentation;
+
+struct RectLess
+{
+    bool operator()(const Rect& a, const Rect& b) const
+    {
+        if (a.x != b.x) return a.x < b.x;
+        if (a.y != b.y) return a.y < b.y;
+        if (a.width != b.width) return a.width < b.width;
+        return a.height < b.height;
+    }
+};
+
+// Four flat vertical stripes A|B|C|D. With 25 bins per channel, A and B share the bins of
+// their first two channels, as do C and D, while B and C only share the last one.
+static Mat createStripesImage()
+{
+    Mat img(120, 160, CV_8UC3);
+    img.colRange(0, 40).setTo(Scalar(10, 10, 10));
+    img.colRange(40, 80).setTo(Scalar(10, 10, 210));
+    img.colRange(80, 120).setTo(Scalar(210, 210, 210));
+    img.colRange(120, 160).setTo(Scalar(210, 210, 10));
+    return img;
+}
+
+static Mat createBlocksImage()
+{
+    RNG rng(0x5E1EC7);
+    Mat img(96, 128, CV_8UC3);
+    for (int y = 0; y < img.rows; y += 16)
+        for (int x = 0; x < img.cols; x += 16)
+            img(Rect(x, y, 16, 16)).setTo(Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256)));
+    Mat noise(img.size(), CV_8UC3);
+    rng.fill(noise, RNG::UNIFORM, 0, 16);
+    return img + noise;
+}
+
+TEST(ximgproc_SelectiveSearchSegmentation, color_strategy_proposals)
+{
+    Ptr<SelectiveSearchSegmentation> ss = createSelectiveSearchSegmentation();
+    ss->addImage(createStripesImage());
+    // a tiny sigma disables the pre-blur, so the graph segmentation returns the four stripes
+    ss->addGraphSegmentation(createGraphSegmentation(0.001, 100.f, 10));
+    ss->addStrategy(createSelectiveSearchSegmentationStrategyColor());
+
+    std::vector<Rect> rects;
+    ss->process(rects);
+    std::sort(rects.begin(), rects.end(), RectLess());
+
+    // (A,B) and (C,D) are merged first, in either order, then AB and CD
+    Rect expected[] = {
+        Rect(0, 0, 40, 120), Rect(0, 0, 80, 120), Rect(0, 0, 160, 120),
+        Rect(40, 0, 40, 120), Rect(80, 0, 40, 120), Rect(80, 0, 80, 120),
+        Rect(120, 0, 40, 120)
+    };
+    ASSERT_EQ(sizeof(expected)/sizeof(expected[0]), rects.size());
+    for (size_t i = 0; i < rects.size(); i++)
+        EXPECT_EQ(expected[i], rects[i]) << "proposal " << i;
+}
+
+TEST(ximgproc_SelectiveSearchSegmentation, same_result_with_single_thread)
+{
+    Mat img = createBlocksImage();
+    Ptr<SelectiveSearchSegmentation> ss = createSelectiveSearchSegmentation();
+    ss->setBaseImage(img);
+    ss->switchToSelectiveSearchFast(100, 100);
+    ss->addImage(255 - img);
+
+    const int numThreads = getNumThreads();
+    std::vector<Rect> rects, rectsSingle;
+
+    // proposals are ranked with rand(), so the sequence is reset before each run
+    srand(0);
+    ss->process(rects);
+    setNumThreads(1);
+    srand(0);
+    ss->process(rectsSingle);
+    setNumThreads(numThreads);
+
+    ASSERT_FALSE(rects.empty());
+    ASSERT_EQ(rects.size(), rectsSingle.size());
+    for (size_t i = 0; i < rects.size(); i++)
+        EXPECT_EQ(rects[i], rectsSingle[i]) << "proposal " << i;
+}
+
+}} // namespace
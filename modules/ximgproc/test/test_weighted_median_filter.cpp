@@ -70,6 +70,31 @@ TEST(WeightedMedianFilterTest, mask_zeros_no_crash)
     EXPECT_EQ(cv::norm(img, filtered, NORM_INF), 0.0);
 }
 
+TEST(WeightedMedianFilterTest, object_matches_single_thread)
+{
+    Mat img = imread(getDataDir() + "cv/ximgproc/sources/01.png");
+    ASSERT_FALSE(img.empty());
+    // 1-channel guide: a 3-channel one goes through k-means, seeded from theRNG()
+    Mat gray, disp;
+    cvtColor(img, gray, COLOR_BGR2GRAY);
+    gray.convertTo(disp, CV_32F, 0.25);
+
+    Mat ref;
+    int numThreads = getNumThreads();
+    setNumThreads(1);
+    weightedMedianFilter(gray, disp, ref, 5, 25.5, WMF_EXP);
+    setNumThreads(numThreads);
+
+    // the same instance reused on several frames must give the serial result every time
+    Ptr<WeightedMedianFilter> wmf = createWeightedMedianFilter(5, 25.5, WMF_EXP);
+    for (int iter = 0; iter < 2; iter++)
+    {
+        Mat res;
+        wmf->filter(gray, disp, res);
+        EXPECT_EQ(0, cvtest::norm(ref, res, NORM_INF));
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(TypicalSET, WeightedMedianFilterTest, Combine(Values(szODD, szQVGA),  Values(WMF_EXP, WMF_IV2, WMF_OFF)));
 
 